@@ -2339,6 +2339,79 @@ static void test_rw_order(void)
     ok(!RegDeleteKeyA(HKEY_CURRENT_USER, keyname), "Failed to delete key\n");
 }
 
+static void test_many_subkeys(void)
+{
+    unsigned int i, j, count = 1000;
+    char name[16], buffer[16];
+    DWORD subkeys, len;
+    HKEY hkey, subkey;
+    LSTATUS ret;
+
+    ret = RegCreateKeyA( hkey_main, "ManySubkeys", &hkey );
+    ok( !ret, "RegCreateKeyA failed: %d\n", ret );
+
+    /* create the subkeys out of order */
+    for (i = 0; i < count; i++)
+    {
+        sprintf( name, "key%05u", (i * 7919) % count );
+        ret = RegCreateKeyA( hkey, name, &subkey );
+        ok( !ret, "RegCreateKeyA %s failed: %d\n", name, ret );
+        RegCloseKey( subkey );
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        sprintf( name, "KEY%05u", i );
+        ret = RegOpenKeyA( hkey, name, &subkey );
+        ok( !ret, "RegOpenKeyA %s failed: %d\n", name, ret );
+        RegCloseKey( subkey );
+    }
+
+    ret = RegOpenKeyA( hkey, "key", &subkey );
+    ok( ret == ERROR_FILE_NOT_FOUND, "RegOpenKeyA returned %d\n", ret );
+
+    /* enumeration is sorted and stable */
+    for (i = 0; i < count; i++)
+    {
+        sprintf( name, "key%05u", i );
+        len = sizeof(buffer);
+        ret = RegEnumKeyExA( hkey, i, buffer, &len, NULL, NULL, NULL, NULL );
+        ok( !ret, "RegEnumKeyExA %u failed: %d\n", i, ret );
+        ok( !strcmp( buffer, name ), "%u: expected %s, got %s\n", i, name, buffer );
+    }
+
+    for (i = 0; i < count; i += 2)
+    {
+        sprintf( name, "Key%05u", i );
+        ret = RegDeleteKeyA( hkey, name );
+        ok( !ret, "RegDeleteKeyA %s failed: %d\n", name, ret );
+    }
+
+    ret = RegQueryInfoKeyA( hkey, NULL, NULL, NULL, &subkeys, NULL, NULL, NULL, NULL, NULL, NULL, NULL );
+    ok( !ret, "RegQueryInfoKeyA failed: %d\n", ret );
+    ok( subkeys == count / 2, "expected %u subkeys, got %u\n", count / 2, subkeys );
+
+    for (i = 0, j = 1; j < count; i++, j += 2)
+    {
+        sprintf( name, "key%05u", j );
+        len = sizeof(buffer);
+        ret = RegEnumKeyExA( hkey, i, buffer, &len, NULL, NULL, NULL, NULL );
+        ok( !ret, "RegEnumKeyExA %u failed: %d\n", i, ret );
+        ok( !strcmp( buffer, name ), "%u: expected %s, got %s\n", i, name, buffer );
+    }
+
+    sprintf( name, "key%05u", 0 );
+    ret = RegOpenKeyA( hkey, name, &subkey );
+    ok( ret == ERROR_FILE_NOT_FOUND, "RegOpenKeyA %s returned %d\n", name, ret );
+    sprintf( name, "key%05u", 1 );
+    ret = RegOpenKeyA( hkey, name, &subkey );
+    ok( !ret, "RegOpenKeyA %s failed: %d\n", name, ret );
+    RegCloseKey( subkey );
+
+    delete_key( hkey );
+    RegCloseKey( hkey );
+}
+
 static void test_symlinks(void)
 {
     static const WCHAR targetW[] = {'\\','S','o','f','t','w','a','r','e','\\','W','i','n','e',
@@ -3691,6 +3764,7 @@ START_TEST(registry)
     test_reg_copy_tree();
     test_reg_delete_tree();
     test_rw_order();
+    test_many_subkeys();
     test_deleted_key();
     test_delete_value();
     test_delete_key_value();
@@ -77,6 +77,8 @@ struct wined3d_resource *wined3d_resource_from_d3d10_resource(ID3D10Resource *re
 DWORD wined3d_map_flags_from_d3d11_map_type(D3D11_MAP map_type) DECLSPEC_HIDDEN;
 DWORD wined3d_clear_flags_from_d3d11_clear_flags(UINT clear_flags) DECLSPEC_HIDDEN;
 unsigned int wined3d_access_from_d3d11(D3D11_USAGE usage, UINT cpu_access) DECLSPEC_HIDDEN;
+BOOL d3d11_validate_constant_buffer_ranges(UINT buffer_count,
+        const UINT *first_constant, const UINT *num_constants) DECLSPEC_HIDDEN;
 
 enum D3D11_USAGE d3d11_usage_from_d3d10_usage(enum D3D10_USAGE usage) DECLSPEC_HIDDEN;
 enum D3D10_USAGE d3d10_usage_from_d3d11_usage(enum D3D11_USAGE usage) DECLSPEC_HIDDEN;
@@ -522,6 +524,82 @@ struct d3d11_immediate_context
     struct wined3d_private_store private_store;
 };
 
+/* Context state, as bound through the ID3D11DeviceContext Set*() methods.
+ * Arrays indexed by shader type use enum wined3d_shader_type. */
+struct d3d11_context_state
+{
+    ID3D11DeviceChild *shaders[WINED3D_SHADER_TYPE_COUNT];
+    ID3D11Buffer *cbs[WINED3D_SHADER_TYPE_COUNT][D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+    UINT cb_first_constants[WINED3D_SHADER_TYPE_COUNT][D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+    UINT cb_num_constants[WINED3D_SHADER_TYPE_COUNT][D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+    ID3D11ShaderResourceView *srvs[WINED3D_SHADER_TYPE_COUNT][D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+    ID3D11SamplerState *samplers[WINED3D_SHADER_TYPE_COUNT][D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT];
+    ID3D11UnorderedAccessView *cs_uavs[D3D11_PS_CS_UAV_REGISTER_COUNT];
+
+    ID3D11InputLayout *input_layout;
+    ID3D11Buffer *vbs[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+    UINT vb_strides[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+    UINT vb_offsets[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+    ID3D11Buffer *ib;
+    DXGI_FORMAT ib_format;
+    UINT ib_offset;
+    D3D11_PRIMITIVE_TOPOLOGY topology;
+
+    ID3D11RenderTargetView *rtvs[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT];
+    ID3D11DepthStencilView *dsv;
+    ID3D11UnorderedAccessView *ps_uavs[D3D11_PS_CS_UAV_REGISTER_COUNT];
+    ID3D11BlendState *blend_state;
+    float blend_factor[4];
+    UINT sample_mask;
+    ID3D11DepthStencilState *depth_stencil_state;
+    UINT stencil_ref;
+
+    ID3D11RasterizerState *rasterizer_state;
+    UINT viewport_count;
+    D3D11_VIEWPORT viewports[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+    UINT scissor_rect_count;
+    D3D11_RECT scissor_rects[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+    ID3D11Buffer *so_targets[D3D11_SO_BUFFER_SLOT_COUNT];
+
+    ID3D11Predicate *predicate;
+    BOOL predicate_value;
+};
+
+/* ID3D11DeviceContext - deferred context */
+struct d3d11_deferred_context
+{
+    ID3D11DeviceContext1 ID3D11DeviceContext1_iface;
+    LONG refcount;
+
+    struct wined3d_private_store private_store;
+    struct d3d_device *device;
+    struct list commands;
+    struct list maps;
+    /* The last unmapped D3D11_MAP_WRITE_DISCARD map of each sub-resource in
+     * "commands", for D3D11_MAP_WRITE_NO_OVERWRITE maps. */
+    struct wine_rb_tree discard_maps;
+    /* The state bound so far, returned by the Get*() methods. */
+    struct d3d11_context_state state;
+};
+
+HRESULT d3d11_deferred_context_create(struct d3d_device *device, UINT flags,
+        struct d3d11_deferred_context **context) DECLSPEC_HIDDEN;
+
+/* ID3D11CommandList */
+struct d3d11_command_list
+{
+    ID3D11CommandList ID3D11CommandList_iface;
+    LONG refcount;
+
+    struct wined3d_private_store private_store;
+    ID3D11Device2 *device;
+    struct list commands;
+};
+
+struct d3d11_command_list *unsafe_impl_from_ID3D11CommandList(ID3D11CommandList *iface) DECLSPEC_HIDDEN;
+void d3d11_command_list_execute(struct d3d11_command_list *list, ID3D11DeviceContext1 *context,
+        BOOL restore_state) DECLSPEC_HIDDEN;
+
 /* ID3D11Device, ID3D10Device1 */
 struct d3d_device
 {
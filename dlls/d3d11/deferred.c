@@ -0,0 +1,3514 @@
+/*
+ * Direct3D 11 deferred contexts and command lists
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ *
+ */
+
+/*
+ * Deferred contexts record their calls into a list of deferred_call entries,
+ * without touching wined3d. FinishCommandList() moves the list into a
+ * command list object, and ExecuteCommandList() replays it on the immediate
+ * context while holding the wined3d mutex, so that recording on several
+ * threads only serialises at submission time.
+ */
+
+#include "config.h"
+#include "wine/port.h"
+
+#include "d3d11_private.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(d3d11);
+
+enum deferred_call_type
+{
+    DEFERRED_SET_SHADER,
+    DEFERRED_SET_CONSTANT_BUFFERS,
+    DEFERRED_SET_SHADER_RESOURCES,
+    DEFERRED_SET_SAMPLERS,
+    DEFERRED_CS_SET_UNORDERED_ACCESS_VIEWS,
+    DEFERRED_IA_SET_INPUT_LAYOUT,
+    DEFERRED_IA_SET_VERTEX_BUFFERS,
+    DEFERRED_IA_SET_INDEX_BUFFER,
+    DEFERRED_IA_SET_PRIMITIVE_TOPOLOGY,
+    DEFERRED_OM_SET_RENDER_TARGETS_AND_UAVS,
+    DEFERRED_OM_SET_BLEND_STATE,
+    DEFERRED_OM_SET_DEPTH_STENCIL_STATE,
+    DEFERRED_SO_SET_TARGETS,
+    DEFERRED_RS_SET_STATE,
+    DEFERRED_RS_SET_VIEWPORTS,
+    DEFERRED_RS_SET_SCISSOR_RECTS,
+    DEFERRED_DRAW,
+    DEFERRED_DRAW_INDEXED,
+    DEFERRED_DRAW_INSTANCED,
+    DEFERRED_DRAW_INDEXED_INSTANCED,
+    DEFERRED_DRAW_AUTO,
+    DEFERRED_DRAW_INSTANCED_INDIRECT,
+    DEFERRED_DRAW_INDEXED_INSTANCED_INDIRECT,
+    DEFERRED_DISPATCH,
+    DEFERRED_DISPATCH_INDIRECT,
+    DEFERRED_BEGIN,
+    DEFERRED_END,
+    DEFERRED_SET_PREDICATION,
+    DEFERRED_COPY_SUBRESOURCE_REGION,
+    DEFERRED_COPY_RESOURCE,
+    DEFERRED_UPDATE_SUBRESOURCE,
+    DEFERRED_MAP_DISCARD,
+    DEFERRED_MAP_NO_OVERWRITE,
+    DEFERRED_COPY_STRUCTURE_COUNT,
+    DEFERRED_CLEAR_RENDER_TARGET_VIEW,
+    DEFERRED_CLEAR_UNORDERED_ACCESS_VIEW_UINT,
+    DEFERRED_CLEAR_UNORDERED_ACCESS_VIEW_FLOAT,
+    DEFERRED_CLEAR_DEPTH_STENCIL_VIEW,
+    DEFERRED_GENERATE_MIPS,
+    DEFERRED_RESOLVE_SUBRESOURCE,
+    DEFERRED_EXECUTE_COMMAND_LIST,
+    DEFERRED_CLEAR_STATE,
+    DEFERRED_SET_STATE,
+};
+
+struct deferred_call
+{
+    struct list entry;
+    enum deferred_call_type type;
+    union
+    {
+        struct
+        {
+            enum wined3d_shader_type type;
+            IUnknown *shader;
+        } shader;
+        struct
+        {
+            enum wined3d_shader_type type;
+            UINT start_slot;
+            UINT count;
+            IUnknown **objects;
+            UINT *initial_counts;
+            UINT *first_constants;
+            UINT *num_constants;
+        } objects;
+        struct
+        {
+            UINT start_slot;
+            UINT count;
+            ID3D11Buffer **buffers;
+            UINT *strides;
+            UINT *offsets;
+        } vertex_buffers;
+        struct
+        {
+            ID3D11Buffer *buffer;
+            DXGI_FORMAT format;
+            UINT offset;
+        } index_buffer;
+        struct
+        {
+            UINT rtv_count;
+            ID3D11RenderTargetView **rtvs;
+            ID3D11DepthStencilView *dsv;
+            UINT uav_start_slot;
+            UINT uav_count;
+            ID3D11UnorderedAccessView **uavs;
+            UINT *initial_counts;
+        } render_targets;
+        struct
+        {
+            ID3D11BlendState *state;
+            BOOL has_factor;
+            float factor[4];
+            UINT sample_mask;
+        } blend_state;
+        struct
+        {
+            ID3D11DepthStencilState *state;
+            UINT stencil_ref;
+        } depth_stencil_state;
+        struct
+        {
+            UINT count;
+            ID3D11Buffer **buffers;
+            UINT *offsets;
+        } so_targets;
+        struct
+        {
+            UINT count;
+            D3D11_VIEWPORT *viewports;
+        } viewports;
+        struct
+        {
+            UINT count;
+            D3D11_RECT *rects;
+        } scissor_rects;
+        struct
+        {
+            UINT count;
+            UINT instance_count;
+            UINT start;
+            INT base_vertex;
+            UINT start_instance;
+        } draw;
+        struct
+        {
+            ID3D11Buffer *buffer;
+            UINT offset;
+        } indirect;
+        struct
+        {
+            UINT x, y, z;
+        } dispatch;
+        ID3D11DeviceChild *object;
+        D3D11_PRIMITIVE_TOPOLOGY topology;
+        struct
+        {
+            ID3D11Predicate *predicate;
+            BOOL value;
+        } predication;
+        struct
+        {
+            ID3D11Resource *dst_resource;
+            UINT dst_subresource_idx;
+            UINT dst_x, dst_y, dst_z;
+            ID3D11Resource *src_resource;
+            UINT src_subresource_idx;
+            BOOL has_box;
+            D3D11_BOX src_box;
+        } copy_region;
+        struct
+        {
+            ID3D11Resource *dst_resource;
+            ID3D11Resource *src_resource;
+        } copy_resource;
+        struct
+        {
+            ID3D11Resource *resource;
+            UINT subresource_idx;
+            BOOL has_box;
+            D3D11_BOX box;
+            void *data;
+            UINT row_pitch;
+            UINT depth_pitch;
+            UINT row_size;
+            UINT row_count;
+            UINT depth;
+        } update;
+        struct
+        {
+            ID3D11Buffer *dst_buffer;
+            UINT dst_offset;
+            ID3D11UnorderedAccessView *src_view;
+        } structure_count;
+        struct
+        {
+            ID3D11View *view;
+            union
+            {
+                float f[4];
+                UINT u[4];
+            } values;
+        } clear_view;
+        struct
+        {
+            ID3D11DepthStencilView *view;
+            UINT flags;
+            float depth;
+            UINT8 stencil;
+        } clear_depth_stencil;
+        struct
+        {
+            ID3D11Resource *dst_resource;
+            UINT dst_subresource_idx;
+            ID3D11Resource *src_resource;
+            UINT src_subresource_idx;
+            DXGI_FORMAT format;
+        } resolve;
+        struct
+        {
+            ID3D11CommandList *command_list;
+            BOOL restore_state;
+        } execute;
+        struct d3d11_context_state *state;
+    } u;
+};
+
+static void *deferred_call_data(struct deferred_call *call)
+{
+    return call + 1;
+}
+
+static struct deferred_call *add_deferred_call(struct list *commands, enum deferred_call_type type,
+        SIZE_T extra_size)
+{
+    struct deferred_call *call;
+
+    if (!(call = heap_alloc_zero(sizeof(*call) + extra_size)))
+    {
+        ERR("Failed to allocate deferred call, type %#x.\n", type);
+        return NULL;
+    }
+    call->type = type;
+    if (commands)
+        list_add_tail(commands, &call->entry);
+
+    return call;
+}
+
+static void copy_objects(IUnknown **dst, IUnknown *const *src, UINT count)
+{
+    unsigned int i;
+
+    for (i = 0; i < count; ++i)
+    {
+        if ((dst[i] = src ? src[i] : NULL))
+            IUnknown_AddRef(dst[i]);
+    }
+}
+
+static void release_objects(IUnknown **objects, UINT count)
+{
+    unsigned int i;
+
+    for (i = 0; i < count; ++i)
+    {
+        if (objects[i])
+            IUnknown_Release(objects[i]);
+    }
+}
+
+static void add_object_refs(IUnknown **objects, UINT count)
+{
+    unsigned int i;
+
+    for (i = 0; i < count; ++i)
+    {
+        if (objects[i])
+            IUnknown_AddRef(objects[i]);
+    }
+}
+
+static void add_object_ref(void *object)
+{
+    if (object)
+        IUnknown_AddRef((IUnknown *)object);
+}
+
+static void release_object(void *object)
+{
+    if (object)
+        IUnknown_Release((IUnknown *)object);
+}
+
+/* Replaces the "count" objects in "dst" with the ones in "src", or with NULL
+ * if "src" is NULL. */
+static void replace_objects(IUnknown **dst, IUnknown *const *src, UINT count)
+{
+    unsigned int i;
+    IUnknown *prev;
+
+    for (i = 0; i < count; ++i)
+    {
+        prev = dst[i];
+        if ((dst[i] = src ? src[i] : NULL))
+            IUnknown_AddRef(dst[i]);
+        if (prev)
+            IUnknown_Release(prev);
+    }
+}
+
+static void replace_object(void *dst, void *object)
+{
+    replace_objects(dst, (IUnknown *const *)&object, 1);
+}
+
+static void d3d11_context_state_init(struct d3d11_context_state *state)
+{
+    memset(state, 0, sizeof(*state));
+    state->ib_format = DXGI_FORMAT_UNKNOWN;
+    state->topology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+    state->blend_factor[0] = state->blend_factor[1] = state->blend_factor[2] = state->blend_factor[3] = 1.0f;
+    state->sample_mask = D3D11_DEFAULT_SAMPLE_MASK;
+}
+
+static void d3d11_context_state_for_each_object(struct d3d11_context_state *state,
+        void (*func)(IUnknown **objects, UINT count))
+{
+    func((IUnknown **)state->shaders, ARRAY_SIZE(state->shaders));
+    func((IUnknown **)state->cbs, ARRAY_SIZE(state->cbs) * ARRAY_SIZE(state->cbs[0]));
+    func((IUnknown **)state->srvs, ARRAY_SIZE(state->srvs) * ARRAY_SIZE(state->srvs[0]));
+    func((IUnknown **)state->samplers, ARRAY_SIZE(state->samplers) * ARRAY_SIZE(state->samplers[0]));
+    func((IUnknown **)state->cs_uavs, ARRAY_SIZE(state->cs_uavs));
+    func((IUnknown **)&state->input_layout, 1);
+    func((IUnknown **)state->vbs, ARRAY_SIZE(state->vbs));
+    func((IUnknown **)&state->ib, 1);
+    func((IUnknown **)state->rtvs, ARRAY_SIZE(state->rtvs));
+    func((IUnknown **)&state->dsv, 1);
+    func((IUnknown **)state->ps_uavs, ARRAY_SIZE(state->ps_uavs));
+    func((IUnknown **)&state->blend_state, 1);
+    func((IUnknown **)&state->depth_stencil_state, 1);
+    func((IUnknown **)&state->rasterizer_state, 1);
+    func((IUnknown **)state->so_targets, ARRAY_SIZE(state->so_targets));
+    func((IUnknown **)&state->predicate, 1);
+}
+
+static void d3d11_context_state_copy(struct d3d11_context_state *dst, const struct d3d11_context_state *src)
+{
+    *dst = *src;
+    d3d11_context_state_for_each_object(dst, add_object_refs);
+}
+
+static void d3d11_context_state_cleanup(struct d3d11_context_state *state)
+{
+    d3d11_context_state_for_each_object(state, release_objects);
+}
+
+static void free_deferred_call(struct deferred_call *call)
+{
+    switch (call->type)
+    {
+        case DEFERRED_SET_SHADER:
+            release_object(call->u.shader.shader);
+            break;
+
+        case DEFERRED_SET_CONSTANT_BUFFERS:
+        case DEFERRED_SET_SHADER_RESOURCES:
+        case DEFERRED_SET_SAMPLERS:
+        case DEFERRED_CS_SET_UNORDERED_ACCESS_VIEWS:
+            release_objects(call->u.objects.objects, call->u.objects.count);
+            break;
+
+        case DEFERRED_IA_SET_VERTEX_BUFFERS:
+            release_objects((IUnknown **)call->u.vertex_buffers.buffers, call->u.vertex_buffers.count);
+            break;
+
+        case DEFERRED_IA_SET_INDEX_BUFFER:
+            release_object(call->u.index_buffer.buffer);
+            break;
+
+        case DEFERRED_OM_SET_RENDER_TARGETS_AND_UAVS:
+            if (call->u.render_targets.rtv_count != D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL)
+            {
+                release_objects((IUnknown **)call->u.render_targets.rtvs, call->u.render_targets.rtv_count);
+                release_object(call->u.render_targets.dsv);
+            }
+            if (call->u.render_targets.uav_count != D3D11_KEEP_UNORDERED_ACCESS_VIEWS)
+                release_objects((IUnknown **)call->u.render_targets.uavs, call->u.render_targets.uav_count);
+            break;
+
+        case DEFERRED_OM_SET_BLEND_STATE:
+            release_object(call->u.blend_state.state);
+            break;
+
+        case DEFERRED_OM_SET_DEPTH_STENCIL_STATE:
+            release_object(call->u.depth_stencil_state.state);
+            break;
+
+        case DEFERRED_SO_SET_TARGETS:
+            release_objects((IUnknown **)call->u.so_targets.buffers, call->u.so_targets.count);
+            break;
+
+        case DEFERRED_IA_SET_INPUT_LAYOUT:
+        case DEFERRED_RS_SET_STATE:
+        case DEFERRED_BEGIN:
+        case DEFERRED_END:
+        case DEFERRED_GENERATE_MIPS:
+            release_object(call->u.object);
+            break;
+
+        case DEFERRED_DRAW_INSTANCED_INDIRECT:
+        case DEFERRED_DRAW_INDEXED_INSTANCED_INDIRECT:
+        case DEFERRED_DISPATCH_INDIRECT:
+            release_object(call->u.indirect.buffer);
+            break;
+
+        case DEFERRED_SET_PREDICATION:
+            release_object(call->u.predication.predicate);
+            break;
+
+        case DEFERRED_COPY_SUBRESOURCE_REGION:
+            release_object(call->u.copy_region.dst_resource);
+            release_object(call->u.copy_region.src_resource);
+            break;
+
+        case DEFERRED_COPY_RESOURCE:
+            release_object(call->u.copy_resource.dst_resource);
+            release_object(call->u.copy_resource.src_resource);
+            break;
+
+        case DEFERRED_UPDATE_SUBRESOURCE:
+        case DEFERRED_MAP_DISCARD:
+        case DEFERRED_MAP_NO_OVERWRITE:
+            release_object(call->u.update.resource);
+            break;
+
+        case DEFERRED_COPY_STRUCTURE_COUNT:
+            release_object(call->u.structure_count.dst_buffer);
+            release_object(call->u.structure_count.src_view);
+            break;
+
+        case DEFERRED_CLEAR_RENDER_TARGET_VIEW:
+        case DEFERRED_CLEAR_UNORDERED_ACCESS_VIEW_UINT:
+        case DEFERRED_CLEAR_UNORDERED_ACCESS_VIEW_FLOAT:
+            release_object(call->u.clear_view.view);
+            break;
+
+        case DEFERRED_CLEAR_DEPTH_STENCIL_VIEW:
+            release_object(call->u.clear_depth_stencil.view);
+            break;
+
+        case DEFERRED_RESOLVE_SUBRESOURCE:
+            release_object(call->u.resolve.dst_resource);
+            release_object(call->u.resolve.src_resource);
+            break;
+
+        case DEFERRED_EXECUTE_COMMAND_LIST:
+            release_object(call->u.execute.command_list);
+            break;
+
+        case DEFERRED_SET_STATE:
+            d3d11_context_state_cleanup(call->u.state);
+            break;
+
+        case DEFERRED_IA_SET_PRIMITIVE_TOPOLOGY:
+        case DEFERRED_RS_SET_VIEWPORTS:
+        case DEFERRED_RS_SET_SCISSOR_RECTS:
+        case DEFERRED_DRAW:
+        case DEFERRED_DRAW_INDEXED:
+        case DEFERRED_DRAW_INSTANCED:
+        case DEFERRED_DRAW_INDEXED_INSTANCED:
+        case DEFERRED_DRAW_AUTO:
+        case DEFERRED_DISPATCH:
+        case DEFERRED_CLEAR_STATE:
+            break;
+    }
+
+    heap_free(call);
+}
+
+static void free_deferred_calls(struct list *commands)
+{
+    struct deferred_call *call, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE(call, next, commands, struct deferred_call, entry)
+    {
+        list_remove(&call->entry);
+        free_deferred_call(call);
+    }
+}
+
+static void exec_set_shader(ID3D11DeviceContext1 *iface, enum wined3d_shader_type type, IUnknown *shader)
+{
+    switch (type)
+    {
+        case WINED3D_SHADER_TYPE_VERTEX:
+            ID3D11DeviceContext1_VSSetShader(iface, (ID3D11VertexShader *)shader, NULL, 0);
+            break;
+        case WINED3D_SHADER_TYPE_HULL:
+            ID3D11DeviceContext1_HSSetShader(iface, (ID3D11HullShader *)shader, NULL, 0);
+            break;
+        case WINED3D_SHADER_TYPE_DOMAIN:
+            ID3D11DeviceContext1_DSSetShader(iface, (ID3D11DomainShader *)shader, NULL, 0);
+            break;
+        case WINED3D_SHADER_TYPE_GEOMETRY:
+            ID3D11DeviceContext1_GSSetShader(iface, (ID3D11GeometryShader *)shader, NULL, 0);
+            break;
+        case WINED3D_SHADER_TYPE_PIXEL:
+            ID3D11DeviceContext1_PSSetShader(iface, (ID3D11PixelShader *)shader, NULL, 0);
+            break;
+        case WINED3D_SHADER_TYPE_COMPUTE:
+            ID3D11DeviceContext1_CSSetShader(iface, (ID3D11ComputeShader *)shader, NULL, 0);
+            break;
+        default:
+            ERR("Unhandled shader type %#x.\n", type);
+            break;
+    }
+}
+
+static void exec_set_constant_buffers(ID3D11DeviceContext1 *iface, enum wined3d_shader_type type,
+        UINT start_slot, UINT count, ID3D11Buffer *const *buffers, const UINT *first_constants,
+        const UINT *num_constants)
+{
+    switch (type)
+    {
+        case WINED3D_SHADER_TYPE_VERTEX:
+            ID3D11DeviceContext1_VSSetConstantBuffers1(iface, start_slot, count, buffers,
+                    first_constants, num_constants);
+            break;
+        case WINED3D_SHADER_TYPE_HULL:
+            ID3D11DeviceContext1_HSSetConstantBuffers1(iface, start_slot, count, buffers,
+                    first_constants, num_constants);
+            break;
+        case WINED3D_SHADER_TYPE_DOMAIN:
+            ID3D11DeviceContext1_DSSetConstantBuffers1(iface, start_slot, count, buffers,
+                    first_constants, num_constants);
+            break;
+        case WINED3D_SHADER_TYPE_GEOMETRY:
+            ID3D11DeviceContext1_GSSetConstantBuffers1(iface, start_slot, count, buffers,
+                    first_constants, num_constants);
+            break;
+        case WINED3D_SHADER_TYPE_PIXEL:
+            ID3D11DeviceContext1_PSSetConstantBuffers1(iface, start_slot, count, buffers,
+                    first_constants, num_constants);
+            break;
+        case WINED3D_SHADER_TYPE_COMPUTE:
+            ID3D11DeviceContext1_CSSetConstantBuffers1(iface, start_slot, count, buffers,
+                    first_constants, num_constants);
+            break;
+        default:
+            ERR("Unhandled shader type %#x.\n", type);
+            break;
+    }
+}
+
+static void exec_set_shader_resources(ID3D11DeviceContext1 *iface, enum wined3d_shader_type type,
+        UINT start_slot, UINT count, ID3D11ShaderResourceView *const *views)
+{
+    switch (type)
+    {
+        case WINED3D_SHADER_TYPE_VERTEX:
+            ID3D11DeviceContext1_VSSetShaderResources(iface, start_slot, count, views);
+            break;
+        case WINED3D_SHADER_TYPE_HULL:
+            ID3D11DeviceContext1_HSSetShaderResources(iface, start_slot, count, views);
+            break;
+        case WINED3D_SHADER_TYPE_DOMAIN:
+            ID3D11DeviceContext1_DSSetShaderResources(iface, start_slot, count, views);
+            break;
+        case WINED3D_SHADER_TYPE_GEOMETRY:
+            ID3D11DeviceContext1_GSSetShaderResources(iface, start_slot, count, views);
+            break;
+        case WINED3D_SHADER_TYPE_PIXEL:
+            ID3D11DeviceContext1_PSSetShaderResources(iface, start_slot, count, views);
+            break;
+        case WINED3D_SHADER_TYPE_COMPUTE:
+            ID3D11DeviceContext1_CSSetShaderResources(iface, start_slot, count, views);
+            break;
+        default:
+            ERR("Unhandled shader type %#x.\n", type);
+            break;
+    }
+}
+
+static void exec_set_samplers(ID3D11DeviceContext1 *iface, enum wined3d_shader_type type,
+        UINT start_slot, UINT count, ID3D11SamplerState *const *samplers)
+{
+    switch (type)
+    {
+        case WINED3D_SHADER_TYPE_VERTEX:
+            ID3D11DeviceContext1_VSSetSamplers(iface, start_slot, count, samplers);
+            break;
+        case WINED3D_SHADER_TYPE_HULL:
+            ID3D11DeviceContext1_HSSetSamplers(iface, start_slot, count, samplers);
+            break;
+        case WINED3D_SHADER_TYPE_DOMAIN:
+            ID3D11DeviceContext1_DSSetSamplers(iface, start_slot, count, samplers);
+            break;
+        case WINED3D_SHADER_TYPE_GEOMETRY:
+            ID3D11DeviceContext1_GSSetSamplers(iface, start_slot, count, samplers);
+            break;
+        case WINED3D_SHADER_TYPE_PIXEL:
+            ID3D11DeviceContext1_PSSetSamplers(iface, start_slot, count, samplers);
+            break;
+        case WINED3D_SHADER_TYPE_COMPUTE:
+            ID3D11DeviceContext1_CSSetSamplers(iface, start_slot, count, samplers);
+            break;
+        default:
+            ERR("Unhandled shader type %#x.\n", type);
+            break;
+    }
+}
+
+static void d3d11_context_state_save(ID3D11DeviceContext1 *iface, struct d3d11_context_state *state)
+{
+    static const UINT cb_count = D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT;
+    static const UINT srv_count = D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT;
+    static const UINT sampler_count = D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT;
+
+    ID3D11DeviceContext1_VSGetShader(iface,
+            (ID3D11VertexShader **)&state->shaders[WINED3D_SHADER_TYPE_VERTEX], NULL, NULL);
+    ID3D11DeviceContext1_VSGetConstantBuffers1(iface, 0, cb_count, state->cbs[WINED3D_SHADER_TYPE_VERTEX],
+            state->cb_first_constants[WINED3D_SHADER_TYPE_VERTEX],
+            state->cb_num_constants[WINED3D_SHADER_TYPE_VERTEX]);
+    ID3D11DeviceContext1_VSGetShaderResources(iface, 0, srv_count, state->srvs[WINED3D_SHADER_TYPE_VERTEX]);
+    ID3D11DeviceContext1_VSGetSamplers(iface, 0, sampler_count, state->samplers[WINED3D_SHADER_TYPE_VERTEX]);
+    ID3D11DeviceContext1_HSGetShader(iface,
+            (ID3D11HullShader **)&state->shaders[WINED3D_SHADER_TYPE_HULL], NULL, NULL);
+    ID3D11DeviceContext1_HSGetConstantBuffers1(iface, 0, cb_count, state->cbs[WINED3D_SHADER_TYPE_HULL],
+            state->cb_first_constants[WINED3D_SHADER_TYPE_HULL],
+            state->cb_num_constants[WINED3D_SHADER_TYPE_HULL]);
+    ID3D11DeviceContext1_HSGetShaderResources(iface, 0, srv_count, state->srvs[WINED3D_SHADER_TYPE_HULL]);
+    ID3D11DeviceContext1_HSGetSamplers(iface, 0, sampler_count, state->samplers[WINED3D_SHADER_TYPE_HULL]);
+    ID3D11DeviceContext1_DSGetShader(iface,
+            (ID3D11DomainShader **)&state->shaders[WINED3D_SHADER_TYPE_DOMAIN], NULL, NULL);
+    ID3D11DeviceContext1_DSGetConstantBuffers1(iface, 0, cb_count, state->cbs[WINED3D_SHADER_TYPE_DOMAIN],
+            state->cb_first_constants[WINED3D_SHADER_TYPE_DOMAIN],
+            state->cb_num_constants[WINED3D_SHADER_TYPE_DOMAIN]);
+    ID3D11DeviceContext1_DSGetShaderResources(iface, 0, srv_count, state->srvs[WINED3D_SHADER_TYPE_DOMAIN]);
+    ID3D11DeviceContext1_DSGetSamplers(iface, 0, sampler_count, state->samplers[WINED3D_SHADER_TYPE_DOMAIN]);
+    ID3D11DeviceContext1_GSGetShader(iface,
+            (ID3D11GeometryShader **)&state->shaders[WINED3D_SHADER_TYPE_GEOMETRY], NULL, NULL);
+    ID3D11DeviceContext1_GSGetConstantBuffers1(iface, 0, cb_count, state->cbs[WINED3D_SHADER_TYPE_GEOMETRY],
+            state->cb_first_constants[WINED3D_SHADER_TYPE_GEOMETRY],
+            state->cb_num_constants[WINED3D_SHADER_TYPE_GEOMETRY]);
+    ID3D11DeviceContext1_GSGetShaderResources(iface, 0, srv_count, state->srvs[WINED3D_SHADER_TYPE_GEOMETRY]);
+    ID3D11DeviceContext1_GSGetSamplers(iface, 0, sampler_count, state->samplers[WINED3D_SHADER_TYPE_GEOMETRY]);
+    ID3D11DeviceContext1_PSGetShader(iface,
+            (ID3D11PixelShader **)&state->shaders[WINED3D_SHADER_TYPE_PIXEL], NULL, NULL);
+    ID3D11DeviceContext1_PSGetConstantBuffers1(iface, 0, cb_count, state->cbs[WINED3D_SHADER_TYPE_PIXEL],
+            state->cb_first_constants[WINED3D_SHADER_TYPE_PIXEL],
+            state->cb_num_constants[WINED3D_SHADER_TYPE_PIXEL]);
+    ID3D11DeviceContext1_PSGetShaderResources(iface, 0, srv_count, state->srvs[WINED3D_SHADER_TYPE_PIXEL]);
+    ID3D11DeviceContext1_PSGetSamplers(iface, 0, sampler_count, state->samplers[WINED3D_SHADER_TYPE_PIXEL]);
+    ID3D11DeviceContext1_CSGetShader(iface,
+            (ID3D11ComputeShader **)&state->shaders[WINED3D_SHADER_TYPE_COMPUTE], NULL, NULL);
+    ID3D11DeviceContext1_CSGetConstantBuffers1(iface, 0, cb_count, state->cbs[WINED3D_SHADER_TYPE_COMPUTE],
+            state->cb_first_constants[WINED3D_SHADER_TYPE_COMPUTE],
+            state->cb_num_constants[WINED3D_SHADER_TYPE_COMPUTE]);
+    ID3D11DeviceContext1_CSGetShaderResources(iface, 0, srv_count, state->srvs[WINED3D_SHADER_TYPE_COMPUTE]);
+    ID3D11DeviceContext1_CSGetSamplers(iface, 0, sampler_count, state->samplers[WINED3D_SHADER_TYPE_COMPUTE]);
+    ID3D11DeviceContext1_CSGetUnorderedAccessViews(iface, 0, D3D11_PS_CS_UAV_REGISTER_COUNT, state->cs_uavs);
+
+    ID3D11DeviceContext1_IAGetInputLayout(iface, &state->input_layout);
+    ID3D11DeviceContext1_IAGetVertexBuffers(iface, 0, D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT,
+            state->vbs, state->vb_strides, state->vb_offsets);
+    ID3D11DeviceContext1_IAGetIndexBuffer(iface, &state->ib, &state->ib_format, &state->ib_offset);
+    ID3D11DeviceContext1_IAGetPrimitiveTopology(iface, &state->topology);
+
+    ID3D11DeviceContext1_OMGetRenderTargetsAndUnorderedAccessViews(iface,
+            D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, state->rtvs, &state->dsv,
+            0, D3D11_PS_CS_UAV_REGISTER_COUNT, state->ps_uavs);
+    ID3D11DeviceContext1_OMGetBlendState(iface, &state->blend_state, state->blend_factor, &state->sample_mask);
+    ID3D11DeviceContext1_OMGetDepthStencilState(iface, &state->depth_stencil_state, &state->stencil_ref);
+
+    ID3D11DeviceContext1_RSGetState(iface, &state->rasterizer_state);
+    ID3D11DeviceContext1_RSGetViewports(iface, &state->viewport_count, NULL);
+    ID3D11DeviceContext1_RSGetViewports(iface, &state->viewport_count, state->viewports);
+    ID3D11DeviceContext1_RSGetScissorRects(iface, &state->scissor_rect_count, NULL);
+    ID3D11DeviceContext1_RSGetScissorRects(iface, &state->scissor_rect_count, state->scissor_rects);
+    ID3D11DeviceContext1_SOGetTargets(iface, D3D11_SO_BUFFER_SLOT_COUNT, state->so_targets);
+
+    ID3D11DeviceContext1_GetPredication(iface, &state->predicate, &state->predicate_value);
+}
+
+static void d3d11_context_state_apply(ID3D11DeviceContext1 *iface, const struct d3d11_context_state *state)
+{
+    static const UINT so_offsets[D3D11_SO_BUFFER_SLOT_COUNT] = {~0u, ~0u, ~0u, ~0u};
+    unsigned int i;
+
+    for (i = 0; i < WINED3D_SHADER_TYPE_COUNT; ++i)
+    {
+        exec_set_shader(iface, i, (IUnknown *)state->shaders[i]);
+        exec_set_constant_buffers(iface, i, 0, ARRAY_SIZE(state->cbs[i]), state->cbs[i],
+                state->cb_first_constants[i], state->cb_num_constants[i]);
+        exec_set_shader_resources(iface, i, 0, ARRAY_SIZE(state->srvs[i]), state->srvs[i]);
+        exec_set_samplers(iface, i, 0, ARRAY_SIZE(state->samplers[i]), state->samplers[i]);
+    }
+    ID3D11DeviceContext1_CSSetUnorderedAccessViews(iface, 0, D3D11_PS_CS_UAV_REGISTER_COUNT,
+            state->cs_uavs, NULL);
+
+    ID3D11DeviceContext1_IASetInputLayout(iface, state->input_layout);
+    ID3D11DeviceContext1_IASetVertexBuffers(iface, 0, D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT,
+            state->vbs, state->vb_strides, state->vb_offsets);
+    ID3D11DeviceContext1_IASetIndexBuffer(iface, state->ib, state->ib_format, state->ib_offset);
+    ID3D11DeviceContext1_IASetPrimitiveTopology(iface, state->topology);
+
+    ID3D11DeviceContext1_OMSetRenderTargetsAndUnorderedAccessViews(iface,
+            D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, state->rtvs, state->dsv,
+            0, D3D11_PS_CS_UAV_REGISTER_COUNT, state->ps_uavs, NULL);
+    ID3D11DeviceContext1_OMSetBlendState(iface, state->blend_state, state->blend_factor, state->sample_mask);
+    ID3D11DeviceContext1_OMSetDepthStencilState(iface, state->depth_stencil_state, state->stencil_ref);
+
+    ID3D11DeviceContext1_RSSetState(iface, state->rasterizer_state);
+    ID3D11DeviceContext1_RSSetViewports(iface, state->viewport_count, state->viewports);
+    ID3D11DeviceContext1_RSSetScissorRects(iface, state->scissor_rect_count, state->scissor_rects);
+    /* The stream output offsets are not queryable, append to the buffers. */
+    ID3D11DeviceContext1_SOSetTargets(iface, D3D11_SO_BUFFER_SLOT_COUNT, state->so_targets, so_offsets);
+
+    ID3D11DeviceContext1_SetPredication(iface, state->predicate, state->predicate_value);
+}
+
+static void exec_map_discard(ID3D11DeviceContext1 *iface, struct deferred_call *call)
+{
+    D3D11_MAPPED_SUBRESOURCE map_desc;
+    const BYTE *src;
+    unsigned int y, z;
+    BYTE *dst;
+    HRESULT hr;
+
+    if (FAILED(hr = ID3D11DeviceContext1_Map(iface, call->u.update.resource, call->u.update.subresource_idx,
+            D3D11_MAP_WRITE_DISCARD, 0, &map_desc)))
+    {
+        ERR("Failed to map resource %p, hr %#x.\n", call->u.update.resource, hr);
+        return;
+    }
+
+    for (z = 0; z < call->u.update.depth; ++z)
+    {
+        src = (const BYTE *)call->u.update.data + z * call->u.update.depth_pitch;
+        dst = (BYTE *)map_desc.pData + z * map_desc.DepthPitch;
+        for (y = 0; y < call->u.update.row_count; ++y)
+        {
+            memcpy(dst, src, call->u.update.row_size);
+            src += call->u.update.row_pitch;
+            dst += map_desc.RowPitch;
+        }
+    }
+
+    ID3D11DeviceContext1_Unmap(iface, call->u.update.resource, call->u.update.subresource_idx);
+}
+
+static void exec_deferred_calls(ID3D11DeviceContext1 *iface, struct list *commands)
+{
+    struct deferred_call *call;
+
+    LIST_FOR_EACH_ENTRY(call, commands, struct deferred_call, entry)
+    {
+        switch (call->type)
+        {
+            case DEFERRED_SET_SHADER:
+                exec_set_shader(iface, call->u.shader.type, call->u.shader.shader);
+                break;
+
+            case DEFERRED_SET_CONSTANT_BUFFERS:
+                exec_set_constant_buffers(iface, call->u.objects.type, call->u.objects.start_slot,
+                        call->u.objects.count, (ID3D11Buffer *const *)call->u.objects.objects,
+                        call->u.objects.first_constants, call->u.objects.num_constants);
+                break;
+
+            case DEFERRED_SET_SHADER_RESOURCES:
+                exec_set_shader_resources(iface, call->u.objects.type, call->u.objects.start_slot,
+                        call->u.objects.count, (ID3D11ShaderResourceView *const *)call->u.objects.objects);
+                break;
+
+            case DEFERRED_SET_SAMPLERS:
+                exec_set_samplers(iface, call->u.objects.type, call->u.objects.start_slot,
+                        call->u.objects.count, (ID3D11SamplerState *const *)call->u.objects.objects);
+                break;
+
+            case DEFERRED_CS_SET_UNORDERED_ACCESS_VIEWS:
+                ID3D11DeviceContext1_CSSetUnorderedAccessViews(iface, call->u.objects.start_slot,
+                        call->u.objects.count, (ID3D11UnorderedAccessView *const *)call->u.objects.objects,
+                        call->u.objects.initial_counts);
+                break;
+
+            case DEFERRED_IA_SET_INPUT_LAYOUT:
+                ID3D11DeviceContext1_IASetInputLayout(iface, (ID3D11InputLayout *)call->u.object);
+                break;
+
+            case DEFERRED_IA_SET_VERTEX_BUFFERS:
+                ID3D11DeviceContext1_IASetVertexBuffers(iface, call->u.vertex_buffers.start_slot,
+                        call->u.vertex_buffers.count, call->u.vertex_buffers.buffers,
+                        call->u.vertex_buffers.strides, call->u.vertex_buffers.offsets);
+                break;
+
+            case DEFERRED_IA_SET_INDEX_BUFFER:
+                ID3D11DeviceContext1_IASetIndexBuffer(iface, call->u.index_buffer.buffer,
+                        call->u.index_buffer.format, call->u.index_buffer.offset);
+                break;
+
+            case DEFERRED_IA_SET_PRIMITIVE_TOPOLOGY:
+                ID3D11DeviceContext1_IASetPrimitiveTopology(iface, call->u.topology);
+                break;
+
+            case DEFERRED_OM_SET_RENDER_TARGETS_AND_UAVS:
+                ID3D11DeviceContext1_OMSetRenderTargetsAndUnorderedAccessViews(iface,
+                        call->u.render_targets.rtv_count, call->u.render_targets.rtvs,
+                        call->u.render_targets.dsv, call->u.render_targets.uav_start_slot,
+                        call->u.render_targets.uav_count, call->u.render_targets.uavs,
+                        call->u.render_targets.initial_counts);
+                break;
+
+            case DEFERRED_OM_SET_BLEND_STATE:
+                ID3D11DeviceContext1_OMSetBlendState(iface, call->u.blend_state.state,
+                        call->u.blend_state.has_factor ? call->u.blend_state.factor : NULL,
+                        call->u.blend_state.sample_mask);
+                break;
+
+            case DEFERRED_OM_SET_DEPTH_STENCIL_STATE:
+                ID3D11DeviceContext1_OMSetDepthStencilState(iface, call->u.depth_stencil_state.state,
+                        call->u.depth_stencil_state.stencil_ref);
+                break;
+
+            case DEFERRED_SO_SET_TARGETS:
+                ID3D11DeviceContext1_SOSetTargets(iface, call->u.so_targets.count,
+                        call->u.so_targets.buffers, call->u.so_targets.offsets);
+                break;
+
+            case DEFERRED_RS_SET_STATE:
+                ID3D11DeviceContext1_RSSetState(iface, (ID3D11RasterizerState *)call->u.object);
+                break;
+
+            case DEFERRED_RS_SET_VIEWPORTS:
+                ID3D11DeviceContext1_RSSetViewports(iface, call->u.viewports.count, call->u.viewports.viewports);
+                break;
+
+            case DEFERRED_RS_SET_SCISSOR_RECTS:
+                ID3D11DeviceContext1_RSSetScissorRects(iface, call->u.scissor_rects.count,
+                        call->u.scissor_rects.rects);
+                break;
+
+            case DEFERRED_DRAW:
+                ID3D11DeviceContext1_Draw(iface, call->u.draw.count, call->u.draw.start);
+                break;
+
+            case DEFERRED_DRAW_INDEXED:
+                ID3D11DeviceContext1_DrawIndexed(iface, call->u.draw.count, call->u.draw.start,
+                        call->u.draw.base_vertex);
+                break;
+
+            case DEFERRED_DRAW_INSTANCED:
+                ID3D11DeviceContext1_DrawInstanced(iface, call->u.draw.count, call->u.draw.instance_count,
+                        call->u.draw.start, call->u.draw.start_instance);
+                break;
+
+            case DEFERRED_DRAW_INDEXED_INSTANCED:
+                ID3D11DeviceContext1_DrawIndexedInstanced(iface, call->u.draw.count,
+                        call->u.draw.instance_count, call->u.draw.start, call->u.draw.base_vertex,
+                        call->u.draw.start_instance);
+                break;
+
+            case DEFERRED_DRAW_AUTO:
+                ID3D11DeviceContext1_DrawAuto(iface);
+                break;
+
+            case DEFERRED_DRAW_INSTANCED_INDIRECT:
+                ID3D11DeviceContext1_DrawInstancedIndirect(iface, call->u.indirect.buffer,
+                        call->u.indirect.offset);
+                break;
+
+            case DEFERRED_DRAW_INDEXED_INSTANCED_INDIRECT:
+                ID3D11DeviceContext1_DrawIndexedInstancedIndirect(iface, call->u.indirect.buffer,
+                        call->u.indirect.offset);
+                break;
+
+            case DEFERRED_DISPATCH:
+                ID3D11DeviceContext1_Dispatch(iface, call->u.dispatch.x, call->u.dispatch.y, call->u.dispatch.z);
+                break;
+
+            case DEFERRED_DISPATCH_INDIRECT:
+                ID3D11DeviceContext1_DispatchIndirect(iface, call->u.indirect.buffer, call->u.indirect.offset);
+                break;
+
+            case DEFERRED_BEGIN:
+                ID3D11DeviceContext1_Begin(iface, (ID3D11Asynchronous *)call->u.object);
+                break;
+
+            case DEFERRED_END:
+                ID3D11DeviceContext1_End(iface, (ID3D11Asynchronous *)call->u.object);
+                break;
+
+            case DEFERRED_SET_PREDICATION:
+                ID3D11DeviceContext1_SetPredication(iface, call->u.predication.predicate,
+                        call->u.predication.value);
+                break;
+
+            case DEFERRED_COPY_SUBRESOURCE_REGION:
+                ID3D11DeviceContext1_CopySubresourceRegion(iface, call->u.copy_region.dst_resource,
+                        call->u.copy_region.dst_subresource_idx, call->u.copy_region.dst_x,
+                        call->u.copy_region.dst_y, call->u.copy_region.dst_z,
+                        call->u.copy_region.src_resource, call->u.copy_region.src_subresource_idx,
+                        call->u.copy_region.has_box ? &call->u.copy_region.src_box : NULL);
+                break;
+
+            case DEFERRED_COPY_RESOURCE:
+                ID3D11DeviceContext1_CopyResource(iface, call->u.copy_resource.dst_resource,
+                        call->u.copy_resource.src_resource);
+                break;
+
+            case DEFERRED_UPDATE_SUBRESOURCE:
+                ID3D11DeviceContext1_UpdateSubresource(iface, call->u.update.resource,
+                        call->u.update.subresource_idx, call->u.update.has_box ? &call->u.update.box : NULL,
+                        call->u.update.data, call->u.update.row_pitch, call->u.update.depth_pitch);
+                break;
+
+            case DEFERRED_MAP_DISCARD:
+                exec_map_discard(iface, call);
+                break;
+
+            case DEFERRED_MAP_NO_OVERWRITE:
+                /* Only used for pending maps, the data is uploaded by the
+                 * D3D11_MAP_WRITE_DISCARD map it was appended to. */
+                break;
+
+            case DEFERRED_COPY_STRUCTURE_COUNT:
+                ID3D11DeviceContext1_CopyStructureCount(iface, call->u.structure_count.dst_buffer,
+                        call->u.structure_count.dst_offset, call->u.structure_count.src_view);
+                break;
+
+            case DEFERRED_CLEAR_RENDER_TARGET_VIEW:
+                ID3D11DeviceContext1_ClearRenderTargetView(iface,
+                        (ID3D11RenderTargetView *)call->u.clear_view.view, call->u.clear_view.values.f);
+                break;
+
+            case DEFERRED_CLEAR_UNORDERED_ACCESS_VIEW_UINT:
+                ID3D11DeviceContext1_ClearUnorderedAccessViewUint(iface,
+                        (ID3D11UnorderedAccessView *)call->u.clear_view.view, call->u.clear_view.values.u);
+                break;
+
+            case DEFERRED_CLEAR_UNORDERED_ACCESS_VIEW_FLOAT:
+                ID3D11DeviceContext1_ClearUnorderedAccessViewFloat(iface,
+                        (ID3D11UnorderedAccessView *)call->u.clear_view.view, call->u.clear_view.values.f);
+                break;
+
+            case DEFERRED_CLEAR_DEPTH_STENCIL_VIEW:
+                ID3D11DeviceContext1_ClearDepthStencilView(iface, call->u.clear_depth_stencil.view,
+                        call->u.clear_depth_stencil.flags, call->u.clear_depth_stencil.depth,
+                        call->u.clear_depth_stencil.stencil);
+                break;
+
+            case DEFERRED_GENERATE_MIPS:
+                ID3D11DeviceContext1_GenerateMips(iface, (ID3D11ShaderResourceView *)call->u.object);
+                break;
+
+            case DEFERRED_RESOLVE_SUBRESOURCE:
+                ID3D11DeviceContext1_ResolveSubresource(iface, call->u.resolve.dst_resource,
+                        call->u.resolve.dst_subresource_idx, call->u.resolve.src_resource,
+                        call->u.resolve.src_subresource_idx, call->u.resolve.format);
+                break;
+
+            case DEFERRED_EXECUTE_COMMAND_LIST:
+                ID3D11DeviceContext1_ExecuteCommandList(iface, call->u.execute.command_list,
+                        call->u.execute.restore_state);
+                break;
+
+            case DEFERRED_CLEAR_STATE:
+                ID3D11DeviceContext1_ClearState(iface);
+                break;
+
+            case DEFERRED_SET_STATE:
+                d3d11_context_state_apply(iface, call->u.state);
+                break;
+        }
+    }
+}
+
+/* ID3D11CommandList methods */
+
+static inline struct d3d11_command_list *impl_from_ID3D11CommandList(ID3D11CommandList *iface)
+{
+    return CONTAINING_RECORD(iface, struct d3d11_command_list, ID3D11CommandList_iface);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_command_list_QueryInterface(ID3D11CommandList *iface,
+        REFIID riid, void **out)
+{
+    TRACE("iface %p, riid %s, out %p.\n", iface, debugstr_guid(riid), out);
+
+    if (IsEqualGUID(riid, &IID_ID3D11CommandList)
+            || IsEqualGUID(riid, &IID_ID3D11DeviceChild)
+            || IsEqualGUID(riid, &IID_IUnknown))
+    {
+        ID3D11CommandList_AddRef(iface);
+        *out = iface;
+        return S_OK;
+    }
+
+    WARN("%s not implemented, returning E_NOINTERFACE.\n", debugstr_guid(riid));
+    *out = NULL;
+    return E_NOINTERFACE;
+}
+
+static ULONG STDMETHODCALLTYPE d3d11_command_list_AddRef(ID3D11CommandList *iface)
+{
+    struct d3d11_command_list *list = impl_from_ID3D11CommandList(iface);
+    ULONG refcount = InterlockedIncrement(&list->refcount);
+
+    TRACE("%p increasing refcount to %u.\n", list, refcount);
+
+    return refcount;
+}
+
+static ULONG STDMETHODCALLTYPE d3d11_command_list_Release(ID3D11CommandList *iface)
+{
+    struct d3d11_command_list *list = impl_from_ID3D11CommandList(iface);
+    ULONG refcount = InterlockedDecrement(&list->refcount);
+
+    TRACE("%p decreasing refcount to %u.\n", list, refcount);
+
+    if (!refcount)
+    {
+        free_deferred_calls(&list->commands);
+        wined3d_private_store_cleanup(&list->private_store);
+        ID3D11Device2_Release(list->device);
+        heap_free(list);
+    }
+
+    return refcount;
+}
+
+static void STDMETHODCALLTYPE d3d11_command_list_GetDevice(ID3D11CommandList *iface, ID3D11Device **device)
+{
+    struct d3d11_command_list *list = impl_from_ID3D11CommandList(iface);
+
+    TRACE("iface %p, device %p.\n", iface, device);
+
+    *device = (ID3D11Device *)list->device;
+    ID3D11Device_AddRef(*device);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_command_list_GetPrivateData(ID3D11CommandList *iface, REFGUID guid,
+        UINT *data_size, void *data)
+{
+    struct d3d11_command_list *list = impl_from_ID3D11CommandList(iface);
+
+    TRACE("iface %p, guid %s, data_size %p, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+
+    return d3d_get_private_data(&list->private_store, guid, data_size, data);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_command_list_SetPrivateData(ID3D11CommandList *iface, REFGUID guid,
+        UINT data_size, const void *data)
+{
+    struct d3d11_command_list *list = impl_from_ID3D11CommandList(iface);
+
+    TRACE("iface %p, guid %s, data_size %u, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+
+    return d3d_set_private_data(&list->private_store, guid, data_size, data);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_command_list_SetPrivateDataInterface(ID3D11CommandList *iface,
+        REFGUID guid, const IUnknown *data)
+{
+    struct d3d11_command_list *list = impl_from_ID3D11CommandList(iface);
+
+    TRACE("iface %p, guid %s, data %p.\n", iface, debugstr_guid(guid), data);
+
+    return d3d_set_private_data_interface(&list->private_store, guid, data);
+}
+
+static UINT STDMETHODCALLTYPE d3d11_command_list_GetContextFlags(ID3D11CommandList *iface)
+{
+    TRACE("iface %p.\n", iface);
+
+    return 0;
+}
+
+static const struct ID3D11CommandListVtbl d3d11_command_list_vtbl =
+{
+    /* IUnknown methods */
+    d3d11_command_list_QueryInterface,
+    d3d11_command_list_AddRef,
+    d3d11_command_list_Release,
+    /* ID3D11DeviceChild methods */
+    d3d11_command_list_GetDevice,
+    d3d11_command_list_GetPrivateData,
+    d3d11_command_list_SetPrivateData,
+    d3d11_command_list_SetPrivateDataInterface,
+    /* ID3D11CommandList methods */
+    d3d11_command_list_GetContextFlags,
+};
+
+struct d3d11_command_list *unsafe_impl_from_ID3D11CommandList(ID3D11CommandList *iface)
+{
+    if (!iface)
+        return NULL;
+    assert(iface->lpVtbl == &d3d11_command_list_vtbl);
+    return impl_from_ID3D11CommandList(iface);
+}
+
+void d3d11_command_list_execute(struct d3d11_command_list *list, ID3D11DeviceContext1 *context,
+        BOOL restore_state)
+{
+    struct d3d11_context_state *state = NULL;
+
+    if (restore_state && !(state = heap_alloc_zero(sizeof(*state))))
+        ERR("Failed to allocate context state, the state will not be restored.\n");
+
+    /* Recursive locking of the wined3d mutex is cheap, holding it for the
+     * whole list avoids bouncing it for every recorded call. */
+    wined3d_mutex_lock();
+    if (state)
+        d3d11_context_state_save(context, state);
+    /* Command lists never inherit state from the immediate context. */
+    ID3D11DeviceContext1_ClearState(context);
+    exec_deferred_calls(context, &list->commands);
+    ID3D11DeviceContext1_ClearState(context);
+    if (state)
+    {
+        d3d11_context_state_apply(context, state);
+        d3d11_context_state_cleanup(state);
+    }
+    wined3d_mutex_unlock();
+
+    heap_free(state);
+}
+
+struct deferred_discard_map
+{
+    struct wine_rb_entry entry;
+    ID3D11Resource *resource;
+    UINT subresource_idx;
+    struct deferred_call *call;
+};
+
+static int deferred_discard_map_compare(const void *key, const struct wine_rb_entry *entry)
+{
+    const struct deferred_discard_map *map = WINE_RB_ENTRY_VALUE(entry, const struct deferred_discard_map, entry);
+    const struct deferred_discard_map *k = key;
+
+    if (k->resource != map->resource)
+        return k->resource < map->resource ? -1 : 1;
+    if (k->subresource_idx != map->subresource_idx)
+        return k->subresource_idx < map->subresource_idx ? -1 : 1;
+    return 0;
+}
+
+static void deferred_discard_map_destroy(struct wine_rb_entry *entry, void *context)
+{
+    heap_free(WINE_RB_ENTRY_VALUE(entry, struct deferred_discard_map, entry));
+}
+
+static struct deferred_call *deferred_context_get_discard_map(struct d3d11_deferred_context *context,
+        ID3D11Resource *resource, UINT subresource_idx)
+{
+    struct deferred_discard_map key;
+    struct wine_rb_entry *entry;
+
+    key.resource = resource;
+    key.subresource_idx = subresource_idx;
+    if (!(entry = wine_rb_get(&context->discard_maps, &key)))
+        return NULL;
+    return WINE_RB_ENTRY_VALUE(entry, struct deferred_discard_map, entry)->call;
+}
+
+static void deferred_context_set_discard_map(struct d3d11_deferred_context *context, struct deferred_call *call)
+{
+    struct deferred_discard_map *map, key;
+    struct wine_rb_entry *entry;
+
+    key.resource = call->u.update.resource;
+    key.subresource_idx = call->u.update.subresource_idx;
+    if ((entry = wine_rb_get(&context->discard_maps, &key)))
+    {
+        WINE_RB_ENTRY_VALUE(entry, struct deferred_discard_map, entry)->call = call;
+        return;
+    }
+
+    if (!(map = heap_alloc(sizeof(*map))))
+    {
+        ERR("Failed to allocate discard map entry.\n");
+        return;
+    }
+    map->resource = key.resource;
+    map->subresource_idx = key.subresource_idx;
+    map->call = call;
+    wine_rb_put(&context->discard_maps, &key, &map->entry);
+}
+
+static HRESULT d3d11_command_list_create(struct d3d11_deferred_context *context,
+        struct d3d11_command_list **command_list)
+{
+    struct d3d11_command_list *object;
+
+    if (!(object = heap_alloc_zero(sizeof(*object))))
+        return E_OUTOFMEMORY;
+
+    object->ID3D11CommandList_iface.lpVtbl = &d3d11_command_list_vtbl;
+    object->refcount = 1;
+    wined3d_private_store_init(&object->private_store);
+    object->device = &context->device->ID3D11Device2_iface;
+    ID3D11Device2_AddRef(object->device);
+    list_init(&object->commands);
+    list_move_tail(&object->commands, &context->commands);
+    wine_rb_clear(&context->discard_maps, deferred_discard_map_destroy, NULL);
+
+    TRACE("Created command list %p.\n", object);
+    *command_list = object;
+
+    return S_OK;
+}
+
+/* ID3D11DeviceContext - deferred context methods */
+
+static inline struct d3d11_deferred_context *impl_from_ID3D11DeviceContext1(ID3D11DeviceContext1 *iface)
+{
+    return CONTAINING_RECORD(iface, struct d3d11_deferred_context, ID3D11DeviceContext1_iface);
+}
+
+/* Returns the state slots set by "call_type" calls for shader "type". */
+static IUnknown **d3d11_context_state_get_slots(struct d3d11_context_state *state,
+        enum deferred_call_type call_type, enum wined3d_shader_type type, UINT *slot_count)
+{
+    switch (call_type)
+    {
+        case DEFERRED_SET_CONSTANT_BUFFERS:
+            *slot_count = ARRAY_SIZE(state->cbs[type]);
+            return (IUnknown **)state->cbs[type];
+
+        case DEFERRED_SET_SHADER_RESOURCES:
+            *slot_count = ARRAY_SIZE(state->srvs[type]);
+            return (IUnknown **)state->srvs[type];
+
+        case DEFERRED_SET_SAMPLERS:
+            *slot_count = ARRAY_SIZE(state->samplers[type]);
+            return (IUnknown **)state->samplers[type];
+
+        case DEFERRED_CS_SET_UNORDERED_ACCESS_VIEWS:
+            *slot_count = ARRAY_SIZE(state->cs_uavs);
+            return (IUnknown **)state->cs_uavs;
+
+        default:
+            ERR("Unhandled call type %#x.\n", call_type);
+            *slot_count = 0;
+            return NULL;
+    }
+}
+
+static void deferred_context_set_slots(struct d3d11_deferred_context *context,
+        enum deferred_call_type call_type, enum wined3d_shader_type type, UINT start_slot,
+        UINT count, void *const *objects)
+{
+    IUnknown **slots;
+    UINT slot_count;
+
+    slots = d3d11_context_state_get_slots(&context->state, call_type, type, &slot_count);
+    if (start_slot >= slot_count)
+        return;
+    replace_objects(&slots[start_slot], (IUnknown *const *)objects, min(count, slot_count - start_slot));
+}
+
+static void deferred_context_get_slots(struct d3d11_deferred_context *context,
+        enum deferred_call_type call_type, enum wined3d_shader_type type, UINT start_slot,
+        UINT count, void **objects)
+{
+    unsigned int i;
+    IUnknown **slots;
+    UINT slot_count;
+
+    slots = d3d11_context_state_get_slots(&context->state, call_type, type, &slot_count);
+    for (i = 0; i < count; ++i)
+    {
+        objects[i] = start_slot + i < slot_count ? slots[start_slot + i] : NULL;
+        add_object_ref(objects[i]);
+    }
+}
+
+static void deferred_context_get_shader(struct d3d11_deferred_context *context,
+        enum wined3d_shader_type type, void **shader, UINT *class_instance_count)
+{
+    if (class_instance_count)
+        *class_instance_count = 0;
+
+    *shader = context->state.shaders[type];
+    add_object_ref(*shader);
+}
+
+static void deferred_context_set_shader(struct d3d11_deferred_context *context,
+        enum wined3d_shader_type type, void *shader, UINT class_instance_count)
+{
+    struct deferred_call *call;
+
+    if (class_instance_count)
+        FIXME("Dynamic linking is not implemented yet.\n");
+
+    replace_object(&context->state.shaders[type], shader);
+
+    if (!(call = add_deferred_call(&context->commands, DEFERRED_SET_SHADER, 0)))
+        return;
+    call->u.shader.type = type;
+    call->u.shader.shader = shader;
+    add_object_ref(shader);
+}
+
+static void deferred_context_set_objects(struct d3d11_deferred_context *context,
+        enum deferred_call_type call_type, enum wined3d_shader_type type, UINT start_slot,
+        UINT count, void *const *objects)
+{
+    struct deferred_call *call;
+
+    deferred_context_set_slots(context, call_type, type, start_slot, count, objects);
+
+    if (!(call = add_deferred_call(&context->commands, call_type, count * sizeof(*call->u.objects.objects))))
+        return;
+    call->u.objects.type = type;
+    call->u.objects.start_slot = start_slot;
+    call->u.objects.count = count;
+    call->u.objects.objects = deferred_call_data(call);
+    copy_objects(call->u.objects.objects, (IUnknown *const *)objects, count);
+}
+
+static void deferred_context_set_constant_buffers(struct d3d11_deferred_context *context,
+        enum wined3d_shader_type type, UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers,
+        const UINT *first_constant, const UINT *num_constants)
+{
+    struct d3d11_context_state *state = &context->state;
+    struct deferred_call *call;
+    unsigned int i, slot;
+    SIZE_T size;
+
+    if (!d3d11_validate_constant_buffer_ranges(buffer_count, first_constant, num_constants))
+        return;
+
+    deferred_context_set_slots(context, DEFERRED_SET_CONSTANT_BUFFERS, type,
+            start_slot, buffer_count, (void *const *)buffers);
+    for (i = 0; i < buffer_count && (slot = start_slot + i) < ARRAY_SIZE(state->cbs[type]); ++i)
+    {
+        if (!buffers[i])
+        {
+            state->cb_first_constants[type][slot] = state->cb_num_constants[type][slot] = 0;
+            continue;
+        }
+        state->cb_first_constants[type][slot] = first_constant ? first_constant[i] : 0;
+        state->cb_num_constants[type][slot] = num_constants
+                ? num_constants[i] : D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT;
+    }
+
+    size = buffer_count * sizeof(*call->u.objects.objects);
+    if (first_constant)
+        size += 2 * buffer_count * sizeof(*first_constant);
+    if (!(call = add_deferred_call(&context->commands, DEFERRED_SET_CONSTANT_BUFFERS, size)))
+        return;
+    call->u.objects.type = type;
+    call->u.objects.start_slot = start_slot;
+    call->u.objects.count = buffer_count;
+    call->u.objects.objects = deferred_call_data(call);
+    copy_objects(call->u.objects.objects, (IUnknown *const *)buffers, buffer_count);
+    if (first_constant)
+    {
+        call->u.objects.first_constants = (UINT *)&call->u.objects.objects[buffer_count];
+        call->u.objects.num_constants = &call->u.objects.first_constants[buffer_count];
+        memcpy(call->u.objects.first_constants, first_constant, buffer_count * sizeof(*first_constant));
+        memcpy(call->u.objects.num_constants, num_constants, buffer_count * sizeof(*num_constants));
+    }
+}
+
+static void deferred_context_get_constant_buffers(struct d3d11_deferred_context *context,
+        enum wined3d_shader_type type, UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers,
+        UINT *first_constant, UINT *num_constants)
+{
+    struct d3d11_context_state *state = &context->state;
+    unsigned int i, slot;
+
+    if (buffers)
+        deferred_context_get_slots(context, DEFERRED_SET_CONSTANT_BUFFERS, type,
+                start_slot, buffer_count, (void **)buffers);
+    for (i = 0; i < buffer_count; ++i)
+    {
+        slot = start_slot + i;
+        if (first_constant)
+            first_constant[i] = slot < ARRAY_SIZE(state->cbs[type]) ? state->cb_first_constants[type][slot] : 0;
+        if (num_constants)
+            num_constants[i] = slot < ARRAY_SIZE(state->cbs[type]) ? state->cb_num_constants[type][slot] : 0;
+    }
+}
+
+static void deferred_context_set_object(struct d3d11_deferred_context *context,
+        enum deferred_call_type call_type, void *object)
+{
+    struct deferred_call *call;
+
+    if (!(call = add_deferred_call(&context->commands, call_type, 0)))
+        return;
+    call->u.object = object;
+    add_object_ref(object);
+}
+
+static void deferred_context_draw(struct d3d11_deferred_context *context, enum deferred_call_type call_type,
+        UINT count, UINT instance_count, UINT start, INT base_vertex, UINT start_instance)
+{
+    struct deferred_call *call;
+
+    if (!(call = add_deferred_call(&context->commands, call_type, 0)))
+        return;
+    call->u.draw.count = count;
+    call->u.draw.instance_count = instance_count;
+    call->u.draw.start = start;
+    call->u.draw.base_vertex = base_vertex;
+    call->u.draw.start_instance = start_instance;
+}
+
+static void deferred_context_indirect(struct d3d11_deferred_context *context, enum deferred_call_type call_type,
+        ID3D11Buffer *buffer, UINT offset)
+{
+    struct deferred_call *call;
+
+    if (!(call = add_deferred_call(&context->commands, call_type, 0)))
+        return;
+    call->u.indirect.buffer = buffer;
+    call->u.indirect.offset = offset;
+    add_object_ref(buffer);
+}
+
+static void deferred_context_clear_view(struct d3d11_deferred_context *context, enum deferred_call_type call_type,
+        ID3D11View *view, const void *values)
+{
+    struct deferred_call *call;
+
+    if (!(call = add_deferred_call(&context->commands, call_type, 0)))
+        return;
+    call->u.clear_view.view = view;
+    memcpy(&call->u.clear_view.values, values, sizeof(call->u.clear_view.values));
+    add_object_ref(view);
+}
+
+/* Returns the number of bytes per row, the number of rows and the number of
+ * slices covered by "box" (or the whole sub-resource) of "resource". */
+static BOOL deferred_context_get_sub_resource_layout(struct d3d11_deferred_context *context,
+        ID3D11Resource *resource, UINT subresource_idx, const D3D11_BOX *box,
+        UINT *row_size, UINT *row_count, UINT *depth)
+{
+    struct wined3d_device_creation_parameters params;
+    struct wined3d_sub_resource_desc desc;
+    D3D11_RESOURCE_DIMENSION dimension;
+    struct wined3d_texture *texture;
+    unsigned int width, height;
+    HRESULT hr;
+
+    ID3D11Resource_GetType(resource, &dimension);
+    if (dimension == D3D11_RESOURCE_DIMENSION_BUFFER)
+    {
+        D3D11_BUFFER_DESC buffer_desc;
+
+        ID3D11Buffer_GetDesc((ID3D11Buffer *)resource, &buffer_desc);
+        *row_size = box ? box->right - box->left : buffer_desc.ByteWidth;
+        *row_count = 1;
+        *depth = 1;
+        return TRUE;
+    }
+
+    wined3d_mutex_lock();
+    texture = wined3d_texture_from_resource(wined3d_resource_from_d3d11_resource(resource));
+    if (FAILED(hr = wined3d_texture_get_sub_resource_desc(texture, subresource_idx, &desc)))
+    {
+        wined3d_mutex_unlock();
+        WARN("Invalid sub-resource index %u.\n", subresource_idx);
+        return FALSE;
+    }
+    width = box ? box->right - box->left : desc.width;
+    height = box ? box->bottom - box->top : desc.height;
+    *depth = box ? box->back - box->front : desc.depth;
+    wined3d_device_get_creation_parameters(context->device->wined3d_device, &params);
+    *row_size = wined3d_calculate_format_pitch(wined3d_device_get_wined3d(context->device->wined3d_device),
+            params.adapter_idx, desc.format, width);
+    wined3d_mutex_unlock();
+
+    switch (desc.format)
+    {
+        case WINED3DFMT_BC1_UNORM:
+        case WINED3DFMT_BC1_UNORM_SRGB:
+        case WINED3DFMT_BC2_UNORM:
+        case WINED3DFMT_BC2_UNORM_SRGB:
+        case WINED3DFMT_BC3_UNORM:
+        case WINED3DFMT_BC3_UNORM_SRGB:
+        case WINED3DFMT_BC4_UNORM:
+        case WINED3DFMT_BC4_SNORM:
+        case WINED3DFMT_BC5_UNORM:
+        case WINED3DFMT_BC5_SNORM:
+        case WINED3DFMT_BC6H_UF16:
+        case WINED3DFMT_BC6H_SF16:
+        case WINED3DFMT_BC7_UNORM:
+        case WINED3DFMT_BC7_UNORM_SRGB:
+            *row_count = (height + 3) / 4;
+            break;
+
+        default:
+            *row_count = height;
+            break;
+    }
+
+    return TRUE;
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_QueryInterface(ID3D11DeviceContext1 *iface,
+        REFIID riid, void **out)
+{
+    TRACE("iface %p, riid %s, out %p.\n", iface, debugstr_guid(riid), out);
+
+    if (IsEqualGUID(riid, &IID_ID3D11DeviceContext1)
+            || IsEqualGUID(riid, &IID_ID3D11DeviceContext)
+            || IsEqualGUID(riid, &IID_ID3D11DeviceChild)
+            || IsEqualGUID(riid, &IID_IUnknown))
+    {
+        ID3D11DeviceContext1_AddRef(iface);
+        *out = iface;
+        return S_OK;
+    }
+
+    WARN("%s not implemented, returning E_NOINTERFACE.\n", debugstr_guid(riid));
+    *out = NULL;
+    return E_NOINTERFACE;
+}
+
+static ULONG STDMETHODCALLTYPE d3d11_deferred_context_AddRef(ID3D11DeviceContext1 *iface)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    ULONG refcount = InterlockedIncrement(&context->refcount);
+
+    TRACE("%p increasing refcount to %u.\n", context, refcount);
+
+    return refcount;
+}
+
+static ULONG STDMETHODCALLTYPE d3d11_deferred_context_Release(ID3D11DeviceContext1 *iface)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    ULONG refcount = InterlockedDecrement(&context->refcount);
+
+    TRACE("%p decreasing refcount to %u.\n", context, refcount);
+
+    if (!refcount)
+    {
+        free_deferred_calls(&context->maps);
+        wine_rb_destroy(&context->discard_maps, deferred_discard_map_destroy, NULL);
+        free_deferred_calls(&context->commands);
+        d3d11_context_state_cleanup(&context->state);
+        wined3d_private_store_cleanup(&context->private_store);
+        ID3D11Device2_Release(&context->device->ID3D11Device2_iface);
+        heap_free(context);
+    }
+
+    return refcount;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GetDevice(ID3D11DeviceContext1 *iface, ID3D11Device **device)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, device %p.\n", iface, device);
+
+    *device = (ID3D11Device *)&context->device->ID3D11Device2_iface;
+    ID3D11Device_AddRef(*device);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_GetPrivateData(ID3D11DeviceContext1 *iface, REFGUID guid,
+        UINT *data_size, void *data)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, guid %s, data_size %p, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+
+    return d3d_get_private_data(&context->private_store, guid, data_size, data);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_SetPrivateData(ID3D11DeviceContext1 *iface, REFGUID guid,
+        UINT data_size, const void *data)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, guid %s, data_size %u, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+
+    return d3d_set_private_data(&context->private_store, guid, data_size, data);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_SetPrivateDataInterface(ID3D11DeviceContext1 *iface,
+        REFGUID guid, const IUnknown *data)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, guid %s, data %p.\n", iface, debugstr_guid(guid), data);
+
+    return d3d_set_private_data_interface(&context->private_store, guid, data);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSSetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
+
+    deferred_context_set_constant_buffers(impl_from_ID3D11DeviceContext1(iface), WINED3D_SHADER_TYPE_VERTEX,
+            start_slot, buffer_count, buffers, NULL, NULL);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSSetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    deferred_context_set_objects(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_SHADER_RESOURCES,
+            WINED3D_SHADER_TYPE_PIXEL, start_slot, view_count, (void *const *)views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSSetShader(ID3D11DeviceContext1 *iface,
+        ID3D11PixelShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    deferred_context_set_shader(impl_from_ID3D11DeviceContext1(iface),
+            WINED3D_SHADER_TYPE_PIXEL, shader, class_instance_count);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSSetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    deferred_context_set_objects(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_SAMPLERS,
+            WINED3D_SHADER_TYPE_PIXEL, start_slot, sampler_count, (void *const *)samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSSetShader(ID3D11DeviceContext1 *iface,
+        ID3D11VertexShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    deferred_context_set_shader(impl_from_ID3D11DeviceContext1(iface),
+            WINED3D_SHADER_TYPE_VERTEX, shader, class_instance_count);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DrawIndexed(ID3D11DeviceContext1 *iface,
+        UINT index_count, UINT start_index_location, INT base_vertex_location)
+{
+    TRACE("iface %p, index_count %u, start_index_location %u, base_vertex_location %d.\n",
+            iface, index_count, start_index_location, base_vertex_location);
+
+    deferred_context_draw(impl_from_ID3D11DeviceContext1(iface), DEFERRED_DRAW_INDEXED,
+            index_count, 0, start_index_location, base_vertex_location, 0);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_Draw(ID3D11DeviceContext1 *iface,
+        UINT vertex_count, UINT start_vertex_location)
+{
+    TRACE("iface %p, vertex_count %u, start_vertex_location %u.\n",
+            iface, vertex_count, start_vertex_location);
+
+    deferred_context_draw(impl_from_ID3D11DeviceContext1(iface), DEFERRED_DRAW,
+            vertex_count, 0, start_vertex_location, 0, 0);
+}
+
+/* D3D11_MAP_WRITE_NO_OVERWRITE maps are only allowed after a
+ * D3D11_MAP_WRITE_DISCARD map of the same sub-resource in the same command
+ * list, and the application promises not to touch data that may be in use.
+ * The data is only uploaded when the command list is executed, so appending
+ * to the data of that map gives the same result. */
+static HRESULT deferred_context_map_no_overwrite(struct d3d11_deferred_context *context,
+        ID3D11Resource *resource, UINT subresource_idx, D3D11_MAPPED_SUBRESOURCE *mapped_subresource)
+{
+    struct deferred_call *call, *discard;
+
+    if (!(discard = deferred_context_get_discard_map(context, resource, subresource_idx)))
+    {
+        WARN("Resource %p, sub-resource %u was not mapped with D3D11_MAP_WRITE_DISCARD.\n",
+                resource, subresource_idx);
+        return E_INVALIDARG;
+    }
+
+    if (!(call = add_deferred_call(NULL, DEFERRED_MAP_NO_OVERWRITE, 0)))
+        return E_OUTOFMEMORY;
+    call->u.update = discard->u.update;
+    ID3D11Resource_AddRef(resource);
+    list_add_tail(&context->maps, &call->entry);
+
+    mapped_subresource->pData = call->u.update.data;
+    mapped_subresource->RowPitch = call->u.update.row_pitch;
+    mapped_subresource->DepthPitch = call->u.update.depth_pitch;
+
+    return S_OK;
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_Map(ID3D11DeviceContext1 *iface, ID3D11Resource *resource,
+        UINT subresource_idx, D3D11_MAP map_type, UINT map_flags, D3D11_MAPPED_SUBRESOURCE *mapped_subresource)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    UINT row_size, row_count, depth;
+    struct deferred_call *call;
+
+    TRACE("iface %p, resource %p, subresource_idx %u, map_type %u, map_flags %#x, mapped_subresource %p.\n",
+            iface, resource, subresource_idx, map_type, map_flags, mapped_subresource);
+
+    if (map_type == D3D11_MAP_WRITE_NO_OVERWRITE)
+        return deferred_context_map_no_overwrite(context, resource, subresource_idx, mapped_subresource);
+
+    if (map_type != D3D11_MAP_WRITE_DISCARD)
+    {
+        WARN("Invalid map type %#x.\n", map_type);
+        return E_INVALIDARG;
+    }
+
+    if (!deferred_context_get_sub_resource_layout(context, resource, subresource_idx, NULL,
+            &row_size, &row_count, &depth))
+        return E_INVALIDARG;
+
+    /* The data is recorded at Unmap() time, and uploaded through a
+     * D3D11_MAP_WRITE_DISCARD map when the command list is executed. */
+    if (!(call = add_deferred_call(NULL, DEFERRED_MAP_DISCARD, (SIZE_T)row_size * row_count * depth)))
+        return E_OUTOFMEMORY;
+    call->u.update.resource = resource;
+    ID3D11Resource_AddRef(resource);
+    call->u.update.subresource_idx = subresource_idx;
+    call->u.update.data = deferred_call_data(call);
+    call->u.update.row_pitch = row_size;
+    call->u.update.depth_pitch = row_size * row_count;
+    call->u.update.row_size = row_size;
+    call->u.update.row_count = row_count;
+    call->u.update.depth = depth;
+    list_add_tail(&context->maps, &call->entry);
+
+    mapped_subresource->pData = call->u.update.data;
+    mapped_subresource->RowPitch = call->u.update.row_pitch;
+    mapped_subresource->DepthPitch = call->u.update.depth_pitch;
+
+    return S_OK;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_Unmap(ID3D11DeviceContext1 *iface, ID3D11Resource *resource,
+        UINT subresource_idx)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    struct deferred_call *call;
+
+    TRACE("iface %p, resource %p, subresource_idx %u.\n", iface, resource, subresource_idx);
+
+    LIST_FOR_EACH_ENTRY(call, &context->maps, struct deferred_call, entry)
+    {
+        if (call->u.update.resource == resource && call->u.update.subresource_idx == subresource_idx)
+        {
+            list_remove(&call->entry);
+            if (call->type == DEFERRED_MAP_NO_OVERWRITE)
+                free_deferred_call(call);
+            else
+            {
+                list_add_tail(&context->commands, &call->entry);
+                deferred_context_set_discard_map(context, call);
+            }
+            return;
+        }
+    }
+
+    WARN("Resource %p, sub-resource %u is not mapped.\n", resource, subresource_idx);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSSetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
+
+    deferred_context_set_constant_buffers(impl_from_ID3D11DeviceContext1(iface), WINED3D_SHADER_TYPE_PIXEL,
+            start_slot, buffer_count, buffers, NULL, NULL);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IASetInputLayout(ID3D11DeviceContext1 *iface,
+        ID3D11InputLayout *input_layout)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, input_layout %p.\n", iface, input_layout);
+
+    replace_object(&context->state.input_layout, input_layout);
+    deferred_context_set_object(context, DEFERRED_IA_SET_INPUT_LAYOUT, input_layout);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IASetVertexBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers, const UINT *strides, const UINT *offsets)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    struct d3d11_context_state *state = &context->state;
+    struct deferred_call *call;
+    UINT count;
+
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p, strides %p, offsets %p.\n",
+            iface, start_slot, buffer_count, buffers, strides, offsets);
+
+    if (start_slot < ARRAY_SIZE(state->vbs))
+    {
+        count = min(buffer_count, ARRAY_SIZE(state->vbs) - start_slot);
+        replace_objects((IUnknown **)&state->vbs[start_slot], (IUnknown *const *)buffers, count);
+        memcpy(&state->vb_strides[start_slot], strides, count * sizeof(*strides));
+        memcpy(&state->vb_offsets[start_slot], offsets, count * sizeof(*offsets));
+    }
+
+    if (!(call = add_deferred_call(&context->commands, DEFERRED_IA_SET_VERTEX_BUFFERS,
+            buffer_count * (sizeof(*buffers) + sizeof(*strides) + sizeof(*offsets)))))
+        return;
+    call->u.vertex_buffers.start_slot = start_slot;
+    call->u.vertex_buffers.count = buffer_count;
+    call->u.vertex_buffers.buffers = deferred_call_data(call);
+    call->u.vertex_buffers.strides = (UINT *)&call->u.vertex_buffers.buffers[buffer_count];
+    call->u.vertex_buffers.offsets = &call->u.vertex_buffers.strides[buffer_count];
+    copy_objects((IUnknown **)call->u.vertex_buffers.buffers, (IUnknown *const *)buffers, buffer_count);
+    memcpy(call->u.vertex_buffers.strides, strides, buffer_count * sizeof(*strides));
+    memcpy(call->u.vertex_buffers.offsets, offsets, buffer_count * sizeof(*offsets));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IASetIndexBuffer(ID3D11DeviceContext1 *iface,
+        ID3D11Buffer *buffer, DXGI_FORMAT format, UINT offset)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    struct deferred_call *call;
+
+    TRACE("iface %p, buffer %p, format %s, offset %u.\n", iface, buffer, debug_dxgi_format(format), offset);
+
+    replace_object(&context->state.ib, buffer);
+    context->state.ib_format = format;
+    context->state.ib_offset = offset;
+
+    if (!(call = add_deferred_call(&context->commands, DEFERRED_IA_SET_INDEX_BUFFER, 0)))
+        return;
+    call->u.index_buffer.buffer = buffer;
+    call->u.index_buffer.format = format;
+    call->u.index_buffer.offset = offset;
+    add_object_ref(buffer);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DrawIndexedInstanced(ID3D11DeviceContext1 *iface,
+        UINT instance_index_count, UINT instance_count, UINT start_index_location, INT base_vertex_location,
+        UINT start_instance_location)
+{
+    TRACE("iface %p, instance_index_count %u, instance_count %u, start_index_location %u, "
+            "base_vertex_location %d, start_instance_location %u.\n",
+            iface, instance_index_count, instance_count, start_index_location,
+            base_vertex_location, start_instance_location);
+
+    deferred_context_draw(impl_from_ID3D11DeviceContext1(iface), DEFERRED_DRAW_INDEXED_INSTANCED,
+            instance_index_count, instance_count, start_index_location, base_vertex_location,
+            start_instance_location);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DrawInstanced(ID3D11DeviceContext1 *iface,
+        UINT instance_vertex_count, UINT instance_count, UINT start_vertex_location, UINT start_instance_location)
+{
+    TRACE("iface %p, instance_vertex_count %u, instance_count %u, start_vertex_location %u, "
+            "start_instance_location %u.\n",
+            iface, instance_vertex_count, instance_count, start_vertex_location,
+            start_instance_location);
+
+    deferred_context_draw(impl_from_ID3D11DeviceContext1(iface), DEFERRED_DRAW_INSTANCED,
+            instance_vertex_count, instance_count, start_vertex_location, 0, start_instance_location);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSSetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
+
+    deferred_context_set_constant_buffers(impl_from_ID3D11DeviceContext1(iface), WINED3D_SHADER_TYPE_GEOMETRY,
+            start_slot, buffer_count, buffers, NULL, NULL);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSSetShader(ID3D11DeviceContext1 *iface,
+        ID3D11GeometryShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    deferred_context_set_shader(impl_from_ID3D11DeviceContext1(iface),
+            WINED3D_SHADER_TYPE_GEOMETRY, shader, class_instance_count);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IASetPrimitiveTopology(ID3D11DeviceContext1 *iface,
+        D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    struct deferred_call *call;
+
+    TRACE("iface %p, topology %#x.\n", iface, topology);
+
+    context->state.topology = topology;
+
+    if (!(call = add_deferred_call(&context->commands, DEFERRED_IA_SET_PRIMITIVE_TOPOLOGY, 0)))
+        return;
+    call->u.topology = topology;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSSetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    deferred_context_set_objects(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_SHADER_RESOURCES,
+            WINED3D_SHADER_TYPE_VERTEX, start_slot, view_count, (void *const *)views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSSetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    deferred_context_set_objects(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_SAMPLERS,
+            WINED3D_SHADER_TYPE_VERTEX, start_slot, sampler_count, (void *const *)samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_Begin(ID3D11DeviceContext1 *iface,
+        ID3D11Asynchronous *asynchronous)
+{
+    TRACE("iface %p, asynchronous %p.\n", iface, asynchronous);
+
+    deferred_context_set_object(impl_from_ID3D11DeviceContext1(iface), DEFERRED_BEGIN, asynchronous);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_End(ID3D11DeviceContext1 *iface,
+        ID3D11Asynchronous *asynchronous)
+{
+    TRACE("iface %p, asynchronous %p.\n", iface, asynchronous);
+
+    deferred_context_set_object(impl_from_ID3D11DeviceContext1(iface), DEFERRED_END, asynchronous);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_GetData(ID3D11DeviceContext1 *iface,
+        ID3D11Asynchronous *asynchronous, void *data, UINT data_size, UINT data_flags)
+{
+    WARN("iface %p, asynchronous %p, data %p, data_size %u, data_flags %#x, "
+            "not supported on deferred contexts.\n",
+            iface, asynchronous, data, data_size, data_flags);
+
+    return DXGI_ERROR_INVALID_CALL;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_SetPredication(ID3D11DeviceContext1 *iface,
+        ID3D11Predicate *predicate, BOOL value)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    struct deferred_call *call;
+
+    TRACE("iface %p, predicate %p, value %#x.\n", iface, predicate, value);
+
+    replace_object(&context->state.predicate, predicate);
+    context->state.predicate_value = value;
+
+    if (!(call = add_deferred_call(&context->commands, DEFERRED_SET_PREDICATION, 0)))
+        return;
+    call->u.predication.predicate = predicate;
+    call->u.predication.value = value;
+    add_object_ref(predicate);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSSetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    deferred_context_set_objects(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_SHADER_RESOURCES,
+            WINED3D_SHADER_TYPE_GEOMETRY, start_slot, view_count, (void *const *)views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSSetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    deferred_context_set_objects(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_SAMPLERS,
+            WINED3D_SHADER_TYPE_GEOMETRY, start_slot, sampler_count, (void *const *)samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMSetRenderTargetsAndUnorderedAccessViews(
+        ID3D11DeviceContext1 *iface, UINT render_target_view_count,
+        ID3D11RenderTargetView *const *render_target_views, ID3D11DepthStencilView *depth_stencil_view,
+        UINT unordered_access_view_start_slot, UINT unordered_access_view_count,
+        ID3D11UnorderedAccessView *const *unordered_access_views, const UINT *initial_counts)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    struct d3d11_context_state *state = &context->state;
+    UINT rtv_count = 0, uav_count = 0, start, count;
+    struct deferred_call *call;
+    SIZE_T size;
+
+    TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p, "
+            "unordered_access_view_start_slot %u, unordered_access_view_count %u, unordered_access_views %p, "
+            "initial_counts %p.\n",
+            iface, render_target_view_count, render_target_views, depth_stencil_view,
+            unordered_access_view_start_slot, unordered_access_view_count, unordered_access_views,
+            initial_counts);
+
+    if (render_target_view_count != D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL)
+    {
+        rtv_count = render_target_view_count;
+        count = min(rtv_count, ARRAY_SIZE(state->rtvs));
+        replace_objects((IUnknown **)state->rtvs, (IUnknown *const *)render_target_views, count);
+        replace_objects((IUnknown **)&state->rtvs[count], NULL, ARRAY_SIZE(state->rtvs) - count);
+        replace_object(&state->dsv, depth_stencil_view);
+    }
+    if (unordered_access_view_count != D3D11_KEEP_UNORDERED_ACCESS_VIEWS)
+    {
+        uav_count = unordered_access_view_count;
+        start = min(unordered_access_view_start_slot, ARRAY_SIZE(state->ps_uavs));
+        count = min(uav_count, ARRAY_SIZE(state->ps_uavs) - start);
+        replace_objects((IUnknown **)state->ps_uavs, NULL, start);
+        replace_objects((IUnknown **)&state->ps_uavs[start], (IUnknown *const *)unordered_access_views, count);
+        replace_objects((IUnknown **)&state->ps_uavs[start + count], NULL,
+                ARRAY_SIZE(state->ps_uavs) - start - count);
+    }
+
+    size = rtv_count * sizeof(*render_target_views) + uav_count * sizeof(*unordered_access_views);
+    if (initial_counts)
+        size += uav_count * sizeof(*initial_counts);
+    if (!(call = add_deferred_call(&context->commands, DEFERRED_OM_SET_RENDER_TARGETS_AND_UAVS, size)))
+        return;
+
+    call->u.render_targets.rtv_count = render_target_view_count;
+    call->u.render_targets.rtvs = deferred_call_data(call);
+    call->u.render_targets.uav_start_slot = unordered_access_view_start_slot;
+    call->u.render_targets.uav_count = unordered_access_view_count;
+    call->u.render_targets.uavs = (ID3D11UnorderedAccessView **)&call->u.render_targets.rtvs[rtv_count];
+    if (render_target_view_count != D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL)
+    {
+        copy_objects((IUnknown **)call->u.render_targets.rtvs, (IUnknown *const *)render_target_views, rtv_count);
+        call->u.render_targets.dsv = depth_stencil_view;
+        add_object_ref(depth_stencil_view);
+    }
+    if (unordered_access_view_count != D3D11_KEEP_UNORDERED_ACCESS_VIEWS)
+    {
+        copy_objects((IUnknown **)call->u.render_targets.uavs, (IUnknown *const *)unordered_access_views,
+                uav_count);
+        if (initial_counts)
+        {
+            call->u.render_targets.initial_counts = (UINT *)&call->u.render_targets.uavs[uav_count];
+            memcpy(call->u.render_targets.initial_counts, initial_counts, uav_count * sizeof(*initial_counts));
+        }
+    }
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMSetRenderTargets(ID3D11DeviceContext1 *iface,
+        UINT render_target_view_count, ID3D11RenderTargetView *const *render_target_views,
+        ID3D11DepthStencilView *depth_stencil_view)
+{
+    TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p.\n",
+            iface, render_target_view_count, render_target_views, depth_stencil_view);
+
+    d3d11_deferred_context_OMSetRenderTargetsAndUnorderedAccessViews(iface, render_target_view_count,
+            render_target_views, depth_stencil_view, 0, D3D11_KEEP_UNORDERED_ACCESS_VIEWS, NULL, NULL);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMSetBlendState(ID3D11DeviceContext1 *iface,
+        ID3D11BlendState *blend_state, const float blend_factor[4], UINT sample_mask)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    struct deferred_call *call;
+
+    TRACE("iface %p, blend_state %p, blend_factor %s, sample_mask 0x%08x.\n",
+            iface, blend_state, debug_float4(blend_factor), sample_mask);
+
+    replace_object(&context->state.blend_state, blend_state);
+    if (blend_factor)
+        memcpy(context->state.blend_factor, blend_factor, sizeof(context->state.blend_factor));
+    else
+        context->state.blend_factor[0] = context->state.blend_factor[1]
+                = context->state.blend_factor[2] = context->state.blend_factor[3] = 1.0f;
+    context->state.sample_mask = sample_mask;
+
+    if (!(call = add_deferred_call(&context->commands, DEFERRED_OM_SET_BLEND_STATE, 0)))
+        return;
+    call->u.blend_state.state = blend_state;
+    if ((call->u.blend_state.has_factor = !!blend_factor))
+        memcpy(call->u.blend_state.factor, blend_factor, sizeof(call->u.blend_state.factor));
+    call->u.blend_state.sample_mask = sample_mask;
+    add_object_ref(blend_state);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMSetDepthStencilState(ID3D11DeviceContext1 *iface,
+        ID3D11DepthStencilState *depth_stencil_state, UINT stencil_ref)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    struct deferred_call *call;
+
+    TRACE("iface %p, depth_stencil_state %p, stencil_ref %u.\n",
+            iface, depth_stencil_state, stencil_ref);
+
+    replace_object(&context->state.depth_stencil_state, depth_stencil_state);
+    context->state.stencil_ref = stencil_ref;
+
+    if (!(call = add_deferred_call(&context->commands, DEFERRED_OM_SET_DEPTH_STENCIL_STATE, 0)))
+        return;
+    call->u.depth_stencil_state.state = depth_stencil_state;
+    call->u.depth_stencil_state.stencil_ref = stencil_ref;
+    add_object_ref(depth_stencil_state);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_SOSetTargets(ID3D11DeviceContext1 *iface, UINT buffer_count,
+        ID3D11Buffer *const *buffers, const UINT *offsets)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    struct d3d11_context_state *state = &context->state;
+    struct deferred_call *call;
+    unsigned int i, count;
+
+    TRACE("iface %p, buffer_count %u, buffers %p, offsets %p.\n", iface, buffer_count, buffers, offsets);
+
+    count = min(buffer_count, ARRAY_SIZE(state->so_targets));
+    replace_objects((IUnknown **)state->so_targets, (IUnknown *const *)buffers, count);
+    replace_objects((IUnknown **)&state->so_targets[count], NULL, ARRAY_SIZE(state->so_targets) - count);
+
+    if (!(call = add_deferred_call(&context->commands, DEFERRED_SO_SET_TARGETS,
+            buffer_count * (sizeof(*buffers) + sizeof(*offsets)))))
+        return;
+    call->u.so_targets.count = buffer_count;
+    call->u.so_targets.buffers = deferred_call_data(call);
+    call->u.so_targets.offsets = (UINT *)&call->u.so_targets.buffers[buffer_count];
+    copy_objects((IUnknown **)call->u.so_targets.buffers, (IUnknown *const *)buffers, buffer_count);
+    for (i = 0; i < buffer_count; ++i)
+        call->u.so_targets.offsets[i] = offsets ? offsets[i] : 0;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DrawAuto(ID3D11DeviceContext1 *iface)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p.\n", iface);
+
+    add_deferred_call(&context->commands, DEFERRED_DRAW_AUTO, 0);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DrawIndexedInstancedIndirect(ID3D11DeviceContext1 *iface,
+        ID3D11Buffer *buffer, UINT offset)
+{
+    TRACE("iface %p, buffer %p, offset %u.\n", iface, buffer, offset);
+
+    deferred_context_indirect(impl_from_ID3D11DeviceContext1(iface),
+            DEFERRED_DRAW_INDEXED_INSTANCED_INDIRECT, buffer, offset);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DrawInstancedIndirect(ID3D11DeviceContext1 *iface,
+        ID3D11Buffer *buffer, UINT offset)
+{
+    TRACE("iface %p, buffer %p, offset %u.\n", iface, buffer, offset);
+
+    deferred_context_indirect(impl_from_ID3D11DeviceContext1(iface),
+            DEFERRED_DRAW_INSTANCED_INDIRECT, buffer, offset);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_Dispatch(ID3D11DeviceContext1 *iface,
+        UINT thread_group_count_x, UINT thread_group_count_y, UINT thread_group_count_z)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    struct deferred_call *call;
+
+    TRACE("iface %p, thread_group_count_x %u, thread_group_count_y %u, thread_group_count_z %u.\n",
+            iface, thread_group_count_x, thread_group_count_y, thread_group_count_z);
+
+    if (!(call = add_deferred_call(&context->commands, DEFERRED_DISPATCH, 0)))
+        return;
+    call->u.dispatch.x = thread_group_count_x;
+    call->u.dispatch.y = thread_group_count_y;
+    call->u.dispatch.z = thread_group_count_z;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DispatchIndirect(ID3D11DeviceContext1 *iface,
+        ID3D11Buffer *buffer, UINT offset)
+{
+    TRACE("iface %p, buffer %p, offset %u.\n", iface, buffer, offset);
+
+    deferred_context_indirect(impl_from_ID3D11DeviceContext1(iface), DEFERRED_DISPATCH_INDIRECT, buffer, offset);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_RSSetState(ID3D11DeviceContext1 *iface,
+        ID3D11RasterizerState *rasterizer_state)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, rasterizer_state %p.\n", iface, rasterizer_state);
+
+    replace_object(&context->state.rasterizer_state, rasterizer_state);
+    deferred_context_set_object(context, DEFERRED_RS_SET_STATE, rasterizer_state);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_RSSetViewports(ID3D11DeviceContext1 *iface,
+        UINT viewport_count, const D3D11_VIEWPORT *viewports)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    struct deferred_call *call;
+
+    TRACE("iface %p, viewport_count %u, viewports %p.\n", iface, viewport_count, viewports);
+
+    if (viewport_count <= ARRAY_SIZE(context->state.viewports))
+    {
+        context->state.viewport_count = viewport_count;
+        memcpy(context->state.viewports, viewports, viewport_count * sizeof(*viewports));
+    }
+
+    if (!(call = add_deferred_call(&context->commands, DEFERRED_RS_SET_VIEWPORTS,
+            viewport_count * sizeof(*viewports))))
+        return;
+    call->u.viewports.count = viewport_count;
+    call->u.viewports.viewports = deferred_call_data(call);
+    memcpy(call->u.viewports.viewports, viewports, viewport_count * sizeof(*viewports));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_RSSetScissorRects(ID3D11DeviceContext1 *iface,
+        UINT rect_count, const D3D11_RECT *rects)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    struct deferred_call *call;
+
+    TRACE("iface %p, rect_count %u, rects %p.\n", iface, rect_count, rects);
+
+    if (rect_count <= ARRAY_SIZE(context->state.scissor_rects))
+    {
+        context->state.scissor_rect_count = rect_count;
+        memcpy(context->state.scissor_rects, rects, rect_count * sizeof(*rects));
+    }
+
+    if (!(call = add_deferred_call(&context->commands, DEFERRED_RS_SET_SCISSOR_RECTS,
+            rect_count * sizeof(*rects))))
+        return;
+    call->u.scissor_rects.count = rect_count;
+    call->u.scissor_rects.rects = deferred_call_data(call);
+    memcpy(call->u.scissor_rects.rects, rects, rect_count * sizeof(*rects));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CopySubresourceRegion(ID3D11DeviceContext1 *iface,
+        ID3D11Resource *dst_resource, UINT dst_subresource_idx, UINT dst_x, UINT dst_y, UINT dst_z,
+        ID3D11Resource *src_resource, UINT src_subresource_idx, const D3D11_BOX *src_box)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    struct deferred_call *call;
+
+    TRACE("iface %p, dst_resource %p, dst_subresource_idx %u, dst_x %u, dst_y %u, dst_z %u, "
+            "src_resource %p, src_subresource_idx %u, src_box %p.\n",
+            iface, dst_resource, dst_subresource_idx, dst_x, dst_y, dst_z,
+            src_resource, src_subresource_idx, src_box);
+
+    if (!(call = add_deferred_call(&context->commands, DEFERRED_COPY_SUBRESOURCE_REGION, 0)))
+        return;
+    call->u.copy_region.dst_resource = dst_resource;
+    call->u.copy_region.dst_subresource_idx = dst_subresource_idx;
+    call->u.copy_region.dst_x = dst_x;
+    call->u.copy_region.dst_y = dst_y;
+    call->u.copy_region.dst_z = dst_z;
+    call->u.copy_region.src_resource = src_resource;
+    call->u.copy_region.src_subresource_idx = src_subresource_idx;
+    if ((call->u.copy_region.has_box = !!src_box))
+        call->u.copy_region.src_box = *src_box;
+    add_object_ref(dst_resource);
+    add_object_ref(src_resource);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CopyResource(ID3D11DeviceContext1 *iface,
+        ID3D11Resource *dst_resource, ID3D11Resource *src_resource)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    struct deferred_call *call;
+
+    TRACE("iface %p, dst_resource %p, src_resource %p.\n", iface, dst_resource, src_resource);
+
+    if (!(call = add_deferred_call(&context->commands, DEFERRED_COPY_RESOURCE, 0)))
+        return;
+    call->u.copy_resource.dst_resource = dst_resource;
+    call->u.copy_resource.src_resource = src_resource;
+    add_object_ref(dst_resource);
+    add_object_ref(src_resource);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_UpdateSubresource(ID3D11DeviceContext1 *iface,
+        ID3D11Resource *resource, UINT subresource_idx, const D3D11_BOX *box,
+        const void *data, UINT row_pitch, UINT depth_pitch)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    UINT row_size, row_count, depth;
+    struct deferred_call *call;
+    SIZE_T size;
+
+    TRACE("iface %p, resource %p, subresource_idx %u, box %p, data %p, row_pitch %u, depth_pitch %u.\n",
+            iface, resource, subresource_idx, box, data, row_pitch, depth_pitch);
+
+    if (!deferred_context_get_sub_resource_layout(context, resource, subresource_idx, box,
+            &row_size, &row_count, &depth))
+        return;
+    if (!row_size || !row_count || !depth)
+        return;
+
+    /* The application is free to reuse "data" after this call returns. */
+    size = (SIZE_T)(depth - 1) * depth_pitch + (SIZE_T)(row_count - 1) * row_pitch + row_size;
+    if (!(call = add_deferred_call(&context->commands, DEFERRED_UPDATE_SUBRESOURCE, size)))
+        return;
+    call->u.update.resource = resource;
+    call->u.update.subresource_idx = subresource_idx;
+    if ((call->u.update.has_box = !!box))
+        call->u.update.box = *box;
+    call->u.update.data = deferred_call_data(call);
+    call->u.update.row_pitch = row_pitch;
+    call->u.update.depth_pitch = depth_pitch;
+    call->u.update.row_size = row_size;
+    call->u.update.row_count = row_count;
+    call->u.update.depth = depth;
+    memcpy(call->u.update.data, data, size);
+    add_object_ref(resource);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CopyStructureCount(ID3D11DeviceContext1 *iface,
+        ID3D11Buffer *dst_buffer, UINT dst_offset, ID3D11UnorderedAccessView *src_view)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    struct deferred_call *call;
+
+    TRACE("iface %p, dst_buffer %p, dst_offset %u, src_view %p.\n",
+            iface, dst_buffer, dst_offset, src_view);
+
+    if (!(call = add_deferred_call(&context->commands, DEFERRED_COPY_STRUCTURE_COUNT, 0)))
+        return;
+    call->u.structure_count.dst_buffer = dst_buffer;
+    call->u.structure_count.dst_offset = dst_offset;
+    call->u.structure_count.src_view = src_view;
+    add_object_ref(dst_buffer);
+    add_object_ref(src_view);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_ClearRenderTargetView(ID3D11DeviceContext1 *iface,
+        ID3D11RenderTargetView *render_target_view, const float color_rgba[4])
+{
+    TRACE("iface %p, render_target_view %p, color_rgba %s.\n",
+            iface, render_target_view, debug_float4(color_rgba));
+
+    deferred_context_clear_view(impl_from_ID3D11DeviceContext1(iface), DEFERRED_CLEAR_RENDER_TARGET_VIEW,
+            (ID3D11View *)render_target_view, color_rgba);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_ClearUnorderedAccessViewUint(ID3D11DeviceContext1 *iface,
+        ID3D11UnorderedAccessView *unordered_access_view, const UINT values[4])
+{
+    TRACE("iface %p, unordered_access_view %p, values {%u, %u, %u, %u}.\n",
+            iface, unordered_access_view, values[0], values[1], values[2], values[3]);
+
+    deferred_context_clear_view(impl_from_ID3D11DeviceContext1(iface), DEFERRED_CLEAR_UNORDERED_ACCESS_VIEW_UINT,
+            (ID3D11View *)unordered_access_view, values);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_ClearUnorderedAccessViewFloat(ID3D11DeviceContext1 *iface,
+        ID3D11UnorderedAccessView *unordered_access_view, const float values[4])
+{
+    TRACE("iface %p, unordered_access_view %p, values %s.\n",
+            iface, unordered_access_view, debug_float4(values));
+
+    deferred_context_clear_view(impl_from_ID3D11DeviceContext1(iface), DEFERRED_CLEAR_UNORDERED_ACCESS_VIEW_FLOAT,
+            (ID3D11View *)unordered_access_view, values);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_ClearDepthStencilView(ID3D11DeviceContext1 *iface,
+        ID3D11DepthStencilView *depth_stencil_view, UINT flags, FLOAT depth, UINT8 stencil)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    struct deferred_call *call;
+
+    TRACE("iface %p, depth_stencil_view %p, flags %#x, depth %.8e, stencil %u.\n",
+            iface, depth_stencil_view, flags, depth, stencil);
+
+    if (!(call = add_deferred_call(&context->commands, DEFERRED_CLEAR_DEPTH_STENCIL_VIEW, 0)))
+        return;
+    call->u.clear_depth_stencil.view = depth_stencil_view;
+    call->u.clear_depth_stencil.flags = flags;
+    call->u.clear_depth_stencil.depth = depth;
+    call->u.clear_depth_stencil.stencil = stencil;
+    add_object_ref(depth_stencil_view);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GenerateMips(ID3D11DeviceContext1 *iface,
+        ID3D11ShaderResourceView *view)
+{
+    TRACE("iface %p, view %p.\n", iface, view);
+
+    deferred_context_set_object(impl_from_ID3D11DeviceContext1(iface), DEFERRED_GENERATE_MIPS, view);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_SetResourceMinLOD(ID3D11DeviceContext1 *iface,
+        ID3D11Resource *resource, FLOAT min_lod)
+{
+    FIXME("iface %p, resource %p, min_lod %f stub!\n", iface, resource, min_lod);
+}
+
+static FLOAT STDMETHODCALLTYPE d3d11_deferred_context_GetResourceMinLOD(ID3D11DeviceContext1 *iface,
+        ID3D11Resource *resource)
+{
+    FIXME("iface %p, resource %p stub!\n", iface, resource);
+
+    return 0.0f;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_ResolveSubresource(ID3D11DeviceContext1 *iface,
+        ID3D11Resource *dst_resource, UINT dst_subresource_idx,
+        ID3D11Resource *src_resource, UINT src_subresource_idx,
+        DXGI_FORMAT format)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    struct deferred_call *call;
+
+    TRACE("iface %p, dst_resource %p, dst_subresource_idx %u, src_resource %p, src_subresource_idx %u, "
+            "format %s.\n",
+            iface, dst_resource, dst_subresource_idx, src_resource, src_subresource_idx,
+            debug_dxgi_format(format));
+
+    if (!(call = add_deferred_call(&context->commands, DEFERRED_RESOLVE_SUBRESOURCE, 0)))
+        return;
+    call->u.resolve.dst_resource = dst_resource;
+    call->u.resolve.dst_subresource_idx = dst_subresource_idx;
+    call->u.resolve.src_resource = src_resource;
+    call->u.resolve.src_subresource_idx = src_subresource_idx;
+    call->u.resolve.format = format;
+    add_object_ref(dst_resource);
+    add_object_ref(src_resource);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_ExecuteCommandList(ID3D11DeviceContext1 *iface,
+        ID3D11CommandList *command_list, BOOL restore_state)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    struct deferred_call *call;
+
+    TRACE("iface %p, command_list %p, restore_state %#x.\n", iface, command_list, restore_state);
+
+    /* Like on the immediate context, the state is cleared after the command
+     * list unless it is restored. */
+    if (!restore_state)
+    {
+        d3d11_context_state_cleanup(&context->state);
+        d3d11_context_state_init(&context->state);
+    }
+
+    if (!(call = add_deferred_call(&context->commands, DEFERRED_EXECUTE_COMMAND_LIST, 0)))
+        return;
+    call->u.execute.command_list = command_list;
+    call->u.execute.restore_state = restore_state;
+    add_object_ref(command_list);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSSetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    deferred_context_set_objects(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_SHADER_RESOURCES,
+            WINED3D_SHADER_TYPE_HULL, start_slot, view_count, (void *const *)views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSSetShader(ID3D11DeviceContext1 *iface,
+        ID3D11HullShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    deferred_context_set_shader(impl_from_ID3D11DeviceContext1(iface),
+            WINED3D_SHADER_TYPE_HULL, shader, class_instance_count);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSSetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    deferred_context_set_objects(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_SAMPLERS,
+            WINED3D_SHADER_TYPE_HULL, start_slot, sampler_count, (void *const *)samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSSetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
+
+    deferred_context_set_constant_buffers(impl_from_ID3D11DeviceContext1(iface), WINED3D_SHADER_TYPE_HULL,
+            start_slot, buffer_count, buffers, NULL, NULL);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSSetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    deferred_context_set_objects(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_SHADER_RESOURCES,
+            WINED3D_SHADER_TYPE_DOMAIN, start_slot, view_count, (void *const *)views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSSetShader(ID3D11DeviceContext1 *iface,
+        ID3D11DomainShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    deferred_context_set_shader(impl_from_ID3D11DeviceContext1(iface),
+            WINED3D_SHADER_TYPE_DOMAIN, shader, class_instance_count);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSSetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    deferred_context_set_objects(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_SAMPLERS,
+            WINED3D_SHADER_TYPE_DOMAIN, start_slot, sampler_count, (void *const *)samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSSetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
+
+    deferred_context_set_constant_buffers(impl_from_ID3D11DeviceContext1(iface), WINED3D_SHADER_TYPE_DOMAIN,
+            start_slot, buffer_count, buffers, NULL, NULL);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSSetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    deferred_context_set_objects(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_SHADER_RESOURCES,
+            WINED3D_SHADER_TYPE_COMPUTE, start_slot, view_count, (void *const *)views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSSetUnorderedAccessViews(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11UnorderedAccessView *const *views, const UINT *initial_counts)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    struct deferred_call *call;
+    SIZE_T size;
+
+    TRACE("iface %p, start_slot %u, view_count %u, views %p, initial_counts %p.\n",
+            iface, start_slot, view_count, views, initial_counts);
+
+    deferred_context_set_slots(context, DEFERRED_CS_SET_UNORDERED_ACCESS_VIEWS, WINED3D_SHADER_TYPE_COMPUTE,
+            start_slot, view_count, (void *const *)views);
+
+    size = view_count * sizeof(*views);
+    if (initial_counts)
+        size += view_count * sizeof(*initial_counts);
+    if (!(call = add_deferred_call(&context->commands, DEFERRED_CS_SET_UNORDERED_ACCESS_VIEWS, size)))
+        return;
+    call->u.objects.type = WINED3D_SHADER_TYPE_COMPUTE;
+    call->u.objects.start_slot = start_slot;
+    call->u.objects.count = view_count;
+    call->u.objects.objects = deferred_call_data(call);
+    copy_objects(call->u.objects.objects, (IUnknown *const *)views, view_count);
+    if (initial_counts)
+    {
+        call->u.objects.initial_counts = (UINT *)&call->u.objects.objects[view_count];
+        memcpy(call->u.objects.initial_counts, initial_counts, view_count * sizeof(*initial_counts));
+    }
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSSetShader(ID3D11DeviceContext1 *iface,
+        ID3D11ComputeShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    deferred_context_set_shader(impl_from_ID3D11DeviceContext1(iface),
+            WINED3D_SHADER_TYPE_COMPUTE, shader, class_instance_count);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSSetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    deferred_context_set_objects(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_SAMPLERS,
+            WINED3D_SHADER_TYPE_COMPUTE, start_slot, sampler_count, (void *const *)samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSSetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
+
+    deferred_context_set_constant_buffers(impl_from_ID3D11DeviceContext1(iface), WINED3D_SHADER_TYPE_COMPUTE,
+            start_slot, buffer_count, buffers, NULL, NULL);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSGetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
+
+    deferred_context_get_slots(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_CONSTANT_BUFFERS,
+            WINED3D_SHADER_TYPE_VERTEX, start_slot, buffer_count, (void **)buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSGetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    deferred_context_get_slots(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_SHADER_RESOURCES,
+            WINED3D_SHADER_TYPE_PIXEL, start_slot, view_count, (void **)views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSGetShader(ID3D11DeviceContext1 *iface,
+        ID3D11PixelShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    deferred_context_get_shader(impl_from_ID3D11DeviceContext1(iface), WINED3D_SHADER_TYPE_PIXEL,
+            (void **)shader, class_instance_count);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSGetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    deferred_context_get_slots(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_SAMPLERS,
+            WINED3D_SHADER_TYPE_PIXEL, start_slot, sampler_count, (void **)samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSGetShader(ID3D11DeviceContext1 *iface,
+        ID3D11VertexShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    deferred_context_get_shader(impl_from_ID3D11DeviceContext1(iface), WINED3D_SHADER_TYPE_VERTEX,
+            (void **)shader, class_instance_count);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSGetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
+
+    deferred_context_get_slots(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_CONSTANT_BUFFERS,
+            WINED3D_SHADER_TYPE_PIXEL, start_slot, buffer_count, (void **)buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IAGetInputLayout(ID3D11DeviceContext1 *iface,
+        ID3D11InputLayout **input_layout)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, input_layout %p.\n", iface, input_layout);
+
+    *input_layout = context->state.input_layout;
+    add_object_ref(*input_layout);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IAGetVertexBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers, UINT *strides, UINT *offsets)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    struct d3d11_context_state *state = &context->state;
+    unsigned int i, slot;
+
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p, strides %p, offsets %p.\n",
+            iface, start_slot, buffer_count, buffers, strides, offsets);
+
+    for (i = 0; i < buffer_count; ++i)
+    {
+        BOOL valid = (slot = start_slot + i) < ARRAY_SIZE(state->vbs);
+
+        if (buffers)
+        {
+            buffers[i] = valid ? state->vbs[slot] : NULL;
+            add_object_ref(buffers[i]);
+        }
+        if (strides)
+            strides[i] = valid ? state->vb_strides[slot] : 0;
+        if (offsets)
+            offsets[i] = valid ? state->vb_offsets[slot] : 0;
+    }
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IAGetIndexBuffer(ID3D11DeviceContext1 *iface,
+        ID3D11Buffer **buffer, DXGI_FORMAT *format, UINT *offset)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, buffer %p, format %p, offset %p.\n", iface, buffer, format, offset);
+
+    if (buffer)
+    {
+        *buffer = context->state.ib;
+        add_object_ref(*buffer);
+    }
+    if (format)
+        *format = context->state.ib_format;
+    if (offset)
+        *offset = context->state.ib_offset;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSGetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
+
+    deferred_context_get_slots(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_CONSTANT_BUFFERS,
+            WINED3D_SHADER_TYPE_GEOMETRY, start_slot, buffer_count, (void **)buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSGetShader(ID3D11DeviceContext1 *iface,
+        ID3D11GeometryShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    deferred_context_get_shader(impl_from_ID3D11DeviceContext1(iface), WINED3D_SHADER_TYPE_GEOMETRY,
+            (void **)shader, class_instance_count);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IAGetPrimitiveTopology(ID3D11DeviceContext1 *iface,
+        D3D11_PRIMITIVE_TOPOLOGY *topology)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, topology %p.\n", iface, topology);
+
+    *topology = context->state.topology;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSGetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    deferred_context_get_slots(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_SHADER_RESOURCES,
+            WINED3D_SHADER_TYPE_VERTEX, start_slot, view_count, (void **)views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSGetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    deferred_context_get_slots(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_SAMPLERS,
+            WINED3D_SHADER_TYPE_VERTEX, start_slot, sampler_count, (void **)samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GetPredication(ID3D11DeviceContext1 *iface,
+        ID3D11Predicate **predicate, BOOL *value)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, predicate %p, value %p.\n", iface, predicate, value);
+
+    if (predicate)
+    {
+        *predicate = context->state.predicate;
+        add_object_ref(*predicate);
+    }
+    if (value)
+        *value = context->state.predicate_value;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSGetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    deferred_context_get_slots(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_SHADER_RESOURCES,
+            WINED3D_SHADER_TYPE_GEOMETRY, start_slot, view_count, (void **)views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSGetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    deferred_context_get_slots(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_SAMPLERS,
+            WINED3D_SHADER_TYPE_GEOMETRY, start_slot, sampler_count, (void **)samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMGetRenderTargetsAndUnorderedAccessViews(
+        ID3D11DeviceContext1 *iface,
+        UINT render_target_view_count, ID3D11RenderTargetView **render_target_views,
+        ID3D11DepthStencilView **depth_stencil_view, UINT unordered_access_view_start_slot,
+        UINT unordered_access_view_count, ID3D11UnorderedAccessView **unordered_access_views)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    struct d3d11_context_state *state = &context->state;
+    unsigned int i, slot;
+
+    TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p, "
+            "unordered_access_view_start_slot %u, unordered_access_view_count %u, "
+            "unordered_access_views %p.\n",
+            iface, render_target_view_count, render_target_views, depth_stencil_view,
+            unordered_access_view_start_slot, unordered_access_view_count, unordered_access_views);
+
+    if (render_target_views)
+    {
+        for (i = 0; i < render_target_view_count; ++i)
+        {
+            render_target_views[i] = i < ARRAY_SIZE(state->rtvs) ? state->rtvs[i] : NULL;
+            add_object_ref(render_target_views[i]);
+        }
+    }
+    if (depth_stencil_view)
+    {
+        *depth_stencil_view = state->dsv;
+        add_object_ref(*depth_stencil_view);
+    }
+    if (unordered_access_views)
+    {
+        for (i = 0; i < unordered_access_view_count; ++i)
+        {
+            slot = unordered_access_view_start_slot + i;
+            unordered_access_views[i] = slot < ARRAY_SIZE(state->ps_uavs) ? state->ps_uavs[slot] : NULL;
+            add_object_ref(unordered_access_views[i]);
+        }
+    }
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMGetRenderTargets(ID3D11DeviceContext1 *iface,
+        UINT render_target_view_count, ID3D11RenderTargetView **render_target_views,
+        ID3D11DepthStencilView **depth_stencil_view)
+{
+    TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p.\n",
+            iface, render_target_view_count, render_target_views, depth_stencil_view);
+
+    d3d11_deferred_context_OMGetRenderTargetsAndUnorderedAccessViews(iface, render_target_view_count,
+            render_target_views, depth_stencil_view, 0, 0, NULL);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMGetBlendState(ID3D11DeviceContext1 *iface,
+        ID3D11BlendState **blend_state, FLOAT blend_factor[4], UINT *sample_mask)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, blend_state %p, blend_factor %p, sample_mask %p.\n",
+            iface, blend_state, blend_factor, sample_mask);
+
+    if (blend_state)
+    {
+        *blend_state = context->state.blend_state;
+        add_object_ref(*blend_state);
+    }
+    if (blend_factor)
+        memcpy(blend_factor, context->state.blend_factor, sizeof(context->state.blend_factor));
+    if (sample_mask)
+        *sample_mask = context->state.sample_mask;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMGetDepthStencilState(ID3D11DeviceContext1 *iface,
+        ID3D11DepthStencilState **depth_stencil_state, UINT *stencil_ref)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, depth_stencil_state %p, stencil_ref %p.\n",
+            iface, depth_stencil_state, stencil_ref);
+
+    if (depth_stencil_state)
+    {
+        *depth_stencil_state = context->state.depth_stencil_state;
+        add_object_ref(*depth_stencil_state);
+    }
+    if (stencil_ref)
+        *stencil_ref = context->state.stencil_ref;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_SOGetTargets(ID3D11DeviceContext1 *iface,
+        UINT buffer_count, ID3D11Buffer **buffers)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    unsigned int i;
+
+    TRACE("iface %p, buffer_count %u, buffers %p.\n", iface, buffer_count, buffers);
+
+    for (i = 0; i < buffer_count; ++i)
+    {
+        buffers[i] = i < ARRAY_SIZE(context->state.so_targets) ? context->state.so_targets[i] : NULL;
+        add_object_ref(buffers[i]);
+    }
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_RSGetState(ID3D11DeviceContext1 *iface,
+        ID3D11RasterizerState **rasterizer_state)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, rasterizer_state %p.\n", iface, rasterizer_state);
+
+    *rasterizer_state = context->state.rasterizer_state;
+    add_object_ref(*rasterizer_state);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_RSGetViewports(ID3D11DeviceContext1 *iface,
+        UINT *viewport_count, D3D11_VIEWPORT *viewports)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    UINT actual_count = context->state.viewport_count;
+
+    TRACE("iface %p, viewport_count %p, viewports %p.\n", iface, viewport_count, viewports);
+
+    if (!viewport_count)
+        return;
+
+    if (!viewports)
+    {
+        *viewport_count = actual_count;
+        return;
+    }
+
+    if (*viewport_count > actual_count)
+        memset(&viewports[actual_count], 0, (*viewport_count - actual_count) * sizeof(*viewports));
+
+    *viewport_count = min(actual_count, *viewport_count);
+    memcpy(viewports, context->state.viewports, *viewport_count * sizeof(*viewports));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_RSGetScissorRects(ID3D11DeviceContext1 *iface,
+        UINT *rect_count, D3D11_RECT *rects)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    UINT actual_count = context->state.scissor_rect_count;
+
+    TRACE("iface %p, rect_count %p, rects %p.\n", iface, rect_count, rects);
+
+    if (!rect_count)
+        return;
+
+    if (!rects)
+    {
+        *rect_count = actual_count;
+        return;
+    }
+
+    if (*rect_count > actual_count)
+        memset(&rects[actual_count], 0, (*rect_count - actual_count) * sizeof(*rects));
+
+    *rect_count = min(actual_count, *rect_count);
+    memcpy(rects, context->state.scissor_rects, *rect_count * sizeof(*rects));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSGetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    deferred_context_get_slots(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_SHADER_RESOURCES,
+            WINED3D_SHADER_TYPE_HULL, start_slot, view_count, (void **)views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSGetShader(ID3D11DeviceContext1 *iface,
+        ID3D11HullShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    deferred_context_get_shader(impl_from_ID3D11DeviceContext1(iface), WINED3D_SHADER_TYPE_HULL,
+            (void **)shader, class_instance_count);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSGetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    deferred_context_get_slots(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_SAMPLERS,
+            WINED3D_SHADER_TYPE_HULL, start_slot, sampler_count, (void **)samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSGetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
+
+    deferred_context_get_slots(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_CONSTANT_BUFFERS,
+            WINED3D_SHADER_TYPE_HULL, start_slot, buffer_count, (void **)buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSGetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    deferred_context_get_slots(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_SHADER_RESOURCES,
+            WINED3D_SHADER_TYPE_DOMAIN, start_slot, view_count, (void **)views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSGetShader(ID3D11DeviceContext1 *iface,
+        ID3D11DomainShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    deferred_context_get_shader(impl_from_ID3D11DeviceContext1(iface), WINED3D_SHADER_TYPE_DOMAIN,
+            (void **)shader, class_instance_count);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSGetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    deferred_context_get_slots(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_SAMPLERS,
+            WINED3D_SHADER_TYPE_DOMAIN, start_slot, sampler_count, (void **)samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSGetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
+
+    deferred_context_get_slots(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_CONSTANT_BUFFERS,
+            WINED3D_SHADER_TYPE_DOMAIN, start_slot, buffer_count, (void **)buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSGetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    deferred_context_get_slots(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_SHADER_RESOURCES,
+            WINED3D_SHADER_TYPE_COMPUTE, start_slot, view_count, (void **)views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSGetUnorderedAccessViews(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11UnorderedAccessView **views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    deferred_context_get_slots(impl_from_ID3D11DeviceContext1(iface), DEFERRED_CS_SET_UNORDERED_ACCESS_VIEWS,
+            WINED3D_SHADER_TYPE_COMPUTE, start_slot, view_count, (void **)views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSGetShader(ID3D11DeviceContext1 *iface,
+        ID3D11ComputeShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    deferred_context_get_shader(impl_from_ID3D11DeviceContext1(iface), WINED3D_SHADER_TYPE_COMPUTE,
+            (void **)shader, class_instance_count);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSGetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    deferred_context_get_slots(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_SAMPLERS,
+            WINED3D_SHADER_TYPE_COMPUTE, start_slot, sampler_count, (void **)samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSGetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
+
+    deferred_context_get_slots(impl_from_ID3D11DeviceContext1(iface), DEFERRED_SET_CONSTANT_BUFFERS,
+            WINED3D_SHADER_TYPE_COMPUTE, start_slot, buffer_count, (void **)buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSGetConstantBuffers1(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers, UINT *first_constant, UINT *num_constants)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p.\n",
+            iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+
+    deferred_context_get_constant_buffers(impl_from_ID3D11DeviceContext1(iface), WINED3D_SHADER_TYPE_VERTEX,
+            start_slot, buffer_count, buffers, first_constant, num_constants);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSGetConstantBuffers1(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers, UINT *first_constant, UINT *num_constants)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p.\n",
+            iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+
+    deferred_context_get_constant_buffers(impl_from_ID3D11DeviceContext1(iface), WINED3D_SHADER_TYPE_HULL,
+            start_slot, buffer_count, buffers, first_constant, num_constants);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSGetConstantBuffers1(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers, UINT *first_constant, UINT *num_constants)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p.\n",
+            iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+
+    deferred_context_get_constant_buffers(impl_from_ID3D11DeviceContext1(iface), WINED3D_SHADER_TYPE_DOMAIN,
+            start_slot, buffer_count, buffers, first_constant, num_constants);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSGetConstantBuffers1(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers, UINT *first_constant, UINT *num_constants)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p.\n",
+            iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+
+    deferred_context_get_constant_buffers(impl_from_ID3D11DeviceContext1(iface), WINED3D_SHADER_TYPE_GEOMETRY,
+            start_slot, buffer_count, buffers, first_constant, num_constants);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSGetConstantBuffers1(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers, UINT *first_constant, UINT *num_constants)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p.\n",
+            iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+
+    deferred_context_get_constant_buffers(impl_from_ID3D11DeviceContext1(iface), WINED3D_SHADER_TYPE_PIXEL,
+            start_slot, buffer_count, buffers, first_constant, num_constants);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSGetConstantBuffers1(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers, UINT *first_constant, UINT *num_constants)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p.\n",
+            iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+
+    deferred_context_get_constant_buffers(impl_from_ID3D11DeviceContext1(iface), WINED3D_SHADER_TYPE_COMPUTE,
+            start_slot, buffer_count, buffers, first_constant, num_constants);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_ClearState(ID3D11DeviceContext1 *iface)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p.\n", iface);
+
+    d3d11_context_state_cleanup(&context->state);
+    d3d11_context_state_init(&context->state);
+
+    add_deferred_call(&context->commands, DEFERRED_CLEAR_STATE, 0);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_Flush(ID3D11DeviceContext1 *iface)
+{
+    TRACE("iface %p.\n", iface);
+}
+
+static D3D11_DEVICE_CONTEXT_TYPE STDMETHODCALLTYPE d3d11_deferred_context_GetType(ID3D11DeviceContext1 *iface)
+{
+    TRACE("iface %p.\n", iface);
+
+    return D3D11_DEVICE_CONTEXT_DEFERRED;
+}
+
+static UINT STDMETHODCALLTYPE d3d11_deferred_context_GetContextFlags(ID3D11DeviceContext1 *iface)
+{
+    TRACE("iface %p.\n", iface);
+
+    return 0;
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_FinishCommandList(ID3D11DeviceContext1 *iface,
+        BOOL restore, ID3D11CommandList **command_list)
+{
+    struct d3d11_deferred_context *context = impl_from_ID3D11DeviceContext1(iface);
+    struct d3d11_command_list *object;
+    struct deferred_call *call;
+    HRESULT hr;
+
+    TRACE("iface %p, restore %#x, command_list %p.\n", iface, restore, command_list);
+
+    if (!list_empty(&context->maps))
+    {
+        WARN("Discarding pending maps.\n");
+        free_deferred_calls(&context->maps);
+    }
+
+    if (FAILED(hr = d3d11_command_list_create(context, &object)))
+    {
+        *command_list = NULL;
+        return hr;
+    }
+
+    /* Command lists start from a cleared state when executed, so the next
+     * one has to set the state it keeps from this one first. */
+    if (!restore)
+    {
+        d3d11_context_state_cleanup(&context->state);
+        d3d11_context_state_init(&context->state);
+    }
+    else if ((call = add_deferred_call(&context->commands, DEFERRED_SET_STATE, sizeof(*call->u.state))))
+    {
+        call->u.state = deferred_call_data(call);
+        d3d11_context_state_copy(call->u.state, &context->state);
+    }
+
+    *command_list = &object->ID3D11CommandList_iface;
+
+    return S_OK;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CopySubresourceRegion1(ID3D11DeviceContext1 *iface,
+        ID3D11Resource *dst_resource, UINT dst_subresource_idx, UINT dst_x, UINT dst_y, UINT dst_z,
+        ID3D11Resource *src_resource, UINT src_subresource_idx, const D3D11_BOX *src_box, UINT flags)
+{
+    TRACE("iface %p, dst_resource %p, dst_subresource_idx %u, dst_x %u, dst_y %u, dst_z %u, "
+            "src_resource %p, src_subresource_idx %u, src_box %p, flags %#x.\n",
+            iface, dst_resource, dst_subresource_idx, dst_x, dst_y, dst_z,
+            src_resource, src_subresource_idx, src_box, flags);
+
+    if (flags)
+        FIXME("Ignoring flags %#x.\n", flags);
+
+    d3d11_deferred_context_CopySubresourceRegion(iface, dst_resource, dst_subresource_idx,
+            dst_x, dst_y, dst_z, src_resource, src_subresource_idx, src_box);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_UpdateSubresource1(ID3D11DeviceContext1 *iface,
+        ID3D11Resource *resource, UINT subresource_idx, const D3D11_BOX *box, const void *data,
+        UINT row_pitch, UINT depth_pitch, UINT flags)
+{
+    TRACE("iface %p, resource %p, subresource_idx %u, box %p, data %p, row_pitch %u, depth_pitch %u, flags %#x.\n",
+            iface, resource, subresource_idx, box, data, row_pitch, depth_pitch, flags);
+
+    if (flags)
+        FIXME("Ignoring flags %#x.\n", flags);
+
+    d3d11_deferred_context_UpdateSubresource(iface, resource, subresource_idx, box, data, row_pitch, depth_pitch);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DiscardResource(ID3D11DeviceContext1 *iface,
+        ID3D11Resource *resource)
+{
+    FIXME("iface %p, resource %p stub!\n", iface, resource);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DiscardView(ID3D11DeviceContext1 *iface, ID3D11View *view)
+{
+    FIXME("iface %p, view %p stub!\n", iface, view);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSSetConstantBuffers1(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer * const *buffers, const UINT *first_constant,
+        const UINT *num_constants)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p.\n",
+            iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+
+    deferred_context_set_constant_buffers(impl_from_ID3D11DeviceContext1(iface), WINED3D_SHADER_TYPE_VERTEX,
+            start_slot, buffer_count, buffers, first_constant, num_constants);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSSetConstantBuffers1(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer * const *buffers, const UINT *first_constant,
+        const UINT *num_constants)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p.\n",
+            iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+
+    deferred_context_set_constant_buffers(impl_from_ID3D11DeviceContext1(iface), WINED3D_SHADER_TYPE_HULL,
+            start_slot, buffer_count, buffers, first_constant, num_constants);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSSetConstantBuffers1(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer * const *buffers, const UINT *first_constant,
+        const UINT *num_constants)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p.\n",
+            iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+
+    deferred_context_set_constant_buffers(impl_from_ID3D11DeviceContext1(iface), WINED3D_SHADER_TYPE_DOMAIN,
+            start_slot, buffer_count, buffers, first_constant, num_constants);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSSetConstantBuffers1(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer * const *buffers, const UINT *first_constant,
+        const UINT *num_constants)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p.\n",
+            iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+
+    deferred_context_set_constant_buffers(impl_from_ID3D11DeviceContext1(iface), WINED3D_SHADER_TYPE_GEOMETRY,
+            start_slot, buffer_count, buffers, first_constant, num_constants);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSSetConstantBuffers1(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer * const *buffers, const UINT *first_constant,
+        const UINT *num_constants)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p.\n",
+            iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+
+    deferred_context_set_constant_buffers(impl_from_ID3D11DeviceContext1(iface), WINED3D_SHADER_TYPE_PIXEL,
+            start_slot, buffer_count, buffers, first_constant, num_constants);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSSetConstantBuffers1(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer * const *buffers, const UINT *first_constant,
+        const UINT *num_constants)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p.\n",
+            iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+
+    deferred_context_set_constant_buffers(impl_from_ID3D11DeviceContext1(iface), WINED3D_SHADER_TYPE_COMPUTE,
+            start_slot, buffer_count, buffers, first_constant, num_constants);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_SwapDeviceContextState(ID3D11DeviceContext1 *iface,
+        ID3DDeviceContextState *state, ID3DDeviceContextState **prev_state)
+{
+    FIXME("iface %p, state %p, prev_state %p stub!\n", iface, state, prev_state);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_ClearView(ID3D11DeviceContext1 *iface, ID3D11View *view,
+        const FLOAT color[4], const D3D11_RECT *rect, UINT num_rects)
+{
+    FIXME("iface %p, view %p, color %p, rect %p, num_rects %u stub!\n", iface, view, color, rect, num_rects);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DiscardView1(ID3D11DeviceContext1 *iface, ID3D11View *view,
+        const D3D11_RECT *rects, UINT num_rects)
+{
+    FIXME("iface %p, view %p, rects %p, num_rects %u stub!\n", iface, view, rects, num_rects);
+}
+
+static const struct ID3D11DeviceContext1Vtbl d3d11_deferred_context_vtbl =
+{
+    /* IUnknown methods */
+    d3d11_deferred_context_QueryInterface,
+    d3d11_deferred_context_AddRef,
+    d3d11_deferred_context_Release,
+    /* ID3D11DeviceChild methods */
+    d3d11_deferred_context_GetDevice,
+    d3d11_deferred_context_GetPrivateData,
+    d3d11_deferred_context_SetPrivateData,
+    d3d11_deferred_context_SetPrivateDataInterface,
+    /* ID3D11DeviceContext methods */
+    d3d11_deferred_context_VSSetConstantBuffers,
+    d3d11_deferred_context_PSSetShaderResources,
+    d3d11_deferred_context_PSSetShader,
+    d3d11_deferred_context_PSSetSamplers,
+    d3d11_deferred_context_VSSetShader,
+    d3d11_deferred_context_DrawIndexed,
+    d3d11_deferred_context_Draw,
+    d3d11_deferred_context_Map,
+    d3d11_deferred_context_Unmap,
+    d3d11_deferred_context_PSSetConstantBuffers,
+    d3d11_deferred_context_IASetInputLayout,
+    d3d11_deferred_context_IASetVertexBuffers,
+    d3d11_deferred_context_IASetIndexBuffer,
+    d3d11_deferred_context_DrawIndexedInstanced,
+    d3d11_deferred_context_DrawInstanced,
+    d3d11_deferred_context_GSSetConstantBuffers,
+    d3d11_deferred_context_GSSetShader,
+    d3d11_deferred_context_IASetPrimitiveTopology,
+    d3d11_deferred_context_VSSetShaderResources,
+    d3d11_deferred_context_VSSetSamplers,
+    d3d11_deferred_context_Begin,
+    d3d11_deferred_context_End,
+    d3d11_deferred_context_GetData,
+    d3d11_deferred_context_SetPredication,
+    d3d11_deferred_context_GSSetShaderResources,
+    d3d11_deferred_context_GSSetSamplers,
+    d3d11_deferred_context_OMSetRenderTargets,
+    d3d11_deferred_context_OMSetRenderTargetsAndUnorderedAccessViews,
+    d3d11_deferred_context_OMSetBlendState,
+    d3d11_deferred_context_OMSetDepthStencilState,
+    d3d11_deferred_context_SOSetTargets,
+    d3d11_deferred_context_DrawAuto,
+    d3d11_deferred_context_DrawIndexedInstancedIndirect,
+    d3d11_deferred_context_DrawInstancedIndirect,
+    d3d11_deferred_context_Dispatch,
+    d3d11_deferred_context_DispatchIndirect,
+    d3d11_deferred_context_RSSetState,
+    d3d11_deferred_context_RSSetViewports,
+    d3d11_deferred_context_RSSetScissorRects,
+    d3d11_deferred_context_CopySubresourceRegion,
+    d3d11_deferred_context_CopyResource,
+    d3d11_deferred_context_UpdateSubresource,
+    d3d11_deferred_context_CopyStructureCount,
+    d3d11_deferred_context_ClearRenderTargetView,
+    d3d11_deferred_context_ClearUnorderedAccessViewUint,
+    d3d11_deferred_context_ClearUnorderedAccessViewFloat,
+    d3d11_deferred_context_ClearDepthStencilView,
+    d3d11_deferred_context_GenerateMips,
+    d3d11_deferred_context_SetResourceMinLOD,
+    d3d11_deferred_context_GetResourceMinLOD,
+    d3d11_deferred_context_ResolveSubresource,
+    d3d11_deferred_context_ExecuteCommandList,
+    d3d11_deferred_context_HSSetShaderResources,
+    d3d11_deferred_context_HSSetShader,
+    d3d11_deferred_context_HSSetSamplers,
+    d3d11_deferred_context_HSSetConstantBuffers,
+    d3d11_deferred_context_DSSetShaderResources,
+    d3d11_deferred_context_DSSetShader,
+    d3d11_deferred_context_DSSetSamplers,
+    d3d11_deferred_context_DSSetConstantBuffers,
+    d3d11_deferred_context_CSSetShaderResources,
+    d3d11_deferred_context_CSSetUnorderedAccessViews,
+    d3d11_deferred_context_CSSetShader,
+    d3d11_deferred_context_CSSetSamplers,
+    d3d11_deferred_context_CSSetConstantBuffers,
+    d3d11_deferred_context_VSGetConstantBuffers,
+    d3d11_deferred_context_PSGetShaderResources,
+    d3d11_deferred_context_PSGetShader,
+    d3d11_deferred_context_PSGetSamplers,
+    d3d11_deferred_context_VSGetShader,
+    d3d11_deferred_context_PSGetConstantBuffers,
+    d3d11_deferred_context_IAGetInputLayout,
+    d3d11_deferred_context_IAGetVertexBuffers,
+    d3d11_deferred_context_IAGetIndexBuffer,
+    d3d11_deferred_context_GSGetConstantBuffers,
+    d3d11_deferred_context_GSGetShader,
+    d3d11_deferred_context_IAGetPrimitiveTopology,
+    d3d11_deferred_context_VSGetShaderResources,
+    d3d11_deferred_context_VSGetSamplers,
+    d3d11_deferred_context_GetPredication,
+    d3d11_deferred_context_GSGetShaderResources,
+    d3d11_deferred_context_GSGetSamplers,
+    d3d11_deferred_context_OMGetRenderTargets,
+    d3d11_deferred_context_OMGetRenderTargetsAndUnorderedAccessViews,
+    d3d11_deferred_context_OMGetBlendState,
+    d3d11_deferred_context_OMGetDepthStencilState,
+    d3d11_deferred_context_SOGetTargets,
+    d3d11_deferred_context_RSGetState,
+    d3d11_deferred_context_RSGetViewports,
+    d3d11_deferred_context_RSGetScissorRects,
+    d3d11_deferred_context_HSGetShaderResources,
+    d3d11_deferred_context_HSGetShader,
+    d3d11_deferred_context_HSGetSamplers,
+    d3d11_deferred_context_HSGetConstantBuffers,
+    d3d11_deferred_context_DSGetShaderResources,
+    d3d11_deferred_context_DSGetShader,
+    d3d11_deferred_context_DSGetSamplers,
+    d3d11_deferred_context_DSGetConstantBuffers,
+    d3d11_deferred_context_CSGetShaderResources,
+    d3d11_deferred_context_CSGetUnorderedAccessViews,
+    d3d11_deferred_context_CSGetShader,
+    d3d11_deferred_context_CSGetSamplers,
+    d3d11_deferred_context_CSGetConstantBuffers,
+    d3d11_deferred_context_ClearState,
+    d3d11_deferred_context_Flush,
+    d3d11_deferred_context_GetType,
+    d3d11_deferred_context_GetContextFlags,
+    d3d11_deferred_context_FinishCommandList,
+    /* ID3D11DeviceContext1 methods */
+    d3d11_deferred_context_CopySubresourceRegion1,
+    d3d11_deferred_context_UpdateSubresource1,
+    d3d11_deferred_context_DiscardResource,
+    d3d11_deferred_context_DiscardView,
+    d3d11_deferred_context_VSSetConstantBuffers1,
+    d3d11_deferred_context_HSSetConstantBuffers1,
+    d3d11_deferred_context_DSSetConstantBuffers1,
+    d3d11_deferred_context_GSSetConstantBuffers1,
+    d3d11_deferred_context_PSSetConstantBuffers1,
+    d3d11_deferred_context_CSSetConstantBuffers1,
+    d3d11_deferred_context_VSGetConstantBuffers1,
+    d3d11_deferred_context_HSGetConstantBuffers1,
+    d3d11_deferred_context_DSGetConstantBuffers1,
+    d3d11_deferred_context_GSGetConstantBuffers1,
+    d3d11_deferred_context_PSGetConstantBuffers1,
+    d3d11_deferred_context_CSGetConstantBuffers1,
+    d3d11_deferred_context_SwapDeviceContextState,
+    d3d11_deferred_context_ClearView,
+    d3d11_deferred_context_DiscardView1,
+};
+
+HRESULT d3d11_deferred_context_create(struct d3d_device *device, UINT flags,
+        struct d3d11_deferred_context **context)
+{
+    struct d3d11_deferred_context *object;
+
+    if (flags)
+    {
+        WARN("Invalid flags %#x.\n", flags);
+        return E_INVALIDARG;
+    }
+
+    if (!(object = heap_alloc_zero(sizeof(*object))))
+        return E_OUTOFMEMORY;
+
+    object->ID3D11DeviceContext1_iface.lpVtbl = &d3d11_deferred_context_vtbl;
+    object->refcount = 1;
+    wined3d_private_store_init(&object->private_store);
+    object->device = device;
+    ID3D11Device2_AddRef(&device->ID3D11Device2_iface);
+    list_init(&object->commands);
+    list_init(&object->maps);
+    wine_rb_init(&object->discard_maps, deferred_discard_map_compare);
+    d3d11_context_state_init(&object->state);
+
+    TRACE("Created deferred context %p.\n", object);
+    *context = object;
+
+    return S_OK;
+}
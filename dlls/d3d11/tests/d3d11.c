@@ -27591,6 +27591,217 @@ static void test_depth_clip(void)
     release_test_context(&test_context);
 }
 
+static void test_deferred_context(void)
+{
+    static const float red[] = {1.0f, 0.0f, 0.0f, 1.0f};
+    static const float green[] = {0.0f, 1.0f, 0.0f, 1.0f};
+    static const float blue[] = {0.0f, 0.0f, 1.0f, 1.0f};
+    struct d3d11_test_context test_context;
+    ID3D11DeviceContext1 *context1, *deferred1;
+    ID3D11DeviceContext *context, *deferred;
+    UINT first_constant, num_constants;
+    D3D11_MAPPED_SUBRESOURCE map_desc;
+    D3D11_TEXTURE2D_DESC texture_desc;
+    ID3D11CommandList *command_list;
+    struct resource_readback rb;
+    D3D11_BUFFER_DESC buffer_desc;
+    ID3D11RenderTargetView *rtv;
+    ID3D11Buffer *buffer, *tmp_buffer;
+    ID3D11Texture2D *texture;
+    ID3D11Device *device;
+    DWORD data[16];
+    unsigned int i;
+    ULONG refcount;
+    HRESULT hr;
+
+    if (!init_test_context(&test_context, NULL))
+        return;
+
+    device = test_context.device;
+    context = test_context.immediate_context;
+
+    hr = ID3D11Device_CreateDeferredContext(device, 0, &deferred);
+    ok(SUCCEEDED(hr), "Failed to create deferred context, hr %#x.\n", hr);
+    ok(ID3D11DeviceContext_GetType(deferred) == D3D11_DEVICE_CONTEXT_DEFERRED,
+            "Got unexpected context type %#x.\n", ID3D11DeviceContext_GetType(deferred));
+
+    /* Nothing happens until the command list is executed. */
+    ID3D11DeviceContext_ClearRenderTargetView(context, test_context.backbuffer_rtv, green);
+    ID3D11DeviceContext_ClearRenderTargetView(deferred, test_context.backbuffer_rtv, red);
+    check_texture_color(test_context.backbuffer, 0xff00ff00, 0);
+    hr = ID3D11DeviceContext_FinishCommandList(deferred, FALSE, &command_list);
+    ok(SUCCEEDED(hr), "Failed to finish command list, hr %#x.\n", hr);
+    check_texture_color(test_context.backbuffer, 0xff00ff00, 0);
+
+    ID3D11DeviceContext_ExecuteCommandList(context, command_list, TRUE);
+    check_texture_color(test_context.backbuffer, 0xff0000ff, 0);
+    ID3D11DeviceContext_OMGetRenderTargets(context, 1, &rtv, NULL);
+    ok(rtv == test_context.backbuffer_rtv, "Got unexpected render target view %p.\n", rtv);
+    ID3D11RenderTargetView_Release(rtv);
+
+    /* Command lists can be executed several times. */
+    ID3D11DeviceContext_ClearRenderTargetView(context, test_context.backbuffer_rtv, blue);
+    check_texture_color(test_context.backbuffer, 0xffff0000, 0);
+    ID3D11DeviceContext_ExecuteCommandList(context, command_list, FALSE);
+    check_texture_color(test_context.backbuffer, 0xff0000ff, 0);
+    ID3D11DeviceContext_OMGetRenderTargets(context, 1, &rtv, NULL);
+    ok(!rtv, "Got unexpected render target view %p.\n", rtv);
+    ID3D11CommandList_Release(command_list);
+    ID3D11DeviceContext_OMSetRenderTargets(context, 1, &test_context.backbuffer_rtv, NULL);
+
+    /* Updates are copied at record time. */
+    texture_desc.Width = 4;
+    texture_desc.Height = 4;
+    texture_desc.MipLevels = 1;
+    texture_desc.ArraySize = 1;
+    texture_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    texture_desc.SampleDesc.Count = 1;
+    texture_desc.SampleDesc.Quality = 0;
+    texture_desc.Usage = D3D11_USAGE_DEFAULT;
+    texture_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    texture_desc.CPUAccessFlags = 0;
+    texture_desc.MiscFlags = 0;
+    hr = ID3D11Device_CreateTexture2D(device, &texture_desc, NULL, &texture);
+    ok(SUCCEEDED(hr), "Failed to create texture, hr %#x.\n", hr);
+
+    for (i = 0; i < ARRAY_SIZE(data); ++i)
+        data[i] = 0xff00ff00;
+    ID3D11DeviceContext_UpdateSubresource(deferred, (ID3D11Resource *)texture, 0, NULL,
+            data, 4 * sizeof(*data), 0);
+    for (i = 0; i < ARRAY_SIZE(data); ++i)
+        data[i] = 0xff0000ff;
+    hr = ID3D11DeviceContext_FinishCommandList(deferred, FALSE, &command_list);
+    ok(SUCCEEDED(hr), "Failed to finish command list, hr %#x.\n", hr);
+    ID3D11DeviceContext_ExecuteCommandList(context, command_list, FALSE);
+    check_texture_color(texture, 0xff00ff00, 0);
+    ID3D11CommandList_Release(command_list);
+    ID3D11Texture2D_Release(texture);
+
+    /* Only D3D11_MAP_WRITE_DISCARD maps are recorded. */
+    texture_desc.Usage = D3D11_USAGE_DYNAMIC;
+    texture_desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    hr = ID3D11Device_CreateTexture2D(device, &texture_desc, NULL, &texture);
+    ok(SUCCEEDED(hr), "Failed to create texture, hr %#x.\n", hr);
+
+    hr = ID3D11DeviceContext_Map(deferred, (ID3D11Resource *)texture, 0, D3D11_MAP_WRITE, 0, &map_desc);
+    ok(hr == E_INVALIDARG, "Got unexpected hr %#x.\n", hr);
+    hr = ID3D11DeviceContext_Map(deferred, (ID3D11Resource *)texture, 0, D3D11_MAP_WRITE_DISCARD, 0, &map_desc);
+    ok(SUCCEEDED(hr), "Failed to map texture, hr %#x.\n", hr);
+    for (i = 0; i < 4; ++i)
+        memcpy((BYTE *)map_desc.pData + i * map_desc.RowPitch, data, 4 * sizeof(*data));
+    ID3D11DeviceContext_Unmap(deferred, (ID3D11Resource *)texture, 0);
+    hr = ID3D11DeviceContext_FinishCommandList(deferred, FALSE, &command_list);
+    ok(SUCCEEDED(hr), "Failed to finish command list, hr %#x.\n", hr);
+    ID3D11DeviceContext_ExecuteCommandList(context, command_list, FALSE);
+    check_texture_color(texture, 0xff0000ff, 0);
+    ID3D11CommandList_Release(command_list);
+    ID3D11Texture2D_Release(texture);
+
+    /* D3D11_MAP_WRITE_NO_OVERWRITE maps append to the previous
+     * D3D11_MAP_WRITE_DISCARD map in the same command list. */
+    buffer_desc.ByteWidth = sizeof(data);
+    buffer_desc.Usage = D3D11_USAGE_DYNAMIC;
+    buffer_desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    buffer_desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    buffer_desc.MiscFlags = 0;
+    buffer_desc.StructureByteStride = 0;
+    hr = ID3D11Device_CreateBuffer(device, &buffer_desc, NULL, &buffer);
+    ok(SUCCEEDED(hr), "Failed to create buffer, hr %#x.\n", hr);
+
+    hr = ID3D11DeviceContext_Map(deferred, (ID3D11Resource *)buffer, 0, D3D11_MAP_WRITE_NO_OVERWRITE, 0, &map_desc);
+    ok(hr == E_INVALIDARG, "Got unexpected hr %#x.\n", hr);
+    hr = ID3D11DeviceContext_Map(deferred, (ID3D11Resource *)buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &map_desc);
+    ok(SUCCEEDED(hr), "Failed to map buffer, hr %#x.\n", hr);
+    for (i = 0; i < ARRAY_SIZE(data) / 2; ++i)
+        ((DWORD *)map_desc.pData)[i] = i;
+    ID3D11DeviceContext_Unmap(deferred, (ID3D11Resource *)buffer, 0);
+    hr = ID3D11DeviceContext_Map(deferred, (ID3D11Resource *)buffer, 0, D3D11_MAP_WRITE_NO_OVERWRITE, 0, &map_desc);
+    ok(SUCCEEDED(hr), "Failed to map buffer, hr %#x.\n", hr);
+    for (i = ARRAY_SIZE(data) / 2; i < ARRAY_SIZE(data); ++i)
+        ((DWORD *)map_desc.pData)[i] = i;
+    ID3D11DeviceContext_Unmap(deferred, (ID3D11Resource *)buffer, 0);
+    hr = ID3D11DeviceContext_FinishCommandList(deferred, FALSE, &command_list);
+    ok(SUCCEEDED(hr), "Failed to finish command list, hr %#x.\n", hr);
+    ID3D11DeviceContext_ExecuteCommandList(context, command_list, FALSE);
+    get_buffer_readback(buffer, &rb);
+    for (i = 0; i < ARRAY_SIZE(data); ++i)
+    {
+        DWORD value = get_readback_color(&rb, i, 0, 0);
+        ok(value == i, "Got unexpected value %#x at %u.\n", value, i);
+    }
+    release_resource_readback(&rb);
+    ID3D11CommandList_Release(command_list);
+
+    /* The D3D11_MAP_WRITE_DISCARD map has to be in the same command list. */
+    hr = ID3D11DeviceContext_Map(deferred, (ID3D11Resource *)buffer, 0, D3D11_MAP_WRITE_NO_OVERWRITE, 0, &map_desc);
+    ok(hr == E_INVALIDARG, "Got unexpected hr %#x.\n", hr);
+    ID3D11Buffer_Release(buffer);
+
+    /* Constant buffer ranges are recorded. */
+    if (SUCCEEDED(ID3D11DeviceContext_QueryInterface(deferred, &IID_ID3D11DeviceContext1, (void **)&deferred1)))
+    {
+        ID3D11DeviceContext_QueryInterface(context, &IID_ID3D11DeviceContext1, (void **)&context1);
+        buffer = create_buffer(device, D3D11_BIND_CONSTANT_BUFFER, 4096, NULL);
+
+        first_constant = 16;
+        num_constants = 32;
+        ID3D11DeviceContext1_VSSetConstantBuffers1(deferred1, 0, 1, &buffer, &first_constant, &num_constants);
+        first_constant = num_constants = 0;
+        ID3D11DeviceContext1_VSGetConstantBuffers1(deferred1, 0, 1, &tmp_buffer, &first_constant, &num_constants);
+        ok(tmp_buffer == buffer, "Got unexpected buffer %p.\n", tmp_buffer);
+        ok(first_constant == 16, "Got unexpected first constant %u.\n", first_constant);
+        ok(num_constants == 32, "Got unexpected constant count %u.\n", num_constants);
+        ID3D11Buffer_Release(tmp_buffer);
+
+        hr = ID3D11DeviceContext1_FinishCommandList(deferred1, FALSE, &command_list);
+        ok(SUCCEEDED(hr), "Failed to finish command list, hr %#x.\n", hr);
+        ID3D11DeviceContext1_ExecuteCommandList(context1, command_list, TRUE);
+        ID3D11DeviceContext1_VSGetConstantBuffers1(context1, 0, 1, &tmp_buffer, NULL, NULL);
+        ok(!tmp_buffer, "Got unexpected buffer %p.\n", tmp_buffer);
+        ID3D11DeviceContext1_ExecuteCommandList(context1, command_list, FALSE);
+        ID3D11DeviceContext1_VSGetConstantBuffers1(context1, 0, 1, &tmp_buffer, &first_constant, &num_constants);
+        ok(!tmp_buffer, "Got unexpected buffer %p.\n", tmp_buffer);
+        ID3D11CommandList_Release(command_list);
+
+        /* The state is kept with "restore" set. */
+        first_constant = 16;
+        num_constants = 32;
+        ID3D11DeviceContext1_VSSetConstantBuffers1(deferred1, 0, 1, &buffer, &first_constant, &num_constants);
+        hr = ID3D11DeviceContext1_FinishCommandList(deferred1, TRUE, &command_list);
+        ok(SUCCEEDED(hr), "Failed to finish command list, hr %#x.\n", hr);
+        ID3D11CommandList_Release(command_list);
+        first_constant = num_constants = 0;
+        ID3D11DeviceContext1_VSGetConstantBuffers1(deferred1, 0, 1, &tmp_buffer, &first_constant, &num_constants);
+        ok(tmp_buffer == buffer, "Got unexpected buffer %p.\n", tmp_buffer);
+        ok(first_constant == 16, "Got unexpected first constant %u.\n", first_constant);
+        ok(num_constants == 32, "Got unexpected constant count %u.\n", num_constants);
+        ID3D11Buffer_Release(tmp_buffer);
+
+        /* Ranges that are not multiples of 16 constants are rejected. */
+        first_constant = 8;
+        num_constants = 16;
+        ID3D11DeviceContext1_VSSetConstantBuffers1(deferred1, 0, 1, &buffer, &first_constant, &num_constants);
+        first_constant = num_constants = 0;
+        ID3D11DeviceContext1_VSGetConstantBuffers1(deferred1, 0, 1, &tmp_buffer, &first_constant, &num_constants);
+        ok(tmp_buffer == buffer, "Got unexpected buffer %p.\n", tmp_buffer);
+        ok(first_constant == 16, "Got unexpected first constant %u.\n", first_constant);
+        ok(num_constants == 32, "Got unexpected constant count %u.\n", num_constants);
+        ID3D11Buffer_Release(tmp_buffer);
+
+        ID3D11Buffer_Release(buffer);
+        ID3D11DeviceContext1_Release(context1);
+        ID3D11DeviceContext1_Release(deferred1);
+    }
+    else
+    {
+        win_skip("ID3D11DeviceContext1 is not available.\n");
+    }
+
+    refcount = ID3D11DeviceContext_Release(deferred);
+    ok(!refcount, "Deferred context has %u references left.\n", refcount);
+    release_test_context(&test_context);
+}
+
 START_TEST(d3d11)
 {
     unsigned int argc, i;
@@ -27734,4 +27945,5 @@ START_TEST(d3d11)
     test_sample_shading();
     test_sample_mask();
     test_depth_clip();
+    test_deferred_context();
 }
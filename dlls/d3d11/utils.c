@@ -819,6 +819,33 @@ unsigned int wined3d_access_from_d3d11(D3D11_USAGE usage, UINT cpu_access)
     return access;
 }
 
+BOOL d3d11_validate_constant_buffer_ranges(UINT buffer_count,
+        const UINT *first_constant, const UINT *num_constants)
+{
+    unsigned int i;
+
+    if (!first_constant && !num_constants)
+        return TRUE;
+    if (!first_constant || !num_constants)
+    {
+        WARN("Invalid buffer ranges, first_constant %p, num_constants %p.\n", first_constant, num_constants);
+        return FALSE;
+    }
+
+    for (i = 0; i < buffer_count; ++i)
+    {
+        if (first_constant[i] % 16 || num_constants[i] % 16
+                || num_constants[i] > D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT)
+        {
+            WARN("Invalid buffer range %u, first_constant %u, num_constants %u.\n",
+                    i, first_constant[i], num_constants[i]);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
 HRESULT d3d_get_private_data(struct wined3d_private_store *store,
         REFGUID guid, UINT *data_size, void *data)
 {
@@ -4110,10 +4110,7 @@ BOOL WINAPI GetProcessDEPPolicy(HANDLE process, LPDWORD flags, PBOOL permanent)
  */
 VOID WINAPI FlushProcessWriteBuffers(void)
 {
-    static int once = 0;
-
-    if (!once++)
-        FIXME(": stub\n");
+    NtFlushProcessWriteBuffers();
 }
 
 /***********************************************************************
@@ -39,6 +39,7 @@
 #define HEAP_VALIDATE_PARAMS  0x40000000
 
 static BOOL (WINAPI *pHeapQueryInformation)(HANDLE, HEAP_INFORMATION_CLASS, PVOID, SIZE_T, PSIZE_T);
+static BOOL (WINAPI *pHeapSetInformation)(HANDLE, HEAP_INFORMATION_CLASS, PVOID, SIZE_T);
 static BOOL (WINAPI *pGetPhysicallyInstalledSystemMemory)(ULONGLONG *);
 static ULONG (WINAPI *pRtlGetNtGlobalFlags)(void);
 
@@ -892,6 +893,116 @@ static void test_HeapQueryInformation(void)
     ok(info == 0 || info == 1 || info == 2, "expected 0, 1 or 2, got %u\n", info);
 }
 
+static void test_low_fragmentation_heap(void)
+{
+    PROCESS_HEAP_ENTRY entry;
+    HANDLE heap;
+    ULONG info;
+    BOOL ret;
+    BYTE *ptrs[300];
+    SIZE_T size;
+    int i, j, busy;
+
+    pHeapSetInformation = (void *)GetProcAddress(GetModuleHandleA("kernel32.dll"), "HeapSetInformation");
+    if (!pHeapSetInformation || !pHeapQueryInformation)
+    {
+        win_skip("HeapSetInformation is not available\n");
+        return;
+    }
+
+    heap = HeapCreate(HEAP_NO_SERIALIZE, 0, 0);
+    ok(heap != NULL, "HeapCreate failed\n");
+    info = 2;
+    ret = pHeapSetInformation(heap, HeapCompatibilityInformation, &info, sizeof(info));
+    ok(!ret, "HeapSetInformation should fail for a HEAP_NO_SERIALIZE heap\n");
+    HeapDestroy(heap);
+
+    heap = HeapCreate(0, 0, 0);
+    ok(heap != NULL, "HeapCreate failed\n");
+    info = 2;
+    ret = pHeapSetInformation(heap, HeapCompatibilityInformation, &info, sizeof(info));
+    ok(ret, "HeapSetInformation error %u\n", GetLastError());
+    info = 0xdeadbeef;
+    ret = pHeapQueryInformation(heap, HeapCompatibilityInformation, &info, sizeof(info), NULL);
+    ok(ret, "HeapQueryInformation error %u\n", GetLastError());
+    ok(info == 2, "expected 2, got %u\n", info);
+
+    for (i = 0; i < sizeof(ptrs) / sizeof(ptrs[0]); i++)
+    {
+        ptrs[i] = HeapAlloc(heap, (i & 1) ? HEAP_ZERO_MEMORY : 0, i * 7 + 1);
+        ok(ptrs[i] != NULL, "HeapAlloc failed for size %u\n", i * 7 + 1);
+        if (i & 1)
+        {
+            for (j = 0; j < i * 7 + 1; j++)
+                if (ptrs[i][j]) break;
+            ok(j == i * 7 + 1, "block %u not zeroed\n", i);
+        }
+        memset(ptrs[i], i, i * 7 + 1);
+        size = HeapSize(heap, 0, ptrs[i]);
+        ok(size == i * 7 + 1, "wrong size %lu for block %u\n", size, i);
+    }
+
+    ret = HeapValidate(heap, 0, NULL);
+    ok(ret, "HeapValidate failed\n");
+
+    for (i = 0; i < sizeof(ptrs) / sizeof(ptrs[0]); i += 2)
+    {
+        ptrs[i] = HeapReAlloc(heap, 0, ptrs[i], i * 7 + 100);
+        ok(ptrs[i] != NULL, "HeapReAlloc failed for block %u\n", i);
+        for (j = 0; j < i * 7 + 1; j++)
+            if (ptrs[i][j] != (BYTE)i) break;
+        ok(j == i * 7 + 1, "block %u contents not preserved\n", i);
+        size = HeapSize(heap, 0, ptrs[i]);
+        ok(size == i * 7 + 100, "wrong size %lu for block %u\n", size, i);
+        ret = HeapValidate(heap, 0, ptrs[i]);
+        ok(ret, "HeapValidate failed for block %u\n", i);
+    }
+
+    /* shrink the odd blocks, most of them to a smaller size class */
+    for (i = 1; i < sizeof(ptrs) / sizeof(ptrs[0]); i += 2)
+    {
+        ptrs[i] = HeapReAlloc(heap, 0, ptrs[i], i + 1);
+        ok(ptrs[i] != NULL, "HeapReAlloc failed for block %u\n", i);
+        for (j = 0; j < i + 1; j++)
+            if (ptrs[i][j] != (BYTE)i) break;
+        ok(j == i + 1, "block %u contents not preserved\n", i);
+        size = HeapSize(heap, 0, ptrs[i]);
+        ok(size == i + 1, "wrong size %lu for block %u\n", size, i);
+        ret = HeapValidate(heap, 0, ptrs[i]);
+        ok(ret, "HeapValidate failed for block %u\n", i);
+    }
+
+    ret = HeapValidate(heap, 0, NULL);
+    ok(ret, "HeapValidate failed\n");
+
+    for (i = 0; i < sizeof(ptrs) / sizeof(ptrs[0]); i += 3)
+    {
+        ret = HeapFree(heap, 0, ptrs[i]);
+        ok(ret, "HeapFree failed for block %u\n", i);
+        ptrs[i] = NULL;
+    }
+
+    ret = HeapValidate(heap, 0, NULL);
+    ok(ret, "HeapValidate failed\n");
+
+    busy = 0;
+    memset(&entry, 0, sizeof(entry));
+    while (HeapWalk(heap, &entry))
+        if (entry.wFlags & PROCESS_HEAP_ENTRY_BUSY) busy++;
+    ok(GetLastError() == ERROR_NO_MORE_ITEMS, "HeapWalk failed with error %u\n", GetLastError());
+    ok(busy > 0, "no busy blocks found\n");
+
+    for (i = 0; i < sizeof(ptrs) / sizeof(ptrs[0]); i++)
+    {
+        if (!ptrs[i]) continue;
+        ret = HeapFree(heap, 0, ptrs[i]);
+        ok(ret, "HeapFree failed for block %u\n", i);
+    }
+
+    ret = HeapDestroy(heap);
+    ok(ret, "HeapDestroy failed\n");
+}
+
 static void test_heap_checks( DWORD flags )
 {
     BYTE old, *p, *p2;
@@ -1245,6 +1356,7 @@ START_TEST(heap)
     test_sized_HeapReAlloc((1 << 20), 1);
 
     test_HeapQueryInformation();
+    test_low_fragmentation_heap();
     test_GetPhysicallyInstalledSystemMemory();
 
     if (pRtlGetNtGlobalFlags)
@@ -303,6 +303,39 @@ static void testGetProcAddress_Wrong(void)
     ok( GetLastError() == ERROR_MOD_NOT_FOUND, "Expected ERROR_MOD_NOT_FOUND, got %d\n", GetLastError() );
 }
 
+static void testGetProcAddress_names(void)
+{
+    HMODULE module = GetModuleHandleA("kernel32.dll");
+    const IMAGE_NT_HEADERS *nt = (const IMAGE_NT_HEADERS *)((const char *)module + ((const IMAGE_DOS_HEADER *)module)->e_lfanew);
+    const IMAGE_DATA_DIRECTORY *dir = &nt->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT];
+    const IMAGE_EXPORT_DIRECTORY *exports = (const IMAGE_EXPORT_DIRECTORY *)((const char *)module + dir->VirtualAddress);
+    const DWORD *names = (const DWORD *)((const char *)module + exports->AddressOfNames);
+    const WORD *ordinals = (const WORD *)((const char *)module + exports->AddressOfNameOrdinals);
+    FARPROC by_name, by_ordinal;
+    DWORD i;
+
+    ok(exports->NumberOfNames > 100, "got %u names\n", exports->NumberOfNames);
+
+    /* look up every name, in reverse order to defeat any hint */
+    for (i = exports->NumberOfNames; i > 0; i--)
+    {
+        const char *name = (const char *)module + names[i - 1];
+
+        by_name = GetProcAddress(module, name);
+        by_ordinal = GetProcAddress(module, (const char *)(ULONG_PTR)(ordinals[i - 1] + exports->Base));
+        ok(by_name != NULL, "%s not found\n", name);
+        ok(by_name == by_ordinal, "%s: got %p by name, %p by ordinal\n", name, by_name, by_ordinal);
+    }
+
+    SetLastError(0xdeadbeef);
+    by_name = GetProcAddress(module, "non_ex_call");
+    ok(!by_name, "non_ex_call should not be found\n");
+    ok(GetLastError() == ERROR_PROC_NOT_FOUND, "Expected ERROR_PROC_NOT_FOUND, got %d\n", GetLastError());
+
+    by_name = GetProcAddress(module, "getprocaddress");
+    ok(!by_name, "names should be case sensitive\n");
+}
+
 static void testLoadLibraryEx(void)
 {
     CHAR path[MAX_PATH];
@@ -1040,6 +1073,7 @@ START_TEST(module)
     testNestedLoadLibraryA();
     testLoadLibraryA_Wrong();
     testGetProcAddress_Wrong();
+    testGetProcAddress_names();
     testLoadLibraryEx();
     test_LoadLibraryEx_search_flags();
     testGetModuleHandleEx();
@@ -54,6 +54,7 @@ static BOOL   (WINAPI *pIsWow64Process)(HANDLE, PBOOL);
 static NTSTATUS (WINAPI *pNtProtectVirtualMemory)(HANDLE, PVOID *, SIZE_T *, ULONG, ULONG *);
 static NTSTATUS (WINAPI *pNtAllocateVirtualMemory)(HANDLE, PVOID *, ULONG, SIZE_T *, ULONG, ULONG);
 static NTSTATUS (WINAPI *pNtFreeVirtualMemory)(HANDLE, PVOID *, SIZE_T *, ULONG);
+static SIZE_T (WINAPI *pGetLargePageMinimum)(void);
 
 /* ############################### */
 
@@ -4333,6 +4334,52 @@ static void test_shared_memory_ro(BOOL is_child, DWORD child_access)
     CloseHandle(mapping);
 }
 
+static void test_large_pages(void)
+{
+    SIZE_T size;
+    char *p;
+    BOOL ret;
+
+    if (!pGetLargePageMinimum)
+    {
+        win_skip("GetLargePageMinimum is not available\n");
+        return;
+    }
+    if (!(size = pGetLargePageMinimum()))
+    {
+        skip("large pages are not supported\n");
+        return;
+    }
+    trace("large page size %#lx\n", size);
+    ok(!(size & (si.dwPageSize - 1)), "large page size %#lx not page aligned\n", size);
+
+    SetLastError(0xdeadbeef);
+    p = VirtualAlloc(NULL, si.dwPageSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    ok(p == NULL, "VirtualAlloc should fail\n");
+    ok(GetLastError() == ERROR_INVALID_PARAMETER || GetLastError() == ERROR_PRIVILEGE_NOT_HELD,
+       "wrong error %u\n", GetLastError());
+
+    SetLastError(0xdeadbeef);
+    p = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
+    ok(p == NULL, "VirtualAlloc should fail\n");
+    ok(GetLastError() == ERROR_INVALID_PARAMETER || GetLastError() == ERROR_PRIVILEGE_NOT_HELD,
+       "wrong error %u\n", GetLastError());
+
+    SetLastError(0xdeadbeef);
+    p = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    if (!p)
+    {
+        ok(GetLastError() == ERROR_PRIVILEGE_NOT_HELD, "wrong error %u\n", GetLastError());
+        return;
+    }
+    ok(!((ULONG_PTR)p & (size - 1)), "%p not aligned to %#lx\n", p, size);
+    p[0] = 1;
+    p[size - 1] = 2;
+    ok(p[0] == 1 && p[size - 1] == 2, "wrong data\n");
+    ret = VirtualFree(p, 0, MEM_RELEASE);
+    ok(ret, "VirtualFree failed %u\n", GetLastError());
+}
+
 START_TEST(virtual)
 {
     int argc;
@@ -4390,6 +4437,7 @@ START_TEST(virtual)
     pNtProtectVirtualMemory = (void *)GetProcAddress( hntdll, "NtProtectVirtualMemory" );
     pNtAllocateVirtualMemory = (void *)GetProcAddress( hntdll, "NtAllocateVirtualMemory" );
     pNtFreeVirtualMemory = (void *)GetProcAddress( hntdll, "NtFreeVirtualMemory" );
+    pGetLargePageMinimum = (void *)GetProcAddress( hkernel32, "GetLargePageMinimum" );
 
     GetSystemInfo(&si);
     trace("system page size %#x\n", si.dwPageSize);
@@ -4404,6 +4452,7 @@ START_TEST(virtual)
     test_VirtualProtect();
     test_VirtualAllocEx();
     test_VirtualAlloc();
+    test_large_pages();
     test_MapViewOfFile();
     test_NtMapViewOfSection();
     test_NtAreMappedFilesTheSame();
@@ -223,6 +223,7 @@ static int (__cdecl *p_event_wait_for_multiple)(event**, size_t, MSVCRT_bool, un
 
 static Context* (__cdecl *p_Context_CurrentContext)(void);
 static unsigned int (__cdecl *p_Context_Id)(void);
+static void (__cdecl *p_Context_Block)(void);
 static SchedulerPolicy* (__thiscall *p_SchedulerPolicy_ctor)(SchedulerPolicy*);
 static void (__thiscall *p_SchedulerPolicy_SetConcurrencyLimits)(SchedulerPolicy*, unsigned int, unsigned int);
 static void (__thiscall *p_SchedulerPolicy_dtor)(SchedulerPolicy*);
@@ -230,6 +231,7 @@ static Scheduler* (__cdecl *p_Scheduler_Create)(SchedulerPolicy*);
 static Scheduler* (__cdecl *p_CurrentScheduler_Get)(void);
 static void (__cdecl *p_CurrentScheduler_Detach)(void);
 static unsigned int (__cdecl *p_CurrentScheduler_Id)(void);
+static void (__cdecl *p_CurrentScheduler_ScheduleTask)(void (__cdecl*)(void*), void*);
 
 static int (__cdecl *p__memicmp)(const char*, const char*, size_t);
 static int (__cdecl *p__memicmp_l)(const char*, const char*, size_t,_locale_t);
@@ -272,6 +274,7 @@ static BOOL init(void)
     SET(p_setlocale, "setlocale");
 
     SET(p_Context_Id, "?Id@Context@Concurrency@@SAIXZ");
+    SET(p_Context_Block, "?Block@Context@Concurrency@@SAXXZ");
     SET(p_CurrentScheduler_Detach, "?Detach@CurrentScheduler@Concurrency@@SAXXZ");
     SET(p_CurrentScheduler_Id, "?Id@CurrentScheduler@Concurrency@@SAIXZ");
 
@@ -316,6 +319,7 @@ static BOOL init(void)
         SET(p_SchedulerPolicy_dtor, "??1SchedulerPolicy@Concurrency@@QEAA@XZ");
         SET(p_Scheduler_Create, "?Create@Scheduler@Concurrency@@SAPEAV12@AEBVSchedulerPolicy@2@@Z");
         SET(p_CurrentScheduler_Get, "?Get@CurrentScheduler@Concurrency@@SAPEAVScheduler@2@XZ");
+        SET(p_CurrentScheduler_ScheduleTask, "?ScheduleTask@CurrentScheduler@Concurrency@@SAXP6AXPEAX@Z0@Z");
     } else {
         SET(pSpinWait_ctor_yield, "??0?$_SpinWait@$00@details@Concurrency@@QAE@P6AXXZ@Z");
         SET(pSpinWait_dtor, "??_F?$_SpinWait@$00@details@Concurrency@@QAEXXZ");
@@ -357,6 +361,7 @@ static BOOL init(void)
         SET(p_SchedulerPolicy_dtor, "??1SchedulerPolicy@Concurrency@@QAE@XZ");
         SET(p_Scheduler_Create, "?Create@Scheduler@Concurrency@@SAPAV12@ABVSchedulerPolicy@2@@Z");
         SET(p_CurrentScheduler_Get, "?Get@CurrentScheduler@Concurrency@@SAPAVScheduler@2@XZ");
+        SET(p_CurrentScheduler_ScheduleTask, "?ScheduleTask@CurrentScheduler@Concurrency@@SAXP6AXPAX@Z0@Z");
     }
 
     init_thiscall_thunk();
@@ -977,6 +982,128 @@ static void test_Scheduler(void)
     call_func1(p_SchedulerPolicy_dtor, &policy);
 }
 
+static LONG task_count;
+static HANDLE tasks_done;
+static Context *blocked_context;
+
+static void __cdecl counting_task(void *arg)
+{
+    if(!InterlockedDecrement(&task_count))
+        SetEvent(tasks_done);
+}
+
+static void __cdecl spawning_task(void *arg)
+{
+    int i;
+
+    for(i=0; i<PtrToInt(arg); i++)
+        p_CurrentScheduler_ScheduleTask(counting_task, NULL);
+    counting_task(NULL);
+}
+
+static void __cdecl blocking_task(void *arg)
+{
+    blocked_context = p_Context_CurrentContext();
+    SetEvent(arg);
+    p_Context_Block();
+    SetEvent(tasks_done);
+}
+
+static DWORD resume_ret;
+
+static void __cdecl resuming_task(void *arg)
+{
+    void (__thiscall *unblock)(Context*) = ((void**)blocked_context->vtable)[3];
+
+    call_func1(unblock, blocked_context);
+    resume_ret = WaitForSingleObject(tasks_done, 5000);
+    SetEvent(arg);
+}
+
+static void test_ScheduleTask(void)
+{
+    void (__thiscall *unblock)(Context*);
+    HANDLE started, resumed, shutdown;
+    SchedulerPolicy policy;
+    Scheduler *scheduler;
+    DWORD ret;
+    int i;
+
+    tasks_done = CreateEventW(NULL, FALSE, FALSE, NULL);
+
+    /* all tasks are queued from an external context */
+    task_count = 20000;
+    for(i=0; i<20000; i++)
+        p_CurrentScheduler_ScheduleTask(counting_task, NULL);
+    ret = WaitForSingleObject(tasks_done, 10000);
+    ok(ret == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", ret);
+    ok(!task_count, "task_count = %d\n", task_count);
+
+    /* tasks are spawned from worker queues and stolen by the other workers */
+    task_count = 200 * 101;
+    for(i=0; i<200; i++)
+        p_CurrentScheduler_ScheduleTask(spawning_task, IntToPtr(100));
+    ret = WaitForSingleObject(tasks_done, 10000);
+    ok(ret == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", ret);
+    ok(!task_count, "task_count = %d\n", task_count);
+
+    /* blocked contexts are resumed by Unblock */
+    started = CreateEventW(NULL, FALSE, FALSE, NULL);
+    p_CurrentScheduler_ScheduleTask(blocking_task, started);
+    ret = WaitForSingleObject(started, 10000);
+    ok(ret == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", ret);
+    ok(blocked_context != NULL, "blocked_context = NULL\n");
+    ret = WaitForSingleObject(tasks_done, 100);
+    ok(ret == WAIT_TIMEOUT, "WaitForSingleObject returned %u\n", ret);
+    unblock = ((void**)blocked_context->vtable)[3];
+    call_func1(unblock, blocked_context);
+    ret = WaitForSingleObject(tasks_done, 10000);
+    ok(ret == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", ret);
+    CloseHandle(started);
+
+    /* queued tasks are run before the scheduler shuts down */
+    call_func1(p_SchedulerPolicy_ctor, &policy);
+    call_func3(p_SchedulerPolicy_SetConcurrencyLimits, &policy, 2, 2);
+    scheduler = p_Scheduler_Create(&policy);
+    call_func1(p_SchedulerPolicy_dtor, &policy);
+    shutdown = CreateEventW(NULL, TRUE, FALSE, NULL);
+    call_func2(scheduler->vtable->RegisterShutdownEvent, scheduler, shutdown);
+
+    call_func1(scheduler->vtable->Attach, scheduler);
+    task_count = 1000;
+    for(i=0; i<1000; i++)
+        p_CurrentScheduler_ScheduleTask(counting_task, NULL);
+    p_CurrentScheduler_Detach();
+    call_func1(scheduler->vtable->Release, scheduler);
+
+    ret = WaitForSingleObject(shutdown, 10000);
+    ok(ret == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", ret);
+    ok(!task_count, "task_count = %d\n", task_count);
+    CloseHandle(shutdown);
+
+    /* tasks queued behind a blocked context can wait for it to resume */
+    call_func1(p_SchedulerPolicy_ctor, &policy);
+    call_func3(p_SchedulerPolicy_SetConcurrencyLimits, &policy, 1, 1);
+    scheduler = p_Scheduler_Create(&policy);
+    call_func1(p_SchedulerPolicy_dtor, &policy);
+    call_func1(scheduler->vtable->Attach, scheduler);
+    started = CreateEventW(NULL, FALSE, FALSE, NULL);
+    resumed = CreateEventW(NULL, FALSE, FALSE, NULL);
+    blocked_context = NULL;
+    p_CurrentScheduler_ScheduleTask(blocking_task, started);
+    ret = WaitForSingleObject(started, 10000);
+    ok(ret == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", ret);
+    p_CurrentScheduler_ScheduleTask(resuming_task, resumed);
+    p_CurrentScheduler_Detach();
+    ret = WaitForSingleObject(resumed, 10000);
+    ok(ret == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", ret);
+    ok(resume_ret == WAIT_OBJECT_0, "blocked context was not resumed: %u\n", resume_ret);
+    call_func1(scheduler->vtable->Release, scheduler);
+    CloseHandle(started);
+    CloseHandle(resumed);
+    CloseHandle(tasks_done);
+}
+
 static void test__memicmp(void)
 {
     static const char *s1 = "abc";
@@ -1072,6 +1199,7 @@ START_TEST(msvcr100)
 
     test_ExternalContextBase();
     test_Scheduler();
+    test_ScheduleTask();
     test_wmemcpy_s();
     test_wmemmove_s();
     test_fread_s();
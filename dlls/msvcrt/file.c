@@ -126,6 +126,36 @@ static int MSVCRT_max_streams = 512, MSVCRT_stream_idx;
 /* INTERNAL: process umask */
 static int MSVCRT_umask = 0;
 
+#if defined(__i386__) || defined(__x86_64__)
+/* While the process has a single thread, fgetc and fputc don't take the
+ * stream lock when they only need to touch the FILE buffer. The flag is
+ * cleared when the second thread starts, see msvcrt_io_thread_attach.
+ * This relies on x86 stores not being reordered with other stores. */
+static volatile BOOL stdio_single_thread;
+static volatile BOOL stdio_unlocked_op;
+
+static inline BOOL stdio_begin_unlocked(void)
+{
+    if (!stdio_single_thread) return FALSE;
+    stdio_unlocked_op = TRUE;
+    /* keep the stream accesses after the flag is set */
+    __asm__ __volatile__( "" ::: "memory" );
+    if (stdio_single_thread) return TRUE;
+    stdio_unlocked_op = FALSE;
+    return FALSE;
+}
+
+static inline void stdio_end_unlocked(void)
+{
+    /* keep the stream accesses before the flag is cleared */
+    __asm__ __volatile__( "" ::: "memory" );
+    stdio_unlocked_op = FALSE;
+}
+#else
+static inline BOOL stdio_begin_unlocked(void) { return FALSE; }
+static inline void stdio_end_unlocked(void) { }
+#endif
+
 /* INTERNAL: static data for tmpnam and _wtmpname functions */
 static int tmpnam_unique;
 static int tmpnam_s_unique;
@@ -649,6 +679,46 @@ void msvcrt_init_io(void)
     MSVCRT__iob[i]._flag = (i == 0) ? MSVCRT__IOREAD : MSVCRT__IOWRT;
   }
   MSVCRT_stream_idx = 3;
+
+#if defined(__i386__) || defined(__x86_64__)
+  {
+    BOOLEAN last;
+
+    if (!NtQueryInformationThread(GetCurrentThread(), ThreadAmILastThread, &last, sizeof(last), NULL) && last)
+      stdio_single_thread = TRUE;
+  }
+#endif
+}
+
+/* INTERNAL: called for every new thread before it can use the streams */
+void msvcrt_io_thread_attach(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+  if (!stdio_single_thread) return;
+
+  TRACE("disabling unlocked stream access\n");
+  stdio_single_thread = FALSE;
+  /* make sure the first thread either sees the flag or has published
+   * stdio_unlocked_op, then wait for its unlocked operation to finish.
+   * The wait is bounded since a fault in the middle of the operation,
+   * handled further up the stack, leaves the flag set forever. */
+  FlushProcessWriteBuffers();
+  if (stdio_unlocked_op)
+  {
+    DWORD start = GetTickCount();
+
+    while (stdio_unlocked_op)
+    {
+      if (GetTickCount() - start > 1000)
+      {
+        WARN("unlocked stream access didn't finish, ignoring it\n");
+        stdio_unlocked_op = FALSE;
+        break;
+      }
+      Sleep(0);
+    }
+  }
+#endif
 }
 
 /* INTERNAL: Flush stdio file buffer */
@@ -3725,6 +3795,12 @@ int CDECL MSVCRT_fgetc(MSVCRT_FILE* file)
 {
     int ret;
 
+    if(file->_cnt>0 && stdio_begin_unlocked()) {
+        ret = MSVCRT__fgetc_nolock(file);
+        stdio_end_unlocked();
+        return ret;
+    }
+
     MSVCRT__lock_file(file);
     ret = MSVCRT__fgetc_nolock(file);
     MSVCRT__unlock_file(file);
@@ -4228,6 +4304,13 @@ int CDECL MSVCRT_fputc(int c, MSVCRT_FILE* file)
 {
     int ret;
 
+    /* writing a newline flushes the buffer */
+    if(file->_cnt>0 && c!='\n' && stdio_begin_unlocked()) {
+        ret = MSVCRT__fputc_nolock(c, file);
+        stdio_end_unlocked();
+        return ret;
+    }
+
     MSVCRT__lock_file(file);
     ret = MSVCRT__fputc_nolock(c, file);
     MSVCRT__unlock_file(file);
@@ -127,6 +127,7 @@ BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvReserved)
     TRACE("finished process init\n");
     break;
   case DLL_THREAD_ATTACH:
+    msvcrt_io_thread_attach();
     break;
   case DLL_PROCESS_DETACH:
     msvcrt_free_io();
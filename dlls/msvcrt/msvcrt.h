@@ -332,8 +332,10 @@ extern void msvcrt_free_locks(void) DECLSPEC_HIDDEN;
 extern void msvcrt_init_exception(void*) DECLSPEC_HIDDEN;
 extern BOOL msvcrt_init_locale(void) DECLSPEC_HIDDEN;
 extern void msvcrt_init_math(void) DECLSPEC_HIDDEN;
+extern BOOL sse2_supported DECLSPEC_HIDDEN;
 extern void msvcrt_init_io(void) DECLSPEC_HIDDEN;
 extern void msvcrt_free_io(void) DECLSPEC_HIDDEN;
+extern void msvcrt_io_thread_attach(void) DECLSPEC_HIDDEN;
 extern void msvcrt_init_console(void) DECLSPEC_HIDDEN;
 extern void msvcrt_free_console(void) DECLSPEC_HIDDEN;
 extern void msvcrt_init_args(void) DECLSPEC_HIDDEN;
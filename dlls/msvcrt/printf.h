@@ -320,6 +320,102 @@ static inline void FUNC_NAME(pf_integer_conv)(APICHAR *buf, int buf_len,
     }
 }
 
+/* pf_fixed_conv:  exact %f conversion of non-negative values that fit in
+   64-bit fixed point, returns FALSE if sprintf needs to be used instead */
+static inline BOOL FUNC_NAME(pf_fixed_conv)(char *buf, double val,
+        FUNC_NAME(pf_flags) *flags)
+{
+    static const ULONGLONG pow10[] = { 1, 10, 100, 1000, 10000, 100000,
+        1000000, 10000000, 100000000, 1000000000, 10000000000, 100000000000,
+        1000000000000, 10000000000000, 100000000000000, 1000000000000000,
+        10000000000000000, 100000000000000000 };
+    union { double f; ULONGLONG i; } u;
+    ULONGLONG m, f, n, hi, lo, mid1, mid2, rem_hi, rem_lo, half_hi, half_lo;
+    int prec = flags->Precision==-1 ? 6 : flags->Precision;
+    int e, k, i;
+    char digits[24];
+
+    if(prec >= sizeof(pow10)/sizeof(pow10[0]) || !(val < 9e18 / pow10[prec]))
+        return FALSE;
+#if defined(__i386__) || defined(__x86_64__)
+    /* sprintf honors the rounding mode, only round to nearest is handled here */
+    if((_control87(0, 0) & MSVCRT__MCW_RC) != MSVCRT__RC_NEAR)
+        return FALSE;
+#endif
+
+    u.f = val;
+    if(u.i >> 63)
+        return FALSE; /* -0.0 */
+    e = (u.i >> 52) & 0x7ff;
+    m = u.i & (((ULONGLONG)1 << 52) - 1);
+    if(e) m |= (ULONGLONG)1 << 52;
+    else e = 1;
+    e -= 1075;
+
+    if(e >= 0) {
+        n = (m << e) * pow10[prec];
+    } else {
+        /* val * 10^prec = m * 5^prec / 2^(-e-prec), compute the product in 128 bits */
+        for(f = 1, i = 0; i < prec; i++)
+            f *= 5;
+        lo = (m & 0xffffffff) * (f & 0xffffffff);
+        mid1 = (m >> 32) * (f & 0xffffffff);
+        mid2 = (m & 0xffffffff) * (f >> 32);
+        hi = (m >> 32) * (f >> 32);
+        mid1 += (lo >> 32) + (mid2 & 0xffffffff);
+        lo = (lo & 0xffffffff) | (mid1 << 32);
+        hi += (mid1 >> 32) + (mid2 >> 32);
+
+        k = -e - prec;
+        if(k <= 0) {
+            /* the value is an integer, the result fits in 64 bits */
+            n = lo << -k;
+        } else if(k >= 128) {
+            /* the product has at most 93 bits, so the value is less than 0.5 */
+            n = 0;
+        } else {
+            if(k > 64) {
+                n = hi >> (k - 64);
+                rem_hi = hi & (((ULONGLONG)1 << (k - 64)) - 1);
+                rem_lo = lo;
+                half_hi = (ULONGLONG)1 << (k - 65);
+                half_lo = 0;
+            } else if(k == 64) {
+                n = hi;
+                rem_hi = 0;
+                rem_lo = lo;
+                half_hi = 0;
+                half_lo = (ULONGLONG)1 << 63;
+            } else {
+                n = (lo >> k) | (hi << 1 << (63 - k));
+                rem_hi = 0;
+                rem_lo = lo & (((ULONGLONG)1 << k) - 1);
+                half_hi = 0;
+                half_lo = (ULONGLONG)1 << (k - 1);
+            }
+
+            /* native rounds exact ties away from zero, unlike sprintf */
+            if(rem_hi > half_hi || (rem_hi == half_hi && rem_lo >= half_lo))
+                n++;
+        }
+    }
+
+    i = 0;
+    do {
+        digits[i++] = '0' + n % 10;
+        n /= 10;
+    } while(n || i <= prec);
+
+    while(i > prec)
+        *buf++ = digits[--i];
+    if(prec || flags->Alternate)
+        *buf++ = '.';
+    while(i > 0)
+        *buf++ = digits[--i];
+    *buf = 0;
+    return TRUE;
+}
+
 static inline void FUNC_NAME(pf_fixup_exponent)(char *buf, BOOL three_digit_exp)
 {
     char* tmp = buf;
@@ -640,7 +736,8 @@ int FUNC_NAME(pf_printf)(FUNC_NAME(puts_clbk) pf_puts, void *puts_ctx, const API
                 if (strchr("EFG", flags.Format))
                     for(i=0; tmp[i]; i++)
                         tmp[i] = toupper(tmp[i]);
-            } else {
+            } else if((flags.Format!='f' && flags.Format!='F') || inf || nan || ind ||
+                    !FUNC_NAME(pf_fixed_conv)(tmp, val, &flags)) {
                 sprintf(tmp, float_fmt, val);
                 if(toupper(flags.Format)=='E' || toupper(flags.Format)=='G')
                     FUNC_NAME(pf_fixup_exponent)(tmp, three_digit_exp);
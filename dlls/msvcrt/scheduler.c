@@ -110,14 +110,21 @@ struct scheduler_list {
     struct scheduler_list *next;
 };
 
+struct virtual_processor;
+
 typedef struct {
     Context context;
     struct scheduler_list scheduler;
     unsigned int id;
     union allocator_cache_entry *allocator_cache[8];
+    struct virtual_processor *vproc;
+    HANDLE block_event;
+    BOOL blocked;
 } ExternalContextBase;
 extern const vtable_ptr MSVCRT_ExternalContextBase_vtable;
 static void ExternalContextBase_ctor(ExternalContextBase*);
+static void ExternalContextBase_ctor_vproc(ExternalContextBase*, struct virtual_processor*);
+static void ExternalContextBase_dtor(ExternalContextBase*);
 
 typedef struct Scheduler {
     const vtable_ptr *vtable;
@@ -146,7 +153,30 @@ typedef struct Scheduler {
         void, (Scheduler*,void (__cdecl*)(void*),void*), (this,proc,data))
 #endif
 
-typedef struct {
+struct scheduled_task {
+    void (__cdecl *proc)(void*);
+    void *data;
+};
+
+/* Every virtual processor owns a queue of tasks. The worker thread running
+ * on it pushes and pops tasks at the tail, idle workers steal the oldest
+ * tasks from the head. When a worker context blocks, another worker thread
+ * is started on its virtual processor if there is work to do. */
+struct virtual_processor {
+    struct ThreadScheduler *scheduler;
+    unsigned int id;
+    CRITICAL_SECTION cs;
+    struct scheduled_task *tasks;
+    unsigned int head;
+    unsigned int size;
+    LONG count;
+    LONG active;
+};
+
+/* idle workers exit after this many milliseconds */
+#define WORKER_IDLE_TIMEOUT 5000
+
+typedef struct ThreadScheduler {
     Scheduler scheduler;
     LONG ref;
     unsigned int id;
@@ -156,6 +186,15 @@ typedef struct {
     int shutdown_size;
     HANDLE *shutdown_events;
     CRITICAL_SECTION cs;
+    struct virtual_processor *vprocs;
+    unsigned int thread_count;
+    LONG blocked;
+    LONG running;
+    LONG next_vproc;
+    LONG idle_count;
+    HANDLE work_sem;
+    HANDLE shutdown_event;
+    BOOL shutdown;
 } ThreadScheduler;
 extern const vtable_ptr MSVCRT_ThreadScheduler_vtable;
 
@@ -182,6 +221,9 @@ static ThreadScheduler *default_scheduler;
 
 static void create_default_scheduler(void);
 
+static void ThreadScheduler_dtor(ThreadScheduler*);
+static void ThreadScheduler_start_worker(ThreadScheduler*);
+
 static Context* try_get_current_context(void)
 {
     if (context_tls_index == TLS_OUT_OF_INDEXES)
@@ -189,21 +231,26 @@ static Context* try_get_current_context(void)
     return TlsGetValue(context_tls_index);
 }
 
-static Context* get_current_context(void)
+static void init_context_tls(void)
 {
-    Context *ret;
-
     if (context_tls_index == TLS_OUT_OF_INDEXES) {
         int tls_index = TlsAlloc();
         if (tls_index == TLS_OUT_OF_INDEXES) {
             throw_exception(EXCEPTION_SCHEDULER_RESOURCE_ALLOCATION_ERROR,
                     HRESULT_FROM_WIN32(GetLastError()), NULL);
-            return NULL;
+            return;
         }
 
         if(InterlockedCompareExchange(&context_tls_index, tls_index, TLS_OUT_OF_INDEXES) != TLS_OUT_OF_INDEXES)
             TlsFree(tls_index);
     }
+}
+
+static Context* get_current_context(void)
+{
+    Context *ret;
+
+    init_context_tls();
 
     ret = TlsGetValue(context_tls_index);
     if (!ret) {
@@ -215,6 +262,225 @@ static Context* get_current_context(void)
     return ret;
 }
 
+static ExternalContextBase* try_get_current_worker_context(void)
+{
+    ExternalContextBase *context = (ExternalContextBase*)try_get_current_context();
+
+    if (!context || context->context.vtable != &MSVCRT_ExternalContextBase_vtable
+            || !context->vproc)
+        return NULL;
+    return context;
+}
+
+static void vproc_push(struct virtual_processor *vproc,
+        void (__cdecl *proc)(void*), void *data)
+{
+    struct scheduled_task *task;
+
+    EnterCriticalSection(&vproc->cs);
+    if(vproc->count == vproc->size) {
+        unsigned int size = vproc->size ? vproc->size * 2 : 64, i;
+        struct scheduled_task *tasks = MSVCRT_operator_new(size * sizeof(*tasks));
+
+        for(i=0; i<vproc->count; i++)
+            tasks[i] = vproc->tasks[(vproc->head + i) & (vproc->size - 1)];
+        MSVCRT_operator_delete(vproc->tasks);
+        vproc->tasks = tasks;
+        vproc->head = 0;
+        vproc->size = size;
+    }
+    task = &vproc->tasks[(vproc->head + vproc->count) & (vproc->size - 1)];
+    task->proc = proc;
+    task->data = data;
+    vproc->count++;
+    LeaveCriticalSection(&vproc->cs);
+}
+
+/* called by the worker owning the queue, returns the newest task */
+static BOOL vproc_pop(struct virtual_processor *vproc, struct scheduled_task *task)
+{
+    BOOL ret = FALSE;
+
+    if(!vproc->count)
+        return FALSE;
+
+    EnterCriticalSection(&vproc->cs);
+    if(vproc->count) {
+        vproc->count--;
+        *task = vproc->tasks[(vproc->head + vproc->count) & (vproc->size - 1)];
+        ret = TRUE;
+    }
+    LeaveCriticalSection(&vproc->cs);
+    return ret;
+}
+
+/* called by other workers, returns the oldest task */
+static BOOL vproc_steal(struct virtual_processor *vproc, struct scheduled_task *task)
+{
+    BOOL ret = FALSE;
+
+    if(!vproc->count)
+        return FALSE;
+
+    EnterCriticalSection(&vproc->cs);
+    if(vproc->count) {
+        *task = vproc->tasks[vproc->head];
+        vproc->head = (vproc->head + 1) & (vproc->size - 1);
+        vproc->count--;
+        ret = TRUE;
+    }
+    LeaveCriticalSection(&vproc->cs);
+    return ret;
+}
+
+static BOOL scheduler_get_task(ThreadScheduler *scheduler,
+        struct virtual_processor *vproc, struct scheduled_task *task)
+{
+    unsigned int i;
+
+    if(vproc_pop(vproc, task))
+        return TRUE;
+
+    for(i=1; i<scheduler->virt_proc_no; i++) {
+        if(vproc_steal(&scheduler->vprocs[(vproc->id + i) % scheduler->virt_proc_no], task))
+            return TRUE;
+    }
+    return FALSE;
+}
+
+static BOOL scheduler_has_task(ThreadScheduler *scheduler)
+{
+    unsigned int i;
+
+    for(i=0; i<scheduler->virt_proc_no; i++)
+        if(scheduler->vprocs[i].count) return TRUE;
+    return FALSE;
+}
+
+/* number of worker threads that are not blocked */
+static inline LONG scheduler_active_workers(const ThreadScheduler *scheduler)
+{
+    return (LONG)scheduler->thread_count - scheduler->blocked;
+}
+
+/* Returns FALSE when the scheduler is shut down and there are no more tasks
+ * to run, or when there was nothing to do for WORKER_IDLE_TIMEOUT. */
+static BOOL scheduler_wait_task(ThreadScheduler *scheduler,
+        struct virtual_processor *vproc, struct scheduled_task *task)
+{
+    HANDLE handles[2];
+    DWORD ret;
+
+    for(;;) {
+        if(scheduler_get_task(scheduler, vproc, task))
+            return TRUE;
+
+        /* ScheduleTask only wakes up workers that are marked as idle,
+         * check the queues again to avoid missing a wake up */
+        InterlockedIncrement(&scheduler->idle_count);
+        if(scheduler_get_task(scheduler, vproc, task)) {
+            InterlockedDecrement(&scheduler->idle_count);
+            return TRUE;
+        }
+        if(scheduler->shutdown) {
+            InterlockedDecrement(&scheduler->idle_count);
+            return FALSE;
+        }
+
+        handles[0] = scheduler->work_sem;
+        handles[1] = scheduler->shutdown_event;
+        ret = WaitForMultipleObjects(2, handles, FALSE, WORKER_IDLE_TIMEOUT);
+        InterlockedDecrement(&scheduler->idle_count);
+        if(ret == WAIT_TIMEOUT)
+            return FALSE;
+    }
+}
+
+static HANDLE ExternalContextBase_get_block_event(ExternalContextBase *this)
+{
+    HANDLE event;
+
+    if(this->block_event)
+        return this->block_event;
+
+    event = CreateEventW(NULL, FALSE, FALSE, NULL);
+    if(!event)
+        throw_exception(EXCEPTION_SCHEDULER_RESOURCE_ALLOCATION_ERROR,
+                HRESULT_FROM_WIN32(GetLastError()), NULL);
+    if(InterlockedCompareExchangePointer(&this->block_event, event, NULL))
+        CloseHandle(event);
+    return this->block_event;
+}
+
+/* Called by a worker that is idle, or that is one too many since a blocked
+ * context has resumed. Returns FALSE if the worker has to keep running, an
+ * idle worker then gets the task to run. */
+static BOOL ThreadScheduler_retire_worker(ThreadScheduler *this,
+        struct virtual_processor *vproc, BOOL idle, struct scheduled_task *task)
+{
+    BOOL ret = TRUE;
+
+    EnterCriticalSection(&this->cs);
+    /* ScheduleTask only starts a worker when it sees the lower count, check
+     * the queues again afterwards to avoid leaving a task behind; the
+     * interlocked operation orders them */
+    this->thread_count--;
+    InterlockedDecrement(&vproc->active);
+    if(scheduler_active_workers(this) < (LONG)this->virt_proc_no &&
+            (!idle || scheduler_get_task(this, vproc, task))) {
+        this->thread_count++;
+        InterlockedIncrement(&vproc->active);
+        ret = FALSE;
+    }
+    LeaveCriticalSection(&this->cs);
+    return ret;
+}
+
+static DWORD WINAPI vproc_worker(void *arg)
+{
+    struct virtual_processor *vproc = arg;
+    ThreadScheduler *scheduler = vproc->scheduler;
+    ExternalContextBase *context;
+    struct scheduled_task task;
+    HMODULE module;
+
+    TRACE("(%p) starting\n", vproc);
+
+    init_context_tls();
+    context = MSVCRT_operator_new(sizeof(*context));
+    ExternalContextBase_ctor_vproc(context, vproc);
+    TlsSetValue(context_tls_index, context);
+
+    for(;;) {
+        if(scheduler_wait_task(scheduler, vproc, &task)) {
+            task.proc(task.data);
+            if(scheduler_active_workers(scheduler) <= (LONG)scheduler->virt_proc_no ||
+                    !ThreadScheduler_retire_worker(scheduler, vproc, FALSE, &task))
+                continue;
+            break;
+        }
+        /* shut down, or idle for too long */
+        if(ThreadScheduler_retire_worker(scheduler, vproc, TRUE, &task))
+            break;
+        task.proc(task.data);
+    }
+
+    TRACE("(%p) exiting\n", vproc);
+
+    TlsSetValue(context_tls_index, NULL);
+    call_Context_dtor(&context->context, 1);
+
+    if(!InterlockedDecrement(&scheduler->running)) {
+        ThreadScheduler_dtor(scheduler);
+        MSVCRT_operator_delete(scheduler);
+    }
+
+    GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+            (const WCHAR*)vproc_worker, &module);
+    FreeLibraryAndExitThread(module, 0);
+    return 0;
+}
+
 static Scheduler* try_get_current_scheduler(void)
 {
     ExternalContextBase *context = (ExternalContextBase*)try_get_current_context();
@@ -259,19 +525,49 @@ unsigned int __cdecl Context_Id(void)
 /* ?Block@Context@Concurrency@@SAXXZ */
 void __cdecl Context_Block(void)
 {
-    FIXME("()\n");
+    ExternalContextBase *context = (ExternalContextBase*)get_current_context();
+    ThreadScheduler *scheduler;
+    HANDLE event;
+
+    TRACE("()\n");
+
+    if(context->context.vtable != &MSVCRT_ExternalContextBase_vtable) {
+        ERR("unknown context set\n");
+        return;
+    }
+
+    event = ExternalContextBase_get_block_event(context);
+    context->blocked = TRUE;
+    if(!context->vproc) {
+        WaitForSingleObject(event, INFINITE);
+    } else {
+        /* Don't leave the virtual processor idle while the context is blocked.
+         * The queued tasks run on another worker thread rather than nested on
+         * this stack, since they may wait for this context to resume. */
+        scheduler = context->vproc->scheduler;
+        InterlockedDecrement(&context->vproc->active);
+        InterlockedIncrement(&scheduler->blocked);
+        if(!InterlockedCompareExchange(&scheduler->idle_count, 0, 0) && scheduler_has_task(scheduler))
+            ThreadScheduler_start_worker(scheduler);
+        WaitForSingleObject(event, INFINITE);
+        InterlockedDecrement(&scheduler->blocked);
+        InterlockedIncrement(&context->vproc->active);
+    }
+    context->blocked = FALSE;
 }
 
 /* ?Yield@Context@Concurrency@@SAXXZ */
 void __cdecl Context_Yield(void)
 {
-    FIXME("()\n");
+    TRACE("()\n");
+    SwitchToThread();
 }
 
 /* ?_SpinYield@Context@Concurrency@@SAXXZ */
 void __cdecl Context__SpinYield(void)
 {
-    FIXME("()\n");
+    TRACE("()\n");
+    Context_Yield();
 }
 
 /* ?IsCurrentTaskCollectionCanceling@Context@Concurrency@@SA_NXZ */
@@ -313,8 +609,8 @@ unsigned int __thiscall ExternalContextBase_GetId(const ExternalContextBase *thi
 DEFINE_THISCALL_WRAPPER(ExternalContextBase_GetVirtualProcessorId, 4)
 unsigned int __thiscall ExternalContextBase_GetVirtualProcessorId(const ExternalContextBase *this)
 {
-    FIXME("(%p)->() stub\n", this);
-    return -1;
+    TRACE("(%p)->()\n", this);
+    return this->vproc ? this->vproc->id : -1;
 }
 
 DEFINE_THISCALL_WRAPPER(ExternalContextBase_GetScheduleGroupId, 4)
@@ -327,14 +623,15 @@ unsigned int __thiscall ExternalContextBase_GetScheduleGroupId(const ExternalCon
 DEFINE_THISCALL_WRAPPER(ExternalContextBase_Unblock, 4)
 void __thiscall ExternalContextBase_Unblock(ExternalContextBase *this)
 {
-    FIXME("(%p)->() stub\n", this);
+    TRACE("(%p)->()\n", this);
+    SetEvent(ExternalContextBase_get_block_event(this));
 }
 
 DEFINE_THISCALL_WRAPPER(ExternalContextBase_IsSynchronouslyBlocked, 4)
 MSVCRT_bool __thiscall ExternalContextBase_IsSynchronouslyBlocked(const ExternalContextBase *this)
 {
-    FIXME("(%p)->() stub\n", this);
-    return FALSE;
+    TRACE("(%p)->()\n", this);
+    return this->blocked;
 }
 
 static void ExternalContextBase_dtor(ExternalContextBase *this)
@@ -351,15 +648,22 @@ static void ExternalContextBase_dtor(ExternalContextBase *this)
         }
     }
 
+    /* worker contexts don't hold a reference to the scheduler they run on,
+     * it's always the last one on the list */
     if (this->scheduler.scheduler) {
-        call_Scheduler_Release(this->scheduler.scheduler);
+        if (!this->vproc || this->scheduler.next)
+            call_Scheduler_Release(this->scheduler.scheduler);
 
         for(scheduler_cur=this->scheduler.next; scheduler_cur; scheduler_cur=scheduler_next) {
             scheduler_next = scheduler_cur->next;
-            call_Scheduler_Release(scheduler_cur->scheduler);
+            if (!this->vproc || scheduler_next)
+                call_Scheduler_Release(scheduler_cur->scheduler);
             MSVCRT_operator_delete(scheduler_cur);
         }
     }
+
+    if (this->block_event)
+        CloseHandle(this->block_event);
 }
 
 DEFINE_THISCALL_WRAPPER(ExternalContextBase_vector_dtor, 8)
@@ -395,6 +699,18 @@ static void ExternalContextBase_ctor(ExternalContextBase *this)
     call_Scheduler_Reference(&default_scheduler->scheduler);
 }
 
+static void ExternalContextBase_ctor_vproc(ExternalContextBase *this,
+        struct virtual_processor *vproc)
+{
+    TRACE("(%p)->(%p)\n", this, vproc);
+
+    memset(this, 0, sizeof(*this));
+    this->context.vtable = &MSVCRT_ExternalContextBase_vtable;
+    this->id = InterlockedIncrement(&context_id);
+    this->scheduler.scheduler = &vproc->scheduler->scheduler;
+    this->vproc = vproc;
+}
+
 /* ?Alloc@Concurrency@@YAPAXI@Z */
 /* ?Alloc@Concurrency@@YAPEAX_K@Z */
 void * CDECL Concurrency_Alloc(MSVCRT_size_t size)
@@ -625,6 +941,7 @@ void __thiscall SchedulerPolicy_dtor(SchedulerPolicy *this)
 
 static void ThreadScheduler_dtor(ThreadScheduler *this)
 {
+    unsigned int j;
     int i;
 
     if(this->ref != 0) WARN("ref = %d\n", this->ref);
@@ -634,6 +951,16 @@ static void ThreadScheduler_dtor(ThreadScheduler *this)
         SetEvent(this->shutdown_events[i]);
     MSVCRT_operator_delete(this->shutdown_events);
 
+    for(j=0; j<this->virt_proc_no; j++) {
+        if(this->vprocs[j].count) WARN("vproc %u: %d tasks not run\n", j, this->vprocs[j].count);
+        MSVCRT_operator_delete(this->vprocs[j].tasks);
+        this->vprocs[j].cs.DebugInfo->Spare[0] = 0;
+        DeleteCriticalSection(&this->vprocs[j].cs);
+    }
+    MSVCRT_operator_delete(this->vprocs);
+    CloseHandle(this->work_sem);
+    CloseHandle(this->shutdown_event);
+
     this->cs.DebugInfo->Spare[0] = 0;
     DeleteCriticalSection(&this->cs);
 }
@@ -675,8 +1002,14 @@ unsigned int __thiscall ThreadScheduler_Release(ThreadScheduler *this)
     TRACE("(%p)\n", this);
 
     if(!ret) {
-        ThreadScheduler_dtor(this);
-        MSVCRT_operator_delete(this);
+        /* the last worker thread to exit destroys the scheduler once
+         * all the queued tasks are done */
+        this->shutdown = TRUE;
+        SetEvent(this->shutdown_event);
+        if(!InterlockedDecrement(&this->running)) {
+            ThreadScheduler_dtor(this);
+            MSVCRT_operator_delete(this);
+        }
     }
     return ret;
 }
@@ -742,18 +1075,80 @@ DEFINE_THISCALL_WRAPPER(ThreadScheduler_CreateScheduleGroup, 4)
     return NULL;
 }
 
-DEFINE_THISCALL_WRAPPER(ThreadScheduler_ScheduleTask_loc, 16)
-void __thiscall ThreadScheduler_ScheduleTask_loc(ThreadScheduler *this,
-        void (__cdecl *proc)(void*), void* data, /*location*/void *placement)
+static void ThreadScheduler_start_worker(ThreadScheduler *this)
 {
-    FIXME("(%p %p %p %p) stub\n", this, proc, data, placement);
+    struct virtual_processor *vproc = NULL;
+    unsigned int stack_size, i;
+    int priority;
+    HMODULE module;
+    HANDLE thread;
+
+    EnterCriticalSection(&this->cs);
+    if(scheduler_active_workers(this) < (LONG)this->virt_proc_no && !this->shutdown) {
+        /* pick a virtual processor without a running worker */
+        for(i=0; i<this->virt_proc_no; i++) {
+            if(!this->vprocs[i].active) {
+                vproc = &this->vprocs[i];
+                break;
+            }
+        }
+    }
+    if(vproc) {
+        stack_size = SchedulerPolicy_GetPolicyValue(&this->policy, ContextStackSize);
+        priority = SchedulerPolicy_GetPolicyValue(&this->policy, ContextPriority);
+
+        /* keep the dll loaded while the worker is running */
+        GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS,
+                (const WCHAR*)vproc_worker, &module);
+        InterlockedIncrement(&this->running);
+        InterlockedIncrement(&vproc->active);
+        thread = CreateThread(NULL, stack_size * 1024, vproc_worker,
+                vproc, CREATE_SUSPENDED, NULL);
+        if(thread) {
+            if(priority != INHERIT_THREAD_PRIORITY)
+                SetThreadPriority(thread, priority);
+            ResumeThread(thread);
+            CloseHandle(thread);
+            this->thread_count++;
+        }else {
+            ERR("failed to create worker thread: %u\n", GetLastError());
+            InterlockedDecrement(&vproc->active);
+            InterlockedDecrement(&this->running);
+            FreeLibrary(module);
+        }
+    }
+    LeaveCriticalSection(&this->cs);
 }
 
 DEFINE_THISCALL_WRAPPER(ThreadScheduler_ScheduleTask, 12)
 void __thiscall ThreadScheduler_ScheduleTask(ThreadScheduler *this,
         void (__cdecl *proc)(void*), void* data)
 {
-    FIXME("(%p %p %p) stub\n", this, proc, data);
+    ExternalContextBase *context = try_get_current_worker_context();
+    struct virtual_processor *vproc;
+
+    TRACE("(%p %p %p)\n", this, proc, data);
+
+    /* tasks spawned by a worker go to its own queue, other workers steal
+     * them when they run out of work */
+    if(context && context->vproc->scheduler == this)
+        vproc = context->vproc;
+    else
+        vproc = &this->vprocs[(unsigned int)InterlockedIncrement(&this->next_vproc) % this->virt_proc_no];
+    vproc_push(vproc, proc, data);
+
+    if(InterlockedCompareExchange(&this->idle_count, 0, 0))
+        ReleaseSemaphore(this->work_sem, 1, NULL);
+    else if(scheduler_active_workers(this) < (LONG)this->virt_proc_no)
+        ThreadScheduler_start_worker(this);
+}
+
+DEFINE_THISCALL_WRAPPER(ThreadScheduler_ScheduleTask_loc, 16)
+void __thiscall ThreadScheduler_ScheduleTask_loc(ThreadScheduler *this,
+        void (__cdecl *proc)(void*), void* data, /*location*/void *placement)
+{
+    FIXME("(%p %p %p %p) placement ignored\n", this, proc, data, placement);
+    ThreadScheduler_ScheduleTask(this, proc, data);
 }
 
 DEFINE_THISCALL_WRAPPER(ThreadScheduler_IsAvailableLocation, 8)
@@ -787,6 +1182,7 @@ Scheduler* __thiscall ThreadScheduler_vector_dtor(ThreadScheduler *this, unsigne
 static ThreadScheduler* ThreadScheduler_ctor(ThreadScheduler *this,
         const SchedulerPolicy *policy)
 {
+    unsigned int i, min_concurrency;
     SYSTEM_INFO si;
 
     TRACE("(%p)->()\n", this);
@@ -800,12 +1196,32 @@ static ThreadScheduler* ThreadScheduler_ctor(ThreadScheduler *this,
     this->virt_proc_no = SchedulerPolicy_GetPolicyValue(&this->policy, MaxConcurrency);
     if(this->virt_proc_no > si.dwNumberOfProcessors)
         this->virt_proc_no = si.dwNumberOfProcessors;
+    min_concurrency = SchedulerPolicy_GetPolicyValue(&this->policy, MinConcurrency);
+    if(this->virt_proc_no < min_concurrency)
+        this->virt_proc_no = min_concurrency;
 
     this->shutdown_count = this->shutdown_size = 0;
     this->shutdown_events = NULL;
 
     InitializeCriticalSection(&this->cs);
     this->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": ThreadScheduler");
+
+    this->vprocs = MSVCRT_operator_new(this->virt_proc_no * sizeof(*this->vprocs));
+    memset(this->vprocs, 0, this->virt_proc_no * sizeof(*this->vprocs));
+    for(i=0; i<this->virt_proc_no; i++) {
+        this->vprocs[i].scheduler = this;
+        this->vprocs[i].id = i;
+        InitializeCriticalSection(&this->vprocs[i].cs);
+        this->vprocs[i].cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": virtual_processor");
+    }
+    this->thread_count = 0;
+    this->blocked = 0;
+    this->running = 1;
+    this->next_vproc = -1;
+    this->idle_count = 0;
+    this->work_sem = CreateSemaphoreW(NULL, 0, MAXLONG, NULL);
+    this->shutdown_event = CreateEventW(NULL, TRUE, FALSE, NULL);
+    this->shutdown = FALSE;
     return this;
 }
 
@@ -471,10 +471,31 @@ static double strtod_helper(const char *str, char **end, MSVCRT__locale_t locale
         }
     }
 
+    if(end)
+        *end = (char*)p;
+
     fpcontrol = _control87(0, 0);
     _control87(MSVCRT__EM_DENORMAL|MSVCRT__EM_INVALID|MSVCRT__EM_ZERODIVIDE
             |MSVCRT__EM_OVERFLOW|MSVCRT__EM_UNDERFLOW|MSVCRT__EM_INEXACT, 0xffffffff);
 
+    /* d and 10^exp are exactly representable, so a single multiplication
+     * or division gives a correctly rounded result when it's done in double
+     * precision */
+    if(base == 10 && d <= (unsigned __int64)1 << 53 && exp >= -22 && exp <= 22
+#ifdef __i386__
+            && (fpcontrol & MSVCRT__MCW_PC) == MSVCRT__PC_53
+#endif
+            ) {
+        static const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+            1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18,
+            1e19, 1e20, 1e21, 1e22 };
+
+        ret = exp < 0 ? (double)d / pow10[-exp] : (double)d * pow10[exp];
+        ret = sign * ret;
+        _control87(fpcontrol, 0xffffffff);
+        return ret;
+    }
+
     negexp = (exp < 0);
     if(negexp)
         exp = -exp;
@@ -495,9 +516,6 @@ static double strtod_helper(const char *str, char **end, MSVCRT__locale_t locale
             *MSVCRT__errno() = MSVCRT_ERANGE;
     }
 
-    if(end)
-        *end = (char*)p;
-
     return ret;
 }
 
@@ -926,12 +944,9 @@ MSVCRT_size_t __cdecl MSVCRT_strlen(const char *str)
  */
 MSVCRT_size_t CDECL MSVCRT_strnlen(const char *s, MSVCRT_size_t maxlen)
 {
-    MSVCRT_size_t i;
-
-    for(i=0; i<maxlen; i++)
-        if(!s[i]) break;
+    const char *end = memchr(s, 0, maxlen);
 
-    return i;
+    return end ? end - s : maxlen;
 }
 
 /*********************************************************************
@@ -34,6 +34,7 @@
 #include <winreg.h>
 #include <process.h>
 #include <errno.h>
+#include <excpt.h>
 #include <locale.h>
 
 #define MSVCRT_FD_BLOCK_SIZE 32
@@ -614,6 +615,129 @@ static void test_fputc( void )
   free(tempf);
 }
 
+static DWORD WINAPI fputc_thread(void *arg)
+{
+  FILE *tempfh = arg;
+  int i;
+
+  for (i = 0; i < 100000; i++)
+    fputc('b', tempfh);
+  return 0;
+}
+
+/* runs in a child process, so that the second thread is the first one started */
+static void test_fputc_threads_child( void )
+{
+  char* tempf;
+  FILE *tempfh;
+  HANDLE thread;
+  int i, c, count_a = 0, count_b = 0;
+
+  tempf=_tempnam(".","wne");
+  tempfh = fopen(tempf,"wb");
+  for (i = 0; i < 1000; i++)
+    fputc('a', tempfh);
+  /* start the second thread while the stream is in use */
+  thread = CreateThread(NULL, 0, fputc_thread, tempfh, 0, NULL);
+  for (; i < 100000; i++)
+    fputc('a', tempfh);
+  WaitForSingleObject(thread, INFINITE);
+  CloseHandle(thread);
+  fclose(tempfh);
+
+  tempfh = fopen(tempf,"rb");
+  while ((c = fgetc(tempfh)) != EOF)
+  {
+    if (c == 'a') count_a++;
+    else if (c == 'b') count_b++;
+  }
+  ok(count_a == 100000, "got %d 'a' characters\n", count_a);
+  ok(count_b == 100000, "got %d 'b' characters\n", count_b);
+  fclose(tempfh);
+
+  unlink(tempf);
+  free(tempf);
+}
+
+#if defined(__i386__) || defined(__x86_64__)
+
+static DWORD WINAPI fputc_fault_thread(void *arg)
+{
+  return 0;
+}
+
+static void WINAPI fputc_fault_continue(void)
+{
+  HANDLE thread;
+  DWORD ret;
+
+  /* the thread must start although fputc never returned */
+  thread = CreateThread(NULL, 0, fputc_fault_thread, NULL, 0, NULL);
+  ret = WaitForSingleObject(thread, 10000);
+  ok(ret == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", ret);
+  CloseHandle(thread);
+  ExitProcess(winetest_get_failures());
+}
+
+static LONG CALLBACK fputc_fault_handler(EXCEPTION_POINTERS *ptrs)
+{
+  CONTEXT *context = ptrs->ContextRecord;
+
+  if (ptrs->ExceptionRecord->ExceptionCode != EXCEPTION_ACCESS_VIOLATION)
+    return EXCEPTION_CONTINUE_SEARCH;
+
+  /* leave fputc for good, like a handler further up the stack would */
+#ifdef __i386__
+  context->Esp = ((context->Esp - 256) & ~15) - 4;
+  context->Eip = (DWORD)fputc_fault_continue;
+#else
+  context->Rsp = ((context->Rsp - 256) & ~15) - 8;
+  context->Rip = (DWORD64)fputc_fault_continue;
+#endif
+  return EXCEPTION_CONTINUE_EXECUTION;
+}
+
+/* runs in a child process, with no other thread started yet */
+static void test_fputc_fault_child( void )
+{
+  FILE file;
+
+  memset(&file, 0, sizeof(file));
+  file._flag = _IOWRT;
+  file._cnt = 16;
+  file._ptr = NULL;
+
+  AddVectoredExceptionHandler(TRUE, fputc_fault_handler);
+  fputc('a', &file);
+  ok(0, "fputc didn't fault\n");
+}
+
+#endif
+
+static void test_fputc_threads( const char* selfname )
+{
+  char cmdline[MAX_PATH];
+  PROCESS_INFORMATION proc;
+  STARTUPINFOA startup;
+
+  memset(&startup, 0, sizeof(startup));
+  startup.cb = sizeof(startup);
+
+  sprintf(cmdline, "%s file fputc_threads", selfname);
+  CreateProcessA(NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &startup, &proc);
+  winetest_wait_child_process(proc.hProcess);
+  CloseHandle(proc.hProcess);
+  CloseHandle(proc.hThread);
+
+#if defined(__i386__) || defined(__x86_64__)
+  sprintf(cmdline, "%s file fputc_fault", selfname);
+  CreateProcessA(NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &startup, &proc);
+  winetest_wait_child_process(proc.hProcess);
+  CloseHandle(proc.hProcess);
+  CloseHandle(proc.hThread);
+#endif
+}
+
 static void test_flsbuf( void )
 {
   char* tempf;
@@ -2604,6 +2728,12 @@ START_TEST(file)
             test_pipes_child(arg_c, arg_v);
         else if (strcmp(arg_v[2], "stdin") == 0)
             test_invalid_stdin_child();
+        else if (strcmp(arg_v[2], "fputc_threads") == 0)
+            test_fputc_threads_child();
+#if defined(__i386__) || defined(__x86_64__)
+        else if (strcmp(arg_v[2], "fputc_fault") == 0)
+            test_fputc_fault_child();
+#endif
         else
             ok(0, "invalid argument '%s'\n", arg_v[2]);
         return;
@@ -2632,6 +2762,7 @@ START_TEST(file)
     test_readboundary();
     test_fgetc();
     test_fputc();
+    test_fputc_threads(arg_v[0]);
     test_flsbuf();
     test_fflush();
     test_fgetwc();
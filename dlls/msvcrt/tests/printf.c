@@ -593,6 +593,46 @@ static void test_sprintf( void )
     ok(!strcmp(buffer,"1"), "failed\n");
     ok( r==1, "return count wrong\n");
 
+    format = "%#.0f";
+    r = sprintf(buffer, format,3.0);
+    ok(!strcmp(buffer,"3."), "failed: \"%s\"\n", buffer);
+    ok( r==2, "return count wrong\n");
+
+    format = "%.3f";
+    r = sprintf(buffer, format,123.456);
+    ok(!strcmp(buffer,"123.456"), "failed: \"%s\"\n", buffer);
+    ok( r==7, "return count wrong\n");
+
+    format = "%.2f";
+    r = sprintf(buffer, format,-0.004);
+    ok(!strcmp(buffer,"-0.00"), "failed: \"%s\"\n", buffer);
+    ok( r==5, "return count wrong\n");
+
+    format = "%.2f";
+    r = sprintf(buffer, format,0.125);
+    ok(!strcmp(buffer,"0.13"), "failed: \"%s\"\n", buffer);
+    ok( r==4, "return count wrong\n");
+
+    format = "%.2f";
+    r = sprintf(buffer, format,-0.125);
+    ok(!strcmp(buffer,"-0.13"), "failed: \"%s\"\n", buffer);
+    ok( r==5, "return count wrong\n");
+
+    format = "%.0f";
+    r = sprintf(buffer, format,2.5);
+    ok(!strcmp(buffer,"3"), "failed: \"%s\"\n", buffer);
+    ok( r==1, "return count wrong\n");
+
+    format = "%.15f";
+    r = sprintf(buffer, format,0.1);
+    ok(!strcmp(buffer,"0.100000000000000"), "failed: \"%s\"\n", buffer);
+    ok( r==17, "return count wrong\n");
+
+    format = "%f";
+    r = sprintf(buffer, format,1e17);
+    ok(!strcmp(buffer,"100000000000000000.000000"), "failed: \"%s\"\n", buffer);
+    ok( r==25, "return count wrong\n");
+
     format = "%2.4e";
     r = sprintf(buffer, format,8.6);
     ok(!strcmp(buffer,"8.6000e+000"), "failed\n");
@@ -100,6 +100,10 @@ static size_t (__cdecl *p__mbsnlen)(const unsigned char*, size_t);
 static int (__cdecl *p__mbccpy_s)(unsigned char*, size_t, int*, const unsigned char*);
 static int (__cdecl *p__memicmp)(const char*, const char*, size_t);
 static int (__cdecl *p__memicmp_l)(const char*, const char*, size_t, _locale_t);
+static size_t (__cdecl *p_wcslen)(const wchar_t*);
+static wchar_t* (__cdecl *p_wcschr)(const wchar_t*, wchar_t);
+static int (__cdecl *p_wcscmp)(const wchar_t*, const wchar_t*);
+static int (__cdecl *p__wcsicmp)(const wchar_t*, const wchar_t*);
 
 #define SETNOFAIL(x,y) x = (void*)GetProcAddress(hMsvcrt,y)
 #define SET(x,y) SETNOFAIL(x,y); ok(x != NULL, "Export '%s' not found\n", y)
@@ -1633,6 +1637,116 @@ static void test_strnlen(void)
     ok(res == 0, "Returned length = %d\n", (int)res);
 }
 
+static wchar_t *ref_wcschr(const wchar_t *str, wchar_t ch)
+{
+    do { if (*str == ch) return (wchar_t *)str; } while (*str++);
+    return NULL;
+}
+
+static int ref_wcscmp(const wchar_t *str1, const wchar_t *str2)
+{
+    while (*str1 && *str1 == *str2) { str1++; str2++; }
+    return *str1 - *str2;
+}
+
+static int ref_wcsicmp(const wchar_t *str1, const wchar_t *str2)
+{
+    int ret;
+
+    for (;;)
+    {
+        if ((ret = towlower(*str1) - towlower(*str2)) || !*str1) return ret;
+        str1++;
+        str2++;
+    }
+}
+
+static int sign(int x)
+{
+    return x < 0 ? -1 : (x > 0 ? 1 : 0);
+}
+
+static void test_wcs_functions(void)
+{
+    static const wchar_t upper[] = {'H','e','L','L','o',' ','W','o','r','L','d',0xc4,0x100,'Z','[','@',0};
+    static const wchar_t lower[] = {'h','E','l','l','O',' ','w','O','R','l','D',0xe4,0x101,'z','[','@',0};
+    wchar_t *page, *str, *str2, *end, *ret;
+    int i, len, off, cmp;
+    DWORD old_prot;
+    BOOL r;
+
+    if (!p_wcslen || !p_wcschr || !p_wcscmp || !p__wcsicmp)
+    {
+        win_skip("wide string functions not available\n");
+        return;
+    }
+
+    /* strings ending right before an inaccessible page */
+    page = VirtualAlloc(NULL, 0x3000, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    ok(page != NULL, "VirtualAlloc failed, error %u\n", GetLastError());
+    r = VirtualProtect((char *)page + 0x2000, 0x1000, PAGE_NOACCESS, &old_prot);
+    ok(r, "VirtualProtect failed, error %u\n", GetLastError());
+    end = (wchar_t *)((char *)page + 0x2000);
+    str2 = page;
+
+    for (len = 0; len < 80; len++)
+    {
+        for (off = 0; off < 8; off++)
+        {
+            str = end - off - len - 1;
+            for (i = 0; i < len; i++) str[i] = 'a' + (i * 7 + off) % 26;
+            str[len] = 0;
+
+            ok(p_wcslen(str) == len, "%d/%d: wcslen returned %d\n", len, off, (int)p_wcslen(str));
+            ok(p_wcschr(str, '#') == NULL, "%d/%d: wcschr found a character\n", len, off);
+            ok(p_wcschr(str, 0) == str + len, "%d/%d: wcschr(0) returned %p\n", len, off, p_wcschr(str, 0));
+            if (len)
+            {
+                ret = p_wcschr(str, str[len - 1]);
+                ok(ret == ref_wcschr(str, str[len - 1]), "%d/%d: wcschr returned %p, expected %p\n",
+                   len, off, ret, ref_wcschr(str, str[len - 1]));
+            }
+
+            memcpy(str2 + off, str, (len + 1) * sizeof(wchar_t));
+            ok(!p_wcscmp(str, str2 + off), "%d/%d: strings differ\n", len, off);
+            ok(!p__wcsicmp(str, str2 + off), "%d/%d: strings differ\n", len, off);
+            if (len)
+            {
+                str2[off + len - 1] = 'A' + (str[len - 1] - 'a');
+                cmp = p_wcscmp(str, str2 + off);
+                ok(cmp > 0, "%d/%d: wcscmp returned %d\n", len, off, cmp);
+                cmp = p__wcsicmp(str2 + off, str);
+                ok(!cmp, "%d/%d: _wcsicmp returned %d\n", len, off, cmp);
+                str2[off + len - 1] = 0xc4;
+                cmp = p_wcscmp(str, str2 + off);
+                ok(sign(cmp) == sign(ref_wcscmp(str, str2 + off)), "%d/%d: wcscmp returned %d\n", len, off, cmp);
+                cmp = p__wcsicmp(str, str2 + off);
+                ok(sign(cmp) == sign(ref_wcsicmp(str, str2 + off)), "%d/%d: _wcsicmp returned %d\n", len, off, cmp);
+            }
+            str2[off + len] = 'x';
+            str2[off + len + 1] = 0;
+            cmp = p_wcscmp(str, str2 + off);
+            ok(cmp < 0, "%d/%d: wcscmp returned %d\n", len, off, cmp);
+            cmp = p__wcsicmp(str2 + off, str);
+            ok(cmp > 0, "%d/%d: _wcsicmp returned %d\n", len, off, cmp);
+        }
+    }
+
+    /* odd addresses */
+    str = (wchar_t *)((char *)end - 2 * sizeof(upper) - 1);
+    memcpy(str, upper, sizeof(upper));
+    ok(p_wcslen(str) == ARRAY_SIZE(upper) - 1, "wcslen returned %d\n", (int)p_wcslen(str));
+    ok(p_wcschr(str, 'Z') == str + 13, "wcschr returned %p, expected %p\n", p_wcschr(str, 'Z'), str + 13);
+    ok(!p__wcsicmp(str, lower), "_wcsicmp failed\n");
+
+    cmp = p__wcsicmp(upper, lower);
+    ok(!cmp, "_wcsicmp returned %d\n", cmp);
+    cmp = p_wcscmp(upper, lower);
+    ok(cmp < 0, "wcscmp returned %d\n", cmp);
+
+    VirtualFree(page, 0, MEM_RELEASE);
+}
+
 static void test__strtoi64(void)
 {
     static const char no1[] = "31923";
@@ -1880,6 +1994,14 @@ static void test__strtod(void)
     ok(almost_equal(d, 0.1e238L), "d = %lf\n", d);
     d = strtod("0.1D-4736", NULL);
     ok(almost_equal(d, 0.1e-4736L), "d = %lf\n", d);
+    d = strtod("0.3", NULL);
+    ok(d == 0.3, "d = %.17g\n", d);
+    d = strtod("123.456", NULL);
+    ok(d == 123.456, "d = %.17g\n", d);
+    d = strtod("-2.5e-3", NULL);
+    ok(d == -2.5e-3, "d = %.17g\n", d);
+    d = strtod("1e22", NULL);
+    ok(d == 1e22, "d = %.17g\n", d);
 
     errno = 0xdeadbeef;
     strtod(overflow, &end);
@@ -3447,6 +3569,10 @@ START_TEST(string)
     p__mbccpy_s = (void*)GetProcAddress(hMsvcrt, "_mbccpy_s");
     p__memicmp = (void*)GetProcAddress(hMsvcrt, "_memicmp");
     p__memicmp_l = (void*)GetProcAddress(hMsvcrt, "_memicmp_l");
+    p_wcslen = (void*)GetProcAddress(hMsvcrt, "wcslen");
+    p_wcschr = (void*)GetProcAddress(hMsvcrt, "wcschr");
+    p_wcscmp = (void*)GetProcAddress(hMsvcrt, "wcscmp");
+    p__wcsicmp = (void*)GetProcAddress(hMsvcrt, "_wcsicmp");
 
     /* MSVCRT memcpy behaves like memmove for overlapping moves,
        MFC42 CString::Insert seems to rely on that behaviour */
@@ -3484,6 +3610,7 @@ START_TEST(string)
     test__wcsupr_s();
     test_strtol();
     test_strnlen();
+    test_wcs_functions();
     test__strtoi64();
     test__strtod();
     test_mbstowcs();
@@ -25,6 +25,11 @@
 #include <stdio.h>
 #include <math.h>
 #include <assert.h>
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && \
+    (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define HAVE_SSE2_STRING_FUNCS
+#include <emmintrin.h>
+#endif
 #include "msvcrt.h"
 #include "winnls.h"
 #include "wtypes.h"
@@ -35,6 +40,103 @@ WINE_DEFAULT_DEBUG_CHANNEL(msvcrt);
 
 static BOOL n_format_enabled = TRUE;
 
+#ifdef HAVE_SSE2_STRING_FUNCS
+
+#ifdef __i386__
+#define SSE2_TARGET __attribute__((target("sse2")))
+#else
+#define SSE2_TARGET
+#endif
+
+/* Find the first occurrence of ch or of the terminating null character.
+ * The string must be WCHAR aligned. Only aligned 16-byte blocks are read,
+ * so we never touch a page that doesn't contain part of the string. */
+static SSE2_TARGET const MSVCRT_wchar_t *sse2_wcschr( const MSVCRT_wchar_t *str, MSVCRT_wchar_t ch )
+{
+    const __m128i *p = (const __m128i *)((ULONG_PTR)str & ~15);
+    const __m128i zero = _mm_setzero_si128(), c = _mm_set1_epi16( ch );
+    unsigned int mask;
+    __m128i v;
+
+    v = _mm_load_si128( p );
+    mask = _mm_movemask_epi8( _mm_or_si128( _mm_cmpeq_epi16( v, zero ), _mm_cmpeq_epi16( v, c ) ) );
+    mask &= ~0u << ((ULONG_PTR)str & 15);
+    while (!mask)
+    {
+        v = _mm_load_si128( ++p );
+        mask = _mm_movemask_epi8( _mm_or_si128( _mm_cmpeq_epi16( v, zero ), _mm_cmpeq_epi16( v, c ) ) );
+    }
+    return (const MSVCRT_wchar_t *)((const char *)p + __builtin_ctz( mask ));
+}
+
+static inline MSVCRT_wchar_t ascii_tolower( MSVCRT_wchar_t c )
+{
+    return (c >= 'A' && c <= 'Z') ? c + 'a' - 'A' : c;
+}
+
+/* Return the index of the first character that differs between the strings,
+ * or of the terminating null character. When fold is set, ASCII letters are
+ * compared case insensitively; other characters may still differ only by
+ * case, so the caller has to check the returned position. */
+static SSE2_TARGET MSVCRT_size_t sse2_wcs_mismatch( const MSVCRT_wchar_t *str1,
+        const MSVCRT_wchar_t *str2, BOOL fold )
+{
+    const __m128i zero = _mm_setzero_si128(), case_bit = _mm_set1_epi16( 'a' - 'A' );
+    const __m128i before_a = _mm_set1_epi16( 'A' - 1 ), after_z = _mm_set1_epi16( 'Z' + 1 );
+    MSVCRT_size_t i = 0;
+    unsigned int mask;
+    __m128i a, b, eq;
+
+    for (;;)
+    {
+        /* don't let an unaligned load cross into the next page */
+        if (((ULONG_PTR)(str1 + i) & 0xfff) > 0x1000 - sizeof(__m128i) ||
+            ((ULONG_PTR)(str2 + i) & 0xfff) > 0x1000 - sizeof(__m128i))
+        {
+            if (!str1[i]) return i;
+            if (fold ? ascii_tolower( str1[i] ) != ascii_tolower( str2[i] ) : str1[i] != str2[i])
+                return i;
+            i++;
+            continue;
+        }
+
+        a = _mm_loadu_si128( (const __m128i *)(str1 + i) );
+        b = _mm_loadu_si128( (const __m128i *)(str2 + i) );
+        eq = _mm_cmpeq_epi16( a, zero );
+        if (fold)
+        {
+            a = _mm_or_si128( a, _mm_and_si128( case_bit, _mm_and_si128(
+                    _mm_cmpgt_epi16( a, before_a ), _mm_cmplt_epi16( a, after_z ) ) ) );
+            b = _mm_or_si128( b, _mm_and_si128( case_bit, _mm_and_si128(
+                    _mm_cmpgt_epi16( b, before_a ), _mm_cmplt_epi16( b, after_z ) ) ) );
+        }
+        mask = _mm_movemask_epi8( _mm_andnot_si128( eq, _mm_cmpeq_epi16( a, b ) ) );
+        if (mask != 0xffff) return i + __builtin_ctz( ~mask ) / sizeof(MSVCRT_wchar_t);
+        i += sizeof(__m128i) / sizeof(MSVCRT_wchar_t);
+    }
+}
+
+#endif /* HAVE_SSE2_STRING_FUNCS */
+
+static int wcsicmp_helper( const MSVCRT_wchar_t *str1, const MSVCRT_wchar_t *str2 )
+{
+#ifdef HAVE_SSE2_STRING_FUNCS
+    if (sse2_supported)
+    {
+        MSVCRT_size_t i = 0;
+        int ret;
+
+        for (;;)
+        {
+            i += sse2_wcs_mismatch( str1 + i, str2 + i, TRUE );
+            if ((ret = tolowerW( str1[i] ) - tolowerW( str2[i] )) || !str1[i]) return ret;
+            i++;
+        }
+    }
+#endif
+    return strcmpiW( str1, str2 );
+}
+
 #include "printf.h"
 #define PRINTF_WIDE
 #include "printf.h"
@@ -82,7 +184,7 @@ INT CDECL MSVCRT__wcsicmp_l(const MSVCRT_wchar_t *str1, const MSVCRT_wchar_t *st
     if(!MSVCRT_CHECK_PMT(str1 != NULL) || !MSVCRT_CHECK_PMT(str2 != NULL))
         return MSVCRT__NLSCMPERROR;
 
-    return strcmpiW(str1, str2);
+    return wcsicmp_helper(str1, str2);
 }
 
 /*********************************************************************
@@ -90,7 +192,7 @@ INT CDECL MSVCRT__wcsicmp_l(const MSVCRT_wchar_t *str1, const MSVCRT_wchar_t *st
  */
 INT CDECL MSVCRT__wcsicmp( const MSVCRT_wchar_t* str1, const MSVCRT_wchar_t* str2 )
 {
-    return strcmpiW( str1, str2 );
+    return wcsicmp_helper( str1, str2 );
 }
 
 /*********************************************************************
@@ -2425,6 +2527,13 @@ int CDECL MSVCRT_towlower(MSVCRT_wint_t c)
  */
 MSVCRT_wchar_t* CDECL MSVCRT_wcschr(const MSVCRT_wchar_t *str, MSVCRT_wchar_t ch)
 {
+#ifdef HAVE_SSE2_STRING_FUNCS
+    if (sse2_supported && !((ULONG_PTR)str & 1))
+    {
+        const MSVCRT_wchar_t *ret = sse2_wcschr(str, ch);
+        return *ret == ch ? (MSVCRT_wchar_t *)ret : NULL;
+    }
+#endif
     return strchrW(str, ch);
 }
 
@@ -2433,9 +2542,28 @@ MSVCRT_wchar_t* CDECL MSVCRT_wcschr(const MSVCRT_wchar_t *str, MSVCRT_wchar_t ch
  */
 int CDECL MSVCRT_wcslen(const MSVCRT_wchar_t *str)
 {
+#ifdef HAVE_SSE2_STRING_FUNCS
+    if (sse2_supported && !((ULONG_PTR)str & 1))
+        return sse2_wcschr(str, 0) - str;
+#endif
     return strlenW(str);
 }
 
+/*********************************************************************
+ *              wcscmp (MSVCRT.@)
+ */
+int CDECL MSVCRT_wcscmp(const MSVCRT_wchar_t *str1, const MSVCRT_wchar_t *str2)
+{
+#ifdef HAVE_SSE2_STRING_FUNCS
+    if (sse2_supported)
+    {
+        MSVCRT_size_t i = sse2_wcs_mismatch(str1, str2, FALSE);
+        return str1[i] - str2[i];
+    }
+#endif
+    return strcmpW(str1, str2);
+}
+
 /*********************************************************************
  *              wcsstr (MSVCRT.@)
  */
@@ -136,7 +136,6 @@ typedef struct
 
 #endif  /* linux */
 
-#define IS_OPTION_TRUE(ch) ((ch) == 'y' || (ch) == 'Y' || (ch) == 't' || (ch) == 'T' || (ch) == '1')
 #define IS_SEPARATOR(ch)   ((ch) == '\\' || (ch) == '/')
 
 #define INVALID_NT_CHARS   '*','?','<','>','|','"'
@@ -216,6 +215,49 @@ static RTL_CRITICAL_SECTION_DEBUG critsect_debug =
 };
 static RTL_CRITICAL_SECTION dir_section = { &critsect_debug, -1, 0, 0, 0, 0 };
 
+/* cached directory listings for case-insensitive lookups */
+
+#define DIR_CACHE_MAX_DIRS 64
+#define DIR_CACHE_NO_NAME  (~0u)
+
+struct dir_cache_name
+{
+    unsigned int           next;        /* index of the next name in the hash chain */
+    unsigned int           hash;        /* hash of the upper-case name */
+    unsigned int           name;        /* offset of the Unicode name in the string pool */
+    unsigned int           unix_name;   /* offset of the Unix name in the string pool */
+    unsigned short         len;         /* length of the Unicode name */
+    unsigned short         is_short;    /* name is a generated 8.3 name */
+};
+
+struct dir_cache
+{
+    struct list            entry;       /* entry in the LRU list */
+    dev_t                  dev;         /* device of the directory */
+    ino_t                  ino;         /* inode of the directory */
+    time_t                 mtime;       /* directory modification time when it was read */
+    unsigned int           hash_mask;   /* size of the hash table - 1 */
+    unsigned int          *buckets;     /* hash table of name indices */
+    struct dir_cache_name *names;       /* names in the directory */
+    unsigned int           count;       /* number of names */
+    unsigned int           size;        /* allocated size of the names array */
+    char                  *pool;        /* string pool */
+    unsigned int           pool_used;   /* used size of the string pool */
+    unsigned int           pool_size;   /* allocated size of the string pool */
+};
+
+static struct list dir_cache_list = LIST_INIT( dir_cache_list );
+static unsigned int dir_cache_count;
+
+static RTL_CRITICAL_SECTION dir_cache_section;
+static RTL_CRITICAL_SECTION_DEBUG dir_cache_critsect_debug =
+{
+    0, 0, &dir_cache_section,
+    { &dir_cache_critsect_debug.ProcessLocksList, &dir_cache_critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": dir_cache_section") }
+};
+static RTL_CRITICAL_SECTION dir_cache_section = { &dir_cache_critsect_debug, -1, 0, 0, 0, 0 };
+
 
 /* check if a given Unicode char is OK in a DOS short name */
 static inline BOOL is_invalid_dos_char( WCHAR ch )
@@ -2024,6 +2066,241 @@ NTSTATUS WINAPI NtQueryDirectoryFile( HANDLE handle, HANDLE event,
 }
 
 
+/***********************************************************************
+ *           dir_cache_hash
+ */
+static unsigned int dir_cache_hash( const WCHAR *name, int len )
+{
+    unsigned int hash = 2166136261u;
+
+    while (len--) hash = (hash ^ toupperW( *name++ )) * 16777619u;
+    return hash;
+}
+
+
+/***********************************************************************
+ *           free_dir_cache
+ */
+static void free_dir_cache( struct dir_cache *cache )
+{
+    RtlFreeHeap( GetProcessHeap(), 0, cache->buckets );
+    RtlFreeHeap( GetProcessHeap(), 0, cache->names );
+    RtlFreeHeap( GetProcessHeap(), 0, cache->pool );
+    RtlFreeHeap( GetProcessHeap(), 0, cache );
+}
+
+
+/***********************************************************************
+ *           dir_cache_alloc_string
+ *
+ * Reserve space in the string pool, returns the offset or DIR_CACHE_NO_NAME.
+ */
+static unsigned int dir_cache_alloc_string( struct dir_cache *cache, unsigned int size )
+{
+    unsigned int ret = (cache->pool_used + sizeof(WCHAR) - 1) & ~(sizeof(WCHAR) - 1);
+
+    if (ret + size > cache->pool_size)
+    {
+        unsigned int new_size = max( cache->pool_size * 2, ret + size + 4096 );
+        char *new_pool;
+
+        if (cache->pool)
+            new_pool = RtlReAllocateHeap( GetProcessHeap(), 0, cache->pool, new_size );
+        else
+            new_pool = RtlAllocateHeap( GetProcessHeap(), 0, new_size );
+        if (!new_pool) return DIR_CACHE_NO_NAME;
+        cache->pool = new_pool;
+        cache->pool_size = new_size;
+    }
+    cache->pool_used = ret + size;
+    return ret;
+}
+
+
+/***********************************************************************
+ *           dir_cache_add_name
+ */
+static BOOL dir_cache_add_name( struct dir_cache *cache, const WCHAR *name, int len,
+                                unsigned int unix_name, BOOL is_short )
+{
+    struct dir_cache_name *entry;
+    unsigned int offset;
+
+    if (cache->count == cache->size)
+    {
+        unsigned int new_size = max( cache->size * 2, 64 );
+        struct dir_cache_name *new_names;
+
+        if (cache->names)
+            new_names = RtlReAllocateHeap( GetProcessHeap(), 0, cache->names,
+                                           new_size * sizeof(*new_names) );
+        else
+            new_names = RtlAllocateHeap( GetProcessHeap(), 0, new_size * sizeof(*new_names) );
+        if (!new_names) return FALSE;
+        cache->names = new_names;
+        cache->size = new_size;
+    }
+    if ((offset = dir_cache_alloc_string( cache, len * sizeof(WCHAR) )) == DIR_CACHE_NO_NAME)
+        return FALSE;
+    memcpy( cache->pool + offset, name, len * sizeof(WCHAR) );
+
+    entry = &cache->names[cache->count++];
+    entry->hash      = dir_cache_hash( name, len );
+    entry->name      = offset;
+    entry->unix_name = unix_name;
+    entry->len       = len;
+    entry->is_short  = is_short;
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           read_dir_cache
+ *
+ * Read the contents of a directory and build the name hash table.
+ */
+static struct dir_cache *read_dir_cache( const char *unix_name, const struct stat *st )
+{
+    WCHAR buffer[MAX_DIR_ENTRY_LEN];
+    UNICODE_STRING str;
+    struct dir_cache *cache;
+    struct dirent *de;
+    BOOLEAN spaces;
+    DIR *dir;
+    unsigned int i, unix_offset;
+    int len;
+
+    if (!(cache = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*cache) ))) return NULL;
+    cache->dev   = st->st_dev;
+    cache->ino   = st->st_ino;
+    cache->mtime = st->st_mtime;
+
+    if (!(dir = opendir( unix_name ))) goto failed;
+
+    str.Buffer = buffer;
+    str.MaximumLength = sizeof(buffer);
+    while ((de = readdir( dir )))
+    {
+        int unix_len = strlen( de->d_name ) + 1;
+
+        len = ntdll_umbstowcs( 0, de->d_name, unix_len - 1, buffer, MAX_DIR_ENTRY_LEN );
+        if (len <= 0) continue;
+
+        if ((unix_offset = dir_cache_alloc_string( cache, unix_len )) == DIR_CACHE_NO_NAME) break;
+        memcpy( cache->pool + unix_offset, de->d_name, unix_len );
+        if (!dir_cache_add_name( cache, buffer, len, unix_offset, FALSE )) break;
+
+        str.Length = len * sizeof(WCHAR);
+        if (!RtlIsNameLegalDOS8Dot3( &str, NULL, &spaces ) || spaces)
+        {
+            WCHAR short_nameW[12];
+            len = hash_short_file_name( &str, short_nameW );
+            if (!dir_cache_add_name( cache, short_nameW, len, unix_offset, TRUE )) break;
+        }
+    }
+    closedir( dir );
+    if (de) goto failed;  /* out of memory */
+
+    for (cache->hash_mask = 15; cache->hash_mask < cache->count; cache->hash_mask = cache->hash_mask * 2 + 1)
+        ;
+    if (!(cache->buckets = RtlAllocateHeap( GetProcessHeap(), 0,
+                                            (cache->hash_mask + 1) * sizeof(*cache->buckets) )))
+        goto failed;
+    memset( cache->buckets, 0xff, (cache->hash_mask + 1) * sizeof(*cache->buckets) );
+
+    /* insert in reverse order so that chains are in directory order */
+    for (i = cache->count; i > 0; i--)
+    {
+        struct dir_cache_name *entry = &cache->names[i - 1];
+        entry->next = cache->buckets[entry->hash & cache->hash_mask];
+        cache->buckets[entry->hash & cache->hash_mask] = i - 1;
+    }
+    return cache;
+
+failed:
+    free_dir_cache( cache );
+    return NULL;
+}
+
+
+/***********************************************************************
+ *           lookup_dir_cache
+ *
+ * Look for a name in the cached listing of the directory unix_name, which
+ * is terminated at pos - 1. On success the Unix name is appended at pos.
+ * Returns 1 if found, 0 if not found, -1 if the cache couldn't be used.
+ */
+static int lookup_dir_cache( char *unix_name, int pos, const WCHAR *name, int length,
+                             BOOLEAN check_short )
+{
+    struct dir_cache *cache, *new_cache = NULL;
+    const struct dir_cache_name *entry, *found = NULL;
+    unsigned int hash, idx;
+    struct stat st;
+
+    if (stat( unix_name, &st ) == -1) return -1;
+
+    /* the listing of a directory modified within the timestamp granularity is not reliable */
+    if (time( NULL ) - st.st_mtime < 2) return -1;
+
+    for (;;)
+    {
+        RtlEnterCriticalSection( &dir_cache_section );
+        LIST_FOR_EACH_ENTRY( cache, &dir_cache_list, struct dir_cache, entry )
+        {
+            if (cache->dev != st.st_dev || cache->ino != st.st_ino) continue;
+            if (cache->mtime == st.st_mtime) goto done;
+            /* directory changed since we read it */
+            list_remove( &cache->entry );
+            dir_cache_count--;
+            free_dir_cache( cache );
+            break;
+        }
+        if (new_cache)
+        {
+            cache = new_cache;
+            new_cache = NULL;
+            list_add_head( &dir_cache_list, &cache->entry );
+            if (++dir_cache_count > DIR_CACHE_MAX_DIRS)
+            {
+                struct dir_cache *old = LIST_ENTRY( list_tail( &dir_cache_list ), struct dir_cache, entry );
+                list_remove( &old->entry );
+                dir_cache_count--;
+                free_dir_cache( old );
+            }
+            goto done;
+        }
+        RtlLeaveCriticalSection( &dir_cache_section );
+
+        /* don't hold the lock while reading the directory */
+        if (!(new_cache = read_dir_cache( unix_name, &st ))) return -1;
+    }
+
+done:
+    if (new_cache) free_dir_cache( new_cache );  /* another thread was faster */
+    list_remove( &cache->entry );
+    list_add_head( &dir_cache_list, &cache->entry );
+
+    hash = dir_cache_hash( name, length );
+    for (idx = cache->buckets[hash & cache->hash_mask]; idx != DIR_CACHE_NO_NAME; idx = entry->next)
+    {
+        entry = &cache->names[idx];
+        if (entry->hash != hash || entry->len != length) continue;
+        if (entry->is_short && (!check_short || found)) continue;
+        if (memicmpW( (const WCHAR *)(cache->pool + entry->name), name, length )) continue;
+        found = entry;
+        if (!entry->is_short) break;  /* long names take precedence */
+    }
+    if (found)
+    {
+        unix_name[pos - 1] = '/';
+        strcpy( unix_name + pos, cache->pool + found->unix_name );
+    }
+    RtlLeaveCriticalSection( &dir_cache_section );
+    return found != NULL;
+}
+
+
 /***********************************************************************
  *           find_file_in_dir
  *
@@ -2134,6 +2411,12 @@ static NTSTATUS find_file_in_dir( char *unix_name, int pos, const WCHAR *name, i
     }
 #endif /* VFAT_IOCTL_READDIR_BOTH */
 
+    switch (lookup_dir_cache( unix_name, pos, name, length, is_name_8_dot_3 ))
+    {
+    case 1: goto success;
+    case 0: goto not_found;
+    }
+
     if (!(dir = opendir( unix_name )))
     {
         if (errno == ENOENT) return STATUS_OBJECT_PATH_NOT_FOUND;
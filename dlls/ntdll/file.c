@@ -95,6 +95,18 @@
 #ifdef HAVE_VALGRIND_MEMCHECK_H
 # include <valgrind/memcheck.h>
 #endif
+#ifdef HAVE_LINUX_IO_URING_H
+# include <linux/io_uring.h>
+# ifdef HAVE_SYS_MMAN_H
+#  include <sys/mman.h>
+# endif
+# ifdef HAVE_SYS_UIO_H
+#  include <sys/uio.h>
+# endif
+# ifdef HAVE_SYS_EVENTFD_H
+#  include <sys/eventfd.h>
+# endif
+#endif
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -102,6 +114,8 @@
 #include "wine/unicode.h"
 #include "wine/debug.h"
 #include "wine/server.h"
+#include "wine/list.h"
+#include "wine/rbtree.h"
 #include "ntdll_misc.h"
 
 #include "winternl.h"
@@ -803,6 +817,530 @@ static NTSTATUS register_async_file_read( HANDLE handle, HANDLE event,
     return status;
 }
 
+#if defined(HAVE_LINUX_IO_URING_H) && defined(HAVE_SYS_EVENTFD_H) && \
+    defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+
+/*
+ * io_uring backend for overlapped I/O on regular files.
+ *
+ * Overlapped reads and writes at an explicit offset are queued on a per-process
+ * ring instead of being performed synchronously by the calling thread. Entries
+ * queued by concurrent threads are submitted together by whichever thread enters
+ * the kernel first. A dedicated thread reaps the completions and updates the
+ * status block, signals the event and posts to the completion port. It also
+ * resubmits the entries left in the ring when io_uring_enter fails.
+ *
+ * This is only enabled when WINEIOURING is set. Requests with an APC are never
+ * queued, since the APC would have to run in the thread that issued them. Requests
+ * without an event are only queued on handles bound to a completion port, which
+ * reports their completion; otherwise the server never sees the I/O, so the file
+ * object stays signaled and waiting on it would return immediately.
+ *
+ * Completions use the handles of the application, so that queuing a request doesn't
+ * need any server call. If the application closes one of them while a request is
+ * pending, uring_close_handle takes a private duplicate first.
+ */
+
+#define URING_ENTRIES 256
+
+struct uring_request
+{
+    struct list      entry;      /* entry in the list of pending requests */
+    HANDLE           handle;     /* handle the request was issued on, for cancellation */
+    DWORD            tid;        /* thread that issued the request */
+    HANDLE           file;       /* file handle for the completion port, if it's bound to one */
+    HANDLE           event;      /* event to signal on completion */
+    BOOL             file_dup;   /* is file a private dup, since the application closed its handle? */
+    BOOL             event_dup;  /* same for event */
+    IO_STATUS_BLOCK *io;         /* status block to update on completion */
+    ULONG_PTR        cvalue;     /* completion port value */
+    int              unix_fd;    /* private dup of the file unix fd */
+    BOOL             write;      /* is this a write request? */
+    BOOL             cancelled;  /* has a cancel request been queued for it? */
+    BOOL             completing; /* has the ring thread started completing it? */
+    LONG             refs;       /* one for the request, one for a pending cancel request */
+    ULONGLONG        offset;     /* file offset */
+    struct iovec     iov;        /* buffer description */
+};
+
+/* handle bound to a completion port by this process */
+struct uring_port
+{
+    struct wine_rb_entry entry;
+    HANDLE               handle;
+};
+
+/* cancel requests complete with the address of their target and this bit set */
+#define URING_CANCEL_TAG 1
+
+static struct
+{
+    int                  fd;         /* ring fd */
+    int                  wake_fd;    /* eventfd to wake up the ring thread */
+    unsigned int        *sq_head;    /* submission queue pointers, mapped from the kernel */
+    unsigned int        *sq_tail;
+    unsigned int        *sq_mask;
+    unsigned int        *sq_array;
+    unsigned int         sq_entries;
+    unsigned int        *cq_head;    /* completion queue pointers, mapped from the kernel */
+    unsigned int        *cq_tail;
+    unsigned int        *cq_mask;
+    unsigned int         cq_entries;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    LONG                 inflight;   /* number of requests that have not been reaped yet */
+} uring;
+
+static struct list uring_requests = LIST_INIT( uring_requests );  /* requests that have not completed yet */
+static struct wine_rb_tree uring_ports;  /* handles bound to a completion port */
+
+static int uring_state;  /* 0 = not initialized, 1 = enabled, -1 = disabled */
+
+/* protects the ring, the request list and the port tree */
+static RTL_CRITICAL_SECTION uring_section;
+static RTL_CRITICAL_SECTION_DEBUG uring_critsect_debug =
+{
+    0, 0, &uring_section,
+    { &uring_critsect_debug.ProcessLocksList, &uring_critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": uring_section") }
+};
+static RTL_CRITICAL_SECTION uring_section = { &uring_critsect_debug, -1, 0, 0, 0, 0 };
+
+/* held while completing a request, so that its handles can't be closed meanwhile;
+ * taken before uring_section */
+static RTL_CRITICAL_SECTION uring_close_section;
+static RTL_CRITICAL_SECTION_DEBUG uring_close_critsect_debug =
+{
+    0, 0, &uring_close_section,
+    { &uring_close_critsect_debug.ProcessLocksList, &uring_close_critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": uring_close_section") }
+};
+static RTL_CRITICAL_SECTION uring_close_section = { &uring_close_critsect_debug, -1, 0, 0, 0, 0 };
+
+static int uring_port_compare( const void *key, const struct wine_rb_entry *entry )
+{
+    const struct uring_port *port = WINE_RB_ENTRY_VALUE( entry, const struct uring_port, entry );
+
+    if ((ULONG_PTR)key < (ULONG_PTR)port->handle) return -1;
+    return (ULONG_PTR)key > (ULONG_PTR)port->handle;
+}
+
+static void uring_release( struct uring_request *req )
+{
+    if (interlocked_xchg_add( &req->refs, -1 ) > 1) return;
+    if (req->file_dup) NtClose( req->file );
+    if (req->event_dup) NtClose( req->event );
+    RtlFreeHeap( GetProcessHeap(), 0, req );
+}
+
+/* submit the queued entries; returns FALSE if some of them are still in the ring */
+static BOOL uring_flush(void)
+{
+    while (syscall( __NR_io_uring_enter, uring.fd, uring.sq_entries, 0, 0, NULL, 0 ) == -1)
+    {
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN && errno != EBUSY) ERR( "io_uring_enter failed: %s\n", strerror( errno ));
+        break;
+    }
+    return __atomic_load_n( uring.sq_tail, __ATOMIC_ACQUIRE ) ==
+           __atomic_load_n( uring.sq_head, __ATOMIC_ACQUIRE );
+}
+
+/* have the ring thread submit the entries left in the ring */
+static void uring_wake(void)
+{
+    static const ULONGLONG one = 1;
+
+    while (write( uring.wake_fd, &one, sizeof(one) ) == -1 && errno == EINTR);
+}
+
+/* complete a request, called from the ring thread */
+static void uring_complete( struct uring_request *req, int res )
+{
+    NTSTATUS status;
+    ULONG total = 0;
+
+    /* it can't be cancelled anymore */
+    RtlEnterCriticalSection( &uring_section );
+    req->completing = TRUE;
+    RtlLeaveCriticalSection( &uring_section );
+
+    /* the kernel can't access buffers in write-watched memory, retry on our side */
+    if (res == -EFAULT && !req->write)
+    {
+        if ((res = virtual_locked_pread( req->unix_fd, req->iov.iov_base, req->iov.iov_len, req->offset )) == -1)
+            res = -errno;
+    }
+    close( req->unix_fd );
+
+    if (res >= 0)
+    {
+        total = res;
+        status = (total || !req->iov.iov_len || req->write) ? STATUS_SUCCESS : STATUS_END_OF_FILE;
+    }
+    else if (res == -EFAULT && req->write) status = STATUS_INVALID_USER_BUFFER;
+    else if (res == -ECANCELED) status = STATUS_CANCELLED;
+    else
+    {
+        errno = -res;
+        status = FILE_GetNtStatus();
+    }
+
+    TRACE( "%p: %s of %u bytes at 0x%s = 0x%08x (%u)\n", req->handle, req->write ? "write" : "read",
+           (ULONG)req->iov.iov_len, wine_dbgstr_longlong( req->offset ), status, total );
+
+    req->io->Information = total;
+    __atomic_store_n( &req->io->u.Status, status, __ATOMIC_RELEASE );
+
+    /* the request stays in the list until then, so that uring_close_handle can find it */
+    RtlEnterCriticalSection( &uring_close_section );
+    if (req->event) NtSetEvent( req->event, NULL );
+    if (req->file) NTDLL_AddCompletion( req->file, req->cvalue, status, total );
+    RtlEnterCriticalSection( &uring_section );
+    list_remove( &req->entry );
+    RtlLeaveCriticalSection( &uring_section );
+    RtlLeaveCriticalSection( &uring_close_section );
+
+    interlocked_xchg_add( &uring.inflight, -1 );
+    uring_release( req );
+}
+
+/* thread reaping the ring completions */
+static void WINAPI uring_thread( void *arg )
+{
+    struct io_uring_cqe *cqe;
+    struct pollfd pfd[2];
+    unsigned int head, tail;
+    ULONGLONG value;
+    BOOL pending = FALSE;
+    int res;
+
+    pfd[0].fd = uring.fd;
+    pfd[0].events = POLLIN;
+    pfd[1].fd = uring.wake_fd;
+    pfd[1].events = POLLIN;
+
+    for (;;)
+    {
+        head = *uring.cq_head;
+        tail = __atomic_load_n( uring.cq_tail, __ATOMIC_ACQUIRE );
+        if (head == tail)
+        {
+            /* entries left by a failed submission, retry until the kernel takes them */
+            if (__atomic_load_n( uring.sq_tail, __ATOMIC_ACQUIRE ) != __atomic_load_n( uring.sq_head, __ATOMIC_ACQUIRE ))
+                pending = !uring_flush();
+            else
+                pending = FALSE;
+
+            if (poll( pfd, 2, pending ? 1 : -1 ) > 0 && (pfd[1].revents & POLLIN))
+                while (read( uring.wake_fd, &value, sizeof(value) ) == -1 && errno == EINTR);
+            continue;
+        }
+        for (; head != tail; head++)
+        {
+            struct uring_request *req;
+
+            cqe = &uring.cqes[head & *uring.cq_mask];
+            req = (struct uring_request *)(ULONG_PTR)(cqe->user_data & ~(ULONGLONG)URING_CANCEL_TAG);
+            res = cqe->res;
+            __atomic_store_n( uring.cq_head, head + 1, __ATOMIC_RELEASE );
+            if (cqe->user_data & URING_CANCEL_TAG)
+            {
+                /* the target was kept alive so that its address couldn't be reused in the meantime */
+                interlocked_xchg_add( &uring.inflight, -1 );
+                uring_release( req );
+            }
+            else uring_complete( req, res );
+        }
+    }
+}
+
+/* create the ring and its thread; called with uring_section held */
+static BOOL uring_init(void)
+{
+    struct io_uring_params params;
+    const char *env = getenv( "WINEIOURING" );
+    size_t sq_size, cq_size;
+    char *sq_ptr, *cq_ptr;
+    void *sqes;
+    HANDLE thread;
+    int fd, wake_fd;
+
+    if (!env || !atoi( env )) return FALSE;
+
+    memset( &params, 0, sizeof(params) );
+    if ((fd = syscall( __NR_io_uring_setup, URING_ENTRIES, &params )) == -1)
+    {
+        WARN( "io_uring not available: %s\n", strerror( errno ));
+        return FALSE;
+    }
+    if ((wake_fd = eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK )) == -1)
+    {
+        close( fd );
+        return FALSE;
+    }
+
+    sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    sq_ptr = mmap( NULL, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, IORING_OFF_SQ_RING );
+    cq_ptr = mmap( NULL, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, IORING_OFF_CQ_RING );
+    sqes = mmap( NULL, params.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                 MAP_SHARED, fd, IORING_OFF_SQES );
+    if (sq_ptr == MAP_FAILED || cq_ptr == MAP_FAILED || sqes == MAP_FAILED) goto failed;
+
+    uring.fd         = fd;
+    uring.wake_fd    = wake_fd;
+    uring.sq_head    = (unsigned int *)(sq_ptr + params.sq_off.head);
+    uring.sq_tail    = (unsigned int *)(sq_ptr + params.sq_off.tail);
+    uring.sq_mask    = (unsigned int *)(sq_ptr + params.sq_off.ring_mask);
+    uring.sq_array   = (unsigned int *)(sq_ptr + params.sq_off.array);
+    uring.sq_entries = params.sq_entries;
+    uring.cq_head    = (unsigned int *)(cq_ptr + params.cq_off.head);
+    uring.cq_tail    = (unsigned int *)(cq_ptr + params.cq_off.tail);
+    uring.cq_mask    = (unsigned int *)(cq_ptr + params.cq_off.ring_mask);
+    uring.cq_entries = params.cq_entries;
+    uring.cqes       = (struct io_uring_cqe *)(cq_ptr + params.cq_off.cqes);
+    uring.sqes       = sqes;
+    wine_rb_init( &uring_ports, uring_port_compare );
+
+    if (RtlCreateUserThread( GetCurrentProcess(), NULL, FALSE, NULL, 0, 0,
+                             (PRTL_THREAD_START_ROUTINE)uring_thread, NULL, &thread, NULL ))
+        goto failed;
+    NtClose( thread );
+    TRACE( "using io_uring with %u entries\n", params.sq_entries );
+    return TRUE;
+
+failed:
+    if (sq_ptr != MAP_FAILED) munmap( sq_ptr, sq_size );
+    if (cq_ptr != MAP_FAILED) munmap( cq_ptr, cq_size );
+    if (sqes != MAP_FAILED) munmap( sqes, params.sq_entries * sizeof(struct io_uring_sqe) );
+    close( wake_fd );
+    close( fd );
+    return FALSE;
+}
+
+static BOOL uring_enabled(void)
+{
+    if (!uring_state)
+    {
+        RtlEnterCriticalSection( &uring_section );
+        if (!uring_state) uring_state = uring_init() ? 1 : -1;
+        RtlLeaveCriticalSection( &uring_section );
+    }
+    return uring_state > 0;
+}
+
+/* remember which handles are bound to a completion port */
+static void uring_set_completion( HANDLE file )
+{
+    struct uring_port *port;
+
+    if (!uring_enabled()) return;
+
+    RtlEnterCriticalSection( &uring_section );
+    if (!wine_rb_get( &uring_ports, file ) &&
+        (port = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*port) )))
+    {
+        port->handle = file;
+        wine_rb_put( &uring_ports, file, &port->entry );
+    }
+    RtlLeaveCriticalSection( &uring_section );
+}
+
+/***********************************************************************
+ *           uring_close_handle
+ *
+ * Called before a handle of the current process is closed. Pending
+ * requests that still use it get a private duplicate.
+ */
+void uring_close_handle( HANDLE handle )
+{
+    struct uring_request *req;
+    struct wine_rb_entry *entry;
+
+    if (uring_state <= 0 || !handle) return;
+
+    RtlEnterCriticalSection( &uring_close_section );
+    RtlEnterCriticalSection( &uring_section );
+    if ((entry = wine_rb_get( &uring_ports, handle )))
+    {
+        wine_rb_remove( &uring_ports, entry );
+        RtlFreeHeap( GetProcessHeap(), 0, WINE_RB_ENTRY_VALUE( entry, struct uring_port, entry ));
+    }
+    LIST_FOR_EACH_ENTRY( req, &uring_requests, struct uring_request, entry )
+    {
+        if (req->file == handle && !req->file_dup)
+        {
+            if (NtDuplicateObject( NtCurrentProcess(), handle, NtCurrentProcess(), &req->file,
+                                   0, 0, DUPLICATE_SAME_ACCESS ))
+                WARN( "%p: can't keep file handle for pending request\n", handle );
+            else req->file_dup = TRUE;
+        }
+        if (req->event == handle && !req->event_dup)
+        {
+            if (NtDuplicateObject( NtCurrentProcess(), handle, NtCurrentProcess(), &req->event,
+                                   0, 0, DUPLICATE_SAME_ACCESS ))
+                WARN( "%p: can't keep event for pending request\n", handle );
+            else req->event_dup = TRUE;
+        }
+    }
+    RtlLeaveCriticalSection( &uring_section );
+    RtlLeaveCriticalSection( &uring_close_section );
+}
+
+/***********************************************************************
+ *           uring_submit
+ *
+ * Queue an overlapped read or write on a regular file.
+ * Returns STATUS_PENDING on success, or STATUS_NOT_SUPPORTED if the
+ * caller has to do the I/O itself.
+ */
+static NTSTATUS uring_submit( HANDLE file, int unix_fd, BOOL write, HANDLE event, ULONG_PTR cvalue,
+                              IO_STATUS_BLOCK *io, void *buffer, ULONG length, ULONGLONG offset )
+{
+    struct uring_request *req;
+    struct io_uring_sqe *sqe;
+    unsigned int tail, index;
+    BOOL bound;
+
+    if ((!event && !cvalue) || !uring_enabled()) return STATUS_NOT_SUPPORTED;
+
+    RtlEnterCriticalSection( &uring_section );
+    bound = cvalue && wine_rb_get( &uring_ports, file );
+    RtlLeaveCriticalSection( &uring_section );
+    if (!event && !bound) return STATUS_NOT_SUPPORTED;
+
+    /* make sure completions can't overflow the completion queue */
+    if (interlocked_xchg_add( &uring.inflight, 1 ) >= uring.cq_entries) goto failed;
+    if (!(req = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*req) ))) goto failed;
+    if ((req->unix_fd = dup( unix_fd )) == -1)
+    {
+        RtlFreeHeap( GetProcessHeap(), 0, req );
+        goto failed;
+    }
+    req->refs         = 1;
+    req->handle       = file;
+    req->tid          = GetCurrentThreadId();
+    req->file         = bound ? file : 0;
+    req->event        = event;
+    req->io           = io;
+    req->cvalue       = cvalue;
+    req->write        = write;
+    req->offset       = offset;
+    req->iov.iov_base = buffer;
+    req->iov.iov_len  = length;
+
+    io->u.Status    = STATUS_PENDING;
+    io->Information = 0;
+    if (event) NtResetEvent( event, NULL );
+
+    RtlEnterCriticalSection( &uring_section );
+    tail = *uring.sq_tail;
+    if (tail - __atomic_load_n( uring.sq_head, __ATOMIC_ACQUIRE ) >= uring.sq_entries)
+    {
+        RtlLeaveCriticalSection( &uring_section );
+        close( req->unix_fd );
+        uring_release( req );
+        goto failed;
+    }
+    index = tail & *uring.sq_mask;
+    sqe = &uring.sqes[index];
+    memset( sqe, 0, sizeof(*sqe) );
+    sqe->opcode    = write ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd        = req->unix_fd;
+    sqe->addr      = (ULONG_PTR)&req->iov;
+    sqe->len       = 1;
+    sqe->off       = offset;
+    sqe->user_data = (ULONG_PTR)req;
+    uring.sq_array[index] = index;
+    __atomic_store_n( uring.sq_tail, tail + 1, __ATOMIC_RELEASE );
+    list_add_tail( &uring_requests, &req->entry );
+    RtlLeaveCriticalSection( &uring_section );
+
+    /* this also submits the entries queued by other threads in the meantime */
+    if (!uring_flush()) uring_wake();
+    return STATUS_PENDING;
+
+failed:
+    interlocked_xchg_add( &uring.inflight, -1 );
+    return STATUS_NOT_SUPPORTED;
+}
+
+/***********************************************************************
+ *           uring_cancel
+ *
+ * Queue cancel requests for the pending requests issued on a handle,
+ * optionally only those with a given status block or from the current
+ * thread. Returns the number of requests that were asked to cancel.
+ * This is best effort; a request that the kernel has already started
+ * completes normally.
+ */
+static unsigned int uring_cancel( HANDLE file, IO_STATUS_BLOCK *io, BOOL only_thread )
+{
+    struct uring_request *req;
+    struct io_uring_sqe *sqe;
+    unsigned int tail, index, count = 0;
+
+    if (uring_state <= 0) return 0;
+
+    RtlEnterCriticalSection( &uring_section );
+    LIST_FOR_EACH_ENTRY( req, &uring_requests, struct uring_request, entry )
+    {
+        if (req->handle != file || req->cancelled || req->completing) continue;
+        if (io && req->io != io) continue;
+        if (only_thread && req->tid != GetCurrentThreadId()) continue;
+
+        tail = *uring.sq_tail;
+        if (tail - __atomic_load_n( uring.sq_head, __ATOMIC_ACQUIRE ) >= uring.sq_entries) break;
+        if (interlocked_xchg_add( &uring.inflight, 1 ) >= uring.cq_entries)
+        {
+            interlocked_xchg_add( &uring.inflight, -1 );
+            break;
+        }
+
+        /* keep the request alive until the cancel request has completed too */
+        interlocked_xchg_add( &req->refs, 1 );
+        req->cancelled = TRUE;
+        index = tail & *uring.sq_mask;
+        sqe = &uring.sqes[index];
+        memset( sqe, 0, sizeof(*sqe) );
+        sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+        sqe->fd        = -1;
+        sqe->addr      = (ULONG_PTR)req;
+        sqe->user_data = (ULONG_PTR)req | URING_CANCEL_TAG;
+        uring.sq_array[index] = index;
+        __atomic_store_n( uring.sq_tail, tail + 1, __ATOMIC_RELEASE );
+        count++;
+    }
+    RtlLeaveCriticalSection( &uring_section );
+
+    if (count && !uring_flush()) uring_wake();
+    return count;
+}
+
+#else  /* HAVE_LINUX_IO_URING_H */
+
+static NTSTATUS uring_submit( HANDLE file, int unix_fd, BOOL write, HANDLE event, ULONG_PTR cvalue,
+                              IO_STATUS_BLOCK *io, void *buffer, ULONG length, ULONGLONG offset )
+{
+    return STATUS_NOT_SUPPORTED;
+}
+
+static unsigned int uring_cancel( HANDLE file, IO_STATUS_BLOCK *io, BOOL only_thread )
+{
+    return 0;
+}
+
+static void uring_set_completion( HANDLE file )
+{
+}
+
+void uring_close_handle( HANDLE handle )
+{
+}
+
+#endif  /* HAVE_LINUX_IO_URING_H */
+
 
 /******************************************************************************
  *  NtReadFile					[NTDLL.@]
@@ -866,6 +1404,11 @@ NTSTATUS WINAPI NtReadFile(HANDLE hFile, HANDLE hEvent,
 
         if (offset && offset->QuadPart != FILE_USE_FILE_POINTER_POSITION)
         {
+            if (async_read && !apc &&
+                (status = uring_submit( hFile, unix_handle, FALSE, hEvent, cvalue, io_status,
+                                        buffer, length, offset->QuadPart )) == STATUS_PENDING)
+                goto err;
+
             /* async I/O doesn't make sense on regular files */
             while ((result = virtual_locked_pread( unix_handle, buffer, length, offset->QuadPart )) == -1)
             {
@@ -1268,6 +1811,10 @@ NTSTATUS WINAPI NtWriteFile(HANDLE hFile, HANDLE hEvent,
                 status = STATUS_INVALID_PARAMETER;
                 goto done;
             }
+            else if (async_write && !apc && !append_write &&
+                     (status = uring_submit( hFile, unix_handle, TRUE, hEvent, cvalue, io_status,
+                                             (void *)buffer, length, off )) == STATUS_PENDING)
+                goto err;
 
             /* async I/O doesn't make sense on regular files */
             while ((result = pwrite( unix_handle, buffer, length, off )) == -1)
@@ -2734,6 +3281,7 @@ NTSTATUS WINAPI NtSetInformationFile(HANDLE handle, PIO_STATUS_BLOCK io,
                 io->u.Status  = wine_server_call( req );
             }
             SERVER_END_REQ;
+            if (!io->u.Status && info->CompletionPort) uring_set_completion( handle );
         } else
             io->u.Status = STATUS_INVALID_PARAMETER_3;
         break;
@@ -3378,18 +3926,34 @@ NTSTATUS WINAPI NtFlushBuffersFile( HANDLE hFile, IO_STATUS_BLOCK* IoStatusBlock
     }
     else if (ret != STATUS_ACCESS_DENIED)
     {
-        SERVER_START_REQ( flush )
-        {
-            req->async = server_async( hFile, NULL, NULL, NULL, NULL, IoStatusBlock );
-            ret = wine_server_call( req );
-            hEvent = wine_server_ptr_handle( reply->event );
-        }
-        SERVER_END_REQ;
+        struct async_irp *async;
 
-        if (hEvent)
+        /* a pending flush reports its status through the iosb */
+        if (!virtual_check_buffer_for_write( IoStatusBlock, sizeof(*IoStatusBlock) ))
+            ret = STATUS_ACCESS_VIOLATION;
+        else if (!(async = (struct async_irp *)alloc_fileio( sizeof(*async), irp_completion, hFile )))
+            ret = STATUS_NO_MEMORY;
+        else
         {
-            NtWaitForSingleObject( hEvent, FALSE, NULL );
-            ret = STATUS_SUCCESS;
+            async->event  = NULL;
+            async->buffer = NULL;
+            async->size   = 0;
+
+            SERVER_START_REQ( flush )
+            {
+                req->async = server_async( hFile, &async->io, NULL, NULL, NULL, IoStatusBlock );
+                ret = wine_server_call( req );
+                hEvent = wine_server_ptr_handle( reply->event );
+            }
+            SERVER_END_REQ;
+
+            if (ret != STATUS_PENDING) RtlFreeHeap( GetProcessHeap(), 0, async );
+
+            if (hEvent)
+            {
+                NtWaitForSingleObject( hEvent, FALSE, NULL );
+                if (ret == STATUS_PENDING) ret = IoStatusBlock->u.Status;
+            }
         }
     }
 
@@ -3580,8 +4144,12 @@ NTSTATUS WINAPI NtDeleteFile( POBJECT_ATTRIBUTES ObjectAttributes )
  */
 NTSTATUS WINAPI NtCancelIoFileEx( HANDLE hFile, PIO_STATUS_BLOCK iosb, PIO_STATUS_BLOCK io_status )
 {
+    unsigned int count;
+
     TRACE("%p %p %p\n", hFile, iosb, io_status );
 
+    count = uring_cancel( hFile, iosb, FALSE );
+
     SERVER_START_REQ( cancel_async )
     {
         req->handle      = wine_server_obj_handle( hFile );
@@ -3591,6 +4159,7 @@ NTSTATUS WINAPI NtCancelIoFileEx( HANDLE hFile, PIO_STATUS_BLOCK iosb, PIO_STATU
     }
     SERVER_END_REQ;
 
+    if (io_status->u.Status == STATUS_NOT_FOUND && count) io_status->u.Status = STATUS_SUCCESS;
     return io_status->u.Status;
 }
 
@@ -3603,6 +4172,8 @@ NTSTATUS WINAPI NtCancelIoFile( HANDLE hFile, PIO_STATUS_BLOCK io_status )
 {
     TRACE("%p %p\n", hFile, io_status );
 
+    uring_cancel( hFile, NULL, TRUE );
+
     SERVER_START_REQ( cancel_async )
     {
         req->handle      = wine_server_obj_handle( hFile );
@@ -164,10 +164,47 @@ typedef struct tagHEAP
     ARENA_INUSE    **pending_free;  /* Ring buffer for pending free requests */
     RTL_CRITICAL_SECTION critSection; /* Critical section for serialization */
     FREE_LIST_ENTRY *freeList;      /* Free lists */
+    struct tagLFH   *lfh;           /* Low fragmentation front-end, if enabled */
 } HEAP;
 
 #define HEAP_MAGIC       ((DWORD)('H' | ('E'<<8) | ('A'<<16) | ('P'<<24)))
 
+/* Low fragmentation heap front-end
+ *
+ * Small blocks are carved from dedicated regions in fixed size classes, and freed
+ * blocks are cached in lock-free per-size bins instead of going back to the free
+ * lists, so that the common allocation and free paths don't need the heap lock.
+ * There are several sets of bins, selected from the thread id, to spread the
+ * contention on the list heads. The blocks use the in-use arena layout with a
+ * special magic, the regions never shrink until the heap is destroyed.
+ */
+
+#define ARENA_LFH_MAGIC        0x48464c    /* in-use LFH block */
+#define ARENA_LFH_FREE_MAGIC   0x46484c    /* LFH block cached in a bin */
+
+#define HEAP_LFH_MAX_DATA_SIZE ROUND_SIZE(0x400)  /* largest block size handled by the LFH */
+#define HEAP_LFH_NB_BINS       ((HEAP_LFH_MAX_DATA_SIZE - HEAP_MIN_DATA_SIZE) / ALIGNMENT + 1)
+#define HEAP_LFH_NB_AFFINITY   8          /* number of per-thread bin sets */
+#define HEAP_LFH_MAX_REGIONS   24
+#define HEAP_LFH_REGION_SIZE   0x100000   /* size of the first region, doubled for each new one */
+#define HEAP_LFH_MAX_REGION_SIZE 0x4000000
+#define HEAP_LFH_REFILL_SIZE   0x2000     /* amount of memory carved at once when a bin is empty */
+
+typedef struct
+{
+    char               *base;       /* Base address of the region */
+    SIZE_T              size;       /* Reserved size */
+    SIZE_T              commit;     /* Committed size */
+    SIZE_T              used;       /* Size already carved into blocks */
+} LFH_REGION;
+
+typedef struct tagLFH
+{
+    SLIST_HEADER        bins[HEAP_LFH_NB_AFFINITY][HEAP_LFH_NB_BINS];  /* Cached free blocks */
+    LFH_REGION          regions[HEAP_LFH_MAX_REGIONS];  /* Regions holding the LFH blocks */
+    int                 nb_regions; /* Number of regions in use */
+} LFH;
+
 #define HEAP_DEF_SIZE        0x110000   /* Default heap size = 1Mb + 64Kb */
 #define COMMIT_MASK          0xffff  /* bitmask for commit/decommit granularity */
 #define MAX_FREE_PENDING     1024    /* max number of free requests to delay */
@@ -179,6 +216,7 @@ typedef struct tagHEAP
 #define HEAP_VALIDATE_PARAMS  0x40000000
 
 static HEAP *processHeap;  /* main process heap */
+static BOOL lfh_by_default;  /* enable the LFH for new heaps */
 
 static BOOL HEAP_IsRealArena( HEAP *heapPtr, DWORD flags, LPCVOID block, BOOL quiet );
 
@@ -716,6 +754,25 @@ static void HEAP_ShrinkBlock(SUBHEAP *subheap, ARENA_INUSE *pArena, SIZE_T size)
 }
 
 
+/***********************************************************************
+ *           set_heap_huge_page_hint
+ *
+ * Hint the kernel to use transparent huge pages for a large heap area,
+ * if enabled with WINEHEAPTHP=1.
+ */
+static void set_heap_huge_page_hint( void *base, SIZE_T size )
+{
+    static int enabled = -1;
+
+    if (enabled == -1)
+    {
+        const char *env = getenv( "WINEHEAPTHP" );
+        enabled = env && atoi( env );
+    }
+    if (enabled) virtual_set_huge_page_hint( base, size );
+}
+
+
 /***********************************************************************
  *           allocate_large_block
  */
@@ -732,6 +789,7 @@ static void *allocate_large_block( HEAP *heap, DWORD flags, SIZE_T size )
         WARN("Could not allocate block for %08lx bytes\n", size );
         return NULL;
     }
+    set_heap_huge_page_hint( address, block_size );
     arena = address;
     arena->data_size = size;
     arena->block_size = block_size;
@@ -870,6 +928,384 @@ static BOOL validate_large_arena( HEAP *heap, const ARENA_LARGE *arena, BOOL qui
 }
 
 
+/***********************************************************************
+ *           lfh_get_bin
+ *
+ * Get the LFH bin index for a given block data size.
+ */
+static inline unsigned int lfh_get_bin( SIZE_T size )
+{
+    return (size - HEAP_MIN_DATA_SIZE) / ALIGNMENT;
+}
+
+
+/***********************************************************************
+ *           lfh_get_affinity
+ *
+ * Get the bin set to use for the current thread.
+ */
+static inline unsigned int lfh_get_affinity(void)
+{
+    return (GetCurrentThreadId() >> 2) % HEAP_LFH_NB_AFFINITY;
+}
+
+
+/***********************************************************************
+ *           find_lfh_block
+ *
+ * Find the LFH arena for a given pointer, if it belongs to a LFH region.
+ * Doesn't need the heap lock.
+ */
+static ARENA_INUSE *find_lfh_block( HEAP *heap, const void *ptr )
+{
+    LFH *lfh = heap->lfh;
+    int i, count = *(volatile int *)&lfh->nb_regions;
+
+    for (i = 0; i < count; i++)
+    {
+        const LFH_REGION *region = &lfh->regions[i];
+        if ((ULONG_PTR)((const char *)ptr - region->base) < *(volatile SIZE_T *)&region->used)
+            return (ARENA_INUSE *)ptr - 1;
+    }
+    return NULL;
+}
+
+
+/***********************************************************************
+ *           validate_lfh_block
+ */
+static BOOL validate_lfh_block( HEAP *heap, const ARENA_INUSE *arena, BOOL quiet )
+{
+    const char *err = NULL;
+
+    if ((ULONG_PTR)arena % ALIGNMENT != ARENA_OFFSET)
+        err = "invalid LFH arena pointer";
+    else if (arena->magic == ARENA_LFH_FREE_MAGIC)
+        err = "LFH block used after free";
+    else if (arena->magic != ARENA_LFH_MAGIC)
+        err = "invalid LFH arena magic";
+    else if (arena->size < HEAP_MIN_DATA_SIZE || arena->size > HEAP_LFH_MAX_DATA_SIZE ||
+             (arena->size - HEAP_MIN_DATA_SIZE) % ALIGNMENT || arena->unused_bytes > arena->size)
+        err = "invalid LFH arena size";
+    else
+        return TRUE;
+
+    if (quiet == NOISY) ERR( "Heap %p: %s %p\n", heap, err, arena );
+    else WARN( "Heap %p: %s %p\n", heap, err, arena );
+    return FALSE;
+}
+
+
+/***********************************************************************
+ *           validate_lfh_regions
+ *
+ * Validate all the blocks of the LFH regions. Must be called with the heap locked.
+ */
+static BOOL validate_lfh_regions( HEAP *heap )
+{
+    int i;
+
+    for (i = 0; i < heap->lfh->nb_regions; i++)
+    {
+        const LFH_REGION *region = &heap->lfh->regions[i];
+        const char *ptr = region->base + ARENA_OFFSET;
+
+        while (ptr < region->base + region->used)
+        {
+            const ARENA_INUSE *arena = (const ARENA_INUSE *)ptr;
+
+            if (arena->magic != ARENA_LFH_FREE_MAGIC)
+            {
+                if (!validate_lfh_block( heap, arena, NOISY )) return FALSE;
+            }
+            else if (arena->size < HEAP_MIN_DATA_SIZE || arena->size > HEAP_LFH_MAX_DATA_SIZE)
+            {
+                ERR( "Heap %p: invalid LFH arena size for free block %p\n", heap, arena );
+                return FALSE;
+            }
+            ptr += sizeof(*arena) + arena->size;
+        }
+    }
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           walk_lfh_regions
+ *
+ * Continue a heap walk through the LFH regions, starting after the block
+ * at 'ptr', or at the first region if 'ptr' is NULL.
+ */
+static NTSTATUS walk_lfh_regions( HEAP *heap, LPPROCESS_HEAP_ENTRY entry, int region_index, char *ptr )
+{
+    LFH *lfh = heap->lfh;
+    const LFH_REGION *region = NULL;
+    const ARENA_INUSE *arena;
+    int i = 0;
+
+    if (ptr)
+    {
+        for (i = 0; i < lfh->nb_regions; i++)
+            if ((ULONG_PTR)(ptr - lfh->regions[i].base) < lfh->regions[i].used) break;
+        ptr += ((const ARENA_INUSE *)ptr - 1)->size;  /* point to next arena */
+    }
+    for ( ; i < lfh->nb_regions; i++, ptr = NULL)
+    {
+        region = &lfh->regions[i];
+        if (!ptr) ptr = region->base + ARENA_OFFSET;
+        if (ptr < region->base + region->used) break;
+    }
+    if (i == lfh->nb_regions) return STATUS_NO_MORE_ENTRIES;
+
+    arena = (const ARENA_INUSE *)ptr;
+    entry->lpData = (void *)(arena + 1);
+    entry->cbData = arena->size;
+    entry->cbOverhead = sizeof(ARENA_INUSE);
+    entry->wFlags = (arena->magic == ARENA_LFH_MAGIC) ?
+                    PROCESS_HEAP_ENTRY_BUSY : PROCESS_HEAP_UNCOMMITTED_RANGE;
+    entry->iRegionIndex = region_index + i;
+
+    /* first element of region ? */
+    if (ptr == region->base + ARENA_OFFSET)
+    {
+        entry->wFlags |= PROCESS_HEAP_REGION;
+        entry->u.Region.dwCommittedSize = region->commit;
+        entry->u.Region.dwUnCommittedSize = region->size - region->commit;
+        entry->u.Region.lpFirstBlock = region->base + ARENA_OFFSET;
+        entry->u.Region.lpLastBlock = region->base + region->size;
+    }
+    return STATUS_SUCCESS;
+}
+
+
+/***********************************************************************
+ *           lfh_get_region
+ *
+ * Find a LFH region with enough committed space for 'size' more bytes.
+ * Must be called with the heap locked.
+ */
+static LFH_REGION *lfh_get_region( HEAP *heap, SIZE_T size )
+{
+    LFH *lfh = heap->lfh;
+    LFH_REGION *region = NULL;
+    SIZE_T commit;
+    void *addr;
+
+    if (lfh->nb_regions)
+    {
+        region = &lfh->regions[lfh->nb_regions - 1];
+        if (region->used + size > region->size) region = NULL;
+    }
+
+    if (!region)
+    {
+        SIZE_T region_size = HEAP_LFH_REGION_SIZE;
+
+        if (lfh->nb_regions == HEAP_LFH_MAX_REGIONS) return NULL;
+        if (lfh->nb_regions)
+            region_size = min( lfh->regions[lfh->nb_regions - 1].size * 2, HEAP_LFH_MAX_REGION_SIZE );
+        addr = NULL;
+        if (NtAllocateVirtualMemory( NtCurrentProcess(), &addr, 0, &region_size, MEM_RESERVE,
+                                     get_protection_type( heap->flags )))
+        {
+            WARN( "Could not allocate LFH region for heap %p\n", heap );
+            return NULL;
+        }
+        set_heap_huge_page_hint( addr, region_size );
+        region = &lfh->regions[lfh->nb_regions];
+        region->base = addr;
+        region->size = region_size;
+        region->commit = 0;
+        region->used = ARENA_OFFSET;
+        interlocked_xchg( &lfh->nb_regions, lfh->nb_regions + 1 );
+    }
+
+    if (region->used + size > region->commit)
+    {
+        commit = ((region->used + size - region->commit) + COMMIT_MASK) & ~COMMIT_MASK;
+        commit = min( commit, region->size - region->commit );
+        addr = region->base + region->commit;
+        if (NtAllocateVirtualMemory( NtCurrentProcess(), &addr, 0, &commit, MEM_COMMIT,
+                                     get_protection_type( heap->flags )))
+        {
+            WARN( "Could not commit %08lx bytes at %p for heap %p\n", commit, addr, heap );
+            return NULL;
+        }
+        region->commit += commit;
+    }
+    return region;
+}
+
+
+/***********************************************************************
+ *           lfh_refill_bin
+ *
+ * Carve a new batch of blocks for an empty bin, and return one of them.
+ */
+static SLIST_ENTRY *lfh_refill_bin( HEAP *heap, unsigned int affinity, unsigned int bin )
+{
+    SIZE_T size = HEAP_MIN_DATA_SIZE + bin * ALIGNMENT;
+    SIZE_T block_size = sizeof(ARENA_INUSE) + size;
+    SIZE_T i, count = HEAP_LFH_REFILL_SIZE / block_size;
+    SLIST_HEADER *list = &heap->lfh->bins[affinity][bin];
+    ARENA_INUSE *arena;
+    LFH_REGION *region;
+    char *ptr, *start;
+
+    RtlEnterCriticalSection( &heap->critSection );
+
+    if (!(region = lfh_get_region( heap, count * block_size )))
+    {
+        RtlLeaveCriticalSection( &heap->critSection );
+        return NULL;
+    }
+    start = ptr = region->base + region->used;
+    for (i = 0; i < count; i++, ptr += block_size)
+    {
+        arena = (ARENA_INUSE *)ptr;
+        arena->size = size;
+        arena->magic = ARENA_LFH_FREE_MAGIC;
+        arena->unused_bytes = 0;
+    }
+    *(volatile SIZE_T *)&region->used += count * block_size;
+
+    RtlLeaveCriticalSection( &heap->critSection );
+
+    /* keep the first block and cache the others */
+    for (i = 1; i < count; i++)
+        RtlInterlockedPushEntrySList( list, (SLIST_ENTRY *)((ARENA_INUSE *)(start + i * block_size) + 1) );
+    return (SLIST_ENTRY *)((ARENA_INUSE *)start + 1);
+}
+
+
+/***********************************************************************
+ *           allocate_lfh_block
+ */
+static void *allocate_lfh_block( HEAP *heap, DWORD flags, SIZE_T rounded_size, SIZE_T size )
+{
+    unsigned int i, bin = lfh_get_bin( rounded_size ), affinity = lfh_get_affinity();
+    SLIST_ENTRY *entry = NULL;
+    ARENA_INUSE *arena;
+
+    /* try our own bin first, then steal from the other threads */
+    for (i = 0; i < HEAP_LFH_NB_AFFINITY && !entry; i++)
+        entry = RtlInterlockedPopEntrySList( &heap->lfh->bins[(affinity + i) % HEAP_LFH_NB_AFFINITY][bin] );
+    if (!entry && !(entry = lfh_refill_bin( heap, affinity, bin ))) return NULL;
+
+    arena = (ARENA_INUSE *)entry - 1;
+    arena->magic = ARENA_LFH_MAGIC;
+    arena->unused_bytes = arena->size - size;
+
+    notify_alloc( arena + 1, size, flags & HEAP_ZERO_MEMORY );
+    initialize_block( arena + 1, size, arena->unused_bytes, flags );
+    return arena + 1;
+}
+
+
+/***********************************************************************
+ *           free_lfh_block
+ */
+static void free_lfh_block( HEAP *heap, ARENA_INUSE *arena )
+{
+    SLIST_HEADER *list = &heap->lfh->bins[lfh_get_affinity()][lfh_get_bin( arena->size )];
+
+    arena->magic = ARENA_LFH_FREE_MAGIC;
+    mark_block_free( arena + 1, arena->size, heap->flags );
+    RtlInterlockedPushEntrySList( list, (SLIST_ENTRY *)(arena + 1) );
+}
+
+
+/***********************************************************************
+ *           realloc_lfh_block
+ */
+static void *realloc_lfh_block( HEAP *heap, DWORD flags, ARENA_INUSE *arena, SIZE_T size )
+{
+    SIZE_T old_size = arena->size - arena->unused_bytes;
+    void *ret;
+
+    /* resize in place as long as the block stays in the same size class */
+    if (size <= arena->size && max( ROUND_SIZE(size), HEAP_MIN_DATA_SIZE ) == arena->size)
+    {
+        notify_realloc( arena + 1, old_size, size );
+        arena->unused_bytes = arena->size - size;
+        if (size > old_size)
+            initialize_block( (char *)(arena + 1) + old_size, size - old_size, arena->unused_bytes, flags );
+        else
+            mark_block_tail( (char *)(arena + 1) + size, arena->unused_bytes, flags );
+        return arena + 1;
+    }
+
+    if (flags & HEAP_REALLOC_IN_PLACE_ONLY) return NULL;
+    if (!(ret = RtlAllocateHeap( heap, flags & ~HEAP_GENERATE_EXCEPTIONS, size ))) return NULL;
+    memcpy( ret, arena + 1, min( size, old_size ) );
+    notify_free( arena + 1 );
+    free_lfh_block( heap, arena );
+    return ret;
+}
+
+
+/***********************************************************************
+ *           free_lfh_regions
+ */
+static void free_lfh_regions( HEAP *heap )
+{
+    void *addr;
+    SIZE_T size;
+    int i;
+
+    for (i = 0; i < heap->lfh->nb_regions; i++)
+    {
+        size = 0;
+        addr = heap->lfh->regions[i].base;
+        NtFreeVirtualMemory( NtCurrentProcess(), &addr, &size, MEM_RELEASE );
+    }
+    size = 0;
+    addr = heap->lfh;
+    NtFreeVirtualMemory( NtCurrentProcess(), &addr, &size, MEM_RELEASE );
+}
+
+
+/***********************************************************************
+ *           heap_enable_lfh
+ *
+ * Enable the low fragmentation front-end for a heap.
+ */
+static NTSTATUS heap_enable_lfh( HEAP *heap )
+{
+    void *addr = NULL;
+    SIZE_T size = sizeof(LFH);
+    NTSTATUS status;
+
+    if (heap->lfh) return STATUS_SUCCESS;
+
+    /* like on Windows, the LFH can't be used with unserialized or debug heaps */
+    if (!(heap->flags & HEAP_GROWABLE) || RUNNING_ON_VALGRIND ||
+        (heap->flags & (HEAP_NO_SERIALIZE | HEAP_PAGE_ALLOCS | HEAP_VALIDATE |
+                        HEAP_TAIL_CHECKING_ENABLED | HEAP_FREE_CHECKING_ENABLED)))
+        return STATUS_UNSUCCESSFUL;
+
+    if ((status = NtAllocateVirtualMemory( NtCurrentProcess(), &addr, 0, &size,
+                                           MEM_COMMIT, PAGE_READWRITE )))
+        return status;
+
+    RtlEnterCriticalSection( &heap->critSection );
+    if (!heap->lfh)
+    {
+        heap->lfh = addr;
+        addr = NULL;
+    }
+    RtlLeaveCriticalSection( &heap->critSection );
+
+    if (addr)
+    {
+        size = 0;
+        NtFreeVirtualMemory( NtCurrentProcess(), &addr, &size, MEM_RELEASE );
+    }
+    TRACE( "enabled LFH for heap %p\n", heap );
+    return STATUS_SUCCESS;
+}
+
+
 /***********************************************************************
  *           HEAP_CreateSubHeap
  */
@@ -895,6 +1331,7 @@ static SUBHEAP *HEAP_CreateSubHeap( HEAP *heap, LPVOID address, DWORD flags,
             WARN("Could not allocate %08lx bytes\n", totalSize );
             return NULL;
         }
+        set_heap_huge_page_hint( address, totalSize );
         if (NtAllocateVirtualMemory( NtCurrentProcess(), &address, 0,
                                      &commitSize, MEM_COMMIT, get_protection_type( flags ) ))
         {
@@ -925,6 +1362,7 @@ static SUBHEAP *HEAP_CreateSubHeap( HEAP *heap, LPVOID address, DWORD flags,
         heap->flags         = flags;
         heap->magic         = HEAP_MAGIC;
         heap->grow_size     = max( HEAP_DEF_SIZE, totalSize );
+        heap->lfh           = NULL;
         list_init( &heap->subheap_list );
         list_init( &heap->large_list );
 
@@ -1345,7 +1783,9 @@ static BOOL HEAP_IsRealArena( HEAP *heapPtr,   /* [in] ptr to the heap */
     {
         const ARENA_INUSE *arena = (const ARENA_INUSE *)block - 1;
 
-        if (!(subheap = HEAP_FindSubHeap( heapPtr, arena )) ||
+        if (heapPtr->lfh && find_lfh_block( heapPtr, block ))
+            ret = validate_lfh_block( heapPtr, arena, quiet );
+        else if (!(subheap = HEAP_FindSubHeap( heapPtr, arena )) ||
             ((const char *)arena < (char *)subheap->base + subheap->headerSize))
         {
             if (!(large_arena = find_large_block( heapPtr, block )))
@@ -1394,6 +1834,8 @@ static BOOL HEAP_IsRealArena( HEAP *heapPtr,   /* [in] ptr to the heap */
     LIST_FOR_EACH_ENTRY( large_arena, &heapPtr->large_list, ARENA_LARGE, entry )
         if (!(ret = validate_large_arena( heapPtr, large_arena, quiet ))) break;
 
+    if (ret && heapPtr->lfh) ret = validate_lfh_regions( heapPtr );
+
     if (!(flags & HEAP_NO_SERIALIZE)) RtlLeaveCriticalSection( &heapPtr->critSection );
     return ret;
 }
@@ -1530,6 +1972,53 @@ void heap_set_debug_flags( HANDLE handle )
 }
 
 
+/***********************************************************************
+ *           heap_init_lfh
+ *
+ * Enable the low fragmentation heap by default if requested in the registry.
+ */
+void heap_init_lfh(void)
+{
+    static const WCHAR heapW[] = {'S','o','f','t','w','a','r','e','\\','W','i','n','e','\\','H','e','a','p',0};
+    static const WCHAR lfhW[] = {'L','o','w','F','r','a','g','m','e','n','t','a','t','i','o','n',0};
+    char tmp[80];
+    HANDLE root, hkey;
+    DWORD dummy;
+    OBJECT_ATTRIBUTES attr;
+    UNICODE_STRING nameW;
+    HEAP *heap;
+
+    if (RtlOpenCurrentUser( KEY_ALL_ACCESS, &root )) return;
+    attr.Length = sizeof(attr);
+    attr.RootDirectory = root;
+    attr.ObjectName = &nameW;
+    attr.Attributes = 0;
+    attr.SecurityDescriptor = NULL;
+    attr.SecurityQualityOfService = NULL;
+    RtlInitUnicodeString( &nameW, heapW );
+
+    /* @@ Wine registry key: HKCU\Software\Wine\Heap */
+    if (!NtOpenKey( &hkey, KEY_QUERY_VALUE, &attr ))
+    {
+        RtlInitUnicodeString( &nameW, lfhW );
+        if (!NtQueryValueKey( hkey, &nameW, KeyValuePartialInformation, tmp, sizeof(tmp), &dummy ))
+        {
+            WCHAR *str = (WCHAR *)((KEY_VALUE_PARTIAL_INFORMATION *)tmp)->Data;
+            lfh_by_default = IS_OPTION_TRUE( str[0] );
+        }
+        NtClose( hkey );
+    }
+    NtClose( root );
+
+    if (!lfh_by_default) return;
+
+    RtlEnterCriticalSection( &processHeap->critSection );
+    heap_enable_lfh( processHeap );
+    LIST_FOR_EACH_ENTRY( heap, &processHeap->entry, HEAP, entry ) heap_enable_lfh( heap );
+    RtlLeaveCriticalSection( &processHeap->critSection );
+}
+
+
 /***********************************************************************
  *           RtlCreateHeap   (NTDLL.@)
  *
@@ -1563,6 +2052,7 @@ HANDLE WINAPI RtlCreateHeap( ULONG flags, PVOID addr, SIZE_T totalSize, SIZE_T c
     if (!(subheap = HEAP_CreateSubHeap( NULL, addr, flags, commitSize, totalSize ))) return 0;
 
     heap_set_debug_flags( subheap->heap );
+    if (lfh_by_default) heap_enable_lfh( subheap->heap );
 
     /* link it into the per-process heap list */
     if (processHeap)
@@ -1615,6 +2105,8 @@ HANDLE WINAPI RtlDestroyHeap( HANDLE heap )
     heapPtr->critSection.DebugInfo->Spare[0] = 0;
     RtlDeleteCriticalSection( &heapPtr->critSection );
 
+    if (heapPtr->lfh) free_lfh_regions( heapPtr );
+
     LIST_FOR_EACH_ENTRY_SAFE( arena, arena_next, &heapPtr->large_list, ARENA_LARGE, entry )
     {
         list_remove( &arena->entry );
@@ -1683,6 +2175,16 @@ PVOID WINAPI RtlAllocateHeap( HANDLE heap, ULONG flags, SIZE_T size )
     }
     if (rounded_size < HEAP_MIN_DATA_SIZE) rounded_size = HEAP_MIN_DATA_SIZE;
 
+    if (heapPtr->lfh && rounded_size <= HEAP_LFH_MAX_DATA_SIZE)
+    {
+        void *ret = allocate_lfh_block( heapPtr, flags, rounded_size, size );
+        if (ret)
+        {
+            TRACE("(%p,%08x,%08lx): returning %p\n", heap, flags, size, ret );
+            return ret;
+        }
+    }
+
     if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
 
     if (rounded_size >= HEAP_MIN_LARGE_BLOCK_SIZE && (flags & HEAP_GROWABLE))
@@ -1766,6 +2268,21 @@ BOOLEAN WINAPI RtlFreeHeap( HANDLE heap, ULONG flags, PVOID ptr )
 
     flags &= HEAP_NO_SERIALIZE;
     flags |= heapPtr->flags;
+
+    if (heapPtr->lfh && (pInUse = find_lfh_block( heapPtr, ptr )))
+    {
+        if (!validate_lfh_block( heapPtr, pInUse, QUIET ))
+        {
+            RtlSetLastWin32ErrorAndNtStatusFromNtStatus( STATUS_INVALID_PARAMETER );
+            TRACE("(%p,%08x,%p): returning FALSE\n", heap, flags, ptr );
+            return FALSE;
+        }
+        notify_free( ptr );
+        free_lfh_block( heapPtr, pInUse );
+        TRACE("(%p,%08x,%p): returning TRUE\n", heap, flags, ptr );
+        return TRUE;
+    }
+
     if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
 
     /* Inform valgrind we are trying to free memory, so it can throw up an error message */
@@ -1827,6 +2344,24 @@ PVOID WINAPI RtlReAllocateHeap( HANDLE heap, ULONG flags, PVOID ptr, SIZE_T size
     flags &= HEAP_GENERATE_EXCEPTIONS | HEAP_NO_SERIALIZE | HEAP_ZERO_MEMORY |
              HEAP_REALLOC_IN_PLACE_ONLY;
     flags |= heapPtr->flags;
+
+    if (heapPtr->lfh && (pArena = find_lfh_block( heapPtr, ptr )))
+    {
+        if (!validate_lfh_block( heapPtr, pArena, QUIET ))
+        {
+            RtlSetLastWin32ErrorAndNtStatusFromNtStatus( STATUS_INVALID_PARAMETER );
+            TRACE("(%p,%08x,%p,%08lx): returning NULL\n", heap, flags, ptr, size );
+            return NULL;
+        }
+        if (!(ret = realloc_lfh_block( heapPtr, flags, pArena, size )))
+        {
+            if (flags & HEAP_GENERATE_EXCEPTIONS) RtlRaiseStatus( STATUS_NO_MEMORY );
+            RtlSetLastWin32ErrorAndNtStatusFromNtStatus( STATUS_NO_MEMORY );
+        }
+        TRACE("(%p,%08x,%p,%08lx): returning %p\n", heap, flags, ptr, size, ret );
+        return ret;
+    }
+
     if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
 
     rounded_size = ROUND_SIZE(size) + HEAP_TAIL_EXTRA_SIZE(flags);
@@ -2036,6 +2571,19 @@ SIZE_T WINAPI RtlSizeHeap( HANDLE heap, ULONG flags, const void *ptr )
     }
     flags &= HEAP_NO_SERIALIZE;
     flags |= heapPtr->flags;
+
+    if (heapPtr->lfh && (pArena = find_lfh_block( heapPtr, ptr )))
+    {
+        if (!validate_lfh_block( heapPtr, pArena, QUIET ))
+        {
+            RtlSetLastWin32ErrorAndNtStatusFromNtStatus( STATUS_INVALID_PARAMETER );
+            ret = ~0UL;
+        }
+        else ret = pArena->size - pArena->unused_bytes;
+        TRACE("(%p,%08x,%p): returning %08lx\n", heap, flags, ptr, ret );
+        return ret;
+    }
+
     if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
 
     pArena = (const ARENA_INUSE *)ptr - 1;
@@ -2127,6 +2675,11 @@ NTSTATUS WINAPI RtlWalkHeap( HANDLE heap, PVOID entry_ptr )
         }
         if (currentheap == NULL)
         {
+            if (heapPtr->lfh && find_lfh_block( heapPtr, ptr ))
+            {
+                ret = walk_lfh_regions( heapPtr, entry, region_index, ptr );
+                goto HW_end;
+            }
             ERR("no matching subheap found, shouldn't happen !\n");
             ret = STATUS_NO_MORE_ENTRIES;
             goto HW_end;
@@ -2150,9 +2703,12 @@ NTSTATUS WINAPI RtlWalkHeap( HANDLE heap, PVOID entry_ptr )
         {   /* proceed with next subheap */
             struct list *next = list_next( &heapPtr->subheap_list, &currentheap->entry );
             if (!next)
-            {  /* successfully finished */
-                TRACE("end reached.\n");
-                ret = STATUS_NO_MORE_ENTRIES;
+            {  /* successfully finished, unless there are LFH blocks left */
+                if (heapPtr->lfh)
+                    ret = walk_lfh_regions( heapPtr, entry, list_count( &heapPtr->subheap_list ), NULL );
+                else
+                    ret = STATUS_NO_MORE_ENTRIES;
+                if (ret == STATUS_NO_MORE_ENTRIES) TRACE("end reached.\n");
                 goto HW_end;
             }
             currentheap = LIST_ENTRY( next, SUBHEAP, entry );
@@ -2246,6 +2802,8 @@ ULONG WINAPI RtlGetProcessHeaps( ULONG count, HANDLE *heaps )
 NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS info_class,
                                          PVOID info, SIZE_T size_in, PSIZE_T size_out)
 {
+    HEAP *heapPtr;
+
     switch (info_class)
     {
     case HeapCompatibilityInformation:
@@ -2254,7 +2812,8 @@ NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS inf
         if (size_in < sizeof(ULONG))
             return STATUS_BUFFER_TOO_SMALL;
 
-        *(ULONG *)info = 0; /* standard heap */
+        heapPtr = HEAP_GetPtr( heap );
+        *(ULONG *)info = (heapPtr && heapPtr->lfh) ? 2 : 0; /* low fragmentation or standard heap */
         return STATUS_SUCCESS;
 
     default:
@@ -2268,6 +2827,29 @@ NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS inf
  */
 NTSTATUS WINAPI RtlSetHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS info_class, PVOID info, SIZE_T size)
 {
-    FIXME("%p %d %p %ld stub\n", heap, info_class, info, size);
-    return STATUS_SUCCESS;
+    HEAP *heapPtr;
+
+    TRACE("%p %d %p %ld\n", heap, info_class, info, size);
+
+    switch (info_class)
+    {
+    case HeapCompatibilityInformation:
+        if (size < sizeof(ULONG)) return STATUS_BUFFER_TOO_SMALL;
+        if (!(heapPtr = HEAP_GetPtr( heap ))) return STATUS_INVALID_HANDLE;
+
+        switch (*(ULONG *)info)
+        {
+        case 0:  /* standard heap, can't be restored once the LFH is enabled */
+        case 1:  /* look-aside lists, not supported anymore */
+            return heapPtr->lfh ? STATUS_UNSUCCESSFUL : STATUS_SUCCESS;
+        case 2:
+            return heap_enable_lfh( heapPtr );
+        default:
+            return STATUS_INVALID_PARAMETER;
+        }
+
+    default:
+        FIXME("%p %d %p %ld stub\n", heap, info_class, info, size);
+        return STATUS_SUCCESS;
+    }
 }
@@ -23,10 +23,18 @@
 #include "wine/port.h"
 
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
 #ifdef HAVE_SYS_MMAN_H
 # include <sys/mman.h>
 #endif
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -92,6 +100,9 @@ typedef struct _wine_modref
     int                   alloc_deps;
     int                   nDeps;
     struct _wine_modref **deps;
+    DWORD                *export_hash;      /* hash table of the exported names */
+    DWORD                 export_hash_mask; /* size of the hash table - 1 */
+    DWORD                 export_lookups;   /* names looked up before the table was built */
 } WINE_MODREF;
 
 /* info about the current builtin dll load */
@@ -572,6 +583,42 @@ static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY
 }
 
 
+#define EXPORT_HASH_MIN_NAMES   64  /* smaller export tables are always searched */
+#define EXPORT_HASH_MIN_LOOKUPS 16  /* lookups in a module before its hash table is built */
+
+static inline DWORD hash_export_name( const char *name )
+{
+    DWORD hash = 2166136261u;
+
+    while (*name) hash = (hash ^ (unsigned char)*name++) * 16777619;
+    return hash;
+}
+
+/*************************************************************************
+ *		build_export_hash
+ *
+ * Build the hash table of the exported names of a module.
+ * The loader_section must be locked while calling this function.
+ */
+static void build_export_hash( WINE_MODREF *wm, const IMAGE_EXPORT_DIRECTORY *exports )
+{
+    const DWORD *names = get_rva( wm->ldr.BaseAddress, exports->AddressOfNames );
+    DWORD i, pos, size = 2, *table;
+
+    while (size < exports->NumberOfNames * 2) size *= 2;
+    if (!(table = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, size * sizeof(*table) ))) return;
+
+    for (i = 0; i < exports->NumberOfNames; i++)
+    {
+        pos = hash_export_name( get_rva( wm->ldr.BaseAddress, names[i] )) & (size - 1);
+        while (table[pos]) pos = (pos + 1) & (size - 1);
+        table[pos] = i + 1;
+    }
+    wm->export_hash = table;
+    wm->export_hash_mask = size - 1;
+}
+
+
 /*************************************************************************
  *		find_named_export
  *
@@ -584,6 +631,7 @@ static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *
     const WORD *ordinals = get_rva( module, exports->AddressOfNameOrdinals );
     const DWORD *names = get_rva( module, exports->AddressOfNames );
     int min = 0, max = exports->NumberOfNames - 1;
+    WINE_MODREF *wm;
 
     /* first check the hint */
     if (hint >= 0 && hint <= max)
@@ -593,6 +641,26 @@ static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *
             return find_ordinal_export( module, exports, exp_size, ordinals[hint], load_path );
     }
 
+    /* modules that get many lookups use a hash table built on demand */
+    if (exports->NumberOfNames >= EXPORT_HASH_MIN_NAMES && (wm = get_modref( module )))
+    {
+        if (!wm->export_hash && ++wm->export_lookups >= EXPORT_HASH_MIN_LOOKUPS)
+            build_export_hash( wm, exports );
+        if (wm->export_hash)
+        {
+            DWORD index, pos = hash_export_name( name ) & wm->export_hash_mask;
+
+            while ((index = wm->export_hash[pos]))
+            {
+                char *ename = get_rva( module, names[index - 1] );
+                if (!strcmp( ename, name ))
+                    return find_ordinal_export( module, exports, exp_size, ordinals[index - 1], load_path );
+                pos = (pos + 1) & wm->export_hash_mask;
+            }
+            return NULL;
+        }
+    }
+
     /* then do a binary search */
     while (min <= max)
     {
@@ -1775,7 +1843,209 @@ static void set_security_cookie( void *module, SIZE_T len )
     }
 }
 
-static NTSTATUS perform_relocations( void *module, SIZE_T len )
+/* Relocation cache, enabled by setting WINERELOCCACHE=1.
+ * The pages modified by the relocations of a native image are saved to a file
+ * keyed by the identity of the image and the address it was loaded at, so that
+ * the next time the image is loaded at the same address they can simply be
+ * mapped copy-on-write from that file, and shared in the page cache. */
+
+#define RELOC_CACHE_MAGIC 0x636c6552  /* "Relc" */
+
+struct reloc_cache_header
+{
+    DWORD     magic;        /* RELOC_CACHE_MAGIC */
+    DWORD     page_size;    /* size of the cached pages */
+    ULONGLONG dev;          /* identity of the image file */
+    ULONGLONG ino;
+    ULONGLONG size;
+    ULONGLONG mtime;
+    ULONGLONG mtime_nsec;
+    DWORD     timestamp;    /* identity of the image itself */
+    DWORD     checksum;
+    DWORD     image_size;
+    DWORD     count;        /* number of cached pages */
+    ULONGLONG base;         /* address the pages have been relocated for */
+    DWORD     data_offset;  /* offset of the page contents in the file, after the page rvas */
+    DWORD     pad;
+};
+
+static int reloc_cache_enabled = -1;
+
+static char *get_reloc_cache_path( void *module, const struct stat *st )
+{
+    const char *config_dir;
+    char *path;
+
+    if (reloc_cache_enabled == -1)
+    {
+        const char *env = getenv( "WINERELOCCACHE" );
+        reloc_cache_enabled = env && atoi( env );
+    }
+    if (!reloc_cache_enabled || !st || !(config_dir = wine_get_config_dir())) return NULL;
+
+    if (!(path = RtlAllocateHeap( GetProcessHeap(), 0, strlen( config_dir ) + 64 ))) return NULL;
+    sprintf( path, "%s/reloc-cache/%x-%x%08x-%lx", config_dir, (unsigned int)st->st_dev,
+             (unsigned int)((ULONGLONG)st->st_ino >> 32), (unsigned int)st->st_ino, (ULONG_PTR)module );
+    return path;
+}
+
+static void init_reloc_cache_header( struct reloc_cache_header *header, void *module,
+                                     const struct stat *st, DWORD count )
+{
+    const IMAGE_NT_HEADERS *nt = RtlImageNtHeader( module );
+
+    memset( header, 0, sizeof(*header) );
+    header->magic       = RELOC_CACHE_MAGIC;
+    header->page_size   = page_size;
+    header->dev         = st->st_dev;
+    header->ino         = st->st_ino;
+    header->size        = st->st_size;
+    header->mtime       = st->st_mtime;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    header->mtime_nsec  = st->st_mtim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC)
+    header->mtime_nsec  = st->st_mtimespec.tv_nsec;
+#endif
+    header->timestamp   = nt->FileHeader.TimeDateStamp;
+    header->checksum    = nt->OptionalHeader.CheckSum;
+    header->image_size  = nt->OptionalHeader.SizeOfImage;
+    header->base        = (ULONG_PTR)module;
+    header->count       = count;
+    header->data_offset = (sizeof(*header) + count * sizeof(DWORD) + page_size - 1) & ~(page_size - 1);
+}
+
+/***********************************************************************
+ *           map_reloc_cache
+ *
+ * Map the relocated pages of a module from the relocation cache.
+ * Returns STATUS_NOT_FOUND if there is no valid cache, the module is left
+ * untouched in that case.
+ */
+static NTSTATUS map_reloc_cache( void *module, SIZE_T len, const struct stat *st )
+{
+    struct reloc_cache_header header, expect;
+    struct stat cache_st;
+    NTSTATUS status = STATUS_NOT_FOUND;
+    DWORD *rvas;
+    char *path;
+    int fd;
+
+    if (!(path = get_reloc_cache_path( module, st ))) return STATUS_NOT_FOUND;
+    fd = open( path, O_RDONLY );
+    RtlFreeHeap( GetProcessHeap(), 0, path );
+    if (fd == -1) return STATUS_NOT_FOUND;
+
+    if (pread( fd, &header, sizeof(header), 0 ) != sizeof(header)) goto done;
+    if (header.count > len / page_size) goto done;
+    init_reloc_cache_header( &expect, module, st, header.count );
+    if (memcmp( &header, &expect, sizeof(header) )) goto done;
+    if (fstat( fd, &cache_st ) == -1) goto done;
+    if (cache_st.st_size < header.data_offset + (off_t)header.count * page_size) goto done;
+
+    if (!(rvas = RtlAllocateHeap( GetProcessHeap(), 0, header.count * sizeof(*rvas) ))) goto done;
+    if (pread( fd, rvas, header.count * sizeof(*rvas), sizeof(header) ) == header.count * sizeof(*rvas))
+    {
+        TRACE( "mapping %u relocated pages for %p from the cache\n", header.count, module );
+        if (virtual_map_image_pages( module, fd, rvas, header.count, header.data_offset ))
+            WARN( "failed to map the relocation cache for %p, relocating\n", module );
+        else
+            status = STATUS_SUCCESS;
+    }
+    RtlFreeHeap( GetProcessHeap(), 0, rvas );
+
+done:
+    close( fd );
+    return status;
+}
+
+static int compare_rvas( const void *a, const void *b )
+{
+    DWORD rva1 = *(const DWORD *)a, rva2 = *(const DWORD *)b;
+    return rva1 < rva2 ? -1 : rva1 > rva2;
+}
+
+/***********************************************************************
+ *           save_reloc_cache
+ *
+ * Save the pages modified by the relocations of a module to the relocation cache.
+ * The pages must be readable.
+ */
+static void save_reloc_cache( void *module, SIZE_T len, const IMAGE_BASE_RELOCATION *rel,
+                              const IMAGE_BASE_RELOCATION *end, const struct stat *st )
+{
+    const IMAGE_BASE_RELOCATION *block;
+    struct reloc_cache_header header;
+    DWORD i, count = 0, max = 0, *rvas;
+    char *path, *tmp, *p;
+    BOOL ret = FALSE;
+    int fd;
+
+    if (!(path = get_reloc_cache_path( module, st ))) return;
+
+    for (block = rel; block < end - 1 && block->SizeOfBlock;
+         block = (const IMAGE_BASE_RELOCATION *)((const char *)block + block->SizeOfBlock))
+        max += 2;
+    if (!max || !(rvas = RtlAllocateHeap( GetProcessHeap(), 0, max * sizeof(*rvas) )))
+    {
+        RtlFreeHeap( GetProcessHeap(), 0, path );
+        return;
+    }
+
+    /* collect the modified pages, including the next one for fixups crossing a page boundary */
+    for (block = rel; block < end - 1 && block->SizeOfBlock;
+         block = (const IMAGE_BASE_RELOCATION *)((const char *)block + block->SizeOfBlock))
+    {
+        const USHORT *fixups = (const USHORT *)(block + 1);
+        UINT nb = (block->SizeOfBlock - sizeof(*block)) / sizeof(USHORT);
+        DWORD page = block->VirtualAddress & ~(page_size - 1);
+        BOOL crossing = FALSE;
+
+        for (i = 0; i < nb; i++)
+            if ((fixups[i] >> 12) != IMAGE_REL_BASED_ABSOLUTE &&
+                (block->VirtualAddress & (page_size - 1)) + (fixups[i] & 0xfff) + 8 > page_size)
+                crossing = TRUE;
+
+        rvas[count++] = page;
+        if (crossing && page + page_size < len) rvas[count++] = page + page_size;
+    }
+    qsort( rvas, count, sizeof(*rvas), compare_rvas );
+    for (i = max = 0; i < count; i++)
+        if (!max || rvas[i] != rvas[max - 1]) rvas[max++] = rvas[i];
+    count = max;
+
+    init_reloc_cache_header( &header, module, st, count );
+
+    if (!(tmp = RtlAllocateHeap( GetProcessHeap(), 0, strlen( path ) + 16 ))) goto done;
+    p = strrchr( path, '/' );
+    *p = 0;
+    mkdir( path, 0777 );
+    *p = '/';
+    sprintf( tmp, "%s.%u", path, (unsigned int)getpid() );
+
+    if ((fd = open( tmp, O_WRONLY | O_CREAT | O_EXCL, 0666 )) != -1)
+    {
+        ret = (pwrite( fd, &header, sizeof(header), 0 ) == sizeof(header) &&
+               pwrite( fd, rvas, count * sizeof(*rvas), sizeof(header) ) == count * sizeof(*rvas));
+        for (i = 0; ret && i < count; i++)
+            ret = (pwrite( fd, (char *)module + rvas[i], page_size,
+                           header.data_offset + (off_t)i * page_size ) == page_size);
+        close( fd );
+        if (ret && rename( tmp, path ) == -1) ret = FALSE;
+        if (!ret)
+        {
+            WARN( "failed to write relocation cache %s: %s\n", debugstr_a(path), strerror(errno) );
+            unlink( tmp );
+        }
+        else TRACE( "saved %u relocated pages for %p to %s\n", count, module, debugstr_a(path) );
+    }
+    RtlFreeHeap( GetProcessHeap(), 0, tmp );
+
+done:
+    RtlFreeHeap( GetProcessHeap(), 0, rvas );
+    RtlFreeHeap( GetProcessHeap(), 0, path );
+}
+
+static NTSTATUS perform_relocations( void *module, SIZE_T len, const struct stat *st )
 {
     IMAGE_NT_HEADERS *nt;
     char *base;
@@ -1784,6 +2054,7 @@ static NTSTATUS perform_relocations( void *module, SIZE_T len )
     const IMAGE_SECTION_HEADER *sec;
     INT_PTR delta;
     ULONG protect_old[96], i;
+    NTSTATUS status;
 
     nt = RtlImageNtHeader( module );
     base = (char *)nt->OptionalHeader.ImageBase;
@@ -1814,6 +2085,13 @@ static NTSTATUS perform_relocations( void *module, SIZE_T len )
 
     sec = (const IMAGE_SECTION_HEADER *)((const char *)&nt->OptionalHeader +
                                          nt->FileHeader.SizeOfOptionalHeader);
+
+    /* shared sections can't be replaced by private pages */
+    for (i = 0; i < nt->FileHeader.NumberOfSections; i++)
+        if (sec[i].Characteristics & IMAGE_SCN_MEM_SHARED) st = NULL;
+
+    if ((status = map_reloc_cache( module, len, st )) != STATUS_NOT_FOUND) return status;
+
     for (i = 0; i < nt->FileHeader.NumberOfSections; i++)
     {
         void *addr = get_rva( module, sec[i].VirtualAddress );
@@ -1842,6 +2120,8 @@ static NTSTATUS perform_relocations( void *module, SIZE_T len )
         if (!rel) return STATUS_INVALID_IMAGE_FORMAT;
     }
 
+    save_reloc_cache( module, len, get_rva( module, relocs->VirtualAddress ), end, st );
+
     for (i = 0; i < nt->FileHeader.NumberOfSections; i++)
     {
         void *addr = get_rva( module, sec[i].VirtualAddress );
@@ -1920,7 +2200,7 @@ static NTSTATUS load_native_dll( LPCWSTR load_path, LPCWSTR name, HANDLE file,
     /* perform base relocation, if necessary */
 
     if (status == STATUS_IMAGE_NOT_AT_BASE)
-        status = perform_relocations( module, len );
+        status = perform_relocations( module, len, st );
 
     if (status != STATUS_SUCCESS)
     {
@@ -2985,6 +3265,7 @@ static void free_modref( WINE_MODREF *wm )
     if (cached_modref == wm) cached_modref = NULL;
     RtlFreeUnicodeString( &wm->ldr.FullDllName );
     RtlFreeHeap( GetProcessHeap(), 0, wm->deps );
+    RtlFreeHeap( GetProcessHeap(), 0, wm->export_hash );
     RtlFreeHeap( GetProcessHeap(), 0, wm );
 }
 
@@ -3283,6 +3564,7 @@ void WINAPI LdrInitializeThunk( void *kernel_start, ULONG_PTR unknown2,
     LdrQueryImageFileExecutionOptions( &peb->ProcessParameters->ImagePathName, globalflagW,
                                        REG_DWORD, &peb->NtGlobalFlag, sizeof(peb->NtGlobalFlag), NULL );
     heap_set_debug_flags( GetProcessHeap() );
+    heap_init_lfh();
 
     /* the main exe needs to be the first in the load order list */
     RemoveEntryList( &wm->ldr.InLoadOrderModuleList );
@@ -355,6 +355,10 @@ NTSTATUS WINAPI NtDuplicateObject( HANDLE source_process, HANDLE source,
                                    ACCESS_MASK access, ULONG attributes, ULONG options )
 {
     NTSTATUS ret;
+
+    if ((options & DUPLICATE_CLOSE_SOURCE) && source_process == NtCurrentProcess())
+        uring_close_handle( source );
+
     SERVER_START_REQ( dup_handle )
     {
         req->src_process = wine_server_obj_handle( source_process );
@@ -371,6 +375,7 @@ NTSTATUS WINAPI NtDuplicateObject( HANDLE source_process, HANDLE source,
             {
                 int fd = server_remove_fd_from_cache( source );
                 if (fd != -1) close( fd );
+                if ((fd = server_remove_esync_fd_from_cache( source )) != -1) close( fd );
             }
         }
     }
@@ -389,6 +394,9 @@ NTSTATUS close_handle( HANDLE handle )
 {
     NTSTATUS ret;
     int fd = server_remove_fd_from_cache( handle );
+    int esync_fd = server_remove_esync_fd_from_cache( handle );
+
+    uring_close_handle( handle );
 
     SERVER_START_REQ( close_handle )
     {
@@ -397,6 +405,7 @@ NTSTATUS close_handle( HANDLE handle )
     }
     SERVER_END_REQ;
     if (fd != -1) close( fd );
+    if (esync_fd != -1) close( esync_fd );
 
     if (ret == STATUS_INVALID_HANDLE && handle && NtCurrentTeb()->Peb->BeingDebugged)
     {
@@ -128,6 +128,15 @@ static RTL_CRITICAL_SECTION_DEBUG critsect_debug =
 };
 static RTL_CRITICAL_SECTION fd_cache_section = { &critsect_debug, -1, 0, 0, 0, 0 };
 
+static RTL_CRITICAL_SECTION closed_handles_section;
+static RTL_CRITICAL_SECTION_DEBUG closed_handles_critsect_debug =
+{
+    0, 0, &closed_handles_section,
+    { &closed_handles_critsect_debug.ProcessLocksList, &closed_handles_critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": closed_handles_section") }
+};
+static RTL_CRITICAL_SECTION closed_handles_section = { &closed_handles_critsect_debug, -1, 0, 0, 0, 0 };
+
 /* atomically exchange a 64-bit value */
 static inline LONG64 interlocked_xchg64( LONG64 *dest, LONG64 val )
 {
@@ -828,6 +837,23 @@ C_ASSERT( sizeof(union fd_cache_entry) == sizeof(LONG64) );
 static union fd_cache_entry *fd_cache[FD_CACHE_ENTRIES];
 static union fd_cache_entry fd_cache_initial_block[FD_CACHE_BLOCK_SIZE];
 
+/* handles closed by the server behind our back, see close_handle in server/handle.c */
+static const handle_cache_shm_t *handle_cache;
+static unsigned int handle_cache_seen;
+static BOOL handle_cache_mapped;
+
+static void update_handle_cache(void);
+
+/* handles recently closed in this process, see wine_server_get_closed_handles */
+#define CLOSED_HANDLES_RING_SIZE 64
+static obj_handle_t closed_handles[CLOSED_HANDLES_RING_SIZE];
+static unsigned int closed_handles_count;
+
+static inline BOOL handle_cache_is_stale(void)
+{
+    return handle_cache && handle_cache->closed_count != handle_cache_seen;
+}
+
 static inline unsigned int handle_to_index( HANDLE handle, unsigned int *entry )
 {
     unsigned int idx = (wine_server_obj_handle(handle) >> 2) - 1;
@@ -909,6 +935,11 @@ int server_remove_fd_from_cache( HANDLE handle )
     unsigned int entry, idx = handle_to_index( handle, &entry );
     int fd = -1;
 
+    RtlEnterCriticalSection( &closed_handles_section );
+    closed_handles[closed_handles_count % CLOSED_HANDLES_RING_SIZE] = wine_server_obj_handle( handle );
+    closed_handles_count++;
+    RtlLeaveCriticalSection( &closed_handles_section );
+
     if (entry < FD_CACHE_ENTRIES && fd_cache[entry])
     {
         union fd_cache_entry cache;
@@ -937,10 +968,14 @@ int server_get_unix_fd( HANDLE handle, unsigned int wanted_access, int *unix_fd,
     *needs_close = 0;
     wanted_access &= FILE_READ_DATA | FILE_WRITE_DATA | FILE_APPEND_DATA;
 
-    ret = get_cached_fd( handle, &fd, type, &access, options );
-    if (ret != STATUS_INVALID_HANDLE) goto done;
+    if (!handle_cache_is_stale())
+    {
+        ret = get_cached_fd( handle, &fd, type, &access, options );
+        if (ret != STATUS_INVALID_HANDLE) goto done;
+    }
 
     server_enter_uninterrupted_section( &fd_cache_section, &sigset );
+    update_handle_cache();
     ret = get_cached_fd( handle, &fd, type, &access, options );
     if (ret == STATUS_INVALID_HANDLE)
     {
@@ -981,6 +1016,324 @@ done:
 }
 
 
+/***********************************************************************/
+/* esync fd cache support */
+
+union esync_cache_entry
+{
+    LONG64 data;
+    struct
+    {
+        int             fd;
+        enum esync_type type : 7;
+        unsigned int    cached : 1;
+        unsigned int    access : 24;
+    } s;
+};
+
+C_ASSERT( sizeof(union esync_cache_entry) == sizeof(LONG64) );
+
+static union esync_cache_entry *esync_cache[FD_CACHE_ENTRIES];
+static unsigned short *esync_slots[FD_CACHE_ENTRIES];  /* esync_shm_t slots of the cached entries */
+static esync_shm_t *esync_shm;
+static BOOL esync_disabled;
+
+
+/***********************************************************************
+ *           get_cached_esync_fd
+ */
+static inline BOOL get_cached_esync_fd( HANDLE handle, int *fd, enum esync_type *type,
+                                        unsigned int *access, esync_shm_t **shm )
+{
+    unsigned int entry, idx = handle_to_index( handle, &entry );
+    union esync_cache_entry cache;
+
+    if (entry >= FD_CACHE_ENTRIES || !esync_cache[entry]) return FALSE;
+
+    cache.data = interlocked_cmpxchg64( &esync_cache[entry][idx].data, 0, 0 );
+    if (!cache.s.cached) return FALSE;
+
+    *fd = cache.s.fd - 1;
+    *type = cache.s.type;
+    *access = cache.s.access;
+    if (shm) *shm = esync_shm + esync_slots[entry][idx];
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           add_esync_fd_to_cache
+ *
+ * Caller must hold fd_cache_section.
+ */
+static BOOL add_esync_fd_to_cache( HANDLE handle, int fd, enum esync_type type, unsigned int access,
+                                   unsigned int slot )
+{
+    unsigned int entry, idx = handle_to_index( handle, &entry );
+    union esync_cache_entry cache;
+
+    if (entry >= FD_CACHE_ENTRIES) return FALSE;
+
+    if (!esync_cache[entry])  /* do we need to allocate a new block of entries? */
+    {
+        void *ptr = wine_anon_mmap( NULL, FD_CACHE_BLOCK_SIZE * sizeof(union esync_cache_entry),
+                                    PROT_READ | PROT_WRITE, 0 );
+        if (ptr == MAP_FAILED) return FALSE;
+        esync_cache[entry] = ptr;
+    }
+    if (!esync_slots[entry])
+    {
+        void *ptr = wine_anon_mmap( NULL, FD_CACHE_BLOCK_SIZE * sizeof(unsigned short),
+                                    PROT_READ | PROT_WRITE, 0 );
+        if (ptr == MAP_FAILED) return FALSE;
+        esync_slots[entry] = ptr;
+    }
+
+    esync_slots[entry][idx] = slot;
+    /* store fd+1 so that objects without eventfd can be cached too */
+    cache.s.fd = fd + 1;
+    cache.s.type = type;
+    cache.s.cached = 1;
+    cache.s.access = access;
+    cache.data = interlocked_xchg64( &esync_cache[entry][idx].data, cache.data );
+    assert( !cache.s.cached );
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           server_remove_esync_fd_from_cache
+ */
+int server_remove_esync_fd_from_cache( HANDLE handle )
+{
+    unsigned int entry, idx = handle_to_index( handle, &entry );
+    int fd = -1;
+
+    if (entry < FD_CACHE_ENTRIES && esync_cache[entry])
+    {
+        union esync_cache_entry cache;
+        cache.data = interlocked_xchg64( &esync_cache[entry][idx].data, 0 );
+        if (cache.s.cached) fd = cache.s.fd - 1;
+    }
+
+    return fd;
+}
+
+
+/***********************************************************************
+ *           flush_handle_caches
+ *
+ * Caller must hold fd_cache_section.
+ */
+static void flush_handle_caches(void)
+{
+    unsigned int entry, idx;
+
+    for (entry = 0; entry < FD_CACHE_ENTRIES; entry++)
+    {
+        for (idx = 0; fd_cache[entry] && idx < FD_CACHE_BLOCK_SIZE; idx++)
+        {
+            union fd_cache_entry cache;
+            cache.data = interlocked_xchg64( &fd_cache[entry][idx].data, 0 );
+            if (cache.data && cache.s.type != FD_TYPE_INVALID) close( cache.s.fd - 1 );
+        }
+        for (idx = 0; esync_cache[entry] && idx < FD_CACHE_BLOCK_SIZE; idx++)
+        {
+            union esync_cache_entry cache;
+            cache.data = interlocked_xchg64( &esync_cache[entry][idx].data, 0 );
+            if (cache.s.cached && cache.s.fd) close( cache.s.fd - 1 );
+        }
+    }
+}
+
+
+/***********************************************************************
+ *           update_handle_cache
+ *
+ * Drop the cached fds of the handles that the server closed behind our back.
+ * Caller must hold fd_cache_section.
+ */
+static void update_handle_cache(void)
+{
+    unsigned int i, count;
+    int fd;
+
+    if (!handle_cache_mapped)
+    {
+        HANDLE mapping = 0;
+        SIZE_T size = 0;
+        void *ptr = NULL;
+
+        handle_cache_mapped = TRUE;
+        SERVER_START_REQ( get_handle_cache_mapping )
+        {
+            if (!wine_server_call( req )) mapping = wine_server_ptr_handle( reply->handle );
+        }
+        SERVER_END_REQ;
+        if (!mapping) return;
+        if (!NtMapViewOfSection( mapping, NtCurrentProcess(), &ptr, 0, 0, NULL, &size,
+                                 ViewShare, 0, PAGE_READONLY ))
+        {
+            handle_cache_seen = ((const handle_cache_shm_t *)ptr)->closed_count;
+            handle_cache = ptr;
+        }
+        NtClose( mapping );
+        return;
+    }
+
+    if (!handle_cache_is_stale()) return;
+
+    count = handle_cache->closed_count;
+    __sync_synchronize();
+    if (count - handle_cache_seen <= HANDLE_CACHE_RING_SIZE)
+    {
+        for (i = handle_cache_seen; i != count; i++)
+        {
+            HANDLE handle = wine_server_ptr_handle( handle_cache->closed[i % HANDLE_CACHE_RING_SIZE] );
+            if ((fd = server_remove_fd_from_cache( handle )) != -1) close( fd );
+            if ((fd = server_remove_esync_fd_from_cache( handle )) != -1) close( fd );
+        }
+        __sync_synchronize();
+        /* make sure the server didn't overwrite the entries while we were reading them */
+        if (handle_cache->closed_count - handle_cache_seen <= HANDLE_CACHE_RING_SIZE)
+        {
+            handle_cache_seen = count;
+            return;
+        }
+    }
+    /* we lost track of the closed handles, start over */
+    flush_handle_caches();
+    handle_cache_seen = count;
+    RtlEnterCriticalSection( &closed_handles_section );
+    closed_handles_count += CLOSED_HANDLES_RING_SIZE + 1;
+    RtlLeaveCriticalSection( &closed_handles_section );
+}
+
+
+/***********************************************************************
+ *           wine_server_get_closed_handles   (NTDLL.@)
+ *
+ * Retrieve the handles closed in the current process since a previous call,
+ * so that callers can drop the state they keep for them.
+ *
+ * PARAMS
+ *     seq     [I/O] Sequence number returned by the previous call.
+ *     handles [O]   Buffer for the closed handles.
+ *     count   [I]   Size of the buffer.
+ *
+ * RETURNS
+ *     The number of closed handles, or ~0u if more were closed than can be
+ *     returned and all the caller state has to be dropped.
+ */
+unsigned int CDECL wine_server_get_closed_handles( unsigned int *seq, HANDLE *handles, unsigned int count )
+{
+    unsigned int i, ret;
+    sigset_t sigset;
+
+    if (handle_cache_is_stale())
+    {
+        server_enter_uninterrupted_section( &fd_cache_section, &sigset );
+        update_handle_cache();
+        server_leave_uninterrupted_section( &fd_cache_section, &sigset );
+    }
+    if (*(volatile unsigned int *)&closed_handles_count == *seq) return 0;
+
+    RtlEnterCriticalSection( &closed_handles_section );
+    ret = closed_handles_count - *seq;
+    if (ret > min( count, CLOSED_HANDLES_RING_SIZE )) ret = ~0u;
+    else for (i = 0; i < ret; i++)
+        handles[i] = wine_server_ptr_handle( closed_handles[(*seq + i) % CLOSED_HANDLES_RING_SIZE] );
+    *seq = closed_handles_count;
+    RtlLeaveCriticalSection( &closed_handles_section );
+    return ret;
+}
+
+
+/***********************************************************************
+ *           map_esync_shm
+ *
+ * Caller must hold fd_cache_section.
+ */
+static BOOL map_esync_shm(void)
+{
+    HANDLE mapping = 0;
+    SIZE_T size = 0;
+    void *ptr = NULL;
+
+    if (esync_shm) return TRUE;
+
+    SERVER_START_REQ( get_esync_mapping )
+    {
+        if (!wine_server_call( req )) mapping = wine_server_ptr_handle( reply->handle );
+    }
+    SERVER_END_REQ;
+    if (!mapping) return FALSE;
+    if (!NtMapViewOfSection( mapping, NtCurrentProcess(), &ptr, 0, 0, NULL, &size,
+                             ViewShare, 0, PAGE_READWRITE ))
+        esync_shm = ptr;
+    NtClose( mapping );
+    return esync_shm != NULL;
+}
+
+
+/***********************************************************************
+ *           server_get_esync_fd
+ *
+ * Retrieve the eventfd that backs an object for client-side synchronization.
+ * Returns -1 if the object has to be handled by the server. The fd is owned
+ * by the cache and must not be closed by the caller. The client-side waiters
+ * of the object have to be counted in the returned esync_shm_t.
+ */
+int server_get_esync_fd( HANDLE handle, enum esync_type *type, unsigned int *access, esync_shm_t **shm )
+{
+    sigset_t sigset;
+    obj_handle_t fd_handle;
+    unsigned int slot = 0;
+    NTSTATUS ret;
+    int fd = -1;
+
+    if (esync_disabled) return -1;
+    if (!handle_cache_is_stale() && get_cached_esync_fd( handle, &fd, type, access, shm )) return fd;
+
+    server_enter_uninterrupted_section( &fd_cache_section, &sigset );
+    update_handle_cache();
+    if (!get_cached_esync_fd( handle, &fd, type, access, shm ))
+    {
+        SERVER_START_REQ( get_esync_fd )
+        {
+            req->handle = wine_server_obj_handle( handle );
+            if (!(ret = wine_server_call( req )))
+            {
+                *type = reply->type;
+                *access = reply->access & 0xffffff;
+                if (*type != ESYNC_NONE && (fd = receive_fd( &fd_handle )) != -1)
+                {
+                    assert( wine_server_ptr_handle(fd_handle) == handle );
+                    slot = reply->slot;
+                    if (!add_esync_fd_to_cache( handle, fd, *type, *access, slot ))
+                    {
+                        close( fd );
+                        fd = -1;
+                    }
+                }
+                else add_esync_fd_to_cache( handle, -1, ESYNC_NONE, 0, 0 );
+            }
+            else if (ret == STATUS_NOT_IMPLEMENTED) esync_disabled = TRUE;
+        }
+        SERVER_END_REQ;
+        /* without the waiter counts pulses would be lost */
+        if (fd != -1 && !map_esync_shm())
+        {
+            esync_disabled = TRUE;
+            fd = -1;
+        }
+        else if (fd != -1 && shm) *shm = esync_shm + slot;
+    }
+    server_leave_uninterrupted_section( &fd_cache_section, &sigset );
+    return fd;
+}
+
+
 /***********************************************************************
  *           wine_server_fd_to_handle   (NTDLL.@)
  *
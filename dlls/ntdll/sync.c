@@ -26,6 +26,7 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <limits.h>
 #include <signal.h>
 #ifdef HAVE_SYS_TIME_H
 # include <sys/time.h>
@@ -336,6 +337,34 @@ NTSTATUS WINAPI NtOpenEvent( HANDLE *handle, ACCESS_MASK access, const OBJECT_AT
 }
 
 
+/* events backed by an eventfd (WINEESYNC mode) are signaled without going through the server,
+ * STATUS_NOT_IMPLEMENTED means the server has to handle the object */
+static NTSTATUS esync_set_event( HANDLE handle )
+{
+    static const ULONGLONG value = 1;
+    enum esync_type type;
+    unsigned int access;
+    int fd;
+
+    if ((fd = server_get_esync_fd( handle, &type, &access, NULL )) == -1) return STATUS_NOT_IMPLEMENTED;
+    if (!(access & EVENT_MODIFY_STATE)) return STATUS_ACCESS_DENIED;
+    if (write( fd, &value, sizeof(value) ) == -1 && errno != EAGAIN) return FILE_GetNtStatus();
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS esync_reset_event( HANDLE handle )
+{
+    enum esync_type type;
+    unsigned int access;
+    ULONGLONG value;
+    int fd;
+
+    if ((fd = server_get_esync_fd( handle, &type, &access, NULL )) == -1) return STATUS_NOT_IMPLEMENTED;
+    if (!(access & EVENT_MODIFY_STATE)) return STATUS_ACCESS_DENIED;
+    if (read( fd, &value, sizeof(value) ) == -1 && errno != EAGAIN) return FILE_GetNtStatus();
+    return STATUS_SUCCESS;
+}
+
 /******************************************************************************
  *  NtSetEvent (NTDLL.@)
  *  ZwSetEvent (NTDLL.@)
@@ -346,6 +375,8 @@ NTSTATUS WINAPI NtSetEvent( HANDLE handle, PULONG NumberOfThreadsReleased )
 
     /* FIXME: set NumberOfThreadsReleased */
 
+    if ((ret = esync_set_event( handle )) != STATUS_NOT_IMPLEMENTED) return ret;
+
     SERVER_START_REQ( event_op )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -366,6 +397,8 @@ NTSTATUS WINAPI NtResetEvent( HANDLE handle, PULONG NumberOfThreadsReleased )
     /* resetting an event can't release any thread... */
     if (NumberOfThreadsReleased) *NumberOfThreadsReleased = 0;
 
+    if ((ret = esync_reset_event( handle )) != STATUS_NOT_IMPLEMENTED) return ret;
+
     SERVER_START_REQ( event_op )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -1016,15 +1049,108 @@ NTSTATUS WINAPI NtSetTimerResolution(IN ULONG resolution,
 
 /* wait operations */
 
+/* count a client-side waiter, so that the server keeps a pulsed event signaled
+ * until the waiter has seen it; returns the epoch parity the waiter is counted in */
+static unsigned int esync_add_waiter( esync_shm_t *shm )
+{
+    unsigned int epoch;
+
+    for (;;)
+    {
+        epoch = shm->epoch;
+        interlocked_xchg_add( (int *)&shm->waiters[epoch & 1], 1 );
+        /* a pulse that started in between may have missed us */
+        if (shm->epoch == epoch) return epoch & 1;
+        interlocked_xchg_add( (int *)&shm->waiters[epoch & 1], -1 );
+    }
+}
+
+static void esync_remove_waiter( esync_shm_t *shm, unsigned int parity )
+{
+    interlocked_xchg_add( (int *)&shm->waiters[parity], -1 );
+}
+
+/* wait directly on the eventfds when all the objects support it;
+ * alertable and wait-all waits are left to the server */
+static NTSTATUS esync_wait_objects( DWORD count, const HANDLE *handles,
+                                    BOOLEAN wait_any, BOOLEAN alertable,
+                                    const LARGE_INTEGER *timeout )
+{
+    struct pollfd fds[MAXIMUM_WAIT_OBJECTS];
+    enum esync_type types[MAXIMUM_WAIT_OBJECTS];
+    esync_shm_t *shms[MAXIMUM_WAIT_OBJECTS];
+    unsigned int parities[MAXIMUM_WAIT_OBJECTS];
+    LARGE_INTEGER now, end;
+    unsigned int access;
+    ULONGLONG value;
+    NTSTATUS status = STATUS_PENDING;
+    DWORD i;
+    int ret, ms = -1;
+
+    if (!wait_any || alertable) return STATUS_NOT_IMPLEMENTED;
+
+    for (i = 0; i < count; i++)
+    {
+        if ((fds[i].fd = server_get_esync_fd( handles[i], &types[i], &access, &shms[i] )) == -1)
+            return STATUS_NOT_IMPLEMENTED;
+        if (!(access & SYNCHRONIZE)) return STATUS_ACCESS_DENIED;
+        fds[i].events = POLLIN;
+    }
+
+    if (timeout)
+    {
+        end = *timeout;
+        if (end.QuadPart < 0)
+        {
+            NtQuerySystemTime( &now );
+            end.QuadPart = now.QuadPart - end.QuadPart;
+        }
+    }
+
+    for (i = 0; i < count; i++) parities[i] = esync_add_waiter( shms[i] );
+
+    while (status == STATUS_PENDING)
+    {
+        if (timeout)
+        {
+            NtQuerySystemTime( &now );
+            if (now.QuadPart >= end.QuadPart) ms = 0;
+            else ms = min( (end.QuadPart - now.QuadPart + 9999) / 10000, INT_MAX );
+        }
+
+        if ((ret = poll( fds, count, ms )) == -1)
+        {
+            if (errno != EINTR) status = FILE_GetNtStatus();
+            continue;
+        }
+        if (!ret) status = STATUS_TIMEOUT;
+
+        for (i = 0; i < count && status == STATUS_PENDING; i++)
+        {
+            if (!(fds[i].revents & POLLIN)) continue;
+            if (types[i] == ESYNC_MANUAL_EVENT) status = STATUS_WAIT_0 + i;
+            /* only one waiter gets to consume an auto-reset event */
+            else if (read( fds[i].fd, &value, sizeof(value) ) == sizeof(value)) status = STATUS_WAIT_0 + i;
+        }
+    }
+
+    for (i = 0; i < count; i++) esync_remove_waiter( shms[i], parities[i] );
+    return status;
+}
+
 static NTSTATUS wait_objects( DWORD count, const HANDLE *handles,
                               BOOLEAN wait_any, BOOLEAN alertable,
                               const LARGE_INTEGER *timeout )
 {
     select_op_t select_op;
     UINT i, flags = SELECT_INTERRUPTIBLE;
+    NTSTATUS ret;
 
     if (!count || count > MAXIMUM_WAIT_OBJECTS) return STATUS_INVALID_PARAMETER_1;
 
+    if ((ret = esync_wait_objects( count, handles, wait_any, alertable, timeout )) != STATUS_NOT_IMPLEMENTED)
+        return ret;
+
     if (alertable) flags |= SELECT_ALERTABLE;
     select_op.wait.op = wait_any ? SELECT_WAIT : SELECT_WAIT_ALL;
     for (i = 0; i < count; i++) select_op.wait.handles[i] = wine_server_obj_handle( handles[i] );
@@ -1331,6 +1457,59 @@ NTSTATUS WINAPI NtRemoveIoCompletion( HANDLE CompletionPort, PULONG_PTR Completi
     return status;
 }
 
+/******************************************************************
+ *              NtRemoveIoCompletionEx (NTDLL.@)
+ *              ZwRemoveIoCompletionEx (NTDLL.@)
+ *
+ * (Wait for and) retrieve up to count completion messages from completion object's queue
+ *
+ * PARAMS
+ *      port      [I] HANDLE to I/O completion object
+ *      info      [O] array of completion messages
+ *      count     [I] size of the info array
+ *      written   [O] number of messages retrieved
+ *      timeout   [I] optional wait time in NTDLL format
+ *      alertable [I] whether the wait is alertable
+ *
+ */
+NTSTATUS WINAPI NtRemoveIoCompletionEx( HANDLE port, FILE_IO_COMPLETION_INFORMATION *info, ULONG count,
+                                        ULONG *written, LARGE_INTEGER *timeout, BOOLEAN alertable )
+{
+    struct completion_packet packets[64];
+    NTSTATUS status;
+    ULONG i, n = 0;
+
+    TRACE("(%p, %p, %u, %p, %p, %u)\n", port, info, count, written, timeout, alertable);
+
+    if (!count) return STATUS_INVALID_PARAMETER;
+
+    for (;;)
+    {
+        SERVER_START_REQ( remove_completions )
+        {
+            req->handle = wine_server_obj_handle( port );
+            wine_server_set_reply( req, packets, min( count, sizeof(packets) / sizeof(packets[0]) ) * sizeof(packets[0]) );
+            if (!(status = wine_server_call( req )))
+                n = wine_server_reply_size( reply ) / sizeof(packets[0]);
+        }
+        SERVER_END_REQ;
+        if (status != STATUS_PENDING) break;
+
+        status = NtWaitForSingleObject( port, alertable, timeout );
+        if (status != WAIT_OBJECT_0) break;
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        info[i].CompletionKey             = packets[i].ckey;
+        info[i].CompletionValue           = packets[i].cvalue;
+        info[i].IoStatusBlock.Information = packets[i].information;
+        info[i].IoStatusBlock.u.Status    = packets[i].status;
+    }
+    *written = n;
+    return status;
+}
+
 /******************************************************************
  *              NtOpenIoCompletion (NTDLL.@)
  *              ZwOpenIoCompletion (NTDLL.@)
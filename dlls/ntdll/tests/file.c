@@ -73,6 +73,7 @@ static NTSTATUS (WINAPI *pNtCreateIoCompletion)(PHANDLE, ACCESS_MASK, POBJECT_AT
 static NTSTATUS (WINAPI *pNtOpenIoCompletion)(PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES);
 static NTSTATUS (WINAPI *pNtQueryIoCompletion)(HANDLE, IO_COMPLETION_INFORMATION_CLASS, PVOID, ULONG, PULONG);
 static NTSTATUS (WINAPI *pNtRemoveIoCompletion)(HANDLE, PULONG_PTR, PULONG_PTR, PIO_STATUS_BLOCK, PLARGE_INTEGER);
+static NTSTATUS (WINAPI *pNtRemoveIoCompletionEx)(HANDLE,FILE_IO_COMPLETION_INFORMATION*,ULONG,ULONG*,LARGE_INTEGER*,BOOLEAN);
 static NTSTATUS (WINAPI *pNtSetIoCompletion)(HANDLE, ULONG_PTR, ULONG_PTR, NTSTATUS, SIZE_T);
 static NTSTATUS (WINAPI *pNtSetInformationFile)(HANDLE, PIO_STATUS_BLOCK, PVOID, ULONG, FILE_INFORMATION_CLASS);
 static NTSTATUS (WINAPI *pNtQueryInformationFile)(HANDLE, PIO_STATUS_BLOCK, PVOID, ULONG, FILE_INFORMATION_CLASS);
@@ -903,6 +904,53 @@ static void test_iocp_setcompletion(HANDLE h)
     ok( !count, "Unexpected msg count: %d\n", count );
 }
 
+static void test_iocp_remove_ex(HANDLE h)
+{
+    FILE_IO_COMPLETION_INFORMATION info[4];
+    LARGE_INTEGER timeout;
+    NTSTATUS res;
+    ULONG count, i;
+
+    if (!pNtRemoveIoCompletionEx)
+    {
+        win_skip( "NtRemoveIoCompletionEx not available\n" );
+        return;
+    }
+
+    for (i = 0; i < 3; i++)
+    {
+        res = pNtSetIoCompletion( h, CKEY_FIRST + i, CVALUE_FIRST, STATUS_SUCCESS, i );
+        ok( res == STATUS_SUCCESS, "NtSetIoCompletion failed: %x\n", res );
+    }
+
+    timeout.QuadPart = 0;
+    count = 0xdeadbeef;
+    memset( info, 0xcc, sizeof(info) );
+    res = pNtRemoveIoCompletionEx( h, info, 2, &count, &timeout, FALSE );
+    ok( res == STATUS_SUCCESS, "NtRemoveIoCompletionEx failed: %x\n", res );
+    ok( count == 2, "got %u entries\n", count );
+    for (i = 0; i < 2; i++)
+    {
+        ok( info[i].CompletionKey == CKEY_FIRST + i, "%u: wrong key %lx\n", i, info[i].CompletionKey );
+        ok( info[i].CompletionValue == CVALUE_FIRST, "%u: wrong value %lx\n", i, info[i].CompletionValue );
+        ok( info[i].IoStatusBlock.Information == i, "%u: wrong information %lu\n", i, info[i].IoStatusBlock.Information );
+        ok( U(info[i].IoStatusBlock).Status == STATUS_SUCCESS, "%u: wrong status %x\n", i, U(info[i].IoStatusBlock).Status );
+    }
+
+    count = 0xdeadbeef;
+    res = pNtRemoveIoCompletionEx( h, info, 4, &count, &timeout, FALSE );
+    ok( res == STATUS_SUCCESS, "NtRemoveIoCompletionEx failed: %x\n", res );
+    ok( count == 1, "got %u entries\n", count );
+    ok( info[0].CompletionKey == CKEY_FIRST + 2, "wrong key %lx\n", info[0].CompletionKey );
+    ok( info[0].IoStatusBlock.Information == 2, "wrong information %lu\n", info[0].IoStatusBlock.Information );
+
+    res = pNtRemoveIoCompletionEx( h, info, 4, &count, &timeout, FALSE );
+    ok( res == STATUS_TIMEOUT, "NtRemoveIoCompletionEx returned %x\n", res );
+
+    count = get_pending_msgs(h);
+    ok( !count, "Unexpected msg count: %d\n", count );
+}
+
 static void test_iocp_fileio(HANDLE h)
 {
     static const char pipe_name[] = "\\\\.\\pipe\\iocompletiontestnamedpipe";
@@ -2770,6 +2818,7 @@ static void test_iocompletion(void)
     if ( h && h != INVALID_HANDLE_VALUE)
     {
         test_iocp_setcompletion(h);
+        test_iocp_remove_ex(h);
         test_iocp_fileio(h);
         pNtClose(h);
     }
@@ -4225,11 +4274,9 @@ static void test_flush_buffers_file(void)
     ok(hfileread != INVALID_HANDLE_VALUE, "could not open temp file, error %d.\n", GetLastError());
 
     status = pNtFlushBuffersFile(hfile, NULL);
-    todo_wine
     ok(status == STATUS_ACCESS_VIOLATION, "expected STATUS_ACCESS_VIOLATION, got %#x.\n", status);
 
     status = pNtFlushBuffersFile(hfile, (IO_STATUS_BLOCK *)0xdeadbeaf);
-    todo_wine
     ok(status == STATUS_ACCESS_VIOLATION, "expected STATUS_ACCESS_VIOLATION, got %#x.\n", status);
 
     status = pNtFlushBuffersFile(hfile, &io_status_block);
@@ -4285,6 +4332,7 @@ START_TEST(file)
     pNtOpenIoCompletion     = (void *)GetProcAddress(hntdll, "NtOpenIoCompletion");
     pNtQueryIoCompletion    = (void *)GetProcAddress(hntdll, "NtQueryIoCompletion");
     pNtRemoveIoCompletion   = (void *)GetProcAddress(hntdll, "NtRemoveIoCompletion");
+    pNtRemoveIoCompletionEx = (void *)GetProcAddress(hntdll, "NtRemoveIoCompletionEx");
     pNtSetIoCompletion      = (void *)GetProcAddress(hntdll, "NtSetIoCompletion");
     pNtSetInformationFile   = (void *)GetProcAddress(hntdll, "NtSetInformationFile");
     pNtQueryInformationFile = (void *)GetProcAddress(hntdll, "NtQueryInformationFile");
@@ -300,6 +300,7 @@ HANDLE thread_init(void)
     }
     user_shared_data = addr;
     memcpy( user_shared_data->NtSystemRoot, default_windirW, sizeof(default_windirW) );
+    user_shared_data->LargePageMinimum = virtual_get_large_page_size();
 
     /* allocate and initialize the PEB */
 
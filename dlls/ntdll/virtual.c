@@ -74,6 +74,9 @@ struct file_view
     void         *base;          /* base address */
     size_t        size;          /* size in bytes */
     unsigned int  protect;       /* protection for all pages at allocation time and SEC_* flags */
+    void         *tree_start;    /* start of the first view of the subtree */
+    void         *tree_end;      /* end of the last view of the subtree */
+    size_t        max_gap;       /* largest free area between the views of the subtree */
 };
 
 /* per-page protection flags */
@@ -169,6 +172,7 @@ static void *preload_reserve_start;
 static void *preload_reserve_end;
 static BOOL use_locks;
 static BOOL force_exec_prot;  /* whether to force PROT_EXEC on all PROT_READ mmaps */
+static SIZE_T large_page_size; /* size of huge pages, 0 if not supported */
 
 static inline int is_view_valloc( const struct file_view *view )
 {
@@ -451,70 +455,174 @@ static struct file_view *find_view_range( const void *addr, size_t size )
 
 
 /***********************************************************************
- *           find_free_area
+ *           update_view_gap
  *
- * Find a free area between views inside the specified range.
- * The csVirtual section must be held by caller.
+ * Recompute the subtree information of a view from its children.
  */
-static void *find_free_area( void *base, void *end, size_t size, size_t mask, int top_down )
+static void update_view_gap( struct wine_rb_entry *ptr )
 {
-    struct wine_rb_entry *first = NULL, *ptr = views_tree.root;
-    void *start;
+    struct file_view *view = WINE_RB_ENTRY_VALUE( ptr, struct file_view, entry );
+    char *end = (char *)view->base + view->size;
 
-    /* find the first (resp. last) view inside the range */
-    while (ptr)
+    view->tree_start = view->base;
+    view->tree_end   = end;
+    view->max_gap    = 0;
+    if (ptr->left)
     {
-        struct file_view *view = WINE_RB_ENTRY_VALUE( ptr, struct file_view, entry );
-        if ((char *)view->base + view->size >= (char *)end)
-        {
-            end = min( end, view->base );
-            ptr = ptr->left;
-        }
-        else if (view->base <= base)
-        {
-            base = max( (char *)base, (char *)view->base + view->size );
-            ptr = ptr->right;
-        }
-        else
-        {
-            first = ptr;
-            ptr = top_down ? ptr->right : ptr->left;
-        }
+        struct file_view *left = WINE_RB_ENTRY_VALUE( ptr->left, struct file_view, entry );
+        view->tree_start = left->tree_start;
+        view->max_gap = max( left->max_gap, (size_t)((char *)view->base - (char *)left->tree_end) );
     }
+    if (ptr->right)
+    {
+        struct file_view *right = WINE_RB_ENTRY_VALUE( ptr->right, struct file_view, entry );
+        view->tree_end = right->tree_end;
+        view->max_gap = max( view->max_gap, right->max_gap );
+        view->max_gap = max( view->max_gap, (size_t)((char *)right->tree_start - end) );
+    }
+}
 
-    if (top_down)
+
+/***********************************************************************
+ *           update_view_gaps
+ *
+ * Update the subtree information after the tree has been modified at the
+ * specified node. Rotations only move nodes next to the path to the root,
+ * and their own children are unchanged, so it's enough to update the
+ * children of the nodes on that path.
+ */
+static void update_view_gaps( struct wine_rb_entry *ptr )
+{
+    for ( ; ptr; ptr = ptr->parent)
     {
-        start = ROUND_ADDR( (char *)end - size, mask );
-        if (start >= end || start < base) return NULL;
+        if (ptr->left) update_view_gap( ptr->left );
+        if (ptr->right) update_view_gap( ptr->right );
+        update_view_gap( ptr );
+    }
+}
 
-        while (first)
-        {
-            struct file_view *view = WINE_RB_ENTRY_VALUE( first, struct file_view, entry );
 
-            if ((char *)view->base + view->size <= (char *)start) break;
-            start = ROUND_ADDR( (char *)view->base - size, mask );
-            /* stop if remaining space is not large enough */
-            if (!start || start >= end || start < base) return NULL;
-            first = wine_rb_prev( first );
-        }
+struct free_area
+{
+    char  *base;    /* range to search */
+    char  *end;
+    size_t size;    /* size of the wanted area */
+    size_t mask;    /* alignment mask */
+    char  *limit;   /* end of the previous view (resp. start of the next one when top-down) */
+    char  *result;
+};
+
+/* check if an area can be allocated in the free range limit..gap_end, bottom-up */
+static BOOL free_area_fits_up( struct free_area *area, char *gap_end )
+{
+    char *start = ROUND_ADDR( max( area->limit, area->base ) + area->mask, area->mask );
+    char *end = min( gap_end, area->end );
+
+    if (!start || start >= end || end - start < area->size) return FALSE;
+    area->result = start;
+    return TRUE;
+}
+
+/* check if an area can be allocated in the free range gap_start..limit, top-down */
+static BOOL free_area_fits_down( struct free_area *area, char *gap_start )
+{
+    char *start = max( gap_start, area->base );
+    char *end = min( area->limit, area->end );
+
+    if (start >= end || end - start < area->size) return FALSE;
+    end = ROUND_ADDR( end - area->size, area->mask );
+    if (end < start) return FALSE;
+    area->result = end;
+    return TRUE;
+}
+
+/* search a subtree bottom-up; returns 1 if found, -1 if the end of the range has been reached */
+static int find_free_area_up( struct wine_rb_entry *ptr, struct free_area *area )
+{
+    struct file_view *view = WINE_RB_ENTRY_VALUE( ptr, struct file_view, entry );
+    int ret;
+
+    if ((char *)view->tree_end <= area->base)
+    {
+        area->limit = max( area->limit, (char *)view->tree_end );
+        return 0;
     }
-    else
+    if ((char *)view->tree_start >= area->end) return -1;
+
+    /* skip the subtree if neither the area before it nor the ones inside it are large enough */
+    if (view->max_gap < area->size && !free_area_fits_up( area, view->tree_start ))
     {
-        start = ROUND_ADDR( (char *)base + mask, mask );
-        if (!start || start >= end || (char *)end - (char *)start < size) return NULL;
+        area->limit = max( area->limit, (char *)view->tree_end );
+        return 0;
+    }
 
-        while (first)
-        {
-            struct file_view *view = WINE_RB_ENTRY_VALUE( first, struct file_view, entry );
+    if (ptr->left && (ret = find_free_area_up( ptr->left, area ))) return ret;
+    if (free_area_fits_up( area, view->base )) return 1;
+    if ((char *)view->base >= area->end) return -1;
+    area->limit = max( area->limit, (char *)view->base + view->size );
+    if (ptr->right) return find_free_area_up( ptr->right, area );
+    return 0;
+}
 
-            if ((char *)view->base >= (char *)start + size) break;
-            start = ROUND_ADDR( (char *)view->base + view->size + mask, mask );
-            /* stop if remaining space is not large enough */
-            if (!start || start >= end || (char *)end - (char *)start < size) return NULL;
-            first = wine_rb_next( first );
-        }
+/* search a subtree top-down; returns 1 if found, -1 if the start of the range has been reached */
+static int find_free_area_down( struct wine_rb_entry *ptr, struct free_area *area )
+{
+    struct file_view *view = WINE_RB_ENTRY_VALUE( ptr, struct file_view, entry );
+    int ret;
+
+    if ((char *)view->tree_start >= area->end)
+    {
+        area->limit = min( area->limit, (char *)view->tree_start );
+        return 0;
+    }
+    if ((char *)view->tree_end <= area->base) return -1;
+
+    /* skip the subtree if neither the area after it nor the ones inside it are large enough */
+    if (view->max_gap < area->size && !free_area_fits_down( area, view->tree_end ))
+    {
+        area->limit = min( area->limit, (char *)view->tree_start );
+        return 0;
+    }
+
+    if (ptr->right && (ret = find_free_area_down( ptr->right, area ))) return ret;
+    if (free_area_fits_down( area, (char *)view->base + view->size )) return 1;
+    if ((char *)view->base + view->size <= area->base) return -1;
+    area->limit = min( area->limit, (char *)view->base );
+    if (ptr->left) return find_free_area_down( ptr->left, area );
+    return 0;
+}
+
+
+/***********************************************************************
+ *           find_free_area
+ *
+ * Find a free area between views inside the specified range.
+ * Subtrees that don't contain a large enough gap are skipped.
+ * The csVirtual section must be held by caller.
+ */
+static void *find_free_area( void *base, void *end, size_t size, size_t mask, int top_down )
+{
+    struct free_area area;
+
+    area.base   = base;
+    area.end    = end;
+    area.size   = size;
+    area.mask   = mask;
+    area.result = NULL;
+
+    if (top_down)
+    {
+        area.limit = end;
+        if (views_tree.root && find_free_area_down( views_tree.root, &area ) == 1) return area.result;
+        if (free_area_fits_down( &area, base )) return area.result;
     }
-    return start;
+    else
+    {
+        area.limit = base;
+        if (views_tree.root && find_free_area_up( views_tree.root, &area ) == 1) return area.result;
+        if (free_area_fits_up( &area, end )) return area.result;
+    }
+    return NULL;
 }
 
 
@@ -684,9 +792,19 @@ static struct file_view *alloc_view(void)
  */
 static void delete_view( struct file_view *view ) /* [in] View */
 {
+    struct wine_rb_entry *ptr, *parent = view->entry.parent;
+
     if (!(view->protect & VPROT_SYSTEM)) unmap_area( view->base, view->size );
+    if (view->entry.left && view->entry.right)
+    {
+        /* the successor replaces the view, the tree changes below its old position */
+        for (ptr = view->entry.right; ptr->left; ptr = ptr->left) ;
+        parent = (ptr->parent == &view->entry) ? ptr : ptr->parent;
+    }
+
     set_page_vprot( view->base, view->size, 0 );
     wine_rb_remove( &views_tree, &view->entry );
+    update_view_gaps( parent );
     *(struct file_view **)view = next_free_view;
     next_free_view = view;
 }
@@ -733,6 +851,7 @@ static NTSTATUS create_view( struct file_view **view_ret, void *base, size_t siz
     set_page_vprot( base, size, vprot );
 
     wine_rb_put( &views_tree, view->base, &view->entry );
+    update_view_gaps( &view->entry );
 
     *view_ret = view;
 
@@ -1602,6 +1721,76 @@ static NTSTATUS map_image( HANDLE hmapping, ACCESS_MASK access, int fd, SIZE_T m
 }
 
 
+/***********************************************************************
+ *           virtual_map_image_pages
+ *
+ * Replace pages of a mapped image by private mappings of consecutive pages of
+ * a file, keeping their current protections. Used by the relocation cache.
+ * The image is left untouched on failure.
+ */
+NTSTATUS virtual_map_image_pages( void *module, int fd, const DWORD *rvas, UINT count, off_t offset )
+{
+    struct file_view *view;
+    NTSTATUS status = STATUS_SUCCESS;
+    size_t total = (size_t)count << page_shift;
+    sigset_t sigset;
+    char *data;
+    UINT i, j;
+
+    server_enter_uninterrupted_section( &csVirtual, &sigset );
+
+    if (!(view = VIRTUAL_FindView( module, 0 )) || view->base != module || !(view->protect & SEC_IMAGE))
+        status = STATUS_INVALID_ADDRESS;
+    for (i = 0; !status && i < count; i++)
+        if ((rvas[i] & page_mask) || rvas[i] >= view->size) status = STATUS_INVALID_IMAGE_FORMAT;
+    if (status || !count) goto done;
+
+    /* get all the data before touching the image, so that a failure leaves it unmodified */
+    if ((data = mmap( NULL, total, PROT_READ, MAP_PRIVATE, fd, offset )) == (void *)-1)
+    {
+        if ((data = wine_anon_mmap( NULL, total, PROT_READ | PROT_WRITE, 0 )) == (void *)-1)
+        {
+            status = STATUS_NO_MEMORY;
+            goto done;
+        }
+        if (pread( fd, data, total, offset ) != total)
+        {
+            munmap( data, total );
+            status = STATUS_INVALID_IMAGE_FORMAT;
+            goto done;
+        }
+    }
+
+    for (i = 0; i < count; i = j)
+    {
+        char *addr = (char *)module + rvas[i];
+        BYTE vprot = get_page_vprot( addr );
+        int prot = VIRTUAL_GetUnixProt( vprot );
+        size_t size;
+
+        if (force_exec_prot && (prot & PROT_READ)) prot |= PROT_EXEC;
+
+        /* merge consecutive pages with the same protections */
+        for (j = i + 1; j < count; j++)
+            if (rvas[j] != rvas[j - 1] + page_size || get_page_vprot( (char *)module + rvas[j] ) != vprot) break;
+        size = (size_t)(j - i) << page_shift;
+
+        if (mmap( addr, size, prot, MAP_FIXED | MAP_PRIVATE, fd, offset + ((off_t)i << page_shift) ) != (void *)-1)
+            continue;
+
+        /* fall back to copying the pages */
+        mprotect( addr, size, PROT_READ | PROT_WRITE );
+        memcpy( addr, data + ((size_t)i << page_shift), size );
+        mprotect( addr, size, prot );
+    }
+    munmap( data, total );
+
+done:
+    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    return status;
+}
+
+
 /***********************************************************************
  *             virtual_map_section
  *
@@ -1778,6 +1967,39 @@ static int alloc_virtual_heap( void *base, size_t size, void *arg )
     return (alloc->base != (void *)-1);
 }
 
+/***********************************************************************
+ *           get_large_page_size
+ *
+ * Retrieve the size of the huge pages supported by the kernel.
+ */
+static SIZE_T get_large_page_size(void)
+{
+    SIZE_T size = 0;
+    char line[64];
+    FILE *f;
+
+    if ((f = fopen( "/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "r" )))
+    {
+        if (fgets( line, sizeof(line), f )) size = strtoul( line, NULL, 10 );
+        fclose( f );
+    }
+    if (!size && (f = fopen( "/proc/meminfo", "r" )))
+    {
+        while (fgets( line, sizeof(line), f ))
+        {
+            if (strncmp( line, "Hugepagesize:", 13 )) continue;
+            size = strtoul( line + 13, NULL, 10 ) * 1024;
+            break;
+        }
+        fclose( f );
+    }
+    /* the size must be a power of 2 multiple of the page size */
+    if (size < page_size || (size & (size - 1))) size = 0;
+    TRACE( "large page size %lx\n", size );
+    return size;
+}
+
+
 /***********************************************************************
  *           virtual_init
  */
@@ -1832,6 +2054,8 @@ void virtual_init(void)
     pages_vprot = (void *)((char *)alloc_views.base + view_block_size);
     wine_rb_init( &views_tree, compare_view );
 
+    large_page_size = get_large_page_size();
+
     /* make the DOS area accessible (except the low 64K) to hide bugs in broken apps like Excel 2003 */
     size = (char *)address_space_start - (char *)0x10000;
     if (size && wine_mmap_is_in_reserved_area( (void*)0x10000, size ) == 1)
@@ -1848,6 +2072,28 @@ void virtual_init_threading(void)
 }
 
 
+/***********************************************************************
+ *           virtual_get_large_page_size
+ */
+SIZE_T virtual_get_large_page_size(void)
+{
+    return large_page_size;
+}
+
+
+/***********************************************************************
+ *           virtual_set_huge_page_hint
+ *
+ * Ask the kernel to back a large anonymous area with transparent huge pages.
+ */
+void virtual_set_huge_page_hint( void *base, SIZE_T size )
+{
+#ifdef MADV_HUGEPAGE
+    if (large_page_size && size >= large_page_size) madvise( base, size, MADV_HUGEPAGE );
+#endif
+}
+
+
 /***********************************************************************
  *           virtual_get_system_info
  */
@@ -1967,6 +2213,7 @@ NTSTATUS virtual_alloc_thread_stack( TEB *teb, SIZE_T reserve_size, SIZE_T commi
         /* shrink the first view and create a second one for the extra size */
         /* this allows the app to free the stack without freeing the thread start portion */
         view->size -= extra_size;
+        update_view_gaps( &view->entry );
         status = create_view( &extra_view, (char *)view->base + view->size, extra_size,
                               VPROT_READ | VPROT_WRITE | VPROT_COMMITTED );
         if (status != STATUS_SUCCESS)
@@ -2012,6 +2259,12 @@ NTSTATUS virtual_handle_fault( LPCVOID addr, DWORD err, BOOL on_signal_stack )
     sigset_t sigset;
     BYTE vprot;
 
+    /* plain access violations don't need the lock, the page protection array is never freed */
+    vprot = get_page_vprot( page );
+    if (!(vprot & (VPROT_GUARD | VPROT_WRITEWATCH)) &&
+        (!(err & EXCEPTION_WRITE_FAULT) || !(VIRTUAL_GetUnixProt( vprot ) & PROT_WRITE)))
+        return ret;
+
     server_enter_uninterrupted_section( &csVirtual, &sigset );
     vprot = get_page_vprot( page );
     if (!on_signal_stack && (vprot & VPROT_GUARD))
@@ -2448,6 +2701,29 @@ void virtual_set_large_address_space(void)
 }
 
 
+/***********************************************************************
+ *           map_large_pages
+ *
+ * Back a newly allocated area with huge pages, using the hugetlb pool if
+ * it has been configured and transparent huge pages otherwise.
+ * The csVirtual section must be held by caller.
+ */
+static void map_large_pages( void *base, size_t size, unsigned int vprot )
+{
+#ifdef MAP_HUGETLB
+    if (mmap( base, size, VIRTUAL_GetUnixProt( vprot ), MAP_PRIVATE | MAP_ANON | MAP_FIXED | MAP_HUGETLB,
+              -1, 0 ) == base)
+    {
+        TRACE( "using hugetlb pages for %p-%p\n", base, (char *)base + size );
+        return;
+    }
+    /* make sure the area is still mapped */
+    wine_anon_mmap( base, size, VIRTUAL_GetUnixProt( vprot ), MAP_FIXED );
+#endif
+    virtual_set_huge_page_hint( base, size );
+}
+
+
 /***********************************************************************
  *             NtAllocateVirtualMemory   (NTDLL.@)
  *             ZwAllocateVirtualMemory   (NTDLL.@)
@@ -2524,12 +2800,22 @@ NTSTATUS WINAPI NtAllocateVirtualMemory( HANDLE process, PVOID *ret, ULONG zero_
     /* Compute the alloc type flags */
 
     if (!(type & (MEM_COMMIT | MEM_RESERVE | MEM_RESET)) ||
-        (type & ~(MEM_COMMIT | MEM_RESERVE | MEM_TOP_DOWN | MEM_WRITE_WATCH | MEM_RESET)))
+        (type & ~(MEM_COMMIT | MEM_RESERVE | MEM_TOP_DOWN | MEM_WRITE_WATCH | MEM_RESET | MEM_LARGE_PAGES)))
     {
         WARN("called with wrong alloc type flags (%08x) !\n", type);
         return STATUS_INVALID_PARAMETER;
     }
 
+    /* large pages must be reserved and committed at once, on large page boundaries */
+    if (type & MEM_LARGE_PAGES)
+    {
+        if (!large_page_size || (type & (MEM_RESERVE | MEM_COMMIT)) != (MEM_RESERVE | MEM_COMMIT) ||
+            (type & MEM_WRITE_WATCH) || (size & (large_page_size - 1)) ||
+            ((UINT_PTR)*ret & (large_page_size - 1)))
+            return STATUS_INVALID_PARAMETER;
+        mask |= large_page_size - 1;
+    }
+
     /* Reserve the memory */
 
     if (use_locks) server_enter_uninterrupted_section( &csVirtual, &sigset );
@@ -2546,7 +2832,11 @@ NTSTATUS WINAPI NtAllocateVirtualMemory( HANDLE process, PVOID *ret, ULONG zero_
             else if (is_dos_memory) status = allocate_dos_memory( &view, vprot );
             else status = map_view( &view, base, size, mask, type & MEM_TOP_DOWN, vprot );
 
-            if (status == STATUS_SUCCESS) base = view->base;
+            if (status == STATUS_SUCCESS)
+            {
+                base = view->base;
+                if (type & MEM_LARGE_PAGES) map_large_pages( base, size, vprot );
+            }
         }
     }
     else if (type & MEM_RESET)
@@ -3301,6 +3591,31 @@ NTSTATUS WINAPI NtFlushVirtualMemory( HANDLE process, LPCVOID *addr_ptr,
 }
 
 
+/***********************************************************************
+ *             NtFlushProcessWriteBuffers   (NTDLL.@)
+ *             ZwFlushProcessWriteBuffers   (NTDLL.@)
+ */
+void WINAPI NtFlushProcessWriteBuffers(void)
+{
+    static void *dummy_page;
+    sigset_t sigset;
+
+    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    if (!dummy_page) dummy_page = wine_anon_mmap( NULL, page_size, PROT_READ | PROT_WRITE, 0 );
+    if (dummy_page != (void *)-1)
+    {
+        /* Changing the protection of a page that is present in the TLB forces the
+         * kernel to interrupt all the CPUs running our threads, which flushes their
+         * store buffers. The page is touched first so that it's really mapped. */
+        mprotect( dummy_page, page_size, PROT_READ | PROT_WRITE );
+        interlocked_xchg_add( dummy_page, 1 );
+        mprotect( dummy_page, page_size, PROT_NONE );
+    }
+    else ERR( "failed to allocate dummy page\n" );
+    server_leave_uninterrupted_section( &csVirtual, &sigset );
+}
+
+
 /***********************************************************************
  *             NtGetWriteWatch   (NTDLL.@)
  *             ZwGetWriteWatch   (NTDLL.@)
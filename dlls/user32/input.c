@@ -103,6 +103,99 @@ static WORD get_key_state(void)
 }
 
 
+/***********************************************************************
+ *           map_shared_memory
+ *
+ * Map the shared memory views of the thread desktop and queue state.
+ * The server only returns a queue mapping once the thread has a queue.
+ */
+static struct user_shared_memory *map_shared_memory(void)
+{
+    struct user_thread_info *thread_info = get_user_thread_info();
+    struct user_shared_memory *shared = thread_info->shared_memory;
+    HANDLE desktop = 0, queue = 0;
+
+    if (!shared)
+    {
+        if (!(shared = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*shared) ))) return NULL;
+        thread_info->shared_memory = shared;
+    }
+
+    SERVER_START_REQ( get_shared_memory )
+    {
+        if (!wine_server_call( req ))
+        {
+            desktop = wine_server_ptr_handle( reply->desktop );
+            queue = wine_server_ptr_handle( reply->queue );
+        }
+    }
+    SERVER_END_REQ;
+
+    if (desktop)
+    {
+        if (!shared->desktop) shared->desktop = MapViewOfFile( desktop, FILE_MAP_READ, 0, 0, 0 );
+        CloseHandle( desktop );
+    }
+    if (queue)
+    {
+        if (!shared->queue) shared->queue = MapViewOfFile( queue, FILE_MAP_READ, 0, 0, 0 );
+        CloseHandle( queue );
+    }
+    return shared;
+}
+
+/***********************************************************************
+ *           free_shared_memory
+ *
+ * Unmap the shared memory views, only the desktop one if the thread changed desktop.
+ */
+void free_shared_memory( BOOL desktop_only )
+{
+    struct user_thread_info *thread_info = get_user_thread_info();
+    struct user_shared_memory *shared = thread_info->shared_memory;
+
+    if (!shared) return;
+    if (shared->desktop) UnmapViewOfFile( shared->desktop );
+    shared->desktop = NULL;
+    if (desktop_only) return;
+    if (shared->queue) UnmapViewOfFile( shared->queue );
+    thread_info->shared_memory = NULL;
+    HeapFree( GetProcessHeap(), 0, shared );
+}
+
+static const desktop_shm_t *get_desktop_shm(void)
+{
+    struct user_shared_memory *shared = get_user_thread_info()->shared_memory;
+
+    if (!shared || !shared->desktop) shared = map_shared_memory();
+    return shared ? shared->desktop : NULL;
+}
+
+static const queue_shm_t *get_queue_shm(void)
+{
+    struct user_thread_info *thread_info = get_user_thread_info();
+    struct user_shared_memory *shared = thread_info->shared_memory;
+
+    /* don't bother the server while the thread has no queue */
+    if (!thread_info->server_queue) return NULL;
+    if (!shared || !shared->queue) shared = map_shared_memory();
+    return shared ? shared->queue : NULL;
+}
+
+/* the server increments seq before and after each update, retry until we get a stable copy */
+#define SHARED_READ_BEGIN( shared ) \
+    do { \
+        unsigned int __seq; \
+        do { \
+            while ((__seq = (shared)->seq) & 1) NtYieldExecution(); \
+            __sync_synchronize();
+
+#define SHARED_READ_END( shared ) \
+            __sync_synchronize(); \
+        } while ((shared)->seq != __seq); \
+    } while(0)
+
+
 /**********************************************************************
  *		set_capture_window
  */
@@ -261,21 +354,33 @@ void WINAPI mouse_event( DWORD dwFlags, DWORD dx, DWORD dy,
  */
 BOOL WINAPI DECLSPEC_HOTPATCH GetCursorPos( POINT *pt )
 {
-    BOOL ret;
+    const desktop_shm_t *shared;
+    BOOL ret = TRUE;
     DWORD last_change;
 
     if (!pt) return FALSE;
 
-    SERVER_START_REQ( set_cursor )
+    if ((shared = get_desktop_shm()))
     {
-        if ((ret = !wine_server_call( req )))
+        SHARED_READ_BEGIN( shared );
+        pt->x = shared->cursor_x;
+        pt->y = shared->cursor_y;
+        last_change = shared->cursor_last_change;
+        SHARED_READ_END( shared );
+    }
+    else
+    {
+        SERVER_START_REQ( set_cursor )
         {
-            pt->x = reply->new_x;
-            pt->y = reply->new_y;
-            last_change = reply->last_change;
+            if ((ret = !wine_server_call( req )))
+            {
+                pt->x = reply->new_x;
+                pt->y = reply->new_y;
+                last_change = reply->last_change;
+            }
         }
+        SERVER_END_REQ;
     }
-    SERVER_END_REQ;
 
     /* query new position from graphics driver if we haven't updated recently */
     if (ret && GetTickCount() - last_change > 100) ret = USER_Driver->pGetCursorPos( pt );
@@ -412,8 +517,9 @@ static void check_for_events( UINT flags )
 SHORT WINAPI DECLSPEC_HOTPATCH GetAsyncKeyState( INT key )
 {
     struct user_key_state_info *key_state_info = get_user_thread_info()->key_state;
+    const desktop_shm_t *shared;
     INT counter = global_key_state_counter;
-    BYTE prev_key_state;
+    BYTE prev_key_state, state;
     SHORT ret;
 
     if (key < 0 || key >= 256) return 0;
@@ -422,6 +528,16 @@ SHORT WINAPI DECLSPEC_HOTPATCH GetAsyncKeyState( INT key )
 
     if ((ret = USER_Driver->pGetAsyncKeyState( key )) == -1)
     {
+        if ((shared = get_desktop_shm()))
+        {
+            SHARED_READ_BEGIN( shared );
+            state = shared->keystate[key];
+            SHARED_READ_END( shared );
+
+            /* the server has to clear the "pressed since last call" bit */
+            if (!(state & 0x40)) return (state & 0x80) ? 0x8000 : 0;
+        }
+
         if (key_state_info &&
             !(key_state_info->state[key] & 0xc0) &&
             key_state_info->counter == counter &&
@@ -474,7 +590,8 @@ SHORT WINAPI DECLSPEC_HOTPATCH GetAsyncKeyState( INT key )
  */
 DWORD WINAPI GetQueueStatus( UINT flags )
 {
-    DWORD ret;
+    const queue_shm_t *shared;
+    DWORD ret, wake_bits, changed_bits;
 
     if (flags & ~(QS_ALLINPUT | QS_ALLPOSTMESSAGE | QS_SMRESULT))
     {
@@ -484,6 +601,17 @@ DWORD WINAPI GetQueueStatus( UINT flags )
 
     check_for_events( flags );
 
+    if ((shared = get_queue_shm()))
+    {
+        SHARED_READ_BEGIN( shared );
+        wake_bits = shared->wake_bits;
+        changed_bits = shared->changed_bits;
+        SHARED_READ_END( shared );
+
+        /* nothing to clear, no need to ask the server */
+        if (!(changed_bits & flags)) return MAKELONG( 0, wake_bits & flags );
+    }
+
     SERVER_START_REQ( get_queue_status )
     {
         req->clear_bits = flags;
@@ -500,10 +628,19 @@ DWORD WINAPI GetQueueStatus( UINT flags )
  */
 BOOL WINAPI GetInputState(void)
 {
+    const queue_shm_t *shared;
     DWORD ret;
 
     check_for_events( QS_INPUT );
 
+    if ((shared = get_queue_shm()))
+    {
+        SHARED_READ_BEGIN( shared );
+        ret = shared->wake_bits & (QS_KEY | QS_MOUSEBUTTON);
+        SHARED_READ_END( shared );
+        return ret;
+    }
+
     SERVER_START_REQ( get_queue_status )
     {
         req->clear_bits = 0;
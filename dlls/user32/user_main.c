@@ -376,6 +376,7 @@ static void thread_detach(void)
 
     destroy_thread_windows();
     CloseHandle( thread_info->server_queue );
+    free_shared_memory( FALSE );
     HeapFree( GetProcessHeap(), 0, thread_info->wmchar_data );
     HeapFree( GetProcessHeap(), 0, thread_info->key_state );
     HeapFree( GetProcessHeap(), 0, thread_info->rawinput );
@@ -170,13 +170,13 @@ struct wm_char_mapping_data
 struct user_thread_info
 {
     DPI_AWARENESS                 dpi_awareness;          /* DPI awareness */
+    BOOL                          hook_unicode;           /* Is current hook unicode? */
     HANDLE                        server_queue;           /* Handle to server-side queue */
     DWORD                         wake_mask;              /* Current queue wake mask */
     DWORD                         changed_mask;           /* Current queue changed mask */
     WORD                          recursion_count;        /* SendMessage recursion counter */
     WORD                          message_count;          /* Get/PeekMessage loop counter */
     WORD                          hook_call_depth;        /* Number of recursively called hook procs */
-    BOOL                          hook_unicode;           /* Is current hook unicode? */
     HHOOK                         hook;                   /* Current hook */
     struct received_message_info *receive_info;           /* Message being currently received */
     struct wm_char_mapping_data  *wmchar_data;            /* Data for WM_CHAR mappings */
@@ -188,6 +188,7 @@ struct user_thread_info
     HWND                          top_window;             /* Desktop window */
     HWND                          msg_window;             /* HWND_MESSAGE parent window */
     RAWINPUT                     *rawinput;
+    struct user_shared_memory    *shared_memory;          /* Shared memory views of the server state */
 };
 
 C_ASSERT( sizeof(struct user_thread_info) <= sizeof(((TEB *)0)->Win32ClientInfo) );
@@ -203,6 +204,12 @@ struct user_key_state_info
     BYTE                          state[256];             /* State for each key */
 };
 
+struct user_shared_memory
+{
+    const void                   *desktop;                /* View of the desktop_shm_t of the thread desktop */
+    const void                   *queue;                  /* View of the queue_shm_t of the thread queue */
+};
+
 struct hook_extra_info
 {
     HHOOK handle;
@@ -228,6 +235,7 @@ struct tagWND;
 extern void CLIPBOARD_ReleaseOwner( HWND hwnd ) DECLSPEC_HIDDEN;
 extern BOOL FOCUS_MouseActivate( HWND hwnd ) DECLSPEC_HIDDEN;
 extern BOOL set_capture_window( HWND hwnd, UINT gui_flags, HWND *prev_ret ) DECLSPEC_HIDDEN;
+extern void free_shared_memory( BOOL desktop_only ) DECLSPEC_HIDDEN;
 extern void free_dce( struct dce *dce, HWND hwnd ) DECLSPEC_HIDDEN;
 extern void invalidate_dce( struct tagWND *win, const RECT *rect ) DECLSPEC_HIDDEN;
 extern HDC get_display_dc(void) DECLSPEC_HIDDEN;
@@ -429,6 +429,7 @@ BOOL WINAPI SetThreadDesktop( HDESK handle )
         thread_info->top_window = 0;
         thread_info->msg_window = 0;
         if (key_state_info) key_state_info->time = 0;
+        free_shared_memory( TRUE );
     }
     return ret;
 }
@@ -43,6 +43,7 @@ static DWORD   vcomp_context_tls = TLS_OUT_OF_INDEXES;
 static HMODULE vcomp_module;
 static int     vcomp_max_threads;
 static int     vcomp_num_threads;
+static int     vcomp_spin_count;
 static BOOL    vcomp_nested_fork = FALSE;
 
 static RTL_CRITICAL_SECTION vcomp_section;
@@ -59,6 +60,9 @@ static RTL_CRITICAL_SECTION vcomp_section = { &critsect_debug, -1, 0, 0, 0, 0 };
 #define VCOMP_DYNAMIC_FLAGS_GUIDED      0x03
 #define VCOMP_DYNAMIC_FLAGS_INCREMENT   0x40
 
+/* number of pause iterations before going to sleep on multiprocessor systems */
+#define VCOMP_SPIN_COUNT                4000
+
 struct vcomp_thread_data
 {
     struct vcomp_team_data  *team;
@@ -96,10 +100,21 @@ struct vcomp_team_data
     __ms_va_list            valist;
 
     /* barrier */
-    unsigned int            barrier;
-    int                     barrier_count;
+    LONG                    barrier;
+    LONG                    barrier_count;
+    LONG                    barrier_sleepers;
+};
+
+/* per thread range of chunks for dynamic loops, padded to avoid false sharing */
+struct vcomp_dynamic_slot
+{
+    LONGLONG                range;
+    LONG                    active;
+    char                    pad[64 - sizeof(LONGLONG) - sizeof(LONG)];
 };
 
+C_ASSERT(sizeof(struct vcomp_dynamic_slot) == 64);
+
 struct vcomp_task_data
 {
     /* single */
@@ -112,11 +127,16 @@ struct vcomp_task_data
 
     /* dynamic */
     unsigned int            dynamic;
+    LONG                    dynamic_ready;
     unsigned int            dynamic_first;
     unsigned int            dynamic_last;
     unsigned int            dynamic_iterations;
     int                     dynamic_step;
     unsigned int            dynamic_chunksize;
+    unsigned int            dynamic_chunks;
+    LONG                    dynamic_next;
+    int                     dynamic_num_slots;
+    struct vcomp_dynamic_slot *dynamic_slots;
 };
 
 #if defined(__i386__)
@@ -379,6 +399,15 @@ static short interlocked_xchg_add16(short *dest, short incr)
 
 #endif  /* __GNUC__ */
 
+static inline void vcomp_pause(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __asm__ __volatile__( "rep;nop" : : : "memory" );
+#else
+    __asm__ __volatile__( "" : : : "memory" );
+#endif
+}
+
 static inline struct vcomp_thread_data *vcomp_get_thread_data(void)
 {
     return (struct vcomp_thread_data *)TlsGetValue(vcomp_context_tls);
@@ -394,20 +423,24 @@ static struct vcomp_thread_data *vcomp_init_thread_data(void)
     struct vcomp_thread_data *thread_data = vcomp_get_thread_data();
     struct
     {
-        struct vcomp_thread_data thread;
-        struct vcomp_task_data   task;
+        struct vcomp_thread_data  thread;
+        struct vcomp_task_data    task;
+        struct vcomp_dynamic_slot slot;
     } *data;
 
     if (thread_data) return thread_data;
-    if (!(data = HeapAlloc(GetProcessHeap(), 0, sizeof(*data))))
+    if (!(data = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*data))))
     {
         ERR("could not create thread data\n");
         ExitProcess(1);
     }
 
-    data->task.single           = 0;
-    data->task.section          = 0;
-    data->task.dynamic          = 0;
+    data->task.single               = 0;
+    data->task.section              = 0;
+    data->task.dynamic              = 0;
+    data->task.dynamic_ready        = 0;
+    data->task.dynamic_num_slots    = 1;
+    data->task.dynamic_slots        = &data->slot;
 
     thread_data = &data->thread;
     thread_data->team           = NULL;
@@ -1054,25 +1087,40 @@ void CDECL _vcomp_flush(void)
 void CDECL _vcomp_barrier(void)
 {
     struct vcomp_team_data *team_data = vcomp_init_thread_data()->team;
+    LONG barrier;
+    int i;
 
     TRACE("()\n");
 
     if (!team_data)
         return;
 
-    EnterCriticalSection(&vcomp_section);
-    if (++team_data->barrier_count >= team_data->num_threads)
+    barrier = team_data->barrier;
+    if (InterlockedIncrement(&team_data->barrier_count) >= team_data->num_threads)
     {
-        team_data->barrier++;
         team_data->barrier_count = 0;
-        WakeAllConditionVariable(&team_data->cond);
+        InterlockedIncrement(&team_data->barrier);
+        if (team_data->barrier_sleepers)
+        {
+            EnterCriticalSection(&vcomp_section);
+            WakeAllConditionVariable(&team_data->cond);
+            LeaveCriticalSection(&vcomp_section);
+        }
+        return;
     }
-    else
+
+    /* the other threads usually arrive shortly, spin for a while first */
+    for (i = 0; i < vcomp_spin_count; i++)
     {
-        unsigned int barrier = team_data->barrier;
-        while (team_data->barrier == barrier)
-            SleepConditionVariableCS(&team_data->cond, &vcomp_section, INFINITE);
+        if (*(volatile LONG *)&team_data->barrier != barrier) return;
+        vcomp_pause();
     }
+
+    EnterCriticalSection(&vcomp_section);
+    InterlockedIncrement(&team_data->barrier_sleepers);
+    while (team_data->barrier == barrier)
+        SleepConditionVariableCS(&team_data->cond, &vcomp_section, INFINITE);
+    InterlockedDecrement(&team_data->barrier_sleepers);
     LeaveCriticalSection(&vcomp_section);
 }
 
@@ -1284,6 +1332,128 @@ void CDECL _vcomp_for_static_end(void)
     /* nothing to do here */
 }
 
+static inline LONGLONG vcomp_dynamic_range(unsigned int begin, unsigned int end)
+{
+    return (LONGLONG)(((ULONGLONG)end << 32) | begin);
+}
+
+static inline LONGLONG vcomp_dynamic_get_range(struct vcomp_dynamic_slot *slot)
+{
+#ifdef _WIN64
+    return *(volatile LONGLONG *)&slot->range;
+#else
+    return InterlockedCompareExchange64(&slot->range, 0, 0);
+#endif
+}
+
+static void vcomp_dynamic_setup(struct vcomp_task_data *task_data, unsigned int generation, int num_threads,
+                                unsigned int first, unsigned int last, unsigned int iterations,
+                                int step, unsigned int chunksize)
+{
+    unsigned int num_chunks;
+    int i, num_slots = min(num_threads, task_data->dynamic_num_slots);
+
+    /* make threads spin until the new loop is set up, and wait for the ones
+     * which are still looking for chunks of the previous loop */
+    InterlockedExchange(&task_data->dynamic_ready, generation + 0x80000000);
+    for (i = 0; i < task_data->dynamic_num_slots; i++)
+        while (*(volatile LONG *)&task_data->dynamic_slots[i].active)
+            vcomp_pause();
+
+    num_chunks = chunksize ? ((ULONGLONG)iterations + chunksize - 1) / chunksize : 0;
+
+    task_data->dynamic_first        = first;
+    task_data->dynamic_last         = last;
+    task_data->dynamic_iterations   = iterations;
+    task_data->dynamic_step         = step;
+    task_data->dynamic_chunksize    = chunksize;
+    task_data->dynamic_chunks       = num_chunks;
+    task_data->dynamic_next         = 0;
+
+    /* chunked loops start with an equal share of chunks for every thread */
+    for (i = 0; i < task_data->dynamic_num_slots; i++)
+    {
+        if (i < num_slots)
+            task_data->dynamic_slots[i].range = vcomp_dynamic_range((ULONGLONG)num_chunks * i / num_slots,
+                                                                    (ULONGLONG)num_chunks * (i + 1) / num_slots);
+        else
+            task_data->dynamic_slots[i].range = 0;
+    }
+
+    InterlockedExchange(&task_data->dynamic_ready, generation);
+}
+
+/* returns FALSE if the loop is already finished */
+static BOOL vcomp_dynamic_enter(struct vcomp_task_data *task_data, struct vcomp_dynamic_slot *slot,
+                                unsigned int generation)
+{
+    LONG ready;
+
+    for (;;)
+    {
+        InterlockedExchange(&slot->active, 1);
+        ready = *(volatile LONG *)&task_data->dynamic_ready;
+        if (ready == generation) return TRUE;
+        *(volatile LONG *)&slot->active = 0;
+        if ((int)(ready - generation) > 0) return FALSE;
+        vcomp_pause();
+    }
+}
+
+/* take the first chunk of our own range */
+static BOOL vcomp_dynamic_take(struct vcomp_dynamic_slot *slot, unsigned int *chunk)
+{
+    LONGLONG range;
+    unsigned int begin, end;
+
+    do
+    {
+        range = vcomp_dynamic_get_range(slot);
+        begin = (unsigned int)range;
+        end   = (ULONGLONG)range >> 32;
+        if (begin >= end) return FALSE;
+    }
+    while (InterlockedCompareExchange64(&slot->range, vcomp_dynamic_range(begin + 1, end), range) != range);
+
+    *chunk = begin;
+    return TRUE;
+}
+
+/* steal the second half of the range of another thread */
+static BOOL vcomp_dynamic_steal(struct vcomp_task_data *task_data, int thread_num, unsigned int *chunk)
+{
+    struct vcomp_dynamic_slot *slot = &task_data->dynamic_slots[thread_num];
+    unsigned int begin, end, count;
+    LONGLONG range;
+    int i;
+
+    for (i = 1; i < task_data->dynamic_num_slots; i++)
+    {
+        struct vcomp_dynamic_slot *victim =
+            &task_data->dynamic_slots[(thread_num + i) % task_data->dynamic_num_slots];
+
+        do
+        {
+            range = vcomp_dynamic_get_range(victim);
+            begin = (unsigned int)range;
+            end   = (ULONGLONG)range >> 32;
+            if (begin >= end) break;
+            count = (end - begin + 1) / 2;
+        }
+        while (InterlockedCompareExchange64(&victim->range, vcomp_dynamic_range(begin, end - count), range) != range);
+
+        if (begin >= end) continue;
+
+        /* our own range is empty, nobody else modifies it */
+        InterlockedCompareExchange64(&slot->range, vcomp_dynamic_range(end - count + 1, end),
+                                     vcomp_dynamic_get_range(slot));
+        *chunk = end - count;
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
 void CDECL _vcomp_for_dynamic_init(unsigned int flags, unsigned int first, unsigned int last,
                                    int step, unsigned int chunksize)
 {
@@ -1294,6 +1464,7 @@ void CDECL _vcomp_for_dynamic_init(unsigned int flags, unsigned int first, unsig
     int num_threads = team_data ? team_data->num_threads : 1;
     int thread_num = thread_data->thread_num;
     unsigned int type = flags & ~VCOMP_DYNAMIC_FLAGS_INCREMENT;
+    unsigned int generation, prev;
 
     TRACE("(%u, %u, %u, %d, %u)\n", flags, first, last, step, chunksize);
 
@@ -1339,19 +1510,22 @@ void CDECL _vcomp_for_dynamic_init(unsigned int flags, unsigned int first, unsig
             type = VCOMP_DYNAMIC_FLAGS_GUIDED;
         }
 
-        EnterCriticalSection(&vcomp_section);
         thread_data->dynamic++;
         thread_data->dynamic_type = type;
-        if ((int)(thread_data->dynamic - task_data->dynamic) > 0)
+
+        /* the first thread to get here sets up the loop */
+        generation = task_data->dynamic;
+        while ((int)(thread_data->dynamic - generation) > 0)
         {
-            task_data->dynamic              = thread_data->dynamic;
-            task_data->dynamic_first        = first;
-            task_data->dynamic_last         = last;
-            task_data->dynamic_iterations   = iterations;
-            task_data->dynamic_step         = step;
-            task_data->dynamic_chunksize    = chunksize;
+            prev = InterlockedCompareExchange((LONG *)&task_data->dynamic, thread_data->dynamic, generation);
+            if (prev == generation)
+            {
+                vcomp_dynamic_setup(task_data, thread_data->dynamic, num_threads,
+                                    first, last, iterations, step, chunksize);
+                break;
+            }
+            generation = prev;
         }
-        LeaveCriticalSection(&vcomp_section);
     }
 }
 
@@ -1371,30 +1545,62 @@ int CDECL _vcomp_for_dynamic_next(unsigned int *begin, unsigned int *end)
         thread_data->dynamic_type = 0;
         return 1;
     }
-    else if (thread_data->dynamic_type == VCOMP_DYNAMIC_FLAGS_CHUNKED ||
-             thread_data->dynamic_type == VCOMP_DYNAMIC_FLAGS_GUIDED)
+    else if (thread_data->dynamic_type == VCOMP_DYNAMIC_FLAGS_GUIDED)
     {
-        unsigned int iterations = 0;
-        EnterCriticalSection(&vcomp_section);
-        if (thread_data->dynamic == task_data->dynamic &&
-            task_data->dynamic_iterations != 0)
+        struct vcomp_dynamic_slot *slot = &task_data->dynamic_slots[thread_data->thread_num];
+        unsigned int iterations = 0, remaining, next;
+
+        if (!vcomp_dynamic_enter(task_data, slot, thread_data->dynamic))
+            return 0;
+
+        /* chunk sizes only depend on the number of remaining iterations */
+        do
         {
-            iterations = min(task_data->dynamic_iterations, task_data->dynamic_chunksize);
-            if (thread_data->dynamic_type == VCOMP_DYNAMIC_FLAGS_GUIDED &&
-                task_data->dynamic_iterations > num_threads * task_data->dynamic_chunksize)
-            {
-                iterations = (task_data->dynamic_iterations + num_threads - 1) / num_threads;
-            }
-            *begin = task_data->dynamic_first;
-            *end   = task_data->dynamic_first + (iterations - 1) * task_data->dynamic_step;
-            task_data->dynamic_iterations -= iterations;
-            task_data->dynamic_first      += iterations * task_data->dynamic_step;
-            if (!task_data->dynamic_iterations)
+            next = *(volatile LONG *)&task_data->dynamic_next;
+            remaining = task_data->dynamic_iterations - next;
+            if (!remaining) break;
+            iterations = min(remaining, task_data->dynamic_chunksize);
+            if (remaining > num_threads * task_data->dynamic_chunksize)
+                iterations = (remaining + num_threads - 1) / num_threads;
+            if (!iterations) break;
+        }
+        while (InterlockedCompareExchange(&task_data->dynamic_next, next + iterations, next) != next);
+
+        if (remaining && iterations)
+        {
+            *begin = task_data->dynamic_first + next * task_data->dynamic_step;
+            if (next + iterations == task_data->dynamic_iterations)
                 *end = task_data->dynamic_last;
+            else
+                *end = *begin + (iterations - 1) * task_data->dynamic_step;
         }
-        LeaveCriticalSection(&vcomp_section);
+        else iterations = 0;
+
+        *(volatile LONG *)&slot->active = 0;
         return iterations != 0;
     }
+    else if (thread_data->dynamic_type == VCOMP_DYNAMIC_FLAGS_CHUNKED)
+    {
+        struct vcomp_dynamic_slot *slot = &task_data->dynamic_slots[thread_data->thread_num];
+        unsigned int chunk;
+        BOOL ret;
+
+        if (!vcomp_dynamic_enter(task_data, slot, thread_data->dynamic))
+            return 0;
+
+        if ((ret = vcomp_dynamic_take(slot, &chunk) ||
+                   vcomp_dynamic_steal(task_data, thread_data->thread_num, &chunk)))
+        {
+            *begin = task_data->dynamic_first + chunk * task_data->dynamic_chunksize * task_data->dynamic_step;
+            if (chunk == task_data->dynamic_chunks - 1)
+                *end = task_data->dynamic_last;
+            else
+                *end = *begin + (task_data->dynamic_chunksize - 1) * task_data->dynamic_step;
+        }
+
+        *(volatile LONG *)&slot->active = 0;
+        return ret;
+    }
 
     return 0;
 }
@@ -1416,6 +1622,8 @@ static DWORD WINAPI _vcomp_fork_worker(void *param)
     for (;;)
     {
         struct vcomp_team_data *team = thread_data->team;
+        int i;
+
         if (team != NULL)
         {
             LeaveCriticalSection(&vcomp_section);
@@ -1427,6 +1635,17 @@ static DWORD WINAPI _vcomp_fork_worker(void *param)
             list_add_tail(&vcomp_idle_threads, &thread_data->entry);
             if (++team->finished_threads >= team->num_threads)
                 WakeAllConditionVariable(&team->cond);
+
+            /* parallel regions are often started back to back, keep the
+             * thread hot for a while before going to sleep */
+            LeaveCriticalSection(&vcomp_section);
+            for (i = 0; i < vcomp_spin_count; i++)
+            {
+                if (*(struct vcomp_team_data * volatile *)&thread_data->team) break;
+                vcomp_pause();
+            }
+            EnterCriticalSection(&vcomp_section);
+            if (thread_data->team) continue;
         }
 
         if (!SleepConditionVariableCS(&thread_data->cond, &vcomp_section, 5000) &&
@@ -1449,10 +1668,12 @@ static DWORD WINAPI _vcomp_fork_worker(void *param)
 void WINAPIV _vcomp_fork(BOOL ifval, int nargs, void *wrapper, ...)
 {
     struct vcomp_thread_data *prev_thread_data = vcomp_init_thread_data();
+    struct vcomp_dynamic_slot local_slot, *slots = &local_slot;
     struct vcomp_thread_data thread_data;
+    void *slots_mem = NULL;
     struct vcomp_team_data team_data;
     struct vcomp_task_data task_data;
-    int num_threads;
+    int num_threads, i;
 
     TRACE("(%d, %d, %p, ...)\n", ifval, nargs, wrapper);
 
@@ -1466,6 +1687,21 @@ void WINAPIV _vcomp_fork(BOOL ifval, int nargs, void *wrapper, ...)
     else
         num_threads = vcomp_num_threads;
 
+    if (num_threads > 1)
+    {
+        /* the slots are padded to a cache line, align them to one too */
+        if ((slots_mem = HeapAlloc(GetProcessHeap(), 0, num_threads * sizeof(*slots) + sizeof(*slots) - 1)))
+            slots = (struct vcomp_dynamic_slot *)(((ULONG_PTR)slots_mem + sizeof(*slots) - 1) &
+                                                  ~(ULONG_PTR)(sizeof(*slots) - 1));
+        else
+            num_threads = 1;
+    }
+    for (i = 0; i < num_threads; i++)
+    {
+        slots[i].range  = 0;
+        slots[i].active = 0;
+    }
+
     InitializeConditionVariable(&team_data.cond);
     team_data.num_threads       = 1;
     team_data.finished_threads  = 0;
@@ -1474,10 +1710,14 @@ void WINAPIV _vcomp_fork(BOOL ifval, int nargs, void *wrapper, ...)
     __ms_va_start(team_data.valist, wrapper);
     team_data.barrier           = 0;
     team_data.barrier_count     = 0;
+    team_data.barrier_sleepers  = 0;
 
     task_data.single            = 0;
     task_data.section           = 0;
     task_data.dynamic           = 0;
+    task_data.dynamic_ready     = 0;
+    task_data.dynamic_num_slots = num_threads;
+    task_data.dynamic_slots     = slots;
 
     thread_data.team            = &team_data;
     thread_data.task            = &task_data;
@@ -1562,6 +1802,16 @@ void WINAPIV _vcomp_fork(BOOL ifval, int nargs, void *wrapper, ...)
         EnterCriticalSection(&vcomp_section);
 
         team_data.finished_threads++;
+        if (team_data.finished_threads < team_data.num_threads)
+        {
+            LeaveCriticalSection(&vcomp_section);
+            for (i = 0; i < vcomp_spin_count; i++)
+            {
+                if (*(volatile int *)&team_data.finished_threads >= team_data.num_threads) break;
+                vcomp_pause();
+            }
+            EnterCriticalSection(&vcomp_section);
+        }
         while (team_data.finished_threads < team_data.num_threads)
             SleepConditionVariableCS(&team_data.cond, &vcomp_section, INFINITE);
 
@@ -1569,6 +1819,7 @@ void WINAPIV _vcomp_fork(BOOL ifval, int nargs, void *wrapper, ...)
         assert(list_empty(&thread_data.entry));
     }
 
+    HeapFree(GetProcessHeap(), 0, slots_mem);
     __ms_va_end(team_data.valist);
 }
 
@@ -1693,6 +1944,7 @@ BOOL WINAPI DllMain(HINSTANCE instance, DWORD reason, LPVOID reserved)
             vcomp_module      = instance;
             vcomp_max_threads = sysinfo.dwNumberOfProcessors;
             vcomp_num_threads = sysinfo.dwNumberOfProcessors;
+            vcomp_spin_count  = sysinfo.dwNumberOfProcessors > 1 ? VCOMP_SPIN_COUNT : 0;
             break;
         }
 
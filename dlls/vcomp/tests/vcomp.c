@@ -1224,15 +1224,35 @@ static void CDECL for_dynamic_guided_cb(unsigned int flags, LONG *a, LONG *b, LO
     }
 }
 
+static void CDECL for_dynamic_steal_cb(LONG *seen)
+{
+    unsigned int begin, end, i;
+    BOOL first = TRUE;
+
+    p_vcomp_for_dynamic_init(VCOMP_DYNAMIC_FLAGS_CHUNKED | VCOMP_DYNAMIC_FLAGS_INCREMENT, 0, 1000, 1, 3);
+    while (p_vcomp_for_dynamic_next(&begin, &end))
+    {
+        /* keep the first thread busy, so that the others take over its chunks */
+        if (first && !pomp_get_thread_num()) Sleep(50);
+        first = FALSE;
+
+        if (begin == 999) ok(end == 1000, "expected end == 1000, got %u\n", end);
+        else ok(begin + 2 == end, "expected begin + 2 == end, got %u and %u\n", begin + 2, end);
+        for (i = begin; i <= end; i++)
+            InterlockedIncrement(&seen[i]);
+    }
+}
+
 static void test_vcomp_for_dynamic_init(void)
 {
     static const int guided_a[] = {0, 6041, 9072, 11179};
     static const int guided_b[] = {1000, 1959, 2928, 3821};
     static const int guided_c[] = {0, 4067, 6139, 7273};
     static const int guided_d[] = {1000, 1933, 2861, 3727};
+    static LONG seen[1001];
     LONG a, b, c, d;
     int max_threads = pomp_get_max_threads();
-    int i;
+    int i, j;
 
     /* test static scheduling */
     for_dynamic_static_cb();
@@ -1325,6 +1345,20 @@ static void test_vcomp_for_dynamic_init(void)
         ok(d == guided_d[0], "expected d == %d, got %d\n", guided_d[0], d);
     }
 
+    /* test that every iteration runs once when chunks are taken over from a busy
+     * thread, with thread counts that don't divide the 334 chunks evenly */
+    for (i = 1; i <= 5; i++)
+    {
+        pomp_set_num_threads(i);
+
+        memset(seen, 0, sizeof(seen));
+        p_vcomp_fork(TRUE, 1, for_dynamic_steal_cb, seen);
+        for (j = 0; j < ARRAY_SIZE(seen); j++)
+            if (seen[j] != 1) break;
+        ok(j == ARRAY_SIZE(seen), "%d threads: iteration %d ran %d times\n",
+           i, j, j < ARRAY_SIZE(seen) ? seen[j] : 0);
+    }
+
     pomp_set_num_threads(max_threads);
 }
 
@@ -1449,6 +1449,9 @@ static void context_destroy_gl_resources(struct wined3d_context *context)
 
         if (context->blit_vbo)
             GL_EXTCALL(glDeleteBuffers(1, &context->blit_vbo));
+        if (gl_info->supported[ARB_COPY_BUFFER])
+            GL_EXTCALL(glDeleteBuffers(ARRAY_SIZE(context->cb_copy_bo) * ARRAY_SIZE(context->cb_copy_bo[0]),
+                    &context->cb_copy_bo[0][0]));
 
         checkGLcall("context cleanup");
     }
@@ -3970,6 +3973,14 @@ static BOOL context_apply_draw_state(struct wined3d_context *context,
             wined3d_buffer_load_sysmem(state->index_buffer, context);
     }
 
+    /* Constant buffer ranges at misaligned offsets are bound from copies,
+     * which have to be refreshed for each draw. */
+    for (i = 0, map = context->cb_copy_mask & ~(1u << WINED3D_SHADER_TYPE_COMPUTE); map; map >>= 1, ++i)
+    {
+        if (map & 1)
+            context_invalidate_state(context, STATE_GRAPHICS_CONSTANT_BUFFER(i));
+    }
+
     for (i = 0; i < context->numDirtyEntries; ++i)
     {
         DWORD rep = context->dirtyArray[i];
@@ -4032,6 +4043,9 @@ static void context_apply_compute_state(struct wined3d_context *context,
     context_load_unordered_access_resources(context, state->shader[WINED3D_SHADER_TYPE_COMPUTE],
             state->unordered_access_view[WINED3D_PIPELINE_COMPUTE]);
 
+    if (context->cb_copy_mask & (1u << WINED3D_SHADER_TYPE_COMPUTE))
+        context_invalidate_compute_state(context, STATE_COMPUTE_CONSTANT_BUFFER);
+
     for (i = 0, state_id = STATE_COMPUTE_OFFSET; i < ARRAY_SIZE(context->dirty_compute_states); ++i)
     {
         unsigned int dirty_mask = context->dirty_compute_states[i];
@@ -210,6 +210,8 @@ struct wined3d_cs_set_constant_buffer
     enum wined3d_shader_type type;
     UINT cb_idx;
     struct wined3d_buffer *buffer;
+    unsigned int offset;
+    unsigned int size;
 };
 
 struct wined3d_cs_set_texture
@@ -1236,6 +1238,8 @@ static void wined3d_cs_exec_set_constant_buffer(struct wined3d_cs *cs, const voi
 
     prev = cs->state.cb[op->type][op->cb_idx];
     cs->state.cb[op->type][op->cb_idx] = op->buffer;
+    cs->state.cb_offset[op->type][op->cb_idx] = op->offset;
+    cs->state.cb_size[op->type][op->cb_idx] = op->size;
 
     if (op->buffer)
         InterlockedIncrement(&op->buffer->resource.bind_count);
@@ -1246,7 +1250,7 @@ static void wined3d_cs_exec_set_constant_buffer(struct wined3d_cs *cs, const voi
 }
 
 void wined3d_cs_emit_set_constant_buffer(struct wined3d_cs *cs, enum wined3d_shader_type type,
-        UINT cb_idx, struct wined3d_buffer *buffer)
+        UINT cb_idx, struct wined3d_buffer *buffer, unsigned int offset, unsigned int size)
 {
     struct wined3d_cs_set_constant_buffer *op;
 
@@ -1255,6 +1259,8 @@ void wined3d_cs_emit_set_constant_buffer(struct wined3d_cs *cs, enum wined3d_sha
     op->type = type;
     op->cb_idx = cb_idx;
     op->buffer = buffer;
+    op->offset = offset;
+    op->size = size;
 
     cs->ops->submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
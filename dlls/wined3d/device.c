@@ -2227,12 +2227,15 @@ struct wined3d_shader * CDECL wined3d_device_get_vertex_shader(const struct wine
     return device->state.shader[WINED3D_SHADER_TYPE_VERTEX];
 }
 
-void CDECL wined3d_device_set_constant_buffer(struct wined3d_device *device,
-        enum wined3d_shader_type type, UINT idx, struct wined3d_buffer *buffer)
+void CDECL wined3d_device_set_constant_buffer_range(struct wined3d_device *device,
+        enum wined3d_shader_type type, unsigned int idx, struct wined3d_buffer *buffer,
+        unsigned int offset, unsigned int size)
 {
+    struct wined3d_state *state = device->update_state;
     struct wined3d_buffer *prev;
 
-    TRACE("device %p, type %#x, idx %u, buffer %p.\n", device, type, idx, buffer);
+    TRACE("device %p, type %#x, idx %u, buffer %p, offset %u, size %u.\n",
+            device, type, idx, buffer, offset, size);
 
     if (idx >= MAX_CONSTANT_BUFFERS)
     {
@@ -2240,23 +2243,36 @@ void CDECL wined3d_device_set_constant_buffer(struct wined3d_device *device,
         return;
     }
 
-    prev = device->update_state->cb[type][idx];
-    if (buffer == prev)
+    if (!buffer)
+        offset = size = 0;
+
+    prev = state->cb[type][idx];
+    if (buffer == prev && offset == state->cb_offset[type][idx] && size == state->cb_size[type][idx])
         return;
 
     if (buffer)
         wined3d_buffer_incref(buffer);
-    device->update_state->cb[type][idx] = buffer;
+    state->cb[type][idx] = buffer;
+    state->cb_offset[type][idx] = offset;
+    state->cb_size[type][idx] = size;
     if (!device->recording)
-        wined3d_cs_emit_set_constant_buffer(device->cs, type, idx, buffer);
+        wined3d_cs_emit_set_constant_buffer(device->cs, type, idx, buffer, offset, size);
     if (prev)
         wined3d_buffer_decref(prev);
 }
 
-struct wined3d_buffer * CDECL wined3d_device_get_constant_buffer(const struct wined3d_device *device,
-        enum wined3d_shader_type shader_type, unsigned int idx)
+void CDECL wined3d_device_set_constant_buffer(struct wined3d_device *device,
+        enum wined3d_shader_type type, UINT idx, struct wined3d_buffer *buffer)
 {
-    TRACE("device %p, shader_type %#x, idx %u.\n", device, shader_type, idx);
+    TRACE("device %p, type %#x, idx %u, buffer %p.\n", device, type, idx, buffer);
+
+    wined3d_device_set_constant_buffer_range(device, type, idx, buffer, 0, buffer ? buffer->resource.size : 0);
+}
+
+struct wined3d_buffer * CDECL wined3d_device_get_constant_buffer_range(const struct wined3d_device *device,
+        enum wined3d_shader_type shader_type, unsigned int idx, unsigned int *offset, unsigned int *size)
+{
+    TRACE("device %p, shader_type %#x, idx %u, offset %p, size %p.\n", device, shader_type, idx, offset, size);
 
     if (idx >= MAX_CONSTANT_BUFFERS)
     {
@@ -2264,9 +2280,21 @@ struct wined3d_buffer * CDECL wined3d_device_get_constant_buffer(const struct wi
         return NULL;
     }
 
+    if (offset)
+        *offset = device->state.cb_offset[shader_type][idx];
+    if (size)
+        *size = device->state.cb_size[shader_type][idx];
     return device->state.cb[shader_type][idx];
 }
 
+struct wined3d_buffer * CDECL wined3d_device_get_constant_buffer(const struct wined3d_device *device,
+        enum wined3d_shader_type shader_type, unsigned int idx)
+{
+    TRACE("device %p, shader_type %#x, idx %u.\n", device, shader_type, idx);
+
+    return wined3d_device_get_constant_buffer_range(device, shader_type, idx, NULL, NULL);
+}
+
 static void wined3d_device_set_shader_resource_view(struct wined3d_device *device,
         enum wined3d_shader_type type, UINT idx, struct wined3d_shader_resource_view *view)
 {
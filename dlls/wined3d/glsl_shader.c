@@ -131,6 +131,15 @@ struct shader_glsl_priv
     struct wine_rb_tree ffp_fragment_shaders;
     BOOL ffp_proj_control;
     BOOL legacy_lighting;
+
+    BOOL program_binary_cache;
+    UINT64 program_binary_seed;
+    struct wine_rb_tree program_binaries;
+    CRITICAL_SECTION program_binary_cs;
+    HANDLE program_binary_thread;
+    HANDLE program_binary_done;
+    HMODULE program_binary_module;
+    LONG program_binary_abort;
 };
 
 struct glsl_vs_program
@@ -257,6 +266,41 @@ struct glsl_program_key
     GLuint cs_id;
 };
 
+#define WINED3D_GLSL_BINARY_MAGIC   0x42534c47 /* "GLSB" */
+#define WINED3D_GLSL_BINARY_VERSION 2
+/* Older binaries are evicted when the cache directory grows past this. */
+#define WINED3D_GLSL_BINARY_CACHE_SIZE   (256 * 1024 * 1024)
+/* At most this much is read ahead of time, the rest is read on first use. */
+#define WINED3D_GLSL_BINARY_PRELOAD_SIZE (32 * 1024 * 1024)
+
+/* On-disk layout of a cached program binary, followed by the binary data. */
+struct glsl_program_binary_header
+{
+    DWORD magic;
+    DWORD version;
+    UINT64 seed;
+    UINT64 hash;
+    GLenum format;
+    DWORD size;
+};
+
+/* A file found in the cache directory, for eviction. */
+struct glsl_program_binary_file
+{
+    char name[40];
+    FILETIME time;
+    DWORD size;
+};
+
+struct glsl_program_binary
+{
+    struct wine_rb_entry entry;
+    UINT64 hash;
+    GLenum format;
+    DWORD size;
+    BYTE data[1];
+};
+
 struct shader_glsl_ctx_priv {
     const struct vs_compile_args    *cur_vs_args;
     const struct ds_compile_args    *cur_ds_args;
@@ -10204,6 +10248,406 @@ static void set_glsl_compute_shader_program(const struct wined3d_context *contex
     ctx_data->glsl_program = entry;
 }
 
+static UINT64 shader_glsl_hash_data(UINT64 hash, const void *data, SIZE_T size)
+{
+    const BYTE *ptr = data;
+    SIZE_T i;
+
+    /* FNV-1a */
+    for (i = 0; i < size; ++i)
+    {
+        hash ^= ptr[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static int glsl_program_binary_compare(const void *key, const struct wine_rb_entry *entry)
+{
+    const struct glsl_program_binary *binary = WINE_RB_ENTRY_VALUE(entry, const struct glsl_program_binary, entry);
+    UINT64 hash = *(const UINT64 *)key;
+
+    if (hash > binary->hash) return 1;
+    if (hash < binary->hash) return -1;
+    return 0;
+}
+
+static void glsl_free_program_binary(struct wine_rb_entry *entry, void *context)
+{
+    heap_free(WINE_RB_ENTRY_VALUE(entry, struct glsl_program_binary, entry));
+}
+
+/* Binaries are named after the driver seed and the program hash, so that
+ * only the ones usable with the current driver are preloaded. */
+static void shader_glsl_get_program_binary_path(UINT64 seed, UINT64 hash, char *path, SIZE_T size)
+{
+    snprintf(path, size, "%s\\%08x%08x-%08x%08x.bin", wined3d_settings.shader_cache,
+            (unsigned int)(seed >> 32), (unsigned int)seed, (unsigned int)(hash >> 32), (unsigned int)hash);
+}
+
+static BOOL shader_glsl_is_hex_string(const char *str, unsigned int count)
+{
+    unsigned int i;
+
+    for (i = 0; i < count; ++i)
+    {
+        if (!isxdigit((unsigned char)str[i]))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/* Read a cached program binary. If "hash" is zero, any program is accepted,
+ * but the binary always has to come from the driver identified by "seed". */
+static struct glsl_program_binary *shader_glsl_read_program_binary(const char *path, UINT64 seed, UINT64 hash)
+{
+    struct glsl_program_binary_header header;
+    struct glsl_program_binary *binary = NULL;
+    DWORD file_size, count;
+    HANDLE file;
+
+    if ((file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+            NULL, OPEN_EXISTING, 0, NULL)) == INVALID_HANDLE_VALUE)
+        return NULL;
+
+    file_size = GetFileSize(file, NULL);
+    if (file_size == INVALID_FILE_SIZE || file_size <= sizeof(header)
+            || !ReadFile(file, &header, sizeof(header), &count, NULL) || count != sizeof(header)
+            || header.magic != WINED3D_GLSL_BINARY_MAGIC || header.version != WINED3D_GLSL_BINARY_VERSION
+            || header.seed != seed || (hash && header.hash != hash) || header.size != file_size - sizeof(header))
+        goto done;
+
+    if (!(binary = heap_alloc(FIELD_OFFSET(struct glsl_program_binary, data[header.size]))))
+        goto done;
+    if (!ReadFile(file, binary->data, header.size, &count, NULL) || count != header.size)
+    {
+        heap_free(binary);
+        binary = NULL;
+        goto done;
+    }
+    binary->hash = header.hash;
+    binary->format = header.format;
+    binary->size = header.size;
+
+done:
+    CloseHandle(file);
+    return binary;
+}
+
+static int glsl_program_binary_file_compare(const void *a, const void *b)
+{
+    const struct glsl_program_binary_file *f1 = a, *f2 = b;
+
+    return CompareFileTime(&f1->time, &f2->time);
+}
+
+/* Delete the oldest binaries, of any driver, until the cache fits in
+ * WINED3D_GLSL_BINARY_CACHE_SIZE. */
+static void shader_glsl_evict_program_binaries(struct glsl_program_binary_file *files,
+        SIZE_T count, ULONGLONG total_size)
+{
+    char path[MAX_PATH];
+    SIZE_T i;
+
+    if (total_size <= WINED3D_GLSL_BINARY_CACHE_SIZE)
+        return;
+
+    qsort(files, count, sizeof(*files), glsl_program_binary_file_compare);
+    for (i = 0; i < count && total_size > WINED3D_GLSL_BINARY_CACHE_SIZE; ++i)
+    {
+        snprintf(path, sizeof(path), "%s\\%s", wined3d_settings.shader_cache, files[i].name);
+        if (DeleteFileA(path))
+            total_size -= files[i].size;
+    }
+    TRACE("Evicted %lu program binaries.\n", (unsigned long)i);
+}
+
+/* Reads the binaries of the current driver ahead of time, up to
+ * WINED3D_GLSL_BINARY_PRELOAD_SIZE, so that the first use of a program only
+ * has to hand the binary to the driver. Binaries from older versions of the
+ * cache are deleted, and the oldest ones are evicted if the cache is full. */
+static DWORD WINAPI shader_glsl_preload_program_binaries(void *ctx)
+{
+    struct shader_glsl_priv *priv = ctx;
+    struct glsl_program_binary_file *files = NULL;
+    ULONGLONG total_size = 0, preload_size = 0;
+    SIZE_T files_size = 0, file_count = 0;
+    struct glsl_program_binary *binary;
+    char path[MAX_PATH], prefix[18], *name;
+    WIN32_FIND_DATAA data;
+    unsigned int count = 0;
+    HMODULE module;
+    HANDLE find;
+
+    module = priv->program_binary_module;
+
+    snprintf(prefix, sizeof(prefix), "%08x%08x-", (unsigned int)(priv->program_binary_seed >> 32),
+            (unsigned int)priv->program_binary_seed);
+    snprintf(path, sizeof(path), "%s\\*.bin", wined3d_settings.shader_cache);
+    if ((find = FindFirstFileA(path, &data)) != INVALID_HANDLE_VALUE)
+    {
+        name = path + strlen(wined3d_settings.shader_cache) + 1;
+        do
+        {
+            if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+                continue;
+            if (strlen(data.cFileName) >= sizeof(path) - (name - path))
+                continue;
+            strcpy(name, data.cFileName);
+
+            /* named after the hash only, from version 1 of the cache */
+            if (strlen(data.cFileName) == 20 && shader_glsl_is_hex_string(data.cFileName, 16))
+            {
+                DeleteFileA(path);
+                continue;
+            }
+            if (strlen(data.cFileName) != 37 || data.cFileName[16] != '-'
+                    || !shader_glsl_is_hex_string(data.cFileName, 16)
+                    || !shader_glsl_is_hex_string(data.cFileName + 17, 16))
+                continue;
+
+            if (wined3d_array_reserve((void **)&files, &files_size, file_count + 1, sizeof(*files)))
+            {
+                strcpy(files[file_count].name, data.cFileName);
+                files[file_count].time = data.ftLastWriteTime;
+                files[file_count].size = data.nFileSizeLow;
+                ++file_count;
+            }
+            total_size += data.nFileSizeLow;
+
+            if (memcmp(data.cFileName, prefix, sizeof(prefix) - 1)
+                    || preload_size + data.nFileSizeLow > WINED3D_GLSL_BINARY_PRELOAD_SIZE)
+                continue;
+            if (!(binary = shader_glsl_read_program_binary(path, priv->program_binary_seed, 0)))
+                continue;
+
+            EnterCriticalSection(&priv->program_binary_cs);
+            if (wine_rb_put(&priv->program_binaries, &binary->hash, &binary->entry))
+            {
+                heap_free(binary);
+            }
+            else
+            {
+                preload_size += data.nFileSizeLow;
+                ++count;
+            }
+            LeaveCriticalSection(&priv->program_binary_cs);
+        } while (!priv->program_binary_abort && FindNextFileA(find, &data));
+        FindClose(find);
+    }
+
+    TRACE("Preloaded %u program binaries.\n", count);
+    if (!priv->program_binary_abort)
+        shader_glsl_evict_program_binaries(files, file_count, total_size);
+    heap_free(files);
+    SetEvent(priv->program_binary_done);
+    FreeLibraryAndExitThread(module, 0);
+}
+
+static void shader_glsl_start_program_binary_preload(struct shader_glsl_priv *priv)
+{
+    if (!(priv->program_binary_done = CreateEventW(NULL, TRUE, FALSE, NULL)))
+        return;
+    if (!GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS,
+            (const WCHAR *)shader_glsl_preload_program_binaries, &priv->program_binary_module))
+    {
+        CloseHandle(priv->program_binary_done);
+        priv->program_binary_done = NULL;
+        return;
+    }
+    if (!(priv->program_binary_thread = CreateThread(NULL, 0,
+            shader_glsl_preload_program_binaries, priv, 0, NULL)))
+    {
+        FreeLibrary(priv->program_binary_module);
+        CloseHandle(priv->program_binary_done);
+        priv->program_binary_done = NULL;
+    }
+}
+
+/* Context activation is done by the caller. */
+static BOOL shader_glsl_init_program_binary_seed(const struct wined3d_gl_info *gl_info,
+        struct shader_glsl_priv *priv)
+{
+    static const GLenum names[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+    const char *str;
+    GLint count = 0;
+    unsigned int i;
+    UINT64 seed;
+
+    gl_info->gl_ops.gl.p_glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count);
+    if (!count)
+    {
+        WARN("No program binary formats supported, disabling the shader cache.\n");
+        priv->program_binary_cache = FALSE;
+        return FALSE;
+    }
+
+    seed = 0xcbf29ce484222325ull;
+    seed = shader_glsl_hash_data(seed, "wined3d-glsl", sizeof("wined3d-glsl"));
+    for (i = 0; i < ARRAY_SIZE(names); ++i)
+    {
+        if (!(str = (const char *)gl_info->gl_ops.gl.p_glGetString(names[i])))
+            str = "";
+        seed = shader_glsl_hash_data(seed, str, strlen(str) + 1);
+    }
+    priv->program_binary_seed = seed ? seed : 1;
+
+    /* the binaries to preload depend on the driver */
+    shader_glsl_start_program_binary_preload(priv);
+    return TRUE;
+}
+
+/* The key of a cached binary is built from the driver and the sources of all
+ * attached shaders, since GL object names don't survive the process.
+ * Context activation is done by the caller. */
+static UINT64 shader_glsl_get_program_binary_hash(const struct wined3d_gl_info *gl_info,
+        struct shader_glsl_priv *priv, GLuint program_id, const struct wined3d_shader *vshader)
+{
+    GLint i, shader_count, source_size = 0, length;
+    GLuint *shaders;
+    char *source = NULL;
+    UINT64 hash;
+    GLint tmp;
+
+    if (!priv->program_binary_seed && !shader_glsl_init_program_binary_seed(gl_info, priv))
+        return 0;
+
+    GL_EXTCALL(glGetProgramiv(program_id, GL_ATTACHED_SHADERS, &shader_count));
+    if (!(shaders = heap_calloc(shader_count, sizeof(*shaders))))
+        return 0;
+    GL_EXTCALL(glGetAttachedShaders(program_id, shader_count, NULL, shaders));
+
+    hash = priv->program_binary_seed;
+    if (vshader)
+    {
+        hash = shader_glsl_hash_data(hash, &vshader->reg_maps.input_registers,
+                sizeof(vshader->reg_maps.input_registers));
+        hash = shader_glsl_hash_data(hash, &vshader->reg_maps.shader_version.major,
+                sizeof(vshader->reg_maps.shader_version.major));
+    }
+
+    for (i = 0; i < shader_count; ++i)
+    {
+        GL_EXTCALL(glGetShaderiv(shaders[i], GL_SHADER_TYPE, &tmp));
+        hash = shader_glsl_hash_data(hash, &tmp, sizeof(tmp));
+
+        GL_EXTCALL(glGetShaderiv(shaders[i], GL_SHADER_SOURCE_LENGTH, &tmp));
+        if (source_size < tmp)
+        {
+            heap_free(source);
+            if (!(source = heap_alloc(tmp)))
+            {
+                heap_free(shaders);
+                return 0;
+            }
+            source_size = tmp;
+        }
+        length = 0;
+        if (tmp)
+            GL_EXTCALL(glGetShaderSource(shaders[i], source_size, &length, source));
+        hash = shader_glsl_hash_data(hash, source, length);
+    }
+    checkGLcall("hash program sources");
+
+    heap_free(source);
+    heap_free(shaders);
+    return hash ? hash : 1;
+}
+
+/* Context activation is done by the caller. */
+static BOOL shader_glsl_load_program_binary(const struct wined3d_gl_info *gl_info,
+        struct shader_glsl_priv *priv, GLuint program_id, UINT64 hash)
+{
+    struct glsl_program_binary *binary = NULL;
+    struct wine_rb_entry *entry;
+    char path[MAX_PATH];
+    GLenum error;
+    GLint status;
+
+    EnterCriticalSection(&priv->program_binary_cs);
+    if ((entry = wine_rb_get(&priv->program_binaries, &hash)))
+    {
+        wine_rb_remove(&priv->program_binaries, entry);
+        binary = WINE_RB_ENTRY_VALUE(entry, struct glsl_program_binary, entry);
+    }
+    LeaveCriticalSection(&priv->program_binary_cs);
+
+    if (!binary)
+    {
+        shader_glsl_get_program_binary_path(priv->program_binary_seed, hash, path, sizeof(path));
+        if (!(binary = shader_glsl_read_program_binary(path, priv->program_binary_seed, hash)))
+            return FALSE;
+    }
+
+    GL_EXTCALL(glProgramBinary(program_id, binary->format, binary->data, binary->size));
+    /* The driver may reject binaries from an older build of itself with an
+     * error; the program is simply linked from source in that case. */
+    if ((error = gl_info->gl_ops.gl.p_glGetError()) != GL_NO_ERROR)
+        TRACE("glProgramBinary failed, error %s.\n", debug_glerror(error));
+    heap_free(binary);
+    GL_EXTCALL(glGetProgramiv(program_id, GL_LINK_STATUS, &status));
+    checkGLcall("glGetProgramiv");
+
+    TRACE("Loading cached binary for program %u %s.\n", program_id, status ? "succeeded" : "failed");
+    return status;
+}
+
+/* Context activation is done by the caller. */
+static void shader_glsl_save_program_binary(const struct wined3d_gl_info *gl_info,
+        const struct shader_glsl_priv *priv, GLuint program_id, UINT64 hash)
+{
+    struct glsl_program_binary_header *header;
+    char path[MAX_PATH], tmp_path[MAX_PATH];
+    GLint status, size = 0;
+    GLsizei length;
+    DWORD written;
+    HANDLE file;
+    BOOL ret;
+
+    GL_EXTCALL(glGetProgramiv(program_id, GL_LINK_STATUS, &status));
+    if (!status)
+        return;
+    GL_EXTCALL(glGetProgramiv(program_id, GL_PROGRAM_BINARY_LENGTH, &size));
+    if (size <= 0 || !(header = heap_alloc(sizeof(*header) + size)))
+        return;
+
+    length = 0;
+    GL_EXTCALL(glGetProgramBinary(program_id, size, &length, &header->format, header + 1));
+    checkGLcall("glGetProgramBinary");
+    if (length <= 0)
+    {
+        heap_free(header);
+        return;
+    }
+    header->magic = WINED3D_GLSL_BINARY_MAGIC;
+    header->version = WINED3D_GLSL_BINARY_VERSION;
+    header->seed = priv->program_binary_seed;
+    header->hash = hash;
+    header->size = length;
+
+    /* Write to a temporary file first so that concurrent readers never see a
+     * partial binary. */
+    shader_glsl_get_program_binary_path(priv->program_binary_seed, hash, path, sizeof(path));
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.%x", path, GetCurrentProcessId()) >= sizeof(tmp_path))
+    {
+        WARN("Program binary path %s is too long.\n", debugstr_a(path));
+        heap_free(header);
+        return;
+    }
+    if ((file = CreateFileA(tmp_path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL)) != INVALID_HANDLE_VALUE)
+    {
+        ret = WriteFile(file, header, sizeof(*header) + length, &written, NULL)
+                && written == sizeof(*header) + length;
+        CloseHandle(file);
+        if (!ret || !MoveFileExA(tmp_path, path, MOVEFILE_REPLACE_EXISTING))
+        {
+            WARN("Failed to write program binary %s.\n", debugstr_a(path));
+            DeleteFileA(tmp_path);
+        }
+    }
+    heap_free(header);
+}
+
 /* Context activation is done by the caller. */
 static void set_glsl_shader_program(const struct wined3d_context *context, const struct wined3d_state *state,
         struct shader_glsl_priv *priv, struct glsl_context_data *ctx_data)
@@ -10228,6 +10672,8 @@ static void set_glsl_shader_program(const struct wined3d_context *context, const
     struct list *ps_list, *vs_list;
     WORD attribs_map;
     struct wined3d_string_buffer *tmp_name;
+    BOOL binary_loaded = FALSE;
+    UINT64 binary_hash = 0;
 
     if (!(context->shader_update_mask & (1u << WINED3D_SHADER_TYPE_VERTEX)) && ctx_data->glsl_program)
     {
@@ -10467,10 +10913,25 @@ static void set_glsl_shader_program(const struct wined3d_context *context, const
         list_add_head(ps_list, &entry->ps.shader_entry);
     }
 
-    /* Link the program */
-    TRACE("Linking GLSL shader program %u.\n", program_id);
-    GL_EXTCALL(glLinkProgram(program_id));
-    shader_glsl_validate_link(gl_info, program_id);
+    /* Transform feedback varyings aren't part of the shader sources, so
+     * programs using stream output are not cached. */
+    if (priv->program_binary_cache && !(gshader && gshader->u.gs.so_desc.element_count)
+            && (binary_hash = shader_glsl_get_program_binary_hash(gl_info, priv, program_id, vshader)))
+    {
+        if (!(binary_loaded = shader_glsl_load_program_binary(gl_info, priv, program_id, binary_hash)))
+            GL_EXTCALL(glProgramParameteri(program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+    }
+
+    if (!binary_loaded)
+    {
+        /* Link the program */
+        TRACE("Linking GLSL shader program %u.\n", program_id);
+        GL_EXTCALL(glLinkProgram(program_id));
+        shader_glsl_validate_link(gl_info, program_id);
+
+        if (binary_hash)
+            shader_glsl_save_program_binary(gl_info, priv, program_id, binary_hash);
+    }
 
     shader_glsl_init_vs_uniform_locations(gl_info, priv, program_id, &entry->vs,
             vshader ? vshader->limits->constant_float : 0);
@@ -11002,6 +11463,39 @@ static void constant_heap_free(struct constant_heap *heap)
     heap_free(heap->entries);
 }
 
+static void shader_glsl_init_program_binary_cache(const struct wined3d_gl_info *gl_info,
+        struct shader_glsl_priv *priv)
+{
+    InitializeCriticalSection(&priv->program_binary_cs);
+    priv->program_binary_cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": shader_glsl_priv.program_binary_cs");
+    wine_rb_init(&priv->program_binaries, glsl_program_binary_compare);
+
+    if (!wined3d_settings.shader_cache || !gl_info->supported[ARB_GET_PROGRAM_BINARY])
+        return;
+    if (!CreateDirectoryA(wined3d_settings.shader_cache, NULL) && GetLastError() != ERROR_ALREADY_EXISTS)
+    {
+        WARN("Failed to create shader cache directory %s, error %u.\n",
+                debugstr_a(wined3d_settings.shader_cache), GetLastError());
+        return;
+    }
+    /* the binaries are preloaded once the driver seed is known */
+    priv->program_binary_cache = TRUE;
+}
+
+static void shader_glsl_cleanup_program_binary_cache(struct shader_glsl_priv *priv)
+{
+    if (priv->program_binary_thread)
+    {
+        InterlockedExchange(&priv->program_binary_abort, TRUE);
+        WaitForSingleObject(priv->program_binary_done, INFINITE);
+        CloseHandle(priv->program_binary_thread);
+        CloseHandle(priv->program_binary_done);
+    }
+    wine_rb_destroy(&priv->program_binaries, glsl_free_program_binary, NULL);
+    priv->program_binary_cs.DebugInfo->Spare[0] = 0;
+    DeleteCriticalSection(&priv->program_binary_cs);
+}
+
 static HRESULT shader_glsl_alloc(struct wined3d_device *device, const struct wined3d_vertex_pipe_ops *vertex_pipe,
         const struct fragment_pipeline *fragment_pipe)
 {
@@ -11064,6 +11558,8 @@ static HRESULT shader_glsl_alloc(struct wined3d_device *device, const struct win
     priv->ffp_proj_control = fragment_caps.wined3d_caps & WINED3D_FRAGMENT_CAP_PROJ_CONTROL;
     priv->legacy_lighting = device->wined3d->flags & WINED3D_LEGACY_FFP_LIGHTING;
 
+    shader_glsl_init_program_binary_cache(gl_info, priv);
+
     device->vertex_priv = vertex_priv;
     device->fragment_priv = fragment_priv;
     device->shader_priv = priv;
@@ -11086,6 +11582,7 @@ static void shader_glsl_free(struct wined3d_device *device)
 {
     struct shader_glsl_priv *priv = device->shader_priv;
 
+    shader_glsl_cleanup_program_binary_cache(priv);
     wine_rb_destroy(&priv->program_lookup, NULL, NULL);
     constant_heap_free(&priv->pconst_heap);
     constant_heap_free(&priv->vconst_heap);
@@ -4395,9 +4395,9 @@ void state_srgbwrite(struct wined3d_context *context, const struct wined3d_state
 static void state_cb(struct wined3d_context *context, const struct wined3d_state *state, DWORD state_id)
 {
     const struct wined3d_gl_info *gl_info = context->gl_info;
+    unsigned int i, base, count, offset, size;
     enum wined3d_shader_type shader_type;
     struct wined3d_buffer *buffer;
-    unsigned int i, base, count;
 
     TRACE("context %p, state %p, state_id %#x.\n", context, state, state_id);
 
@@ -4406,11 +4406,50 @@ static void state_cb(struct wined3d_context *context, const struct wined3d_state
     else
         shader_type = WINED3D_SHADER_TYPE_COMPUTE;
 
+    context->cb_copy_mask &= ~(1u << shader_type);
     wined3d_gl_limits_get_uniform_block_range(&gl_info->limits, shader_type, &base, &count);
     for (i = 0; i < count; ++i)
     {
         buffer = state->cb[shader_type][i];
-        GL_EXTCALL(glBindBufferBase(GL_UNIFORM_BUFFER, base + i, buffer ? buffer->buffer_object : 0));
+        offset = state->cb_offset[shader_type][i];
+        size = state->cb_size[shader_type][i];
+
+        if (!buffer || offset >= buffer->resource.size)
+        {
+            GL_EXTCALL(glBindBufferBase(GL_UNIFORM_BUFFER, base + i, 0));
+            continue;
+        }
+        size = min(size, buffer->resource.size - offset);
+        if ((offset & (gl_info->limits.uniform_buffer_offset_alignment - 1)))
+        {
+            GLuint *bo = &context->cb_copy_bo[shader_type][i];
+
+            if (!gl_info->supported[ARB_COPY_BUFFER])
+            {
+                FIXME("Buffer offset %u is not %u byte aligned.\n",
+                        offset, gl_info->limits.uniform_buffer_offset_alignment);
+                GL_EXTCALL(glBindBufferRange(GL_UNIFORM_BUFFER, base + i, buffer->buffer_object, 0, size));
+                continue;
+            }
+
+            /* The range is copied to the start of a buffer owned by the
+             * context. The source may be written between draws, so the copy
+             * is redone for every draw while the offset stays misaligned. */
+            if (!*bo)
+            {
+                GL_EXTCALL(glGenBuffers(1, bo));
+                GL_EXTCALL(glBindBuffer(GL_COPY_WRITE_BUFFER, *bo));
+                GL_EXTCALL(glBufferData(GL_COPY_WRITE_BUFFER, MAX_CONSTANT_BUFFER_SIZE, NULL, GL_STREAM_COPY));
+            }
+            size = min(size, MAX_CONSTANT_BUFFER_SIZE);
+            GL_EXTCALL(glBindBuffer(GL_COPY_READ_BUFFER, buffer->buffer_object));
+            GL_EXTCALL(glBindBuffer(GL_COPY_WRITE_BUFFER, *bo));
+            GL_EXTCALL(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset, 0, size));
+            GL_EXTCALL(glBindBufferRange(GL_UNIFORM_BUFFER, base + i, *bo, 0, size));
+            context->cb_copy_mask |= 1u << shader_type;
+            continue;
+        }
+        GL_EXTCALL(glBindBufferRange(GL_UNIFORM_BUFFER, base + i, buffer->buffer_object, offset, size));
     }
     checkGLcall("bind constant buffers");
 }
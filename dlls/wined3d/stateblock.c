@@ -484,6 +484,7 @@ void state_unbind_resources(struct wined3d_state *state)
             if ((buffer = state->cb[i][j]))
             {
                 state->cb[i][j] = NULL;
+                state->cb_offset[i][j] = state->cb_size[i][j] = 0;
                 wined3d_buffer_decref(buffer);
             }
         }
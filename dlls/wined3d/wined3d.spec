@@ -62,6 +62,7 @@
 @ cdecl wined3d_device_get_clip_status(ptr ptr)
 @ cdecl wined3d_device_get_compute_shader(ptr)
 @ cdecl wined3d_device_get_constant_buffer(ptr long long)
+@ cdecl wined3d_device_get_constant_buffer_range(ptr long long ptr ptr)
 @ cdecl wined3d_device_get_creation_parameters(ptr ptr)
 @ cdecl wined3d_device_get_cs_resource_view(ptr long)
 @ cdecl wined3d_device_get_cs_sampler(ptr long)
@@ -133,6 +134,7 @@
 @ cdecl wined3d_device_set_clip_status(ptr ptr)
 @ cdecl wined3d_device_set_compute_shader(ptr ptr)
 @ cdecl wined3d_device_set_constant_buffer(ptr long long ptr)
+@ cdecl wined3d_device_set_constant_buffer_range(ptr long long ptr long long)
 @ cdecl wined3d_device_set_cs_resource_view(ptr long ptr)
 @ cdecl wined3d_device_set_cs_sampler(ptr long ptr)
 @ cdecl wined3d_device_set_cs_uav(ptr long ptr long)
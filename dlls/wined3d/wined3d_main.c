@@ -91,6 +91,7 @@ struct wined3d_settings wined3d_settings =
     ~0U,            /* No PS shader model limit by default. */
     ~0u,            /* No CS shader model limit by default. */
     FALSE,          /* 3D support enabled by default. */
+    NULL,           /* No shader cache by default. */
 };
 
 struct wined3d * CDECL wined3d_create(DWORD flags)
@@ -313,6 +314,16 @@ static BOOL wined3d_dll_init(HINSTANCE hInstDLL)
             TRACE("Disabling 3D support.\n");
             wined3d_settings.no_3d = TRUE;
         }
+        if (!get_config_key(hkey, appkey, "ShaderCache", buffer, size) && *buffer)
+        {
+            size_t len = strlen(buffer) + 1;
+
+            if (!(wined3d_settings.shader_cache = heap_alloc(len)))
+                ERR("Failed to allocate shader cache path memory.\n");
+            else
+                memcpy(wined3d_settings.shader_cache, buffer, len);
+            TRACE("Using shader cache %s.\n", debugstr_a(wined3d_settings.shader_cache));
+        }
     }
 
     if (appkey) RegCloseKey( appkey );
@@ -345,6 +356,7 @@ static BOOL wined3d_dll_destroy(HINSTANCE hInstDLL)
     heap_free(wndproc_table.entries);
 
     heap_free(wined3d_settings.logo);
+    heap_free(wined3d_settings.shader_cache);
     UnregisterClassA(WINED3D_OPENGL_WINDOW_CLASS_NAME, hInstDLL);
 
     DeleteCriticalSection(&wined3d_wndproc_cs);
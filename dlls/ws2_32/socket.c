@@ -64,6 +64,9 @@
 #ifdef HAVE_SYS_UIO_H
 # include <sys/uio.h>
 #endif
+#ifdef HAVE_SYS_SENDFILE_H
+# include <sys/sendfile.h>
+#endif
 #ifdef HAVE_SYS_SOCKET_H
 #include <sys/socket.h>
 #endif
@@ -128,6 +131,9 @@
 #ifdef HAVE_SYS_POLL_H
 # include <sys/poll.h>
 #endif
+#ifdef HAVE_SYS_EPOLL_H
+# include <sys/epoll.h>
+#endif
 #ifdef HAVE_SYS_TIME_H
 # include <sys/time.h>
 #endif
@@ -157,6 +163,7 @@
 #include "wine/server.h"
 #include "wine/debug.h"
 #include "wine/exception.h"
+#include "wine/list.h"
 #include "wine/unicode.h"
 
 #if defined(linux) && !defined(IP_UNICAST_IF)
@@ -488,6 +495,14 @@ struct ws2_async_shutdown
     int                 type;
 };
 
+/* state of an overlapped operation with respect to batching */
+enum ws2_batch_state
+{
+    BATCH_NONE,     /* not in a pending list */
+    BATCH_QUEUED,   /* in the pending list of its socket */
+    BATCH_DONE      /* done as part of another batch, result not yet reported */
+};
+
 struct ws2_async
 {
     struct ws2_async_io                 io;
@@ -504,6 +519,10 @@ struct ws2_async
     DWORD                               flags;
     DWORD                              *lpFlags;
     WSABUF                             *control;
+    struct list                         batch_entry;
+    enum ws2_batch_state                batch_state;
+    NTSTATUS                            batch_status;
+    int                                 batch_result;
     unsigned int                        n_iovecs;
     unsigned int                        first_iovec;
     struct iovec                        iovec[1];
@@ -525,16 +544,17 @@ struct ws2_accept_async
 
 struct ws2_transmitfile_async
 {
-    struct ws2_async_io   io;
-    char                  *buffer;
-    HANDLE                file;
-    DWORD                 file_read;
-    DWORD                 file_bytes;
-    DWORD                 bytes_per_send;
-    TRANSMIT_FILE_BUFFERS buffers;
-    DWORD                 flags;
-    LARGE_INTEGER         offset;
-    struct ws2_async      write;
+    struct ws2_async_io       io;
+    char                     *buffer;
+    TRANSMIT_PACKETS_ELEMENT *elements;
+    DWORD                     n_elements;
+    DWORD                     cur_element;
+    DWORD                     file_read;
+    DWORD                     bytes_per_send;
+    DWORD                     flags;
+    LARGE_INTEGER             offset;
+    BOOL                      use_sendfile;
+    struct ws2_async          write;
 };
 
 static struct ws2_async_io *async_io_freelist;
@@ -606,6 +626,8 @@ typedef struct          /* WSAAsyncSelect() control struct */
 #define WS_MAX_UDP_DATAGRAM             1024
 static INT WINAPI WSA_DefaultBlockingHook( FARPROC x );
 
+struct poll_set;
+
 /* hostent's, servent's and protent's are stored in one buffer per thread,
  * as documented on MSDN for the functions that return any of the buffers */
 struct per_thread_data
@@ -616,6 +638,7 @@ struct per_thread_data
     struct WS_protoent *pe_buffer;
     struct pollfd *fd_cache;
     unsigned int fd_count;
+    struct poll_set *poll_set;
     int he_len;
     int se_len;
     int pe_len;
@@ -643,6 +666,7 @@ int WSAIOCTL_GetInterfaceCount(void);
 int WSAIOCTL_GetInterfaceName(int intNumber, char *intName);
 
 static void WS_AddCompletion( SOCKET sock, ULONG_PTR CompletionValue, NTSTATUS CompletionStatus, ULONG Information );
+static void rio_stop_service_thread(void);
 
 #define MAP_OPTION(opt) { WS_##opt, opt }
 
@@ -1281,6 +1305,49 @@ static BOOL get_dont_fragment(SOCKET s, int level, BOOL *out)
     return value;
 }
 
+/* per-thread state kept between select/WSAPoll calls, indexed by unix fd */
+struct poll_set_entry
+{
+    SOCKET         socket;      /* socket owning the fd, 0 if the entry is unused */
+    unsigned int   tag;         /* tag of the epoll registration of the entry */
+    unsigned int   seq;         /* last poll call that used the entry */
+    unsigned short wanted;      /* poll events wanted by the current call */
+    unsigned short registered;  /* poll events registered in the epoll set */
+    unsigned short revents;     /* poll events returned by the current call */
+    char           in_epoll;    /* fd is registered in the epoll set */
+    char           bound;       /* socket is known to be bound */
+    int            type;        /* socket type, 0 if not known yet */
+};
+
+struct poll_set
+{
+    unsigned int           seq;        /* sequence number of the current poll call */
+    unsigned int           tag;        /* last tag given to an entry */
+    unsigned int           close_seq;  /* sequence number of the closed handles already seen */
+    struct poll_set_entry *entries;    /* entries indexed by unix fd */
+    unsigned int           size;       /* size of the entries array */
+    int                    epoll_fd;   /* epoll set, -1 if not created yet */
+    int                   *active;     /* fds registered in the epoll set */
+    unsigned int           active_count;
+    unsigned int           active_size;
+#ifdef HAVE_SYS_EPOLL_H
+    struct epoll_event    *events;     /* buffer for epoll_wait */
+    unsigned int           events_size;
+#endif
+};
+
+static void free_poll_set( struct poll_set *set )
+{
+    if (!set) return;
+    if (set->epoll_fd != -1) close( set->epoll_fd );
+    HeapFree( GetProcessHeap(), 0, set->entries );
+    HeapFree( GetProcessHeap(), 0, set->active );
+#ifdef HAVE_SYS_EPOLL_H
+    HeapFree( GetProcessHeap(), 0, set->events );
+#endif
+    HeapFree( GetProcessHeap(), 0, set );
+}
+
 static struct per_thread_data *get_per_thread_data(void)
 {
     struct per_thread_data * ptb = NtCurrentTeb()->WinSockData;
@@ -1304,6 +1371,7 @@ static void free_per_thread_data(void)
     HeapFree( GetProcessHeap(), 0, ptb->se_buffer );
     HeapFree( GetProcessHeap(), 0, ptb->pe_buffer );
     HeapFree( GetProcessHeap(), 0, ptb->fd_cache );
+    free_poll_set( ptb->poll_set );
 
     HeapFree( GetProcessHeap(), 0, ptb );
     NtCurrentTeb()->WinSockData = NULL;
@@ -1664,7 +1732,7 @@ int WINAPI WSAStartup(WORD wVersionRequested, LPWSADATA lpWSAData)
 INT WINAPI WSACleanup(void)
 {
     if (num_startup) {
-        num_startup--;
+        if (!--num_startup) rio_stop_service_thread();
         TRACE("pending cleanups: %d\n", num_startup);
         return 0;
     }
@@ -2396,6 +2464,327 @@ static int WS2_recv( int fd, struct ws2_async *wsa, int flags )
     return n;
 }
 
+/***********************************************************************
+ *     Batching of overlapped datagram I/O
+ *
+ * The server wakes up the overlapped receives and sends queued on a socket
+ * one at a time. On datagram sockets, the operation being woken up also
+ * handles the other ones pending on the same socket with a single
+ * recvmmsg/sendmmsg call, and they are all completed with one server request.
+ */
+
+#define MAX_BATCH_SIZE  32  /* must fit in the complete_socket_asyncs mask */
+#define BATCH_HASH_SIZE 64
+
+#ifndef HAVE_RECVMMSG
+struct mmsghdr
+{
+    struct msghdr msg_hdr;
+    unsigned int  msg_len;
+};
+#endif
+
+static int WS2_send( int fd, struct ws2_async *wsa, int flags );
+
+static struct list batch_queues[2][BATCH_HASH_SIZE];  /* pending reads and writes hashed by socket */
+
+static CRITICAL_SECTION batch_cs;
+static CRITICAL_SECTION_DEBUG batch_cs_debug =
+{
+    0, 0, &batch_cs,
+    { &batch_cs_debug.ProcessLocksList, &batch_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": batch_cs") }
+};
+static CRITICAL_SECTION batch_cs = { &batch_cs_debug, -1, 0, 0, 0, 0 };
+
+static int ws2_recvmmsg( int fd, struct mmsghdr *msgs, unsigned int count, int flags )
+{
+#ifdef HAVE_RECVMMSG
+    return recvmmsg( fd, msgs, count, flags, NULL );
+#else
+    unsigned int i;
+    int ret;
+
+    for (i = 0; i < count; i++)
+    {
+        if ((ret = recvmsg( fd, &msgs[i].msg_hdr, flags )) == -1) return i ? i : -1;
+        msgs[i].msg_len = ret;
+    }
+    return count;
+#endif
+}
+
+static int ws2_sendmmsg( int fd, struct mmsghdr *msgs, unsigned int count, int flags )
+{
+#ifdef HAVE_SENDMMSG
+    return sendmmsg( fd, msgs, count, flags );
+#else
+    unsigned int i;
+    int ret;
+
+    for (i = 0; i < count; i++)
+    {
+        if ((ret = sendmsg( fd, &msgs[i].msg_hdr, flags )) == -1) return i ? i : -1;
+        msgs[i].msg_len = ret;
+    }
+    return count;
+#endif
+}
+
+/* caller must hold batch_cs */
+static struct list *get_batch_queue( HANDLE socket, int type )
+{
+    struct list *queue = &batch_queues[type == ASYNC_TYPE_WRITE][((ULONG_PTR)socket >> 2) % BATCH_HASH_SIZE];
+
+    if (!queue->next) list_init( queue );
+    return queue;
+}
+
+/* queue an overlapped operation on the server, adding it to the pending list of its socket if it
+ * can be batched; holding the lock keeps other batches from doing its I/O before it is queued, and
+ * the callback can't run and free it before it is in the list */
+static NTSTATUS register_ws2_async( int type, struct ws2_async *wsa, BOOL batch, HANDLE event,
+                                    PIO_APC_ROUTINE apc, void *apc_context, IO_STATUS_BLOCK *io )
+{
+    NTSTATUS status;
+
+    if (!batch) return register_async( type, wsa->hSocket, &wsa->io, event, apc, apc_context, io );
+
+    EnterCriticalSection( &batch_cs );
+    list_add_tail( get_batch_queue( wsa->hSocket, type ), &wsa->batch_entry );
+    wsa->batch_state = BATCH_QUEUED;
+    status = register_async( type, wsa->hSocket, &wsa->io, event, apc, apc_context, io );
+    if (status != STATUS_PENDING)
+    {
+        list_remove( &wsa->batch_entry );
+        wsa->batch_state = BATCH_NONE;
+    }
+    LeaveCriticalSection( &batch_cs );
+    return status;
+}
+
+/* retrieve the result of an operation that has already been done by a batch */
+static BOOL batch_get_result( struct ws2_async *wsa, NTSTATUS *status, int *result )
+{
+    BOOL ret = FALSE;
+
+    if (wsa->batch_state == BATCH_NONE) return FALSE;
+
+    EnterCriticalSection( &batch_cs );
+    if (wsa->batch_state == BATCH_DONE)
+    {
+        *status = wsa->batch_status;
+        *result = wsa->batch_result;
+        wsa->batch_state = BATCH_NONE;
+        ret = TRUE;
+    }
+    LeaveCriticalSection( &batch_cs );
+    return ret;
+}
+
+/* remove a completed operation from the pending list */
+static void batch_remove_async( struct ws2_async *wsa )
+{
+    if (wsa->batch_state == BATCH_NONE) return;
+
+    EnterCriticalSection( &batch_cs );
+    if (wsa->batch_state == BATCH_QUEUED) list_remove( &wsa->batch_entry );
+    wsa->batch_state = BATCH_NONE;
+    LeaveCriticalSection( &batch_cs );
+}
+
+/* collect the operations that can be done together with wsa; caller must hold batch_cs */
+static unsigned int batch_collect( int fd, struct ws2_async *wsa, int type, struct ws2_async **batch )
+{
+    struct ws2_async *other;
+    unsigned int count = 0;
+    socklen_t len = sizeof(int);
+    int sock_type;
+
+    batch[count++] = wsa;
+    LIST_FOR_EACH_ENTRY( other, get_batch_queue( wsa->hSocket, type ), struct ws2_async, batch_entry )
+    {
+        if (other == wsa || other->hSocket != wsa->hSocket || other->flags != wsa->flags) continue;
+        batch[count++] = other;
+        if (count == MAX_BATCH_SIZE) break;
+    }
+    if (count > 1 && (getsockopt( fd, SOL_SOCKET, SO_TYPE, &sock_type, &len ) || sock_type != SOCK_DGRAM))
+        count = 1;
+    return count;
+}
+
+/* complete the other operations of a batch; caller must hold batch_cs
+ *
+ * The server reports their results right after the one of the operation that was woken up, once its
+ * callback returns, so that completions are posted in the order the operations were queued. */
+static void batch_complete( struct ws2_async **batch, const struct mmsghdr *msgs, unsigned int count, int type )
+{
+    struct async_result results[MAX_BATCH_SIZE];
+    unsigned int i, done = 0;
+
+    if (count <= 1) return;
+
+    for (i = 1; i < count; i++)
+    {
+        list_remove( &batch[i]->batch_entry );
+        results[i - 1].user   = wine_server_client_ptr( batch[i] );
+        results[i - 1].total  = msgs[i].msg_len;
+        results[i - 1].status = STATUS_SUCCESS;
+    }
+
+    SERVER_START_REQ( complete_socket_asyncs )
+    {
+        req->handle = wine_server_obj_handle( batch[0]->hSocket );
+        req->type   = type;
+        req->user   = wine_server_client_ptr( batch[0] );
+        wine_server_add_data( req, results, (count - 1) * sizeof(results[0]) );
+        if (!wine_server_call( req )) done = reply->done;
+    }
+    SERVER_END_REQ;
+
+    for (i = 1; i < count; i++)
+    {
+        struct ws2_async *other = batch[i];
+        IO_STATUS_BLOCK *iosb = other->user_overlapped ? (IO_STATUS_BLOCK *)other->user_overlapped
+                                                        : &other->local_iosb;
+
+        if (!(done & (1 << (i - 1))))
+        {
+            /* it was woken up in the meantime, its own callback reports the result */
+            other->batch_state  = BATCH_DONE;
+            other->batch_status = STATUS_SUCCESS;
+            other->batch_result = msgs[i].msg_len;
+            continue;
+        }
+        other->batch_state = BATCH_NONE;
+        iosb->Information  = msgs[i].msg_len;
+        iosb->u.Status     = STATUS_SUCCESS;
+        if (!other->completion_func) release_async_io( &other->io );
+    }
+}
+
+/***********************************************************************
+ *              WS2_recv_batch          (INTERNAL)
+ *
+ * Receive data for an overlapped recv() and all the others pending on the socket.
+ */
+static int WS2_recv_batch( int fd, struct ws2_async *wsa, int flags )
+{
+    union generic_unix_sockaddr addrs[MAX_BATCH_SIZE];
+    struct ws2_async *batch[MAX_BATCH_SIZE];
+    struct mmsghdr msgs[MAX_BATCH_SIZE];
+    unsigned int i, count;
+    int ret, err;
+
+    EnterCriticalSection( &batch_cs );
+    if (wsa->batch_state == BATCH_DONE)
+    {
+        /* done by another batch in the meantime */
+        wsa->batch_state = BATCH_NONE;
+        LeaveCriticalSection( &batch_cs );
+        return wsa->batch_result;
+    }
+    if ((count = batch_collect( fd, wsa, ASYNC_TYPE_READ, batch )) == 1)
+    {
+        LeaveCriticalSection( &batch_cs );
+        return WS2_recv( fd, wsa, flags );
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        memset( &msgs[i], 0, sizeof(msgs[i]) );
+        msgs[i].msg_hdr.msg_iov    = batch[i]->iovec + batch[i]->first_iovec;
+        msgs[i].msg_hdr.msg_iovlen = batch[i]->n_iovecs - batch[i]->first_iovec;
+        if (batch[i]->addr)
+        {
+            msgs[i].msg_hdr.msg_name    = &addrs[i];
+            msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+        }
+    }
+
+    while ((ret = ws2_recvmmsg( fd, msgs, count, flags )) == -1 && errno == EINTR) /* nothing */;
+    if (ret == -1)
+    {
+        err = errno;
+        LeaveCriticalSection( &batch_cs );
+        /* the buffers may be write watched, let the single recv handle that */
+        if (err == EFAULT) return WS2_recv( fd, wsa, flags );
+        errno = err;
+        return -1;
+    }
+
+    for (i = 0; i < ret; i++)
+    {
+        if (batch[i]->addr && msgs[i].msg_hdr.msg_namelen)
+            ws_sockaddr_u2ws( &addrs[i].addr, batch[i]->addr, batch[i]->addrlen.ptr );
+    }
+    batch_complete( batch, msgs, ret, ASYNC_TYPE_READ );
+    LeaveCriticalSection( &batch_cs );
+    return msgs[0].msg_len;
+}
+
+/***********************************************************************
+ *              WS2_send_batch          (INTERNAL)
+ *
+ * Send the data of an overlapped send() and all the others pending on the socket.
+ */
+static int WS2_send_batch( int fd, struct ws2_async *wsa, int flags )
+{
+    union generic_unix_sockaddr addrs[MAX_BATCH_SIZE];
+    struct ws2_async *batch[MAX_BATCH_SIZE];
+    struct mmsghdr msgs[MAX_BATCH_SIZE];
+    unsigned int i, count;
+    int ret, err;
+
+    EnterCriticalSection( &batch_cs );
+    if (wsa->batch_state == BATCH_DONE)
+    {
+        /* done by another batch in the meantime */
+        wsa->batch_state = BATCH_NONE;
+        wsa->first_iovec = wsa->n_iovecs;
+        LeaveCriticalSection( &batch_cs );
+        return wsa->batch_result;
+    }
+    if ((count = batch_collect( fd, wsa, ASYNC_TYPE_WRITE, batch )) == 1)
+    {
+        LeaveCriticalSection( &batch_cs );
+        return WS2_send( fd, wsa, flags );
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        memset( &msgs[i], 0, sizeof(msgs[i]) );
+        msgs[i].msg_hdr.msg_iov    = batch[i]->iovec + batch[i]->first_iovec;
+        msgs[i].msg_hdr.msg_iovlen = batch[i]->n_iovecs - batch[i]->first_iovec;
+        if (batch[i]->addr)
+        {
+            msgs[i].msg_hdr.msg_name    = &addrs[i];
+            msgs[i].msg_hdr.msg_namelen = ws_sockaddr_ws2u( batch[i]->addr, batch[i]->addrlen.val, &addrs[i] );
+            /* stop the batch before any address that can't be converted */
+            if (!msgs[i].msg_hdr.msg_namelen) break;
+        }
+    }
+    if (!i)
+    {
+        LeaveCriticalSection( &batch_cs );
+        return WS2_send( fd, wsa, flags );
+    }
+
+    while ((ret = ws2_sendmmsg( fd, msgs, i, flags )) == -1 && errno == EINTR) /* nothing */;
+    if (ret == -1)
+    {
+        err = errno;
+        LeaveCriticalSection( &batch_cs );
+        errno = err;
+        return -1;
+    }
+
+    wsa->first_iovec = wsa->n_iovecs;
+    batch_complete( batch, msgs, ret, ASYNC_TYPE_WRITE );
+    LeaveCriticalSection( &batch_cs );
+    return msgs[0].msg_len;
+}
+
 /***********************************************************************
  *              WS2_async_recv          (INTERNAL)
  *
@@ -2406,13 +2795,18 @@ static NTSTATUS WS2_async_recv( void *user, IO_STATUS_BLOCK *iosb, NTSTATUS stat
     struct ws2_async *wsa = user;
     int result = 0, fd;
 
+    if (batch_get_result( wsa, &status, &result )) goto done;
+
     switch (status)
     {
     case STATUS_ALERTED:
         if ((status = wine_server_handle_to_fd( wsa->hSocket, FILE_READ_DATA, &fd, NULL ) ))
             break;
 
-        result = WS2_recv( fd, wsa, convert_flags(wsa->flags) );
+        if (wsa->batch_state == BATCH_QUEUED)
+            result = WS2_recv_batch( fd, wsa, convert_flags(wsa->flags) );
+        else
+            result = WS2_recv( fd, wsa, convert_flags(wsa->flags) );
         wine_server_release_fd( wsa->hSocket, fd );
         if (result >= 0)
         {
@@ -2434,8 +2828,10 @@ static NTSTATUS WS2_async_recv( void *user, IO_STATUS_BLOCK *iosb, NTSTATUS stat
         }
         break;
     }
+done:
     if (status != STATUS_PENDING)
     {
+        batch_remove_async( wsa );
         iosb->u.Status = status;
         iosb->Information = result;
         if (!wsa->completion_func)
@@ -2619,6 +3015,12 @@ static NTSTATUS WS2_async_send( void *user, IO_STATUS_BLOCK *iosb, NTSTATUS stat
     struct ws2_async *wsa = user;
     int result = 0, fd;
 
+    if (batch_get_result( wsa, &status, &result ))
+    {
+        iosb->Information += result;
+        goto done;
+    }
+
     switch (status)
     {
     case STATUS_ALERTED:
@@ -2632,7 +3034,10 @@ static NTSTATUS WS2_async_send( void *user, IO_STATUS_BLOCK *iosb, NTSTATUS stat
             break;
 
         /* check to see if the data is ready (non-blocking) */
-        result = WS2_send( fd, wsa, convert_flags(wsa->flags) );
+        if (wsa->batch_state == BATCH_QUEUED)
+            result = WS2_send_batch( fd, wsa, convert_flags(wsa->flags) );
+        else
+            result = WS2_send( fd, wsa, convert_flags(wsa->flags) );
         wine_server_release_fd( wsa->hSocket, fd );
 
         if (result >= 0)
@@ -2654,8 +3059,10 @@ static NTSTATUS WS2_async_send( void *user, IO_STATUS_BLOCK *iosb, NTSTATUS stat
         }
         break;
     }
+done:
     if (status != STATUS_PENDING)
     {
+        batch_remove_async( wsa );
         iosb->u.Status = status;
         if (!wsa->completion_func)
             release_async_io( &wsa->io );
@@ -2857,6 +3264,7 @@ static BOOL WINAPI WS2_AcceptEx(SOCKET listener, SOCKET acceptor, PVOID dest, DW
         wsa->read->control     = NULL;
         wsa->read->n_iovecs    = 1;
         wsa->read->first_iovec = 0;
+        wsa->read->batch_state = BATCH_NONE;
         wsa->read->completion_func = NULL;
         wsa->read->iovec[0].iov_base = wsa->buf;
         wsa->read->iovec[0].iov_len  = wsa->data_len;
@@ -2922,6 +3330,87 @@ static NTSTATUS WS2_ReadFile(HANDLE hFile, PIO_STATUS_BLOCK io_status, char* buf
     return status;
 }
 
+/***********************************************************************
+ *     WS2_transmitfile_start_element   (INTERNAL)
+ *
+ * Reset the transfer state for the current element.
+ */
+static void WS2_transmitfile_start_element( struct ws2_transmitfile_async *wsa )
+{
+    TRANSMIT_PACKETS_ELEMENT *element;
+
+    wsa->file_read = 0;
+    if (wsa->cur_element >= wsa->n_elements) return;
+    element = &wsa->elements[wsa->cur_element];
+    if (!(element->dwElFlags & TP_ELEMENT_FILE)) return;
+    wsa->offset = element->u.s.nFileOffset;
+    if (wsa->offset.QuadPart == -1) wsa->offset.QuadPart = FILE_USE_FILE_POINTER_POSITION;
+}
+
+/***********************************************************************
+ *     WS2_transmitfile_sendfile        (INTERNAL)
+ *
+ * Send a file element directly from the page cache, without copying it
+ * through user space.
+ * Returns STATUS_NOT_SUPPORTED if the file can't be sent this way.
+ */
+static NTSTATUS WS2_transmitfile_sendfile( int fd, struct ws2_transmitfile_async *wsa,
+                                           TRANSMIT_PACKETS_ELEMENT *element )
+{
+#ifdef HAVE_SYS_SENDFILE_H
+    IO_STATUS_BLOCK *iosb = (IO_STATUS_BLOCK *)wsa->write.user_overlapped;
+    NTSTATUS status;
+    size_t count;
+    ssize_t ret;
+    off_t off;
+    int file_fd;
+
+    if ((status = wine_server_handle_to_fd( element->u.s.hFile, FILE_READ_DATA, &file_fd, NULL )))
+        return status;
+
+    for (;;)
+    {
+        count = 1 << 30;
+        if (element->cLength) count = min( count, element->cLength - wsa->file_read );
+        if (!count)
+        {
+            status = STATUS_SUCCESS;
+            break;
+        }
+        if (wsa->offset.QuadPart == FILE_USE_FILE_POINTER_POSITION)
+            ret = sendfile( fd, file_fd, NULL, count );
+        else
+        {
+            off = wsa->offset.QuadPart;
+            ret = sendfile( fd, file_fd, &off, count );
+        }
+        if (ret > 0)
+        {
+            wsa->file_read += ret;
+            if (wsa->offset.QuadPart != FILE_USE_FILE_POINTER_POSITION)
+                wsa->offset.QuadPart += ret;
+            if (iosb) iosb->Information += ret;
+            continue;
+        }
+        if (!ret)  /* end of file */
+        {
+            status = STATUS_SUCCESS;
+            break;
+        }
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN) status = STATUS_PENDING;
+        else if (errno == EINVAL || errno == ENOSYS) status = STATUS_NOT_SUPPORTED;
+        else status = wsaErrStatus();
+        break;
+    }
+
+    wine_server_release_fd( element->u.s.hFile, file_fd );
+    return status;
+#else
+    return STATUS_NOT_SUPPORTED;
+#endif
+}
+
 /***********************************************************************
  *     WS2_transmitfile_getbuffer       (INTERNAL)
  *
@@ -2933,61 +3422,69 @@ static NTSTATUS WS2_transmitfile_getbuffer( int fd, struct ws2_transmitfile_asyn
     if (wsa->write.first_iovec < wsa->write.n_iovecs)
         return STATUS_PENDING;
 
-    /* process the header (if applicable) */
-    if (wsa->buffers.Head)
-    {
-        wsa->write.first_iovec       = 0;
-        wsa->write.n_iovecs          = 1;
-        wsa->write.iovec[0].iov_base = wsa->buffers.Head;
-        wsa->write.iovec[0].iov_len  = wsa->buffers.HeadLength;
-        wsa->buffers.Head            = NULL;
-        return STATUS_PENDING;
-    }
-
-    /* process the main file */
-    if (wsa->file)
+    while (wsa->cur_element < wsa->n_elements)
     {
+        TRANSMIT_PACKETS_ELEMENT *element = &wsa->elements[wsa->cur_element];
         DWORD bytes_per_send = wsa->bytes_per_send;
         IO_STATUS_BLOCK iosb;
         NTSTATUS status;
 
+        if (!(element->dwElFlags & TP_ELEMENT_FILE))
+        {
+            wsa->cur_element++;
+            WS2_transmitfile_start_element( wsa );
+            if (!element->cLength) continue;
+            wsa->write.first_iovec       = 0;
+            wsa->write.n_iovecs          = 1;
+            wsa->write.iovec[0].iov_base = element->u.pBuffer;
+            wsa->write.iovec[0].iov_len  = element->cLength;
+            return STATUS_PENDING;
+        }
+
+        if (wsa->use_sendfile)
+        {
+            status = WS2_transmitfile_sendfile( fd, wsa, element );
+            if (status == STATUS_SUCCESS)
+            {
+                wsa->cur_element++;
+                WS2_transmitfile_start_element( wsa );
+                continue;
+            }
+            if (status != STATUS_NOT_SUPPORTED) return status;
+            wsa->use_sendfile = FALSE;  /* fall back to copying the data */
+        }
+
         iosb.Information = 0;
         /* when the size of the transfer is limited ensure that we don't go past that limit */
-        if (wsa->file_bytes != 0)
-            bytes_per_send = min(bytes_per_send, wsa->file_bytes - wsa->file_read);
-        status = WS2_ReadFile( wsa->file, &iosb, wsa->buffer, bytes_per_send, &wsa->offset );
+        if (element->cLength != 0)
+            bytes_per_send = min(bytes_per_send, element->cLength - wsa->file_read);
+        status = WS2_ReadFile( element->u.s.hFile, &iosb, wsa->buffer, bytes_per_send, &wsa->offset );
         if (wsa->offset.QuadPart != FILE_USE_FILE_POINTER_POSITION)
             wsa->offset.QuadPart += iosb.Information;
         if (status == STATUS_END_OF_FILE)
-            wsa->file = NULL; /* continue on to the footer */
-        else if (status != STATUS_SUCCESS)
-            return status;
-        else
         {
-            if (iosb.Information)
-            {
-                wsa->write.first_iovec       = 0;
-                wsa->write.n_iovecs          = 1;
-                wsa->write.iovec[0].iov_base = wsa->buffer;
-                wsa->write.iovec[0].iov_len  = iosb.Information;
-                wsa->file_read += iosb.Information;
-            }
-
-            if (wsa->file_bytes != 0 && wsa->file_read >= wsa->file_bytes)
-                wsa->file = NULL;
+            /* continue on to the next element */
+            wsa->cur_element++;
+            WS2_transmitfile_start_element( wsa );
+            continue;
+        }
+        if (status != STATUS_SUCCESS)
+            return status;
 
-            return STATUS_PENDING;
+        if (iosb.Information)
+        {
+            wsa->write.first_iovec       = 0;
+            wsa->write.n_iovecs          = 1;
+            wsa->write.iovec[0].iov_base = wsa->buffer;
+            wsa->write.iovec[0].iov_len  = iosb.Information;
+            wsa->file_read += iosb.Information;
         }
-    }
 
-    /* send the footer (if applicable) */
-    if (wsa->buffers.Tail)
-    {
-        wsa->write.first_iovec       = 0;
-        wsa->write.n_iovecs          = 1;
-        wsa->write.iovec[0].iov_base = wsa->buffers.Tail;
-        wsa->write.iovec[0].iov_len  = wsa->buffers.TailLength;
-        wsa->buffers.Tail            = NULL;
+        if (element->cLength != 0 && wsa->file_read >= element->cLength)
+        {
+            wsa->cur_element++;
+            WS2_transmitfile_start_element( wsa );
+        }
         return STATUS_PENDING;
     }
 
@@ -3004,7 +3501,7 @@ static NTSTATUS WS2_transmitfile_base( int fd, struct ws2_transmitfile_async *ws
     NTSTATUS status;
 
     status = WS2_transmitfile_getbuffer( fd, wsa );
-    if (status == STATUS_PENDING)
+    if (status == STATUS_PENDING && wsa->write.first_iovec < wsa->write.n_iovecs)
     {
         IO_STATUS_BLOCK *iosb = (IO_STATUS_BLOCK *)wsa->write.user_overlapped;
         int n;
@@ -3048,109 +3545,976 @@ static NTSTATUS WS2_async_transmitfile( void *user, IO_STATUS_BLOCK *iosb, NTSTA
 }
 
 /***********************************************************************
- *     TransmitFile
+ *     WS2_transmit_elements            (INTERNAL)
+ *
+ * Shared implementation of TransmitFile and TransmitPackets.
+ */
+static BOOL WS2_transmit_elements( SOCKET s, int fd, const TRANSMIT_PACKETS_ELEMENT *elements, DWORD count,
+                                   DWORD bytes_per_send, LPOVERLAPPED overlapped, DWORD flags )
+{
+    struct ws2_transmitfile_async *wsa;
+    NTSTATUS status;
+
+    /* set reasonable defaults when requested */
+    if (!bytes_per_send)
+        bytes_per_send = (1 << 16); /* Depends on OS version: PAGE_SIZE, 2*PAGE_SIZE, or 2^16 */
+
+    if (!(wsa = (struct ws2_transmitfile_async *)alloc_async_io( sizeof(*wsa) + count * sizeof(*elements)
+                                                                 + bytes_per_send,
+                                                                 WS2_async_transmitfile )))
+    {
+        release_sock_fd( s, fd );
+        WSASetLastError( WSAEFAULT );
+        return FALSE;
+    }
+    wsa->elements              = (TRANSMIT_PACKETS_ELEMENT *)(wsa + 1);
+    wsa->n_elements            = count;
+    wsa->cur_element           = 0;
+    wsa->buffer                = (char *)(wsa->elements + count);
+    wsa->bytes_per_send        = bytes_per_send;
+    wsa->flags                 = flags;
+    wsa->use_sendfile          = TRUE;
+    wsa->write.hSocket         = SOCKET2HANDLE(s);
+    wsa->write.addr            = NULL;
+    wsa->write.addrlen.val     = 0;
+    wsa->write.flags           = 0;
+    wsa->write.lpFlags         = &wsa->flags;
+    wsa->write.control         = NULL;
+    wsa->write.n_iovecs        = 0;
+    wsa->write.first_iovec     = 0;
+    wsa->write.user_overlapped = overlapped;
+    memcpy( wsa->elements, elements, count * sizeof(*elements) );
+    WS2_transmitfile_start_element( wsa );
+
+    if (overlapped)
+    {
+        IO_STATUS_BLOCK *iosb = (IO_STATUS_BLOCK *)overlapped;
+        int status;
+
+        iosb->u.Status = STATUS_PENDING;
+        iosb->Information = 0;
+        status = register_async( ASYNC_TYPE_WRITE, SOCKET2HANDLE(s), &wsa->io,
+                                 overlapped->hEvent, NULL, NULL, iosb );
+        if(status != STATUS_PENDING) HeapFree( GetProcessHeap(), 0, wsa );
+        release_sock_fd( s, fd );
+        WSASetLastError( NtStatusToWSAError(status) );
+        return FALSE;
+    }
+
+    do
+    {
+        status = WS2_transmitfile_base( fd, wsa );
+        if (status == STATUS_PENDING)
+        {
+            /* block here */
+            do_block(fd, POLLOUT, -1);
+            _sync_sock_state(s); /* let wineserver notice connection */
+        }
+    }
+    while (status == STATUS_PENDING);
+    release_sock_fd( s, fd );
+
+    if (status != STATUS_SUCCESS)
+        WSASetLastError( NtStatusToWSAError(status) );
+    HeapFree( GetProcessHeap(), 0, wsa );
+    return (status == STATUS_SUCCESS);
+}
+
+/***********************************************************************
+ *     TransmitFile
+ */
+static BOOL WINAPI WS2_TransmitFile( SOCKET s, HANDLE h, DWORD file_bytes, DWORD bytes_per_send,
+                                     LPOVERLAPPED overlapped, LPTRANSMIT_FILE_BUFFERS buffers,
+                                     DWORD flags )
+{
+    union generic_unix_sockaddr uaddr;
+    socklen_t uaddrlen = sizeof(uaddr);
+    TRANSMIT_PACKETS_ELEMENT elements[3];
+    DWORD count = 0;
+    int fd;
+
+    TRACE("(%lx, %p, %d, %d, %p, %p, %d)\n", s, h, file_bytes, bytes_per_send, overlapped,
+            buffers, flags );
+
+    fd = get_sock_fd( s, FILE_WRITE_DATA, NULL );
+    if (fd == -1)
+    {
+        WSASetLastError( WSAENOTSOCK );
+        return FALSE;
+    }
+    if (getpeername( fd, &uaddr.addr, &uaddrlen ) != 0)
+    {
+        release_sock_fd( s, fd );
+        WSASetLastError( WSAENOTCONN );
+        return FALSE;
+    }
+    if (flags)
+        FIXME("Flags are not currently supported (0x%x).\n", flags);
+
+    if (h && GetFileType( h ) != FILE_TYPE_DISK)
+    {
+        FIXME("Non-disk file handles are not currently supported.\n");
+        release_sock_fd( s, fd );
+        WSASetLastError( WSAEOPNOTSUPP );
+        return FALSE;
+    }
+
+    if (buffers && buffers->Head)
+    {
+        elements[count].dwElFlags = TP_ELEMENT_MEMORY;
+        elements[count].cLength   = buffers->HeadLength;
+        elements[count].u.pBuffer = buffers->Head;
+        count++;
+    }
+    if (h)
+    {
+        elements[count].dwElFlags = TP_ELEMENT_FILE;
+        elements[count].cLength   = file_bytes;
+        elements[count].u.s.hFile = h;
+        if (overlapped)
+        {
+            elements[count].u.s.nFileOffset.u.LowPart  = overlapped->u.s.Offset;
+            elements[count].u.s.nFileOffset.u.HighPart = overlapped->u.s.OffsetHigh;
+        }
+        else elements[count].u.s.nFileOffset.QuadPart = FILE_USE_FILE_POINTER_POSITION;
+        count++;
+    }
+    if (buffers && buffers->Tail)
+    {
+        elements[count].dwElFlags = TP_ELEMENT_MEMORY;
+        elements[count].cLength   = buffers->TailLength;
+        elements[count].u.pBuffer = buffers->Tail;
+        count++;
+    }
+
+    return WS2_transmit_elements( s, fd, elements, count, bytes_per_send, overlapped, flags );
+}
+
+/***********************************************************************
+ *     TransmitPackets
+ */
+static BOOL WINAPI WS2_TransmitPackets( SOCKET s, LPTRANSMIT_PACKETS_ELEMENT elements, DWORD count,
+                                        DWORD send_size, LPOVERLAPPED overlapped, DWORD flags )
+{
+    union generic_unix_sockaddr uaddr;
+    socklen_t uaddrlen = sizeof(uaddr);
+    DWORD i;
+    int fd;
+
+    TRACE("(%lx, %p, %u, %u, %p, %#x)\n", s, elements, count, send_size, overlapped, flags );
+
+    if (count && !elements)
+    {
+        WSASetLastError( WSAEINVAL );
+        return FALSE;
+    }
+    for (i = 0; i < count; i++)
+    {
+        if (!(elements[i].dwElFlags & (TP_ELEMENT_MEMORY | TP_ELEMENT_FILE)) ||
+            (elements[i].dwElFlags & (TP_ELEMENT_MEMORY | TP_ELEMENT_FILE)) == (TP_ELEMENT_MEMORY | TP_ELEMENT_FILE))
+        {
+            WSASetLastError( WSAEINVAL );
+            return FALSE;
+        }
+        if ((elements[i].dwElFlags & TP_ELEMENT_FILE) && GetFileType( elements[i].u.s.hFile ) != FILE_TYPE_DISK)
+        {
+            FIXME("Non-disk file handles are not currently supported.\n");
+            WSASetLastError( WSAEOPNOTSUPP );
+            return FALSE;
+        }
+    }
+
+    fd = get_sock_fd( s, FILE_WRITE_DATA, NULL );
+    if (fd == -1)
+    {
+        WSASetLastError( WSAENOTSOCK );
+        return FALSE;
+    }
+    if (getpeername( fd, &uaddr.addr, &uaddrlen ) != 0)
+    {
+        release_sock_fd( s, fd );
+        WSASetLastError( WSAENOTCONN );
+        return FALSE;
+    }
+    if (flags)
+        FIXME("Flags are not currently supported (0x%x).\n", flags);
+
+    return WS2_transmit_elements( s, fd, elements, count, send_size, overlapped, flags );
+}
+
+/***********************************************************************
+ *     Registered I/O
+ *
+ * Requests are sent and received in batches with sendmmsg/recvmmsg on a
+ * private copy of the socket unix fd, without any server round trip.
+ * Requests that can't complete right away are picked up by a service
+ * thread polling the sockets of all the request queues.
+ */
+
+#define RIO_BATCH_SIZE 32
+
+struct rio_buffer
+{
+    char  *base;
+    DWORD  size;
+};
+
+struct rio_cq
+{
+    RIO_NOTIFICATION_COMPLETION notify;
+    BOOL       has_notify;  /* notify is valid */
+    BOOL       armed;       /* RIONotify has been called */
+    RIORESULT *results;
+    DWORD      size;        /* size of the results ring */
+    DWORD      head;        /* first queued result */
+    DWORD      count;       /* number of queued results */
+    DWORD      reserved;    /* queued results and outstanding requests */
+};
+
+struct rio_op
+{
+    char               *data;
+    ULONG               len;
+    ULONG               done;       /* bytes already sent */
+    struct WS_sockaddr *addr;       /* remote address for RIOReceiveEx/RIOSendEx */
+    int                 addrlen;
+    DWORD               flags;
+    PVOID               context;
+};
+
+struct rio_op_queue
+{
+    struct rio_op *ops;
+    ULONG          size;        /* size of the ops ring */
+    ULONG          head;        /* first outstanding request */
+    ULONG          count;       /* number of outstanding requests */
+    ULONG          committed;   /* number of requests that aren't deferred */
+};
+
+struct rio_rq
+{
+    struct list         entry;      /* entry in rio_queues */
+    SOCKET              socket;
+    int                 fd;         /* private unix fd of the socket */
+    ULONGLONG           context;
+    struct rio_cq      *recv_cq;
+    struct rio_cq      *send_cq;
+    struct rio_op_queue recv;
+    struct rio_op_queue send;
+    short               watched;    /* events polled by the service thread */
+    BOOL                stream;     /* stream socket, sends must not be reordered */
+    LONG                error;      /* error of a failed socket, it isn't polled anymore */
+};
+
+static struct list rio_queues = LIST_INIT( rio_queues );
+static unsigned int rio_generation;  /* incremented every time a request queue is freed */
+static int rio_wake_pipe[2] = { -1, -1 };
+static HANDLE rio_thread;
+static BOOL rio_thread_stop;
+
+static CRITICAL_SECTION rio_cs;
+static CRITICAL_SECTION_DEBUG rio_cs_debug =
+{
+    0, 0, &rio_cs,
+    { &rio_cs_debug.ProcessLocksList, &rio_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": rio_cs") }
+};
+static CRITICAL_SECTION rio_cs = { &rio_cs_debug, -1, 0, 0, 0, 0 };
+
+static inline struct rio_op *rio_get_op( struct rio_op_queue *queue, ULONG index )
+{
+    return &queue->ops[(queue->head + index) % queue->size];
+}
+
+/* resize a ring of requests; caller must hold rio_cs */
+static BOOL rio_resize_op_queue( struct rio_op_queue *queue, ULONG size )
+{
+    struct rio_op *ops;
+    ULONG i;
+
+    if (size < queue->count) return FALSE;
+    if (!(ops = HeapAlloc( GetProcessHeap(), 0, size * sizeof(*ops) ))) return FALSE;
+    for (i = 0; i < queue->count; i++) ops[i] = *rio_get_op( queue, i );
+    HeapFree( GetProcessHeap(), 0, queue->ops );
+    queue->ops  = ops;
+    queue->size = size;
+    queue->head = 0;
+    return TRUE;
+}
+
+/* signal the completion queue notification; caller must hold rio_cs */
+static void rio_signal_cq( struct rio_cq *cq )
+{
+    if (!cq->armed) return;
+    cq->armed = FALSE;
+    if (cq->notify.Type == RIO_EVENT_COMPLETION)
+        SetEvent( cq->notify.u.Event.EventHandle );
+    else
+        PostQueuedCompletionStatus( cq->notify.u.Iocp.IocpHandle, 0,
+                                    (ULONG_PTR)cq->notify.u.Iocp.CompletionKey,
+                                    cq->notify.u.Iocp.Overlapped );
+}
+
+/* complete the first outstanding request of a queue; caller must hold rio_cs */
+static void rio_complete_op( struct rio_rq *rq, struct rio_cq *cq, struct rio_op_queue *queue,
+                             LONG status, ULONG bytes )
+{
+    struct rio_op *op = rio_get_op( queue, 0 );
+    RIORESULT *result = &cq->results[(cq->head + cq->count) % cq->size];
+
+    result->Status           = status;
+    result->BytesTransferred = bytes;
+    result->SocketContext    = rq->context;
+    result->RequestContext   = (ULONG_PTR)op->context;
+    cq->count++;
+
+    queue->head = (queue->head + 1) % queue->size;
+    queue->count--;
+    queue->committed--;
+    if (!(op->flags & RIO_MSG_DONT_NOTIFY)) rio_signal_cq( cq );
+}
+
+/* complete all the committed requests of a failed socket; caller must hold rio_cs */
+static void rio_fail_ops( struct rio_rq *rq )
+{
+    while (rq->recv.committed) rio_complete_op( rq, rq->recv_cq, &rq->recv, rq->error, 0 );
+    while (rq->send.committed) rio_complete_op( rq, rq->send_cq, &rq->send, rq->error, 0 );
+}
+
+/* receive data for as many committed requests as possible; caller must hold rio_cs */
+static void rio_process_recv( struct rio_rq *rq )
+{
+    union generic_unix_sockaddr addrs[RIO_BATCH_SIZE];
+    struct mmsghdr msgs[RIO_BATCH_SIZE];
+    struct iovec iov[RIO_BATCH_SIZE];
+    struct rio_op *op;
+    unsigned int i, count;
+    int ret;
+
+    while (rq->recv.committed)
+    {
+        count = min( rq->recv.committed, RIO_BATCH_SIZE );
+        for (i = 0; i < count; i++)
+        {
+            op = rio_get_op( &rq->recv, i );
+            iov[i].iov_base = op->data;
+            iov[i].iov_len  = op->len;
+            memset( &msgs[i], 0, sizeof(msgs[i]) );
+            msgs[i].msg_hdr.msg_iov    = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            if (op->addr)
+            {
+                msgs[i].msg_hdr.msg_name    = &addrs[i];
+                msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+            }
+        }
+
+        if ((ret = ws2_recvmmsg( rq->fd, msgs, count, MSG_DONTWAIT )) == -1)
+        {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN) break;
+            rio_complete_op( rq, rq->recv_cq, &rq->recv, sock_get_error( errno ), 0 );
+            continue;
+        }
+
+        for (i = 0; i < ret; i++)
+        {
+            op = rio_get_op( &rq->recv, 0 );
+            if (op->addr && msgs[i].msg_hdr.msg_namelen)
+                ws_sockaddr_u2ws( &addrs[i].addr, op->addr, &op->addrlen );
+            rio_complete_op( rq, rq->recv_cq, &rq->recv,
+                             (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) ? WSAEMSGSIZE : 0, msgs[i].msg_len );
+        }
+        if (ret < count) break;
+    }
+}
+
+/* send data for as many committed requests as possible; caller must hold rio_cs */
+static void rio_process_send( struct rio_rq *rq )
+{
+    union generic_unix_sockaddr addrs[RIO_BATCH_SIZE];
+    struct mmsghdr msgs[RIO_BATCH_SIZE];
+    struct iovec iov[RIO_BATCH_SIZE];
+    struct rio_op *op;
+    unsigned int i, count, len;
+    int ret;
+
+    while (rq->send.committed)
+    {
+        /* a partial write on a stream socket must be completed before
+         * anything else is sent, so send the requests one at a time */
+        count = rq->stream ? 1 : min( rq->send.committed, RIO_BATCH_SIZE );
+        for (i = 0; i < count; i++)
+        {
+            op = rio_get_op( &rq->send, i );
+            iov[i].iov_base = op->data + op->done;
+            iov[i].iov_len  = op->len - op->done;
+            memset( &msgs[i], 0, sizeof(msgs[i]) );
+            msgs[i].msg_hdr.msg_iov    = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            if (op->addr && (len = ws_sockaddr_ws2u( op->addr, op->addrlen, &addrs[i] )))
+            {
+                msgs[i].msg_hdr.msg_name    = &addrs[i];
+                msgs[i].msg_hdr.msg_namelen = len;
+            }
+        }
+
+        if ((ret = ws2_sendmmsg( rq->fd, msgs, count, MSG_DONTWAIT )) == -1)
+        {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN) break;
+            rio_complete_op( rq, rq->send_cq, &rq->send, sock_get_error( errno ), 0 );
+            continue;
+        }
+
+        for (i = 0; i < ret; i++)
+        {
+            op = rio_get_op( &rq->send, 0 );
+            if (msgs[i].msg_len < iov[i].iov_len)
+            {
+                /* partial write on a stream socket, it is the only request
+                 * sent in the batch; wait until we can send the rest */
+                op->done += msgs[i].msg_len;
+                return;
+            }
+            rio_complete_op( rq, rq->send_cq, &rq->send, 0, op->done + msgs[i].msg_len );
+        }
+        if (ret < count) break;
+    }
+}
+
+/* make sure the service thread polls for the pending requests; caller must hold rio_cs */
+static void rio_update_watch( struct rio_rq *rq )
+{
+    short events = 0;
+    char dummy = 0;
+
+    if (rq->recv.committed) events |= POLLIN;
+    if (rq->send.committed) events |= POLLOUT;
+    if (!(events & ~rq->watched)) return;
+    if (write( rio_wake_pipe[1], &dummy, 1 ) == -1 && errno != EAGAIN)
+        ERR( "failed to wake the service thread: %s\n", strerror( errno ) );
+}
+
+/* complete the remaining requests of a socket reported as failed by poll; caller must hold rio_cs */
+static void rio_check_error( struct rio_rq *rq, short revents )
+{
+    int error = 0;
+    socklen_t len = sizeof(error);
+
+    if (!(revents & (POLLERR | POLLHUP | POLLNVAL))) return;
+    if (!rq->recv.committed && !rq->send.committed) return;
+    if (revents & POLLNVAL) error = EBADF;
+    else if (getsockopt( rq->fd, SOL_SOCKET, SO_ERROR, &error, &len ) == -1) error = errno;
+    rq->error = error ? sock_get_error( error ) : WSAECONNRESET;
+    WARN( "socket %04lx failed, error %d\n", rq->socket, rq->error );
+    rio_fail_ops( rq );
+}
+
+static DWORD WINAPI rio_service_thread( void *arg )
+{
+    HMODULE module = arg;
+    struct pollfd *pfd = NULL;
+    struct rio_rq **queues = NULL, *rq;
+    unsigned int i, count, size = 0, generation;
+    char dummy[64];
+
+    for (;;)
+    {
+        EnterCriticalSection( &rio_cs );
+        if (rio_thread_stop)
+        {
+            LeaveCriticalSection( &rio_cs );
+            break;
+        }
+        count = list_count( &rio_queues ) + 1;
+        if (count > size)
+        {
+            HeapFree( GetProcessHeap(), 0, pfd );
+            HeapFree( GetProcessHeap(), 0, queues );
+            size = max( count, size * 2 );
+            pfd = HeapAlloc( GetProcessHeap(), 0, size * sizeof(*pfd) );
+            queues = HeapAlloc( GetProcessHeap(), 0, size * sizeof(*queues) );
+        }
+        pfd[0].fd = rio_wake_pipe[0];
+        pfd[0].events = POLLIN;
+        count = 1;
+        LIST_FOR_EACH_ENTRY( rq, &rio_queues, struct rio_rq, entry )
+        {
+            rq->watched = 0;
+            if (rq->error) continue;
+            if (rq->recv.committed) rq->watched |= POLLIN;
+            if (rq->send.committed) rq->watched |= POLLOUT;
+            if (!rq->watched) continue;
+            pfd[count].fd = rq->fd;
+            pfd[count].events = rq->watched;
+            queues[count++] = rq;
+        }
+        generation = rio_generation;
+        LeaveCriticalSection( &rio_cs );
+
+        if (poll( pfd, count, -1 ) <= 0) continue;
+        if (pfd[0].revents) while (read( rio_wake_pipe[0], dummy, sizeof(dummy) ) > 0) /* nothing */;
+
+        EnterCriticalSection( &rio_cs );
+        if (generation == rio_generation)
+        {
+            for (i = 1; i < count; i++)
+            {
+                if (pfd[i].revents & (POLLIN | POLLERR | POLLHUP)) rio_process_recv( queues[i] );
+                if (pfd[i].revents & (POLLOUT | POLLERR | POLLHUP)) rio_process_send( queues[i] );
+                rio_check_error( queues[i], pfd[i].revents );
+            }
+        }
+        LeaveCriticalSection( &rio_cs );
+    }
+
+    HeapFree( GetProcessHeap(), 0, pfd );
+    HeapFree( GetProcessHeap(), 0, queues );
+    FreeLibraryAndExitThread( module, 0 );
+}
+
+/* start the service thread if needed; caller must hold rio_cs */
+static BOOL rio_start_service_thread(void)
+{
+    HMODULE module;
+
+    if (rio_thread) return TRUE;
+    if (pipe( rio_wake_pipe ) == -1) return FALSE;
+    fcntl( rio_wake_pipe[0], F_SETFL, O_NONBLOCK );
+    fcntl( rio_wake_pipe[1], F_SETFL, O_NONBLOCK );
+    /* the thread keeps the module loaded until it is stopped */
+    GetModuleHandleExW( GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, (const WCHAR *)rio_service_thread, &module );
+    rio_thread_stop = FALSE;
+    if (!(rio_thread = CreateThread( NULL, 0, rio_service_thread, module, 0, NULL )))
+    {
+        FreeLibrary( module );
+        close( rio_wake_pipe[0] );
+        close( rio_wake_pipe[1] );
+        rio_wake_pipe[0] = rio_wake_pipe[1] = -1;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* stop the service thread, called when winsock is cleaned up */
+static void rio_stop_service_thread(void)
+{
+    HANDLE thread;
+    char dummy = 0;
+
+    EnterCriticalSection( &rio_cs );
+    if (!(thread = rio_thread))
+    {
+        LeaveCriticalSection( &rio_cs );
+        return;
+    }
+    rio_thread = NULL;
+    rio_thread_stop = TRUE;
+    write( rio_wake_pipe[1], &dummy, 1 );
+    LeaveCriticalSection( &rio_cs );
+
+    WaitForSingleObject( thread, INFINITE );
+    CloseHandle( thread );
+    close( rio_wake_pipe[0] );
+    close( rio_wake_pipe[1] );
+    rio_wake_pipe[0] = rio_wake_pipe[1] = -1;
+}
+
+/* free the request queue of a socket being closed */
+static void rio_close_socket( SOCKET s )
+{
+    struct rio_rq *rq;
+
+    EnterCriticalSection( &rio_cs );
+    LIST_FOR_EACH_ENTRY( rq, &rio_queues, struct rio_rq, entry )
+    {
+        if (rq->socket != s) continue;
+        list_remove( &rq->entry );
+        rq->recv_cq->reserved -= rq->recv.count;
+        rq->send_cq->reserved -= rq->send.count;
+        close( rq->fd );
+        HeapFree( GetProcessHeap(), 0, rq->recv.ops );
+        HeapFree( GetProcessHeap(), 0, rq->send.ops );
+        HeapFree( GetProcessHeap(), 0, rq );
+        rio_generation++;
+        break;
+    }
+    LeaveCriticalSection( &rio_cs );
+}
+
+/* get a pointer to the data of a RIO buffer slice, NULL if invalid */
+static char *rio_get_buffer( const RIO_BUF *buf )
+{
+    struct rio_buffer *buffer = (struct rio_buffer *)buf->BufferId;
+
+    if (!buffer || buf->BufferId == RIO_INVALID_BUFFERID) return NULL;
+    if (buf->Offset > buffer->size || buf->Length > buffer->size - buf->Offset) return NULL;
+    return buffer->base + buf->Offset;
+}
+
+/* queue and process a RIO request */
+static BOOL rio_submit( RIO_RQ handle, BOOL send, const RIO_BUF *data, ULONG count,
+                        const RIO_BUF *addr, DWORD flags, PVOID context )
+{
+    struct rio_rq *rq = (struct rio_rq *)handle;
+    struct rio_op_queue *queue;
+    struct rio_cq *cq;
+    struct rio_op *op;
+    DWORD err = 0;
+
+    if (!rq || (flags & ~(RIO_MSG_DONT_NOTIFY | RIO_MSG_DEFER | RIO_MSG_WAITALL | RIO_MSG_COMMIT_ONLY)))
+    {
+        SetLastError( WSAEINVAL );
+        return FALSE;
+    }
+    if (flags & RIO_MSG_WAITALL) FIXME( "RIO_MSG_WAITALL not supported\n" );
+
+    queue = send ? &rq->send : &rq->recv;
+    cq = send ? rq->send_cq : rq->recv_cq;
+
+    EnterCriticalSection( &rio_cs );
+    if (!(flags & RIO_MSG_COMMIT_ONLY))
+    {
+        if (count != 1 || !data) err = WSAEINVAL;
+        else if (queue->count == queue->size || cq->reserved == cq->size) err = WSAENOBUFS;
+        else
+        {
+            op = rio_get_op( queue, queue->count );
+            if (!(op->data = rio_get_buffer( data ))) err = WSAEINVAL;
+            op->len     = data->Length;
+            op->addr    = NULL;
+            op->addrlen = 0;
+            op->done    = 0;
+            op->flags   = flags;
+            op->context = context;
+            if (addr && !(op->addr = (struct WS_sockaddr *)rio_get_buffer( addr ))) err = WSAEINVAL;
+            else if (addr) op->addrlen = addr->Length;
+            if (!err)
+            {
+                queue->count++;
+                cq->reserved++;
+            }
+        }
+    }
+    if (!err && !(flags & RIO_MSG_DEFER))
+    {
+        queue->committed = queue->count;
+        if (rq->error) rio_fail_ops( rq );
+        else
+        {
+            if (send) rio_process_send( rq );
+            else rio_process_recv( rq );
+            rio_update_watch( rq );
+        }
+    }
+    LeaveCriticalSection( &rio_cs );
+
+    if (err)
+    {
+        SetLastError( err );
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/***********************************************************************
+ *     RIOReceive
+ */
+static BOOL WINAPI WS2_RIOReceive( RIO_RQ rq, PRIO_BUF data, ULONG count, DWORD flags, PVOID context )
+{
+    TRACE( "(%p, %p, %u, %#x, %p)\n", rq, data, count, flags, context );
+    return rio_submit( rq, FALSE, data, count, NULL, flags, context );
+}
+
+/***********************************************************************
+ *     RIOReceiveEx
+ */
+static int WINAPI WS2_RIOReceiveEx( RIO_RQ rq, PRIO_BUF data, ULONG count, PRIO_BUF local, PRIO_BUF remote,
+                                    PRIO_BUF control, PRIO_BUF flags_buf, DWORD flags, PVOID context )
+{
+    TRACE( "(%p, %p, %u, %p, %p, %p, %p, %#x, %p)\n", rq, data, count, local, remote, control,
+           flags_buf, flags, context );
+    if (local || control || flags_buf) FIXME( "local address, control and flags buffers not supported\n" );
+    return rio_submit( rq, FALSE, data, count, remote, flags, context );
+}
+
+/***********************************************************************
+ *     RIOSend
+ */
+static BOOL WINAPI WS2_RIOSend( RIO_RQ rq, PRIO_BUF data, ULONG count, DWORD flags, PVOID context )
+{
+    TRACE( "(%p, %p, %u, %#x, %p)\n", rq, data, count, flags, context );
+    return rio_submit( rq, TRUE, data, count, NULL, flags, context );
+}
+
+/***********************************************************************
+ *     RIOSendEx
+ */
+static BOOL WINAPI WS2_RIOSendEx( RIO_RQ rq, PRIO_BUF data, ULONG count, PRIO_BUF local, PRIO_BUF remote,
+                                  PRIO_BUF control, PRIO_BUF flags_buf, DWORD flags, PVOID context )
+{
+    TRACE( "(%p, %p, %u, %p, %p, %p, %p, %#x, %p)\n", rq, data, count, local, remote, control,
+           flags_buf, flags, context );
+    if (local || control || flags_buf) FIXME( "local address, control and flags buffers not supported\n" );
+    return rio_submit( rq, TRUE, data, count, remote, flags, context );
+}
+
+/***********************************************************************
+ *     RIOCloseCompletionQueue
+ */
+static void WINAPI WS2_RIOCloseCompletionQueue( RIO_CQ handle )
+{
+    struct rio_cq *cq = (struct rio_cq *)handle;
+
+    TRACE( "(%p)\n", handle );
+    if (!cq) return;
+    HeapFree( GetProcessHeap(), 0, cq->results );
+    HeapFree( GetProcessHeap(), 0, cq );
+}
+
+/***********************************************************************
+ *     RIOCreateCompletionQueue
+ */
+static RIO_CQ WINAPI WS2_RIOCreateCompletionQueue( DWORD size, PRIO_NOTIFICATION_COMPLETION notify )
+{
+    struct rio_cq *cq;
+
+    TRACE( "(%u, %p)\n", size, notify );
+
+    if (!size || size > RIO_MAX_CQ_SIZE ||
+        (notify && notify->Type != RIO_EVENT_COMPLETION && notify->Type != RIO_IOCP_COMPLETION))
+    {
+        SetLastError( WSAEINVAL );
+        return RIO_INVALID_CQ;
+    }
+    if (!(cq = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*cq) )) ||
+        !(cq->results = HeapAlloc( GetProcessHeap(), 0, size * sizeof(*cq->results) )))
+    {
+        HeapFree( GetProcessHeap(), 0, cq );
+        SetLastError( WSAENOBUFS );
+        return RIO_INVALID_CQ;
+    }
+    cq->size = size;
+    if (notify)
+    {
+        cq->notify = *notify;
+        cq->has_notify = TRUE;
+    }
+    return (RIO_CQ)cq;
+}
+
+/***********************************************************************
+ *     RIOCreateRequestQueue
+ */
+static RIO_RQ WINAPI WS2_RIOCreateRequestQueue( SOCKET s, ULONG max_recv, ULONG max_recv_buffers,
+                                                ULONG max_send, ULONG max_send_buffers,
+                                                RIO_CQ recv_cq, RIO_CQ send_cq, PVOID context )
+{
+    struct rio_rq *rq, *other;
+    int fd;
+
+    TRACE( "(%04lx, %u, %u, %u, %u, %p, %p, %p)\n", s, max_recv, max_recv_buffers, max_send,
+           max_send_buffers, recv_cq, send_cq, context );
+
+    if (!recv_cq || !send_cq || (max_recv && max_recv_buffers != 1) || (max_send && max_send_buffers != 1))
+    {
+        SetLastError( WSAEINVAL );
+        return RIO_INVALID_RQ;
+    }
+    if ((fd = get_sock_fd( s, 0, NULL )) == -1) return RIO_INVALID_RQ;
+    if (!(rq = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*rq) )))
+    {
+        release_sock_fd( s, fd );
+        SetLastError( WSAENOBUFS );
+        return RIO_INVALID_RQ;
+    }
+    rq->socket  = s;
+    rq->context = (ULONG_PTR)context;
+    rq->recv_cq = (struct rio_cq *)recv_cq;
+    rq->send_cq = (struct rio_cq *)send_cq;
+    rq->fd      = dup( fd );
+    release_sock_fd( s, fd );
+    if (rq->fd != -1)
+    {
+        int type;
+        socklen_t len = sizeof(type);
+
+        rq->stream = !getsockopt( rq->fd, SOL_SOCKET, SO_TYPE, &type, &len ) && type == SOCK_STREAM;
+    }
+
+    EnterCriticalSection( &rio_cs );
+    LIST_FOR_EACH_ENTRY( other, &rio_queues, struct rio_rq, entry )
+    {
+        if (other->socket != s) continue;
+        SetLastError( WSAEINVAL );
+        goto error;
+    }
+    if (rq->fd == -1 || !rio_start_service_thread())
+    {
+        SetLastError( wsaErrno() );
+        goto error;
+    }
+    if (!rio_resize_op_queue( &rq->recv, max_recv ) || !rio_resize_op_queue( &rq->send, max_send ))
+    {
+        SetLastError( WSAENOBUFS );
+        goto error;
+    }
+    list_add_tail( &rio_queues, &rq->entry );
+    LeaveCriticalSection( &rio_cs );
+    return (RIO_RQ)rq;
+
+error:
+    LeaveCriticalSection( &rio_cs );
+    if (rq->fd != -1) close( rq->fd );
+    HeapFree( GetProcessHeap(), 0, rq->recv.ops );
+    HeapFree( GetProcessHeap(), 0, rq->send.ops );
+    HeapFree( GetProcessHeap(), 0, rq );
+    return RIO_INVALID_RQ;
+}
+
+/***********************************************************************
+ *     RIODequeueCompletion
+ */
+static ULONG WINAPI WS2_RIODequeueCompletion( RIO_CQ handle, PRIORESULT results, ULONG size )
+{
+    struct rio_cq *cq = (struct rio_cq *)handle;
+    ULONG i, count;
+
+    TRACE( "(%p, %p, %u)\n", handle, results, size );
+
+    if (!cq || !results)
+    {
+        SetLastError( WSAEINVAL );
+        return RIO_CORRUPT_CQ;
+    }
+
+    EnterCriticalSection( &rio_cs );
+    count = min( size, cq->count );
+    for (i = 0; i < count; i++) results[i] = cq->results[(cq->head + i) % cq->size];
+    cq->head = (cq->head + count) % cq->size;
+    cq->count -= count;
+    cq->reserved -= count;
+    LeaveCriticalSection( &rio_cs );
+    return count;
+}
+
+/***********************************************************************
+ *     RIODeregisterBuffer
+ */
+static void WINAPI WS2_RIODeregisterBuffer( RIO_BUFFERID id )
+{
+    TRACE( "(%p)\n", id );
+    if (id == RIO_INVALID_BUFFERID) return;
+    HeapFree( GetProcessHeap(), 0, id );
+}
+
+/***********************************************************************
+ *     RIONotify
  */
-static BOOL WINAPI WS2_TransmitFile( SOCKET s, HANDLE h, DWORD file_bytes, DWORD bytes_per_send,
-                                     LPOVERLAPPED overlapped, LPTRANSMIT_FILE_BUFFERS buffers,
-                                     DWORD flags )
+static int WINAPI WS2_RIONotify( RIO_CQ handle )
 {
-    union generic_unix_sockaddr uaddr;
-    socklen_t uaddrlen = sizeof(uaddr);
-    struct ws2_transmitfile_async *wsa;
-    NTSTATUS status;
-    int fd;
+    struct rio_cq *cq = (struct rio_cq *)handle;
+    int ret = 0;
 
-    TRACE("(%lx, %p, %d, %d, %p, %p, %d)\n", s, h, file_bytes, bytes_per_send, overlapped,
-            buffers, flags );
+    TRACE( "(%p)\n", handle );
 
-    fd = get_sock_fd( s, FILE_WRITE_DATA, NULL );
-    if (fd == -1)
+    if (!cq || !cq->has_notify) return WSAEINVAL;
+
+    EnterCriticalSection( &rio_cs );
+    if (cq->armed) ret = WSAEALREADY;
+    else
     {
-        WSASetLastError( WSAENOTSOCK );
-        return FALSE;
+        if (cq->notify.Type == RIO_EVENT_COMPLETION && cq->notify.u.Event.NotifyReset)
+            ResetEvent( cq->notify.u.Event.EventHandle );
+        cq->armed = TRUE;
+        if (cq->count) rio_signal_cq( cq );
     }
-    if (getpeername( fd, &uaddr.addr, &uaddrlen ) != 0)
+    LeaveCriticalSection( &rio_cs );
+    return ret;
+}
+
+/***********************************************************************
+ *     RIORegisterBuffer
+ */
+static RIO_BUFFERID WINAPI WS2_RIORegisterBuffer( PCHAR data, DWORD size )
+{
+    struct rio_buffer *buffer;
+
+    TRACE( "(%p, %u)\n", data, size );
+
+    if (!data)
     {
-        release_sock_fd( s, fd );
-        WSASetLastError( WSAENOTCONN );
-        return FALSE;
+        SetLastError( WSAEFAULT );
+        return RIO_INVALID_BUFFERID;
     }
-    if (flags)
-        FIXME("Flags are not currently supported (0x%x).\n", flags);
-
-    if (h && GetFileType( h ) != FILE_TYPE_DISK)
+    if (!(buffer = HeapAlloc( GetProcessHeap(), 0, sizeof(*buffer) )))
     {
-        FIXME("Non-disk file handles are not currently supported.\n");
-        release_sock_fd( s, fd );
-        WSASetLastError( WSAEOPNOTSUPP );
-        return FALSE;
+        SetLastError( WSAENOBUFS );
+        return RIO_INVALID_BUFFERID;
     }
+    buffer->base = data;
+    buffer->size = size;
+    return (RIO_BUFFERID)buffer;
+}
 
-    /* set reasonable defaults when requested */
-    if (!bytes_per_send)
-        bytes_per_send = (1 << 16); /* Depends on OS version: PAGE_SIZE, 2*PAGE_SIZE, or 2^16 */
+/***********************************************************************
+ *     RIOResizeCompletionQueue
+ */
+static BOOL WINAPI WS2_RIOResizeCompletionQueue( RIO_CQ handle, DWORD size )
+{
+    struct rio_cq *cq = (struct rio_cq *)handle;
+    RIORESULT *results;
+    DWORD i;
+    BOOL ret = FALSE;
 
-    if (!(wsa = (struct ws2_transmitfile_async *)alloc_async_io( sizeof(*wsa) + bytes_per_send,
-                                                                 WS2_async_transmitfile )))
+    TRACE( "(%p, %u)\n", handle, size );
+
+    if (!cq || !size || size > RIO_MAX_CQ_SIZE)
     {
-        release_sock_fd( s, fd );
-        WSASetLastError( WSAEFAULT );
+        SetLastError( WSAEINVAL );
         return FALSE;
     }
-    if (buffers)
-        wsa->buffers = *buffers;
+
+    EnterCriticalSection( &rio_cs );
+    if (size < cq->reserved) SetLastError( WSAETOOMANYREFS );
+    else if (!(results = HeapAlloc( GetProcessHeap(), 0, size * sizeof(*results) ))) SetLastError( WSAENOBUFS );
     else
-        memset(&wsa->buffers, 0x0, sizeof(wsa->buffers));
-    wsa->buffer                = (char *)(wsa + 1);
-    wsa->file                  = h;
-    wsa->file_read             = 0;
-    wsa->file_bytes            = file_bytes;
-    wsa->bytes_per_send        = bytes_per_send;
-    wsa->flags                 = flags;
-    wsa->offset.QuadPart       = FILE_USE_FILE_POINTER_POSITION;
-    wsa->write.hSocket         = SOCKET2HANDLE(s);
-    wsa->write.addr            = NULL;
-    wsa->write.addrlen.val     = 0;
-    wsa->write.flags           = 0;
-    wsa->write.lpFlags         = &wsa->flags;
-    wsa->write.control         = NULL;
-    wsa->write.n_iovecs        = 0;
-    wsa->write.first_iovec     = 0;
-    wsa->write.user_overlapped = overlapped;
-    if (overlapped)
     {
-        IO_STATUS_BLOCK *iosb = (IO_STATUS_BLOCK *)overlapped;
-        int status;
-
-        wsa->offset.u.LowPart  = overlapped->u.s.Offset;
-        wsa->offset.u.HighPart = overlapped->u.s.OffsetHigh;
-        iosb->u.Status = STATUS_PENDING;
-        iosb->Information = 0;
-        status = register_async( ASYNC_TYPE_WRITE, SOCKET2HANDLE(s), &wsa->io,
-                                 overlapped->hEvent, NULL, NULL, iosb );
-        if(status != STATUS_PENDING) HeapFree( GetProcessHeap(), 0, wsa );
-        release_sock_fd( s, fd );
-        WSASetLastError( NtStatusToWSAError(status) );
-        return FALSE;
+        for (i = 0; i < cq->count; i++) results[i] = cq->results[(cq->head + i) % cq->size];
+        HeapFree( GetProcessHeap(), 0, cq->results );
+        cq->results = results;
+        cq->size = size;
+        cq->head = 0;
+        ret = TRUE;
     }
+    LeaveCriticalSection( &rio_cs );
+    return ret;
+}
 
-    do
+/***********************************************************************
+ *     RIOResizeRequestQueue
+ */
+static BOOL WINAPI WS2_RIOResizeRequestQueue( RIO_RQ handle, DWORD max_recv, DWORD max_send )
+{
+    struct rio_rq *rq = (struct rio_rq *)handle;
+    BOOL ret = FALSE;
+
+    TRACE( "(%p, %u, %u)\n", handle, max_recv, max_send );
+
+    if (!rq)
     {
-        status = WS2_transmitfile_base( fd, wsa );
-        if (status == STATUS_PENDING)
-        {
-            /* block here */
-            do_block(fd, POLLOUT, -1);
-            _sync_sock_state(s); /* let wineserver notice connection */
-        }
+        SetLastError( WSAEINVAL );
+        return FALSE;
     }
-    while (status == STATUS_PENDING);
-    release_sock_fd( s, fd );
 
-    if (status != STATUS_SUCCESS)
-        WSASetLastError( NtStatusToWSAError(status) );
-    HeapFree( GetProcessHeap(), 0, wsa );
-    return (status == STATUS_SUCCESS);
+    EnterCriticalSection( &rio_cs );
+    if (max_recv < rq->recv.count || max_send < rq->send.count) SetLastError( WSAETOOMANYREFS );
+    else if (!rio_resize_op_queue( &rq->recv, max_recv ) || !rio_resize_op_queue( &rq->send, max_send ))
+        SetLastError( WSAENOBUFS );
+    else ret = TRUE;
+    LeaveCriticalSection( &rio_cs );
+    return ret;
 }
 
 /***********************************************************************
@@ -3384,6 +4748,7 @@ int WINAPI WS_closesocket(SOCKET s)
         if (fd >= 0)
         {
             release_sock_fd(s, fd);
+            rio_close_socket(s);
             if (CloseHandle(SOCKET2HANDLE(s)))
                 res = 0;
         }
@@ -3578,6 +4943,7 @@ static BOOL WINAPI WS2_ConnectEx(SOCKET s, const struct WS_sockaddr* name, int n
             wsa->control     = NULL;
             wsa->n_iovecs    = sendBuf ? 1 : 0;
             wsa->first_iovec = 0;
+            wsa->batch_state = BATCH_NONE;
             wsa->completion_func = NULL;
             wsa->iovec[0].iov_base = sendBuf;
             wsa->iovec[0].iov_len  = sendBufLen;
@@ -4474,6 +5840,7 @@ static const char *debugstr_wsaioctl(DWORD code)
         IOCTL_NAME(WS_SIO_FLUSH);
         IOCTL_NAME(WS_SIO_GET_BROADCAST_ADDRESS);
         IOCTL_NAME(WS_SIO_GET_EXTENSION_FUNCTION_POINTER);
+        IOCTL_NAME(WS_SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER);
         IOCTL_NAME(WS_SIO_GET_GROUP_QOS);
         IOCTL_NAME(WS_SIO_GET_INTERFACE_LIST);
         /* IOCTL_NAME(WS_SIO_GET_INTERFACE_LIST_EX); */
@@ -4906,7 +6273,7 @@ INT WINAPI WSAIoctl(SOCKET s, DWORD code, LPVOID in_buff, DWORD in_size, LPVOID
             EXTENSION_FUNCTION(WSAID_ACCEPTEX, WS2_AcceptEx)
             EXTENSION_FUNCTION(WSAID_GETACCEPTEXSOCKADDRS, WS2_GetAcceptExSockaddrs)
             EXTENSION_FUNCTION(WSAID_TRANSMITFILE, WS2_TransmitFile)
-            /* EXTENSION_FUNCTION(WSAID_TRANSMITPACKETS, WS2_TransmitPackets) */
+            EXTENSION_FUNCTION(WSAID_TRANSMITPACKETS, WS2_TransmitPackets)
             EXTENSION_FUNCTION(WSAID_WSARECVMSG, WS2_WSARecvMsg)
             EXTENSION_FUNCTION(WSAID_WSASENDMSG, WSASendMsg)
         };
@@ -4935,6 +6302,44 @@ INT WINAPI WSAIoctl(SOCKET s, DWORD code, LPVOID in_buff, DWORD in_size, LPVOID
         status = WSAEOPNOTSUPP;
         break;
     }
+    case WS_SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER:
+    {
+        static const GUID rio_guid = WSAID_MULTIPLE_RIO;
+        static const RIO_EXTENSION_FUNCTION_TABLE rio_table =
+        {
+            sizeof(RIO_EXTENSION_FUNCTION_TABLE),
+            WS2_RIOReceive,
+            WS2_RIOReceiveEx,
+            WS2_RIOSend,
+            WS2_RIOSendEx,
+            WS2_RIOCloseCompletionQueue,
+            WS2_RIOCreateCompletionQueue,
+            WS2_RIOCreateRequestQueue,
+            WS2_RIODequeueCompletion,
+            WS2_RIODeregisterBuffer,
+            WS2_RIONotify,
+            WS2_RIORegisterBuffer,
+            WS2_RIOResizeCompletionQueue,
+            WS2_RIOResizeRequestQueue
+        };
+
+        if (!in_buff || in_size < sizeof(GUID) || !IsEqualGUID(&rio_guid, in_buff))
+        {
+            FIXME("SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER %s: stub\n",
+                  in_buff ? debugstr_guid(in_buff) : "(null)");
+            status = WSAEOPNOTSUPP;
+            break;
+        }
+        if (!out_buff || out_size < sizeof(rio_table))
+        {
+            status = WSAEFAULT;
+            break;
+        }
+        TRACE("-> got RIO function table\n");
+        memcpy(out_buff, &rio_table, sizeof(rio_table));
+        total = sizeof(rio_table);
+        break;
+    }
     case WS_SIO_KEEPALIVE_VALS:
     {
         struct tcp_keepalive *k;
@@ -5171,13 +6576,127 @@ int WINAPI WS_recvfrom(SOCKET s, char *buf, INT len, int flags,
         return n;
 }
 
+#define POLL_SET_EPOLL_MIN 16
+
+/* drop all the fds registered in the epoll set of a poll set */
+static void reset_poll_set_epoll( struct poll_set *set )
+{
+    unsigned int i;
+
+    for (i = 0; i < set->active_count; i++) set->entries[set->active[i]].in_epoll = 0;
+    set->active_count = 0;
+    if (set->epoll_fd != -1) close( set->epoll_fd );
+    set->epoll_fd = -1;
+}
+
+/* drop the entries of the sockets closed since the last poll call */
+static void update_poll_set( struct poll_set *set )
+{
+    HANDLE closed[64];
+    unsigned int i, j, count;
+
+    count = wine_server_get_closed_handles( &set->close_seq, closed, sizeof(closed) / sizeof(closed[0]) );
+    if (!count) return;
+
+    /* the old socket may still be in the epoll set if the server holds it,
+     * do_epoll() ignores its events by their tag */
+    for (i = 0; i < set->size; i++)
+    {
+        if (!set->entries[i].socket) continue;
+        if (count != ~0u)
+        {
+            for (j = 0; j < count; j++)
+                if (SOCKET2HANDLE(set->entries[i].socket) == closed[j]) break;
+            if (j == count) continue;
+        }
+        memset( &set->entries[i], 0, sizeof(set->entries[i]) );
+    }
+}
+
+/* get the poll set of the current thread */
+static struct poll_set *get_poll_set( struct per_thread_data *ptb )
+{
+    struct poll_set *set = ptb->poll_set;
+
+    if (!set)
+    {
+        if (!(set = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*set) ))) return NULL;
+        set->epoll_fd = -1;
+        ptb->poll_set = set;
+    }
+    update_poll_set( set );
+    return set;
+}
+
+/* get the entry caching the state of a socket fd */
+static struct poll_set_entry *get_poll_set_entry( struct poll_set *set, SOCKET s, int fd )
+{
+    struct poll_set_entry *entry;
+
+    if (!set || fd < 0) return NULL;
+    if (fd >= set->size)
+    {
+        unsigned int size = max( 64, set->size * 2 );
+
+        while (size <= fd) size *= 2;
+        if (set->entries)
+            entry = HeapReAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, set->entries, size * sizeof(*entry) );
+        else
+            entry = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, size * sizeof(*entry) );
+        if (!entry) return NULL;
+        set->entries = entry;
+        set->size = size;
+    }
+    entry = &set->entries[fd];
+    /* closed sockets are dropped by update_poll_set(), so an entry of the same
+     * socket is still valid; the fd may have been given to another socket */
+    if (entry->socket != s)
+    {
+        memset( entry, 0, sizeof(*entry) );
+        entry->socket = s;
+        entry->tag = ++set->tag;
+    }
+    return entry;
+}
+
+static BOOL poll_set_is_bound( struct poll_set_entry *entry, int fd )
+{
+    if (entry && entry->bound) return TRUE;
+    if (is_fd_bound( fd, NULL, NULL ) != 1) return FALSE;
+    if (entry) entry->bound = 1;  /* a socket can't be unbound */
+    return TRUE;
+}
+
+static int poll_set_get_type( struct poll_set_entry *entry, int fd )
+{
+    int type;
+
+    if (entry && entry->type) return entry->type;
+    type = _get_fd_type( fd );
+    if (entry && type != -1) entry->type = type;
+    return type;
+}
+
+/* get the per-thread pollfd buffer, resizing it if needed */
+static struct pollfd *get_poll_buffer( struct per_thread_data *ptb, unsigned int count )
+{
+    struct pollfd *fds;
+
+    if (ptb->fd_count >= count) return ptb->fd_cache;
+    if (!(fds = HeapAlloc( GetProcessHeap(), 0, count * sizeof(fds[0]) ))) return NULL;
+    HeapFree( GetProcessHeap(), 0, ptb->fd_cache );
+    ptb->fd_cache = fds;
+    ptb->fd_count = count;
+    return fds;
+}
+
 /* allocate a poll array for the corresponding fd sets */
 static struct pollfd *fd_sets_to_poll( const WS_fd_set *readfds, const WS_fd_set *writefds,
-                                       const WS_fd_set *exceptfds, int *count_ptr )
+                                       const WS_fd_set *exceptfds, struct poll_set *set, int *count_ptr )
 {
     unsigned int i, j = 0, count = 0;
+    struct poll_set_entry *entry;
     struct pollfd *fds;
-    struct per_thread_data *ptb = get_per_thread_data();
 
     if (readfds) count += readfds->fd_count;
     if (writefds) count += writefds->fd_count;
@@ -5189,20 +6708,11 @@ static struct pollfd *fd_sets_to_poll( const WS_fd_set *readfds, const WS_fd_set
         return NULL;
     }
 
-    /* check if the cache can hold all descriptors, if not do the resizing */
-    if (ptb->fd_count < count)
+    if (!(fds = get_poll_buffer( get_per_thread_data(), count )))
     {
-        if (!(fds = HeapAlloc(GetProcessHeap(), 0, count * sizeof(fds[0]))))
-        {
-            SetLastError( ERROR_NOT_ENOUGH_MEMORY );
-            return NULL;
-        }
-        HeapFree(GetProcessHeap(), 0, ptb->fd_cache);
-        ptb->fd_cache = fds;
-        ptb->fd_count = count;
+        SetLastError( ERROR_NOT_ENOUGH_MEMORY );
+        return NULL;
     }
-    else
-        fds = ptb->fd_cache;
 
     if (readfds)
         for (i = 0; i < readfds->fd_count; i++, j++)
@@ -5210,7 +6720,8 @@ static struct pollfd *fd_sets_to_poll( const WS_fd_set *readfds, const WS_fd_set
             fds[j].fd = get_sock_fd( readfds->fd_array[i], FILE_READ_DATA, NULL );
             if (fds[j].fd == -1) goto failed;
             fds[j].revents = 0;
-            if (is_fd_bound(fds[j].fd, NULL, NULL) == 1)
+            entry = get_poll_set_entry( set, readfds->fd_array[i], fds[j].fd );
+            if (poll_set_is_bound( entry, fds[j].fd ))
             {
                 fds[j].events = POLLIN;
             }
@@ -5227,8 +6738,9 @@ static struct pollfd *fd_sets_to_poll( const WS_fd_set *readfds, const WS_fd_set
             fds[j].fd = get_sock_fd( writefds->fd_array[i], FILE_WRITE_DATA, NULL );
             if (fds[j].fd == -1) goto failed;
             fds[j].revents = 0;
-            if (is_fd_bound(fds[j].fd, NULL, NULL) == 1 ||
-                _get_fd_type(fds[j].fd) == SOCK_DGRAM)
+            entry = get_poll_set_entry( set, writefds->fd_array[i], fds[j].fd );
+            if (poll_set_is_bound( entry, fds[j].fd ) ||
+                poll_set_get_type( entry, fds[j].fd ) == SOCK_DGRAM)
             {
                 fds[j].events = POLLOUT;
             }
@@ -5245,7 +6757,8 @@ static struct pollfd *fd_sets_to_poll( const WS_fd_set *readfds, const WS_fd_set
             fds[j].fd = get_sock_fd( exceptfds->fd_array[i], 0, NULL );
             if (fds[j].fd == -1) goto failed;
             fds[j].revents = 0;
-            if (is_fd_bound(fds[j].fd, NULL, NULL) == 1)
+            entry = get_poll_set_entry( set, exceptfds->fd_array[i], fds[j].fd );
+            if (poll_set_is_bound( entry, fds[j].fd ))
             {
                 int oob_inlined = 0;
                 socklen_t olen = sizeof(oob_inlined);
@@ -5316,9 +6829,27 @@ static void release_poll_fds( const WS_fd_set *readfds, const WS_fd_set *writefd
     }
 }
 
+/* compute the time left before a timeout expires after an interrupted wait */
+static int get_remaining_timeout( const struct timeval *start, int timeout )
+{
+    struct timeval now;
+
+    gettimeofday( &now, 0 );
+
+    now.tv_sec  -= start->tv_sec;
+    now.tv_usec -= start->tv_usec;
+    if (now.tv_usec < 0)
+    {
+        now.tv_usec += 1000000;
+        now.tv_sec  -= 1;
+    }
+
+    return timeout - (now.tv_sec * 1000) - (now.tv_usec + 999) / 1000;
+}
+
 static int do_poll(struct pollfd *pollfds, int count, int timeout)
 {
-    struct timeval tv1, tv2;
+    struct timeval tv1;
     int ret, torig = timeout;
 
     if (timeout > 0) gettimeofday( &tv1, 0 );
@@ -5329,20 +6860,191 @@ static int do_poll(struct pollfd *pollfds, int count, int timeout)
         if (timeout < 0) continue;
         if (timeout == 0) return 0;
 
-        gettimeofday( &tv2, 0 );
+        timeout = get_remaining_timeout( &tv1, torig );
+        if (timeout <= 0) return 0;
+    }
+    return ret;
+}
+
+#ifdef HAVE_SYS_EPOLL_H
+
+static unsigned int poll_to_epoll( unsigned short events )
+{
+    unsigned int ret = 0;
+
+    if (events & POLLIN) ret |= EPOLLIN;
+    if (events & POLLOUT) ret |= EPOLLOUT;
+    if (events & POLLPRI) ret |= EPOLLPRI;
+    return ret;
+}
+
+static unsigned short epoll_to_poll( unsigned int events )
+{
+    unsigned short ret = 0;
+
+    if (events & EPOLLIN) ret |= POLLIN;
+    if (events & EPOLLOUT) ret |= POLLOUT;
+    if (events & EPOLLPRI) ret |= POLLPRI;
+    if (events & EPOLLERR) ret |= POLLERR;
+    if (events & EPOLLHUP) ret |= POLLHUP;
+    return ret;
+}
+
+/* wait on a poll array through the persistent epoll set of the thread, so that only the
+ * changes since the previous call have to be passed to the kernel and the wait itself
+ * only costs the number of ready fds; returns FALSE if poll() must be used instead */
+static BOOL do_epoll( struct poll_set *set, struct pollfd *fds, int count, int timeout, int *ret )
+{
+    struct poll_set_entry *entry;
+    struct epoll_event ev;
+    struct timeval start;
+    unsigned int i, j, seq = ++set->seq;
+    int n, fd, torig = timeout;
+    BOOL stale;
+
+    if (set->epoll_fd == -1 && (set->epoll_fd = epoll_create( POLL_SET_EPOLL_MIN )) == -1)
+        return FALSE;
 
-        tv2.tv_sec  -= tv1.tv_sec;
-        tv2.tv_usec -= tv1.tv_usec;
-        if (tv2.tv_usec < 0)
+    for (i = 0; i < count; i++)
+    {
+        if ((fd = fds[i].fd) == -1) continue;
+        if (fd >= set->size || !set->entries[fd].socket) return FALSE;
+        entry = &set->entries[fd];
+        if (entry->seq != seq)
         {
-            tv2.tv_usec += 1000000;
-            tv2.tv_sec  -= 1;
+            entry->seq = seq;
+            entry->wanted = 0;
+            entry->revents = 0;
         }
+        entry->wanted |= fds[i].events;
+    }
 
-        timeout = torig - (tv2.tv_sec * 1000) - (tv2.tv_usec + 999) / 1000;
-        if (timeout <= 0) return 0;
+    /* remove the fds that are no longer waited on */
+    for (i = j = 0; i < set->active_count; i++)
+    {
+        entry = &set->entries[set->active[i]];
+        if (!entry->in_epoll) continue;
+        if (entry->seq != seq)
+        {
+            epoll_ctl( set->epoll_fd, EPOLL_CTL_DEL, set->active[i], &ev );
+            entry->in_epoll = 0;
+            continue;
+        }
+        set->active[j++] = set->active[i];
     }
-    return ret;
+    set->active_count = j;
+
+    if (set->active_size < set->active_count + count)
+    {
+        unsigned int size = max( set->active_size * 2, set->active_count + count );
+        int *active;
+
+        if (set->active)
+            active = HeapReAlloc( GetProcessHeap(), 0, set->active, size * sizeof(*active) );
+        else
+            active = HeapAlloc( GetProcessHeap(), 0, size * sizeof(*active) );
+        if (!active) return FALSE;
+        set->active = active;
+        set->active_size = size;
+    }
+
+    /* then add the new ones and update the changed ones */
+    for (i = 0; i < count; i++)
+    {
+        if ((fd = fds[i].fd) == -1) continue;
+        entry = &set->entries[fd];
+        if (entry->in_epoll && entry->registered == entry->wanted) continue;
+
+        memset( &ev, 0, sizeof(ev) );
+        ev.events = poll_to_epoll( entry->wanted );
+        ev.data.u64 = ((ULONGLONG)entry->tag << 32) | (unsigned int)fd;
+        if (entry->in_epoll)
+        {
+            if (epoll_ctl( set->epoll_fd, EPOLL_CTL_MOD, fd, &ev ) == -1) goto failed;
+        }
+        else
+        {
+            if (epoll_ctl( set->epoll_fd, EPOLL_CTL_ADD, fd, &ev ) == -1 &&
+                (errno != EEXIST || epoll_ctl( set->epoll_fd, EPOLL_CTL_MOD, fd, &ev ) == -1))
+                goto failed;
+            entry->in_epoll = 1;
+            set->active[set->active_count++] = fd;
+        }
+        entry->registered = entry->wanted;
+    }
+
+    if (!set->active_count) return FALSE;
+
+    if (set->events_size < set->active_count)
+    {
+        struct epoll_event *events;
+
+        HeapFree( GetProcessHeap(), 0, set->events );
+        if (!(events = HeapAlloc( GetProcessHeap(), 0, set->active_count * sizeof(*events) )))
+        {
+            set->events = NULL;
+            set->events_size = 0;
+            return FALSE;
+        }
+        set->events = events;
+        set->events_size = set->active_count;
+    }
+
+    if (timeout > 0) gettimeofday( &start, 0 );
+
+    while ((n = epoll_wait( set->epoll_fd, set->events, set->active_count, timeout )) < 0)
+    {
+        if (errno != EINTR)
+        {
+            *ret = -1;
+            return TRUE;
+        }
+        if (timeout < 0) continue;
+        if (timeout == 0 || (timeout = get_remaining_timeout( &start, torig )) <= 0)
+        {
+            n = 0;
+            break;
+        }
+    }
+
+    for (i = 0, stale = FALSE; i < n; i++)
+    {
+        fd = (unsigned int)set->events[i].data.u64;
+        entry = &set->entries[fd];
+        if (entry->in_epoll && entry->tag == (unsigned int)(set->events[i].data.u64 >> 32))
+            entry->revents = epoll_to_poll( set->events[i].events );
+        else
+            stale = TRUE;
+    }
+    /* a closed socket is still registered, start over to get rid of it */
+    if (stale) reset_poll_set_epoll( set );
+
+    for (i = 0, n = 0; i < count; i++)
+    {
+        if ((fd = fds[i].fd) == -1) continue;
+        fds[i].revents = set->entries[fd].revents & (fds[i].events | POLLERR | POLLHUP);
+        if (fds[i].revents) n++;
+    }
+    *ret = n;
+    return TRUE;
+
+failed:
+    reset_poll_set_epoll( set );
+    return FALSE;
+}
+
+#endif  /* HAVE_SYS_EPOLL_H */
+
+/* wait on the unix fds of a set of sockets */
+static int poll_sockets( struct poll_set *set, struct pollfd *fds, int count, int timeout )
+{
+#ifdef HAVE_SYS_EPOLL_H
+    int ret;
+
+    if (set && count >= POLL_SET_EPOLL_MIN && do_epoll( set, fds, count, timeout, &ret ))
+        return ret;
+#endif
+    return do_poll( fds, count, timeout );
 }
 
 /* map the poll results back into the Windows fd sets */
@@ -5393,19 +7095,20 @@ int WINAPI WS_select(int nfds, WS_fd_set *ws_readfds,
                      WS_fd_set *ws_writefds, WS_fd_set *ws_exceptfds,
                      const struct WS_timeval* ws_timeout)
 {
+    struct poll_set *set = get_poll_set( get_per_thread_data() );
     struct pollfd *pollfds;
     int count, ret, timeout = -1;
 
     TRACE("read %p, write %p, excp %p timeout %p\n",
           ws_readfds, ws_writefds, ws_exceptfds, ws_timeout);
 
-    if (!(pollfds = fd_sets_to_poll( ws_readfds, ws_writefds, ws_exceptfds, &count )))
+    if (!(pollfds = fd_sets_to_poll( ws_readfds, ws_writefds, ws_exceptfds, set, &count )))
         return SOCKET_ERROR;
 
     if (ws_timeout)
         timeout = (ws_timeout->tv_sec * 1000) + (ws_timeout->tv_usec + 999) / 1000;
 
-    ret = do_poll(pollfds, count, timeout);
+    ret = poll_sockets( set, pollfds, count, timeout );
     release_poll_fds( ws_readfds, ws_writefds, ws_exceptfds, pollfds );
 
     if (ret == -1) SetLastError(wsaErrno());
@@ -5418,6 +7121,8 @@ int WINAPI WS_select(int nfds, WS_fd_set *ws_readfds,
  */
 int WINAPI WSAPoll(WSAPOLLFD *wfds, ULONG count, int timeout)
 {
+    struct per_thread_data *ptb = get_per_thread_data();
+    struct poll_set *set;
     int i, ret;
     struct pollfd *ufds;
 
@@ -5432,20 +7137,22 @@ int WINAPI WSAPoll(WSAPOLLFD *wfds, ULONG count, int timeout)
         return SOCKET_ERROR;
     }
 
-    if (!(ufds = HeapAlloc(GetProcessHeap(), 0, count * sizeof(ufds[0]))))
+    if (!(ufds = get_poll_buffer( ptb, count )))
     {
         SetLastError(WSAENOBUFS);
         return SOCKET_ERROR;
     }
 
+    set = get_poll_set( ptb );
     for (i = 0; i < count; i++)
     {
         ufds[i].fd = get_sock_fd(wfds[i].fd, 0, NULL);
         ufds[i].events = convert_poll_w2u(wfds[i].events);
         ufds[i].revents = 0;
+        if (ufds[i].fd != -1) get_poll_set_entry( set, wfds[i].fd, ufds[i].fd );
     }
 
-    ret = do_poll(ufds, count, timeout);
+    ret = poll_sockets( set, ufds, count, timeout );
 
     for (i = 0; i < count; i++)
     {
@@ -5471,7 +7178,6 @@ int WINAPI WSAPoll(WSAPOLLFD *wfds, ULONG count, int timeout)
             wfds[i].revents = WS_POLLNVAL;
     }
 
-    HeapFree(GetProcessHeap(), 0, ufds);
     return ret;
 }
 
@@ -5579,6 +7285,7 @@ static int WS2_sendto( SOCKET s, LPWSABUF lpBuffers, DWORD dwBufferCount,
     wsa->control     = NULL;
     wsa->n_iovecs    = dwBufferCount;
     wsa->first_iovec = 0;
+    wsa->batch_state = BATCH_NONE;
     for ( i = 0; i < dwBufferCount; i++ )
     {
         wsa->iovec[i].iov_base = lpBuffers[i].buf;
@@ -5609,11 +7316,11 @@ static int WS2_sendto( SOCKET s, LPWSABUF lpBuffers, DWORD dwBufferCount,
             iosb->Information = n == -1 ? 0 : n;
 
             if (wsa->completion_func)
-                err = register_async( ASYNC_TYPE_WRITE, wsa->hSocket, &wsa->io, NULL,
-                                      ws2_async_apc, wsa, iosb );
+                err = register_ws2_async( ASYNC_TYPE_WRITE, wsa, n == -1, NULL,
+                                          ws2_async_apc, wsa, iosb );
             else
-                err = register_async( ASYNC_TYPE_WRITE, wsa->hSocket, &wsa->io, lpOverlapped->hEvent,
-                                      NULL, (void *)cvalue, iosb );
+                err = register_ws2_async( ASYNC_TYPE_WRITE, wsa, n == -1, lpOverlapped->hEvent,
+                                          NULL, (void *)cvalue, iosb );
 
             /* Enable the event only after starting the async. The server will deliver it as soon as
                the async is done. */
@@ -7986,6 +9693,7 @@ static int WS2_recv_base( SOCKET s, LPWSABUF lpBuffers, DWORD dwBufferCount,
     wsa->control     = lpControlBuffer;
     wsa->n_iovecs    = dwBufferCount;
     wsa->first_iovec = 0;
+    wsa->batch_state = BATCH_NONE;
     for (i = 0; i < dwBufferCount; i++)
     {
         /* check buffer first to trigger write watches */
@@ -8027,15 +9735,17 @@ static int WS2_recv_base( SOCKET s, LPWSABUF lpBuffers, DWORD dwBufferCount,
 
             if (n == -1)
             {
+                BOOL batch = !wsa->control && !(flags & (MSG_OOB | MSG_PEEK));
+
                 iosb->u.Status = STATUS_PENDING;
                 iosb->Information = 0;
 
                 if (wsa->completion_func)
-                    err = register_async( ASYNC_TYPE_READ, wsa->hSocket, &wsa->io, NULL,
-                                          ws2_async_apc, wsa, iosb );
+                    err = register_ws2_async( ASYNC_TYPE_READ, wsa, batch, NULL,
+                                              ws2_async_apc, wsa, iosb );
                 else
-                    err = register_async( ASYNC_TYPE_READ, wsa->hSocket, &wsa->io, lpOverlapped->hEvent,
-                                          NULL, (void *)cvalue, iosb );
+                    err = register_ws2_async( ASYNC_TYPE_READ, wsa, batch, lpOverlapped->hEvent,
+                                              NULL, (void *)cvalue, iosb );
 
                 if (err != STATUS_PENDING) HeapFree( GetProcessHeap(), 0, wsa );
                 SetLastError(NtStatusToWSAError( err ));
@@ -4186,6 +4186,98 @@ todo_wine
     ok(FD_ISSET(fdWrite, &writefds), "fdWrite socket is not in the set\n");
     closesocket(fdWrite);
 }
+
+static void test_select_many(void)
+{
+    SOCKET sockets[24], src;
+    struct sockaddr_in addr[24];
+    fd_set readfds;
+    struct timeval tv;
+    unsigned int i, j;
+    char buffer[4];
+    int ret, len;
+
+    src = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    ok(src != INVALID_SOCKET, "socket failed, error %d\n", WSAGetLastError());
+
+    for (i = 0; i < sizeof(sockets) / sizeof(sockets[0]); i++)
+    {
+        sockets[i] = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        ok(sockets[i] != INVALID_SOCKET, "socket failed, error %d\n", WSAGetLastError());
+        memset(&addr[i], 0, sizeof(addr[i]));
+        addr[i].sin_family = AF_INET;
+        addr[i].sin_addr.s_addr = inet_addr("127.0.0.1");
+        ret = bind(sockets[i], (struct sockaddr *)&addr[i], sizeof(addr[i]));
+        ok(!ret, "bind failed, error %d\n", WSAGetLastError());
+        len = sizeof(addr[i]);
+        ret = getsockname(sockets[i], (struct sockaddr *)&addr[i], &len);
+        ok(!ret, "getsockname failed, error %d\n", WSAGetLastError());
+    }
+
+    /* repeated selects over the same large set, with the ready socket changing */
+    for (j = 0; j < 3; j++)
+    {
+        unsigned int target = 5 + j * 7;
+
+        FD_ZERO(&readfds);
+        for (i = 0; i < sizeof(sockets) / sizeof(sockets[0]); i++) FD_SET(sockets[i], &readfds);
+        tv.tv_sec = 0;
+        tv.tv_usec = 0;
+        ret = select(0, &readfds, NULL, NULL, &tv);
+        ok(!ret, "select returned %d\n", ret);
+
+        ret = sendto(src, "x", 1, 0, (struct sockaddr *)&addr[target], sizeof(addr[target]));
+        ok(ret == 1, "sendto returned %d, error %d\n", ret, WSAGetLastError());
+
+        FD_ZERO(&readfds);
+        for (i = 0; i < sizeof(sockets) / sizeof(sockets[0]); i++) FD_SET(sockets[i], &readfds);
+        tv.tv_sec = 1;
+        ret = select(0, &readfds, NULL, NULL, &tv);
+        ok(ret == 1, "select returned %d\n", ret);
+        ok(readfds.fd_count == 1 && readfds.fd_array[0] == sockets[target],
+           "got %u sockets, first %lx, expected %lx\n", readfds.fd_count,
+           readfds.fd_count ? readfds.fd_array[0] : 0, sockets[target]);
+
+        /* the socket stays ready until the datagram is read */
+        FD_ZERO(&readfds);
+        for (i = 0; i < sizeof(sockets) / sizeof(sockets[0]); i++) FD_SET(sockets[i], &readfds);
+        ret = select(0, &readfds, NULL, NULL, &tv);
+        ok(ret == 1, "select returned %d\n", ret);
+
+        ret = recv(sockets[target], buffer, sizeof(buffer), 0);
+        ok(ret == 1, "recv returned %d, error %d\n", ret, WSAGetLastError());
+
+        /* replace a socket of the set, its handle and fd are likely to be reused */
+        closesocket(sockets[j]);
+        sockets[j] = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        ok(sockets[j] != INVALID_SOCKET, "socket failed, error %d\n", WSAGetLastError());
+        memset(&addr[j], 0, sizeof(addr[j]));
+        addr[j].sin_family = AF_INET;
+        addr[j].sin_addr.s_addr = inet_addr("127.0.0.1");
+        ret = bind(sockets[j], (struct sockaddr *)&addr[j], sizeof(addr[j]));
+        ok(!ret, "bind failed, error %d\n", WSAGetLastError());
+        len = sizeof(addr[j]);
+        ret = getsockname(sockets[j], (struct sockaddr *)&addr[j], &len);
+        ok(!ret, "getsockname failed, error %d\n", WSAGetLastError());
+
+        ret = sendto(src, "x", 1, 0, (struct sockaddr *)&addr[j], sizeof(addr[j]));
+        ok(ret == 1, "sendto returned %d, error %d\n", ret, WSAGetLastError());
+
+        FD_ZERO(&readfds);
+        for (i = 0; i < sizeof(sockets) / sizeof(sockets[0]); i++) FD_SET(sockets[i], &readfds);
+        ret = select(0, &readfds, NULL, NULL, &tv);
+        ok(ret == 1, "select returned %d\n", ret);
+        ok(readfds.fd_count == 1 && readfds.fd_array[0] == sockets[j],
+           "got %u sockets, first %lx, expected %lx\n", readfds.fd_count,
+           readfds.fd_count ? readfds.fd_array[0] : 0, sockets[j]);
+
+        ret = recv(sockets[j], buffer, sizeof(buffer), 0);
+        ok(ret == 1, "recv returned %d, error %d\n", ret, WSAGetLastError());
+    }
+
+    for (i = 0; i < sizeof(sockets) / sizeof(sockets[0]); i++) closesocket(sockets[i]);
+    closesocket(src);
+}
 #undef FD_SET_ALL
 #undef FD_ZERO_ALL
 
@@ -8836,7 +8928,10 @@ static void test_TransmitFile(void)
 {
     DWORD num_bytes, err, file_size, total_sent;
     GUID transmitFileGuid = WSAID_TRANSMITFILE;
+    GUID transmitPacketsGuid = WSAID_TRANSMITPACKETS;
     LPFN_TRANSMITFILE pTransmitFile = NULL;
+    LPFN_TRANSMITPACKETS pTransmitPackets = NULL;
+    TRANSMIT_PACKETS_ELEMENT elements[3];
     HANDLE file = INVALID_HANDLE_VALUE;
     char header_msg[] = "hello world";
     char footer_msg[] = "goodbye!!!";
@@ -9040,6 +9135,39 @@ static void test_TransmitFile(void)
     ok(memcmp(buf, &footer_msg[0], sizeof(footer_msg)) == 0,
        "TransmitFile footer buffer did not match!\n");
 
+    /* Test TransmitPackets with file and buffer data */
+    iret = WSAIoctl(client, SIO_GET_EXTENSION_FUNCTION_POINTER, &transmitPacketsGuid, sizeof(transmitPacketsGuid),
+                    &pTransmitPackets, sizeof(pTransmitPackets), &num_bytes, NULL, NULL);
+    ok(!iret, "WSAIoctl failed to get TransmitPackets with ret %d + errno %d\n", iret, WSAGetLastError());
+    if (pTransmitPackets)
+    {
+        elements[0].dwElFlags = TP_ELEMENT_MEMORY;
+        elements[0].cLength = sizeof(header_msg);
+        elements[0].pBuffer = header_msg;
+        elements[1].dwElFlags = TP_ELEMENT_FILE;
+        elements[1].cLength = 0;
+        elements[1].nFileOffset.QuadPart = 0;
+        elements[1].hFile = file;
+        elements[2].dwElFlags = TP_ELEMENT_MEMORY;
+        elements[2].cLength = sizeof(footer_msg);
+        elements[2].pBuffer = footer_msg;
+        bret = pTransmitPackets(client, elements, 3, 0, NULL, 0);
+        ok(bret, "TransmitPackets failed unexpectedly, error %d.\n", WSAGetLastError());
+        iret = recv(dest, buf, sizeof(header_msg), 0);
+        ok(memcmp(buf, &header_msg[0], sizeof(header_msg)) == 0,
+           "TransmitPackets header buffer did not match!\n");
+        compare_file(file, dest, 0);
+        iret = recv(dest, buf, sizeof(footer_msg), 0);
+        ok(memcmp(buf, &footer_msg[0], sizeof(footer_msg)) == 0,
+           "TransmitPackets footer buffer did not match!\n");
+
+        elements[0].dwElFlags = 0;
+        bret = pTransmitPackets(client, elements, 1, 0, NULL, 0);
+        err = WSAGetLastError();
+        ok(!bret, "TransmitPackets succeeded unexpectedly.\n");
+        ok(err == WSAEINVAL, "TransmitPackets triggered unexpected errno (%d != %d)\n", err, WSAEINVAL);
+    }
+
     /* Test TransmitFile with a UDP datagram socket */
     closesocket(client);
     client = socket(AF_INET, SOCK_DGRAM, 0);
@@ -9055,6 +9183,203 @@ cleanup:
     closesocket(server);
 }
 
+static void test_overlapped_udp_queue(void)
+{
+    struct sockaddr_in addr;
+    OVERLAPPED ovs[4], *ovr;
+    char buffers[4][16], msg[16];
+    SOCKET src, dst;
+    HANDLE port;
+    WSABUF wsabuf;
+    DWORD flags, size;
+    ULONG_PTR key;
+    unsigned int i;
+    int ret, len;
+    BOOL bret;
+
+    src = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    dst = WSASocketA(AF_INET, SOCK_DGRAM, IPPROTO_UDP, NULL, 0, WSA_FLAG_OVERLAPPED);
+    ok(src != INVALID_SOCKET && dst != INVALID_SOCKET, "failed to create sockets, error %d\n", WSAGetLastError());
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    ret = bind(dst, (struct sockaddr *)&addr, sizeof(addr));
+    ok(!ret, "bind failed, error %d\n", WSAGetLastError());
+    len = sizeof(addr);
+    ret = getsockname(dst, (struct sockaddr *)&addr, &len);
+    ok(!ret, "getsockname failed, error %d\n", WSAGetLastError());
+
+    port = CreateIoCompletionPort((HANDLE)dst, NULL, 0x1234, 0);
+    ok(port != NULL, "CreateIoCompletionPort failed, error %u\n", GetLastError());
+
+    /* queue several receives before any data is available */
+    for (i = 0; i < 4; i++)
+    {
+        memset(&ovs[i], 0, sizeof(ovs[i]));
+        memset(buffers[i], 0, sizeof(buffers[i]));
+        wsabuf.buf = buffers[i];
+        wsabuf.len = sizeof(buffers[i]);
+        flags = 0;
+        ret = WSARecv(dst, &wsabuf, 1, NULL, &flags, &ovs[i], NULL);
+        ok(ret == SOCKET_ERROR && WSAGetLastError() == ERROR_IO_PENDING,
+           "WSARecv returned %d, error %d\n", ret, WSAGetLastError());
+    }
+
+    for (i = 0; i < 4; i++)
+    {
+        sprintf(msg, "datagram %u", i);
+        ret = sendto(src, msg, strlen(msg) + 1, 0, (struct sockaddr *)&addr, sizeof(addr));
+        ok(ret == strlen(msg) + 1, "sendto returned %d, error %d\n", ret, WSAGetLastError());
+    }
+
+    for (i = 0; i < 4; i++)
+    {
+        ovr = NULL;
+        bret = GetQueuedCompletionStatus(port, &size, &key, &ovr, 1000);
+        ok(bret, "GetQueuedCompletionStatus failed, error %u\n", GetLastError());
+        ok(key == 0x1234, "got key %#lx\n", key);
+        ok(ovr == &ovs[i], "got overlapped %p, expected %p\n", ovr, &ovs[i]);
+        sprintf(msg, "datagram %u", i);
+        ok(size == strlen(msg) + 1, "got size %u\n", size);
+        ok(!strcmp(buffers[i], msg), "got data %s\n", buffers[i]);
+    }
+
+    closesocket(src);
+    closesocket(dst);
+    CloseHandle(port);
+}
+
+static void test_rio(void)
+{
+    GUID rio_guid = WSAID_MULTIPLE_RIO;
+    RIO_EXTENSION_FUNCTION_TABLE rio;
+    RIO_NOTIFICATION_COMPLETION notify;
+    struct sockaddr_in addr, remote;
+    RIO_BUF data, remote_buf;
+    RIORESULT results[4];
+    RIO_BUFFERID buffer_id;
+    RIO_CQ cq;
+    RIO_RQ rq;
+    SOCKET src, dst;
+    char buffer[256], remote_data[sizeof(SOCKADDR_INET)];
+    DWORD size;
+    int ret, len;
+    ULONG count;
+    BOOL bret;
+
+    src = WSASocketA(AF_INET, SOCK_DGRAM, IPPROTO_UDP, NULL, 0, WSA_FLAG_REGISTERED_IO);
+    dst = WSASocketA(AF_INET, SOCK_DGRAM, IPPROTO_UDP, NULL, 0, WSA_FLAG_REGISTERED_IO);
+    ok(src != INVALID_SOCKET && dst != INVALID_SOCKET, "failed to create sockets, error %d\n", WSAGetLastError());
+
+    memset(&rio, 0, sizeof(rio));
+    ret = WSAIoctl(dst, SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER, &rio_guid, sizeof(rio_guid),
+                   &rio, sizeof(rio), &size, NULL, NULL);
+    if (ret)
+    {
+        win_skip("RIO is not supported, error %d\n", WSAGetLastError());
+        closesocket(src);
+        closesocket(dst);
+        return;
+    }
+    ok(size == sizeof(rio), "got size %u\n", size);
+    ok(rio.cbSize == sizeof(rio), "got cbSize %u\n", rio.cbSize);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    ret = bind(dst, (struct sockaddr *)&addr, sizeof(addr));
+    ok(!ret, "bind failed, error %d\n", WSAGetLastError());
+    len = sizeof(addr);
+    ret = getsockname(dst, (struct sockaddr *)&addr, &len);
+    ok(!ret, "getsockname failed, error %d\n", WSAGetLastError());
+
+    buffer_id = rio.RIORegisterBuffer(buffer, sizeof(buffer));
+    ok(buffer_id != RIO_INVALID_BUFFERID, "RIORegisterBuffer failed, error %d\n", WSAGetLastError());
+
+    notify.Type = RIO_EVENT_COMPLETION;
+    notify.Event.EventHandle = CreateEventW(NULL, FALSE, FALSE, NULL);
+    notify.Event.NotifyReset = TRUE;
+    cq = rio.RIOCreateCompletionQueue(4, &notify);
+    ok(cq != RIO_INVALID_CQ, "RIOCreateCompletionQueue failed, error %d\n", WSAGetLastError());
+    rq = rio.RIOCreateRequestQueue(dst, 2, 1, 2, 1, cq, cq, (void *)0xdeadbeef);
+    ok(rq != RIO_INVALID_RQ, "RIOCreateRequestQueue failed, error %d\n", WSAGetLastError());
+
+    count = rio.RIODequeueCompletion(cq, results, 4);
+    ok(!count, "got %u completions\n", count);
+
+    data.BufferId = buffer_id;
+    data.Offset = 0;
+    data.Length = sizeof(buffer);
+    bret = rio.RIOReceive(rq, &data, 1, 0, (void *)0x1234);
+    ok(bret, "RIOReceive failed, error %d\n", WSAGetLastError());
+
+    ret = rio.RIONotify(cq);
+    ok(!ret, "RIONotify returned %d\n", ret);
+    ret = rio.RIONotify(cq);
+    ok(ret == WSAEALREADY, "RIONotify returned %d\n", ret);
+
+    ret = sendto(src, "hello", 5, 0, (struct sockaddr *)&addr, sizeof(addr));
+    ok(ret == 5, "sendto returned %d, error %d\n", ret, WSAGetLastError());
+
+    ret = WaitForSingleObject(notify.Event.EventHandle, 1000);
+    ok(!ret, "wait returned %d\n", ret);
+    count = rio.RIODequeueCompletion(cq, results, 4);
+    ok(count == 1, "got %u completions\n", count);
+    ok(!results[0].Status, "got status %d\n", results[0].Status);
+    ok(results[0].BytesTransferred == 5, "got %u bytes\n", results[0].BytesTransferred);
+    ok(results[0].SocketContext == 0xdeadbeef, "got socket context %s\n", wine_dbgstr_longlong(results[0].SocketContext));
+    ok(results[0].RequestContext == 0x1234, "got request context %s\n", wine_dbgstr_longlong(results[0].RequestContext));
+    ok(!memcmp(buffer, "hello", 5), "got data %s\n", wine_dbgstr_an(buffer, 5));
+
+    /* send back to the source socket with RIOSendEx */
+    len = sizeof(remote);
+    ret = getsockname(src, (struct sockaddr *)&remote, &len);
+    ok(!ret, "getsockname failed, error %d\n", WSAGetLastError());
+    remote.sin_addr.s_addr = inet_addr("127.0.0.1");
+    memset(remote_data, 0, sizeof(remote_data));
+    memcpy(remote_data, &remote, sizeof(remote));
+    memcpy(buffer, "world", 5);
+    memcpy(buffer + 16, remote_data, sizeof(remote_data));
+    data.BufferId = buffer_id;
+    data.Offset = 0;
+    data.Length = 5;
+    remote_buf.BufferId = buffer_id;
+    remote_buf.Offset = 16;
+    remote_buf.Length = sizeof(remote_data);
+    bret = rio.RIOSendEx(rq, &data, 1, NULL, &remote_buf, NULL, NULL, 0, (void *)0x5678);
+    ok(bret, "RIOSendEx failed, error %d\n", WSAGetLastError());
+
+    ret = rio.RIONotify(cq);
+    ok(!ret, "RIONotify returned %d\n", ret);
+    ret = WaitForSingleObject(notify.Event.EventHandle, 1000);
+    ok(!ret, "wait returned %d\n", ret);
+    count = rio.RIODequeueCompletion(cq, results, 4);
+    ok(count == 1, "got %u completions\n", count);
+    ok(!results[0].Status, "got status %d\n", results[0].Status);
+    ok(results[0].BytesTransferred == 5, "got %u bytes\n", results[0].BytesTransferred);
+    ok(results[0].RequestContext == 0x5678, "got request context %s\n", wine_dbgstr_longlong(results[0].RequestContext));
+
+    memset(buffer + 64, 0, 5);
+    ret = recv(src, buffer + 64, 5, 0);
+    ok(ret == 5, "recv returned %d, error %d\n", ret, WSAGetLastError());
+    ok(!memcmp(buffer + 64, "world", 5), "got data %s\n", wine_dbgstr_an(buffer + 64, 5));
+
+    /* invalid buffer slice */
+    data.Offset = sizeof(buffer) - 1;
+    data.Length = 2;
+    SetLastError(0xdeadbeef);
+    bret = rio.RIOReceive(rq, &data, 1, 0, NULL);
+    ok(!bret, "RIOReceive succeeded\n");
+    ok(WSAGetLastError() == WSAEINVAL, "got error %d\n", WSAGetLastError());
+
+    closesocket(dst);
+    closesocket(src);
+    rio.RIOCloseCompletionQueue(cq);
+    rio.RIODeregisterBuffer(buffer_id);
+    CloseHandle(notify.Event.EventHandle);
+}
+
 static void test_getpeername(void)
 {
     SOCKET sock;
@@ -11527,6 +11852,7 @@ START_TEST( sock )
     test_errors();
     test_listen();
     test_select();
+    test_select_many();
     test_accept();
     test_getpeername();
     test_getsockname();
@@ -11550,6 +11876,8 @@ START_TEST( sock )
 
     test_ipv6only();
     test_TransmitFile();
+    test_overlapped_udp_queue();
+    test_rio();
     test_GetAddrInfoW();
     test_GetAddrInfoExW();
     test_getaddrinfo();
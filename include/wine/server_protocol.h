@@ -263,6 +263,15 @@ typedef struct
 } async_data_t;
 
 
+struct async_result
+{
+    client_ptr_t    user;
+    apc_param_t     total;
+    unsigned int    status;
+    unsigned int    __pad;
+};
+
+
 
 struct hardware_msg_data
 {
@@ -715,6 +724,52 @@ struct rawinput_device
     user_handle_t  target;
 };
 
+struct completion_packet
+{
+    apc_param_t    ckey;
+    apc_param_t    cvalue;
+    apc_param_t    information;
+    unsigned int   status;
+    unsigned int   __pad;
+};
+
+
+typedef volatile struct
+{
+    unsigned int   seq;
+    int            cursor_x;
+    int            cursor_y;
+    unsigned int   cursor_last_change;
+    unsigned char  keystate[256];
+} desktop_shm_t;
+
+
+typedef volatile struct
+{
+    unsigned int   seq;
+    unsigned int   wake_bits;
+    unsigned int   changed_bits;
+} queue_shm_t;
+
+#define HANDLE_CACHE_RING_SIZE 64
+
+/* handles of a process closed without a close_handle request from that process,
+ * used to keep the client-side handle caches coherent */
+typedef volatile struct
+{
+    unsigned int   closed_count;
+    obj_handle_t   closed[HANDLE_CACHE_RING_SIZE];
+} handle_cache_shm_t;
+
+#define ESYNC_SHM_SLOTS 16384
+
+
+typedef volatile struct
+{
+    unsigned int   epoch;
+    int            waiters[2];
+} esync_shm_t;
+
 
 
 
@@ -1105,6 +1160,20 @@ struct close_handle_reply
 
 
 
+struct get_handle_cache_mapping_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct get_handle_cache_mapping_reply
+{
+    struct reply_header __header;
+    obj_handle_t handle;
+    char __pad_12[4];
+};
+
+
+
 struct set_handle_info_request
 {
     struct request_header __header;
@@ -1244,6 +1313,40 @@ struct query_event_reply
 };
 
 
+struct get_esync_fd_request
+{
+    struct request_header __header;
+    obj_handle_t  handle;
+};
+struct get_esync_fd_reply
+{
+    struct reply_header __header;
+    int          type;
+    unsigned int access;
+    unsigned int slot;
+    char __pad_20[4];
+};
+enum esync_type
+{
+    ESYNC_NONE,
+    ESYNC_AUTO_EVENT,
+    ESYNC_MANUAL_EVENT
+};
+
+
+struct get_esync_mapping_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct get_esync_mapping_reply
+{
+    struct reply_header __header;
+    obj_handle_t handle;
+    char __pad_12[4];
+};
+
+
 struct open_event_request
 {
     struct request_header __header;
@@ -1720,6 +1823,23 @@ struct enable_socket_event_reply
     struct reply_header __header;
 };
 
+
+struct complete_socket_asyncs_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+    int          type;
+    char __pad_20[4];
+    client_ptr_t user;
+    /* VARARG(results,async_results); */
+};
+struct complete_socket_asyncs_reply
+{
+    struct reply_header __header;
+    unsigned int done;
+    char __pad_12[4];
+};
+
 struct set_socket_deferred_request
 {
     struct request_header __header;
@@ -3026,6 +3146,20 @@ struct get_queue_status_reply
 
 
 
+struct get_shared_memory_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct get_shared_memory_reply
+{
+    struct reply_header __header;
+    obj_handle_t desktop;
+    obj_handle_t queue;
+};
+
+
+
 struct get_process_idle_event_request
 {
     struct request_header __header;
@@ -5323,6 +5457,19 @@ struct remove_completion_reply
 
 
 
+struct remove_completions_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+};
+struct remove_completions_reply
+{
+    struct reply_header __header;
+    /* VARARG(packets,completion_packets); */
+};
+
+
+
 struct query_completion_request
 {
     struct request_header __header;
@@ -5653,6 +5800,7 @@ enum request
     REQ_queue_apc,
     REQ_get_apc_result,
     REQ_close_handle,
+    REQ_get_handle_cache_mapping,
     REQ_set_handle_info,
     REQ_dup_handle,
     REQ_open_process,
@@ -5661,6 +5809,8 @@ enum request
     REQ_create_event,
     REQ_event_op,
     REQ_query_event,
+    REQ_get_esync_fd,
+    REQ_get_esync_mapping,
     REQ_open_event,
     REQ_create_keyed_event,
     REQ_open_keyed_event,
@@ -5690,6 +5840,7 @@ enum request
     REQ_get_socket_event,
     REQ_get_socket_info,
     REQ_enable_socket_event,
+    REQ_complete_socket_asyncs,
     REQ_set_socket_deferred,
     REQ_alloc_console,
     REQ_free_console,
@@ -5766,6 +5917,7 @@ enum request
     REQ_set_queue_fd,
     REQ_set_queue_mask,
     REQ_get_queue_status,
+    REQ_get_shared_memory,
     REQ_get_process_idle_event,
     REQ_send_message,
     REQ_post_quit_message,
@@ -5900,6 +6052,7 @@ enum request
     REQ_open_completion,
     REQ_add_completion,
     REQ_remove_completion,
+    REQ_remove_completions,
     REQ_query_completion,
     REQ_set_completion_info,
     REQ_add_fd_completion,
@@ -5949,6 +6102,7 @@ union generic_request
     struct queue_apc_request queue_apc_request;
     struct get_apc_result_request get_apc_result_request;
     struct close_handle_request close_handle_request;
+    struct get_handle_cache_mapping_request get_handle_cache_mapping_request;
     struct set_handle_info_request set_handle_info_request;
     struct dup_handle_request dup_handle_request;
     struct open_process_request open_process_request;
@@ -5957,6 +6111,8 @@ union generic_request
     struct create_event_request create_event_request;
     struct event_op_request event_op_request;
     struct query_event_request query_event_request;
+    struct get_esync_fd_request get_esync_fd_request;
+    struct get_esync_mapping_request get_esync_mapping_request;
     struct open_event_request open_event_request;
     struct create_keyed_event_request create_keyed_event_request;
     struct open_keyed_event_request open_keyed_event_request;
@@ -5986,6 +6142,7 @@ union generic_request
     struct get_socket_event_request get_socket_event_request;
     struct get_socket_info_request get_socket_info_request;
     struct enable_socket_event_request enable_socket_event_request;
+    struct complete_socket_asyncs_request complete_socket_asyncs_request;
     struct set_socket_deferred_request set_socket_deferred_request;
     struct alloc_console_request alloc_console_request;
     struct free_console_request free_console_request;
@@ -6062,6 +6219,7 @@ union generic_request
     struct set_queue_fd_request set_queue_fd_request;
     struct set_queue_mask_request set_queue_mask_request;
     struct get_queue_status_request get_queue_status_request;
+    struct get_shared_memory_request get_shared_memory_request;
     struct get_process_idle_event_request get_process_idle_event_request;
     struct send_message_request send_message_request;
     struct post_quit_message_request post_quit_message_request;
@@ -6196,6 +6354,7 @@ union generic_request
     struct open_completion_request open_completion_request;
     struct add_completion_request add_completion_request;
     struct remove_completion_request remove_completion_request;
+    struct remove_completions_request remove_completions_request;
     struct query_completion_request query_completion_request;
     struct set_completion_info_request set_completion_info_request;
     struct add_fd_completion_request add_fd_completion_request;
@@ -6243,6 +6402,7 @@ union generic_reply
     struct queue_apc_reply queue_apc_reply;
     struct get_apc_result_reply get_apc_result_reply;
     struct close_handle_reply close_handle_reply;
+    struct get_handle_cache_mapping_reply get_handle_cache_mapping_reply;
     struct set_handle_info_reply set_handle_info_reply;
     struct dup_handle_reply dup_handle_reply;
     struct open_process_reply open_process_reply;
@@ -6251,6 +6411,8 @@ union generic_reply
     struct create_event_reply create_event_reply;
     struct event_op_reply event_op_reply;
     struct query_event_reply query_event_reply;
+    struct get_esync_fd_reply get_esync_fd_reply;
+    struct get_esync_mapping_reply get_esync_mapping_reply;
     struct open_event_reply open_event_reply;
     struct create_keyed_event_reply create_keyed_event_reply;
     struct open_keyed_event_reply open_keyed_event_reply;
@@ -6280,6 +6442,7 @@ union generic_reply
     struct get_socket_event_reply get_socket_event_reply;
     struct get_socket_info_reply get_socket_info_reply;
     struct enable_socket_event_reply enable_socket_event_reply;
+    struct complete_socket_asyncs_reply complete_socket_asyncs_reply;
     struct set_socket_deferred_reply set_socket_deferred_reply;
     struct alloc_console_reply alloc_console_reply;
     struct free_console_reply free_console_reply;
@@ -6356,6 +6519,7 @@ union generic_reply
     struct set_queue_fd_reply set_queue_fd_reply;
     struct set_queue_mask_reply set_queue_mask_reply;
     struct get_queue_status_reply get_queue_status_reply;
+    struct get_shared_memory_reply get_shared_memory_reply;
     struct get_process_idle_event_reply get_process_idle_event_reply;
     struct send_message_reply send_message_reply;
     struct post_quit_message_reply post_quit_message_reply;
@@ -6490,6 +6654,7 @@ union generic_reply
     struct open_completion_reply open_completion_reply;
     struct add_completion_reply add_completion_reply;
     struct remove_completion_reply remove_completion_reply;
+    struct remove_completions_reply remove_completions_reply;
     struct query_completion_reply query_completion_reply;
     struct set_completion_info_reply set_completion_info_reply;
     struct add_fd_completion_reply add_fd_completion_reply;
@@ -6512,6 +6677,6 @@ union generic_reply
     struct terminate_job_reply terminate_job_reply;
 };
 
-#define SERVER_PROTOCOL_VERSION 554
+#define SERVER_PROTOCOL_VERSION 561
 
 #endif /* __WINE_WINE_SERVER_PROTOCOL_H */
@@ -2263,6 +2263,8 @@ HRESULT __cdecl wined3d_device_get_clip_status(const struct wined3d_device *devi
 struct wined3d_shader * __cdecl wined3d_device_get_compute_shader(const struct wined3d_device *device);
 struct wined3d_buffer * __cdecl wined3d_device_get_constant_buffer(const struct wined3d_device *device,
         enum wined3d_shader_type shader_type, unsigned int idx);
+struct wined3d_buffer * __cdecl wined3d_device_get_constant_buffer_range(const struct wined3d_device *device,
+        enum wined3d_shader_type shader_type, unsigned int idx, unsigned int *offset, unsigned int *size);
 void __cdecl wined3d_device_get_creation_parameters(const struct wined3d_device *device,
         struct wined3d_device_creation_parameters *creation_parameters);
 struct wined3d_shader_resource_view * __cdecl wined3d_device_get_cs_resource_view(const struct wined3d_device *device,
@@ -2377,6 +2379,8 @@ HRESULT __cdecl wined3d_device_set_clip_status(struct wined3d_device *device,
 void __cdecl wined3d_device_set_compute_shader(struct wined3d_device *device, struct wined3d_shader *shader);
 void __cdecl wined3d_device_set_constant_buffer(struct wined3d_device *device, enum wined3d_shader_type type, UINT idx,
         struct wined3d_buffer *buffer);
+void __cdecl wined3d_device_set_constant_buffer_range(struct wined3d_device *device, enum wined3d_shader_type type,
+        unsigned int idx, struct wined3d_buffer *buffer, unsigned int offset, unsigned int size);
 void __cdecl wined3d_device_set_cs_resource_view(struct wined3d_device *device,
         unsigned int idx, struct wined3d_shader_resource_view *view);
 void __cdecl wined3d_device_set_cs_sampler(struct wined3d_device *device,
@@ -0,0 +1,93 @@
+/*
+ * Micro benchmarks for Wine components
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/*
+ * Throughput measurements of the optimized code paths, kept out of the
+ * conformance tests so that those only check behavior.
+ * Usage: winebench [benchmark [count]], all the benchmarks are run by default.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "winebench.h"
+
+static const struct
+{
+    const char *name;
+    int (*func)( unsigned int count );
+    const char *description;
+} benchmarks[] =
+{
+    { "registry", bench_registry, "create, open, enumerate and delete many subkeys of a key" },
+    { "scheduler", bench_scheduler, "run tasks queued by CurrentScheduler::ScheduleTask" },
+    { "wcs", bench_wcs, "msvcrt wide string functions against plain C loops" },
+};
+
+double elapsed_ms( const LARGE_INTEGER *start )
+{
+    LARGE_INTEGER end, freq;
+
+    QueryPerformanceCounter( &end );
+    QueryPerformanceFrequency( &freq );
+    return (end.QuadPart - start->QuadPart) * 1000.0 / freq.QuadPart;
+}
+
+void report( const char *what, unsigned int count, const LARGE_INTEGER *start )
+{
+    double ms = elapsed_ms( start );
+
+    printf( "  %-24s %8u in %10.2f ms, %12.0f/s\n", what, count, ms, ms > 0 ? count * 1000.0 / ms : 0.0 );
+}
+
+static void usage(void)
+{
+    unsigned int i;
+
+    printf( "Usage: winebench [benchmark [count]]\n\nBenchmarks:\n" );
+    for (i = 0; i < ARRAY_SIZE(benchmarks); i++)
+        printf( "  %-12s %s\n", benchmarks[i].name, benchmarks[i].description );
+}
+
+int main( int argc, char *argv[] )
+{
+    unsigned int i, count = 0;
+    int ret = 0, found = 0;
+
+    if (argc > 3 || (argc > 1 && !strcmp( argv[1], "/?" )))
+    {
+        usage();
+        return 0;
+    }
+    if (argc > 2) count = strtoul( argv[2], NULL, 0 );
+
+    for (i = 0; i < ARRAY_SIZE(benchmarks); i++)
+    {
+        if (argc > 1 && strcmp( argv[1], benchmarks[i].name )) continue;
+        printf( "%s:\n", benchmarks[i].name );
+        if (benchmarks[i].func( count )) ret = 1;
+        found = 1;
+    }
+    if (!found)
+    {
+        usage();
+        return 1;
+    }
+    return ret;
+}
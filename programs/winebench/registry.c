@@ -0,0 +1,98 @@
+/*
+ * Registry benchmarks
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include <stdio.h>
+
+#include "winebench.h"
+#include "winreg.h"
+
+/* keys like HKCR\CLSID have tens of thousands of subkeys */
+int bench_registry( unsigned int count )
+{
+    static const char keyname[] = "Software\\Wine\\winebench";
+    char name[16];
+    DWORD len;
+    HKEY hkey, subkey;
+    LARGE_INTEGER start;
+    unsigned int i;
+    LSTATUS ret;
+
+    if (!count) count = 20000;
+
+    RegDeleteTreeA( HKEY_CURRENT_USER, keyname );
+    if ((ret = RegCreateKeyA( HKEY_CURRENT_USER, keyname, &hkey )))
+    {
+        printf( "  failed to create %s: %d\n", keyname, ret );
+        return 1;
+    }
+
+    /* create the subkeys out of order, so that they have to be inserted in the middle */
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++)
+    {
+        sprintf( name, "key%07u", (unsigned int)(((ULONGLONG)i * 7919) % count) );
+        if (!RegCreateKeyA( hkey, name, &subkey )) RegCloseKey( subkey );
+    }
+    report( "create", count, &start );
+
+    /* insertion still moves the following entries of the sorted subkey array,
+     * so adding keys that sort first is the worst case */
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++)
+    {
+        sprintf( name, "a%07u", count - i );
+        if (!RegCreateKeyA( hkey, name, &subkey )) RegCloseKey( subkey );
+    }
+    report( "create first", count, &start );
+
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++)
+    {
+        sprintf( name, "a%07u", i + 1 );
+        RegDeleteKeyA( hkey, name );
+    }
+    report( "delete first", count, &start );
+
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++)
+    {
+        sprintf( name, "KEY%07u", i );
+        if (!RegOpenKeyA( hkey, name, &subkey )) RegCloseKey( subkey );
+    }
+    report( "open", count, &start );
+
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++)
+    {
+        len = sizeof(name);
+        RegEnumKeyExA( hkey, i, name, &len, NULL, NULL, NULL, NULL );
+    }
+    report( "enumerate", count, &start );
+
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++)
+    {
+        sprintf( name, "key%07u", i );
+        RegDeleteKeyA( hkey, name );
+    }
+    report( "delete", count, &start );
+
+    RegCloseKey( hkey );
+    RegDeleteTreeA( HKEY_CURRENT_USER, keyname );
+    return 0;
+}
@@ -0,0 +1,95 @@
+/*
+ * Concurrency Runtime scheduler benchmarks
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include <stdio.h>
+
+#include "winebench.h"
+
+static void (__cdecl *pScheduleTask)(void (__cdecl *)(void *), void *);
+
+static LONG task_count;
+static HANDLE tasks_done;
+
+static void __cdecl counting_task( void *arg )
+{
+    if (!InterlockedDecrement( &task_count )) SetEvent( tasks_done );
+}
+
+/* queues its tasks on the queue of a worker, so that the other workers have to steal them */
+static void __cdecl spawning_task( void *arg )
+{
+    int i;
+
+    for (i = 0; i < PtrToInt( arg ); i++) pScheduleTask( counting_task, NULL );
+    counting_task( NULL );
+}
+
+static int wait_tasks( const char *what )
+{
+    if (WaitForSingleObject( tasks_done, 60000 ) == WAIT_OBJECT_0) return 0;
+    printf( "  %s: timed out with %d tasks left\n", what, task_count );
+    return 1;
+}
+
+int bench_scheduler( unsigned int count )
+{
+    HMODULE module;
+    LARGE_INTEGER start;
+    unsigned int i;
+    int ret = 0;
+
+    if (!(module = LoadLibraryA( "msvcr100.dll" )))
+    {
+        printf( "  msvcr100.dll not available\n" );
+        return 1;
+    }
+#ifdef _WIN64
+    pScheduleTask = (void *)GetProcAddress( module, "?ScheduleTask@CurrentScheduler@Concurrency@@SAXP6AXPEAX@Z0@Z" );
+#else
+    pScheduleTask = (void *)GetProcAddress( module, "?ScheduleTask@CurrentScheduler@Concurrency@@SAXP6AXPAX@Z0@Z" );
+#endif
+    if (!pScheduleTask)
+    {
+        printf( "  CurrentScheduler::ScheduleTask not available\n" );
+        FreeLibrary( module );
+        return 1;
+    }
+
+    if (!count) count = 200000;
+    count = max( count - count % 101, 101 );
+    tasks_done = CreateEventA( NULL, FALSE, FALSE, NULL );
+
+    /* all the tasks are queued from an external context */
+    task_count = count;
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++) pScheduleTask( counting_task, NULL );
+    if (!(ret = wait_tasks( "spawn" ))) report( "spawn", count, &start );
+
+    /* the tasks are queued from the workers */
+    if (!ret)
+    {
+        task_count = count;
+        QueryPerformanceCounter( &start );
+        for (i = 0; i < count / 101; i++) pScheduleTask( spawning_task, IntToPtr( 100 ) );
+        if (!(ret = wait_tasks( "steal" ))) report( "steal", count, &start );
+    }
+
+    CloseHandle( tasks_done );
+    FreeLibrary( module );
+    return ret;
+}
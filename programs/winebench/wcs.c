@@ -0,0 +1,117 @@
+/*
+ * msvcrt wide string function benchmarks
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <wctype.h>
+
+#include "winebench.h"
+
+/* plain C versions to compare with */
+
+static size_t __cdecl ref_wcslen( const WCHAR *str )
+{
+    const WCHAR *s = str;
+    while (*s) s++;
+    return s - str;
+}
+
+static WCHAR * __cdecl ref_wcschr( const WCHAR *str, WCHAR ch )
+{
+    do { if (*str == ch) return (WCHAR *)str; } while (*str++);
+    return NULL;
+}
+
+static int __cdecl ref_wcscmp( const WCHAR *str1, const WCHAR *str2 )
+{
+    while (*str1 && *str1 == *str2) { str1++; str2++; }
+    return *str1 - *str2;
+}
+
+static int __cdecl ref_wcsicmp( const WCHAR *str1, const WCHAR *str2 )
+{
+    int ret;
+
+    for (;;)
+    {
+        if ((ret = towlower( *str1 ) - towlower( *str2 )) || !*str1) return ret;
+        str1++;
+        str2++;
+    }
+}
+
+int bench_wcs( unsigned int count )
+{
+    size_t (__cdecl *p_wcslen)(const WCHAR *);
+    WCHAR * (__cdecl *p_wcschr)(const WCHAR *, WCHAR);
+    int (__cdecl *p_wcscmp)(const WCHAR *, const WCHAR *);
+    int (__cdecl *p__wcsicmp)(const WCHAR *, const WCHAR *);
+    static WCHAR str[0x800], str2[0x800];
+    volatile size_t sum = 0;
+    LARGE_INTEGER start;
+    HMODULE module;
+    unsigned int i;
+
+    /* call through pointers so that the compiler doesn't use its builtins */
+    module = GetModuleHandleA( "msvcrt.dll" );
+    p_wcslen = (void *)GetProcAddress( module, "wcslen" );
+    p_wcschr = (void *)GetProcAddress( module, "wcschr" );
+    p_wcscmp = (void *)GetProcAddress( module, "wcscmp" );
+    p__wcsicmp = (void *)GetProcAddress( module, "_wcsicmp" );
+    if (!p_wcslen || !p_wcschr || !p_wcscmp || !p__wcsicmp)
+    {
+        printf( "  msvcrt wide string functions not available\n" );
+        return 1;
+    }
+
+    if (!count) count = 100000;
+    for (i = 0; i < ARRAY_SIZE(str) - 1; i++) str[i] = 'a' + i % 26;
+    memcpy( str2, str, sizeof(str) );
+
+    printf( "  %u calls on %u character strings\n", count, (unsigned int)ARRAY_SIZE(str) - 1 );
+
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++) sum += p_wcslen( str );
+    report( "wcslen", count, &start );
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++) sum += ref_wcslen( str );
+    report( "wcslen (generic)", count, &start );
+
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++) sum += (size_t)p_wcschr( str, '#' );
+    report( "wcschr", count, &start );
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++) sum += (size_t)ref_wcschr( str, '#' );
+    report( "wcschr (generic)", count, &start );
+
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++) sum += p_wcscmp( str, str2 );
+    report( "wcscmp", count, &start );
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++) sum += ref_wcscmp( str, str2 );
+    report( "wcscmp (generic)", count, &start );
+
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++) sum += p__wcsicmp( str, str2 );
+    report( "_wcsicmp", count, &start );
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++) sum += ref_wcsicmp( str, str2 );
+    report( "_wcsicmp (generic)", count, &start );
+
+    return 0;
+}
@@ -0,0 +1,32 @@
+/*
+ * Micro benchmarks for Wine components
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include <stdarg.h>
+
+#include "windef.h"
+#include "winbase.h"
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+/* benchmarks take an optional iteration count, 0 selects the default */
+extern int bench_registry( unsigned int count );
+extern int bench_scheduler( unsigned int count );
+extern int bench_wcs( unsigned int count );
+
+extern double elapsed_ms( const LARGE_INTEGER *start );
+extern void report( const char *what, unsigned int count, const LARGE_INTEGER *start );
@@ -53,12 +53,17 @@ struct async
     int                  direct_result;   /* a flag if we're passing result directly from request instead of APC  */
     struct completion   *completion;      /* completion associated with fd */
     apc_param_t          comp_key;        /* completion key associated with fd */
+    struct list          batch;           /* asyncs to complete right after this one */
+    struct list          batch_entry;     /* entry in the batch list of another async */
+    unsigned int         batch_status;    /* status to report when completed as part of a batch */
+    apc_param_t          batch_total;     /* bytes transferred when completed as part of a batch */
 };
 
 static void async_dump( struct object *obj, int verbose );
 static int async_signaled( struct object *obj, struct wait_queue_entry *entry );
 static void async_satisfied( struct object * obj, struct wait_queue_entry *entry );
 static void async_destroy( struct object *obj );
+static void async_complete_batch( struct async *async );
 
 static const struct object_ops async_ops =
 {
@@ -115,7 +120,7 @@ static void async_satisfied( struct object *obj, struct wait_queue_entry *entry
     /* close wait handle here to avoid extra server round trip */
     if (async->wait_handle)
     {
-        close_handle( async->thread->process, async->wait_handle );
+        close_handle_no_notify( async->thread->process, async->wait_handle );
         async->wait_handle = 0;
     }
 }
@@ -126,6 +131,7 @@ static void async_destroy( struct object *obj )
     assert( obj->ops == &async_ops );
 
     list_remove( &async->process_entry );
+    async_complete_batch( async );  /* in case the thread died before reporting its own result */
 
     if (async->queue)
     {
@@ -239,6 +245,7 @@ struct async *create_async( struct fd *fd, struct thread *thread, const async_da
     async->wait_handle   = 0;
     async->direct_result = 0;
     async->completion    = fd_get_completion( fd, &async->comp_key );
+    list_init( &async->batch );
 
     if (iosb) async->iosb = (struct iosb *)grab_object( iosb );
     else async->iosb = NULL;
@@ -285,7 +292,7 @@ obj_handle_t async_handoff( struct async *async, int success, data_size_t *resul
 {
     if (!success)
     {
-        close_handle( async->thread->process, async->wait_handle );
+        close_handle_no_notify( async->thread->process, async->wait_handle );
         async->wait_handle = 0;
         return 0;
     }
@@ -315,7 +322,7 @@ obj_handle_t async_handoff( struct async *async, int success, data_size_t *resul
         async->direct_result = 0;
         if (!async_is_blocking( async ))
         {
-            close_handle( async->thread->process, async->wait_handle);
+            close_handle_no_notify( async->thread->process, async->wait_handle);
             async->wait_handle = 0;
         }
     }
@@ -364,7 +371,11 @@ void async_set_result( struct object *obj, unsigned int status, apc_param_t tota
         if (async->timeout) remove_timeout_user( async->timeout );
         async->timeout = NULL;
         async->status = status;
-        if (status == STATUS_MORE_PROCESSING_REQUIRED) return;  /* don't report the completion */
+        if (status == STATUS_MORE_PROCESSING_REQUIRED)  /* don't report the completion */
+        {
+            async_complete_batch( async );
+            return;
+        }
 
         if (async->data.apc)
         {
@@ -388,6 +399,53 @@ void async_set_result( struct object *obj, unsigned int status, apc_param_t tota
             wake_up( &async->obj, 0 );
         }
     }
+    async_complete_batch( async );
+}
+
+/* report the results of the asyncs that were done as part of the batch of another one */
+static void async_complete_batch( struct async *async )
+{
+    struct async *batched, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE( batched, next, &async->batch, struct async, batch_entry )
+    {
+        list_remove( &batched->batch_entry );
+        async_set_result( &batched->obj, batched->batch_status, batched->batch_total );
+        async_reselect( batched );
+        release_object( batched );  /* it is no longer in use by the batch */
+    }
+}
+
+static struct async *find_queued_async( struct async_queue *queue, struct process *process, client_ptr_t user )
+{
+    struct async *async;
+
+    LIST_FOR_EACH_ENTRY( async, &queue->queue, struct async, queue_entry )
+        if (async->data.user == user && async->thread->process == process) return async;
+    return NULL;
+}
+
+/* attach to a woken up async the result of a queued async whose I/O the client did at the same time;
+ * it gets reported right after the result of the woken up async, so that completions stay in order */
+int async_add_to_batch( struct async_queue *queue, struct process *process, client_ptr_t first,
+                        client_ptr_t user, unsigned int status, apc_param_t total )
+{
+    struct async *owner, *async;
+
+    assert( status != STATUS_PENDING );
+
+    if (!(owner = find_queued_async( queue, process, first ))) return 0;
+    if (owner->status == STATUS_PENDING || owner->signaled) return 0;  /* result already reported */
+    if (!(async = find_queued_async( queue, process, user ))) return 0;
+    if (async->status != STATUS_PENDING) return 0;  /* already woken up, the client will get the result */
+
+    /* the reference held by the queue is now held by the batch */
+    async->status = STATUS_ALERTED;
+    async->batch_status = status;
+    async->batch_total = total;
+    list_add_tail( &owner->batch, &async->batch_entry );
+    async_reselect( async );
+    return 1;
 }
 
 /* check if an async operation is waiting to be alerted */
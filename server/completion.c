@@ -240,6 +240,41 @@ DECL_HANDLER(remove_completion)
     release_object( completion );
 }
 
+/* get several completions from completion port */
+DECL_HANDLER(remove_completions)
+{
+    struct completion* completion = get_completion_obj( current->process, req->handle, IO_COMPLETION_MODIFY_STATE );
+    struct completion_packet *packet;
+    struct list *entry;
+    struct comp_msg *msg;
+    data_size_t count;
+
+    if (!completion) return;
+
+    count = min( completion->depth, get_reply_max_size() / sizeof(*packet) );
+    if (!count)
+        set_error( list_empty( &completion->queue ) ? STATUS_PENDING : STATUS_BUFFER_TOO_SMALL );
+    else if ((packet = set_reply_data_size( count * sizeof(*packet) )))
+    {
+        while (count--)
+        {
+            entry = list_head( &completion->queue );
+            list_remove( entry );
+            completion->depth--;
+            msg = LIST_ENTRY( entry, struct comp_msg, queue_entry );
+            packet->ckey        = msg->ckey;
+            packet->cvalue      = msg->cvalue;
+            packet->information = msg->information;
+            packet->status      = msg->status;
+            packet->__pad       = 0;
+            packet++;
+            free( msg );
+        }
+    }
+
+    release_object( completion );
+}
+
 /* get queue depth for completion port */
 DECL_HANDLER(query_completion)
 {
@@ -22,9 +22,17 @@
 #include "wine/port.h"
 
 #include <assert.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#ifdef HAVE_POLL_H
+#include <poll.h>
+#endif
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
+#include <unistd.h>
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -32,31 +40,42 @@
 #include "winternl.h"
 
 #include "handle.h"
+#include "file.h"
 #include "thread.h"
 #include "request.h"
 #include "security.h"
 
 struct event
 {
-    struct object  obj;             /* object header */
-    int            manual_reset;    /* is it a manual reset event? */
-    int            signaled;        /* event has been signaled */
+    struct object        obj;             /* object header */
+    int                  manual_reset;    /* is it a manual reset event? */
+    int                  signaled;        /* event has been signaled (eventfd count taken by the server with esync) */
+    struct fd           *esync_fd;        /* eventfd holding the state for client-side waits */
+    struct timeout_user *esync_timeout;   /* timeout to poll the eventfd again */
+    struct timeout_user *esync_release;   /* timeout to give back an unused eventfd count */
+    unsigned int         esync_slot;      /* index of the esync_shm_t of the event */
+    struct timeout_user *pulse_timeout;   /* timeout to check for the end of a pulse */
+    unsigned int         pulse_epoch;     /* epoch of the client-side waiters woken up by the pulse */
 };
 
 static void event_dump( struct object *obj, int verbose );
 static struct object_type *event_get_type( struct object *obj );
+static int event_add_queue( struct object *obj, struct wait_queue_entry *entry );
+static void event_remove_queue( struct object *obj, struct wait_queue_entry *entry );
 static int event_signaled( struct object *obj, struct wait_queue_entry *entry );
 static void event_satisfied( struct object *obj, struct wait_queue_entry *entry );
 static unsigned int event_map_access( struct object *obj, unsigned int access );
 static int event_signal( struct object *obj, unsigned int access);
+static void event_destroy( struct object *obj );
+static void event_poll_event( struct fd *fd, int event );
 
 static const struct object_ops event_ops =
 {
     sizeof(struct event),      /* size */
     event_dump,                /* dump */
     event_get_type,            /* get_type */
-    add_queue,                 /* add_queue */
-    remove_queue,              /* remove_queue */
+    event_add_queue,           /* add_queue */
+    event_remove_queue,        /* remove_queue */
     event_signaled,            /* signaled */
     event_satisfied,           /* satisfied */
     event_signal,              /* signal */
@@ -69,7 +88,22 @@ static const struct object_ops event_ops =
     default_unlink_name,       /* unlink_name */
     no_open_file,              /* open_file */
     no_close_handle,           /* close_handle */
-    no_destroy                 /* destroy */
+    event_destroy              /* destroy */
+};
+
+static const struct fd_ops event_fd_ops =
+{
+    NULL,                      /* get_poll_events */
+    event_poll_event,          /* poll_event */
+    NULL,                      /* get_fd_type */
+    no_fd_read,                /* read */
+    no_fd_write,               /* write */
+    no_fd_flush,               /* flush */
+    no_fd_get_file_info,       /* get_file_info */
+    no_fd_get_volume_info,     /* get_volume_info */
+    no_fd_ioctl,               /* ioctl */
+    no_fd_queue_async,         /* queue_async */
+    NULL                       /* reselect_async */
 };
 
 
@@ -106,6 +140,74 @@ static const struct object_ops keyed_event_ops =
 };
 
 
+/* check if events are backed by an eventfd that clients can wait on directly */
+static int do_esync(void)
+{
+#ifdef HAVE_SYS_EVENTFD_H
+    static int esync = -1;
+
+    if (esync == -1)
+    {
+        const char *env = getenv( "WINEESYNC" );
+        esync = env && atoi( env );
+    }
+    return esync;
+#else
+    return 0;
+#endif
+}
+
+static struct mapping *esync_mapping;      /* mapping of the esync_shm_t array */
+static esync_shm_t *esync_shm;             /* server view of the esync_shm_t array */
+static unsigned int esync_free[ESYNC_SHM_SLOTS];  /* stack of the free slots */
+static unsigned int esync_free_count;      /* number of slots in the free stack */
+static unsigned int esync_used_slots;      /* number of slots used at least once */
+
+static int alloc_esync_slot( unsigned int *slot )
+{
+    if (!esync_mapping)
+    {
+        void *ptr;
+
+        if (!(esync_mapping = create_shared_mapping( ESYNC_SHM_SLOTS * sizeof(esync_shm_t), &ptr )))
+            return 0;
+        make_object_static( (struct object *)esync_mapping );
+        esync_shm = ptr;
+    }
+    if (esync_free_count) *slot = esync_free[--esync_free_count];
+    else if (esync_used_slots < ESYNC_SHM_SLOTS) *slot = esync_used_slots++;
+    else return 0;
+
+    esync_shm[*slot].epoch = 0;
+    esync_shm[*slot].waiters[0] = esync_shm[*slot].waiters[1] = 0;
+    return 1;
+}
+
+static int esync_is_signaled( struct event *event )
+{
+    struct pollfd pfd;
+
+    pfd.fd     = get_unix_fd( event->esync_fd );
+    pfd.events = POLLIN;
+    return poll( &pfd, 1, 0 ) > 0;
+}
+
+static void esync_set( struct event *event )
+{
+    unsigned __int64 value = 1;
+
+    if (write( get_unix_fd( event->esync_fd ), &value, sizeof(value) ) == -1 && errno != EAGAIN)
+        file_set_error();
+}
+
+/* returns 1 if the event was signaled, only one reader can consume an auto-reset event */
+static int esync_reset( struct event *event )
+{
+    unsigned __int64 value;
+
+    return read( get_unix_fd( event->esync_fd ), &value, sizeof(value) ) == sizeof(value);
+}
+
 struct event *create_event( struct object *root, const struct unicode_str *name,
                             unsigned int attr, int manual_reset, int initial_state,
                             const struct security_descriptor *sd )
@@ -117,8 +219,23 @@ struct event *create_event( struct object *root, const struct unicode_str *name,
         if (get_error() != STATUS_OBJECT_NAME_EXISTS)
         {
             /* initialize it if it didn't already exist */
-            event->manual_reset = manual_reset;
-            event->signaled     = initial_state;
+            event->manual_reset  = manual_reset;
+            event->signaled      = initial_state;
+            event->esync_fd      = NULL;
+            event->esync_timeout = NULL;
+            event->esync_release = NULL;
+            event->pulse_timeout = NULL;
+#ifdef HAVE_SYS_EVENTFD_H
+            if (do_esync() && alloc_esync_slot( &event->esync_slot ))
+            {
+                int fd = eventfd( initial_state ? 1 : 0, EFD_CLOEXEC | EFD_NONBLOCK );
+
+                if (fd != -1) event->esync_fd = create_anonymous_fd( &event_fd_ops, fd, &event->obj, 0 );
+                if (!event->esync_fd) esync_free[esync_free_count++] = event->esync_slot;
+                else event->signaled = 0;  /* the state is in the eventfd */
+            }
+            if (do_esync() && !event->esync_fd) clear_error();  /* fall back to server-side state */
+#endif
         }
     }
     return event;
@@ -129,8 +246,51 @@ struct event *get_event_obj( struct process *process, obj_handle_t handle, unsig
     return (struct event *)get_handle_obj( process, handle, access, &event_ops );
 }
 
+static void end_pulse( struct event *event )
+{
+    if (event->pulse_timeout) remove_timeout_user( event->pulse_timeout );
+    event->pulse_timeout = NULL;
+}
+
+/* check if the client-side waiters woken up by a pulse are gone */
+static int pulse_done( struct event *event )
+{
+    esync_shm_t *shm = &esync_shm[event->esync_slot];
+
+    __sync_synchronize();
+    /* waiters that started after the pulse are released too for manual-reset events,
+     * but don't wait for them so that pulses can't turn into a set */
+    if (event->manual_reset) return shm->waiters[event->pulse_epoch & 1] <= 0;
+    return !esync_is_signaled( event ) || shm->waiters[0] + shm->waiters[1] <= 0;
+}
+
+static void pulse_timeout( void *private )
+{
+    struct event *event = private;
+
+    event->pulse_timeout = NULL;
+    if (!pulse_done( event ))
+        event->pulse_timeout = add_timeout_user( -TICKS_PER_SEC / 1000, pulse_timeout, event );
+    else
+    {
+        esync_reset( event );
+        event->signaled = 0;
+    }
+}
+
 void pulse_event( struct event *event )
 {
+    if (event->esync_fd)
+    {
+        /* the clients polling the eventfd only see the pulse if it's still signaled
+         * when they get to run, so keep it set until they have woken up */
+        esync_set( event );
+        wake_up( &event->obj, !event->manual_reset );
+        if (event->pulse_timeout) return;
+        event->pulse_epoch = esync_shm[event->esync_slot].epoch++;
+        pulse_timeout( event );
+        return;
+    }
     event->signaled = 1;
     /* wake up all waiters if manual reset, a single one otherwise */
     wake_up( &event->obj, !event->manual_reset );
@@ -139,13 +299,24 @@ void pulse_event( struct event *event )
 
 void set_event( struct event *event )
 {
-    event->signaled = 1;
+    if (event->esync_fd)
+    {
+        end_pulse( event );
+        /* the server already holds the count of a signaled auto-reset event */
+        if (!event->signaled) esync_set( event );
+    }
+    else event->signaled = 1;
     /* wake up all waiters if manual reset, a single one otherwise */
     wake_up( &event->obj, !event->manual_reset );
 }
 
 void reset_event( struct event *event )
 {
+    if (event->esync_fd)
+    {
+        end_pulse( event );
+        esync_reset( event );
+    }
     event->signaled = 0;
 }
 
@@ -153,8 +324,9 @@ static void event_dump( struct object *obj, int verbose )
 {
     struct event *event = (struct event *)obj;
     assert( obj->ops == &event_ops );
-    fprintf( stderr, "Event manual=%d signaled=%d\n",
-             event->manual_reset, event->signaled );
+    fprintf( stderr, "Event manual=%d signaled=%d esync=%d\n",
+             event->manual_reset, event_signaled( obj, NULL ),
+             event->esync_fd ? get_unix_fd( event->esync_fd ) : -1 );
 }
 
 static struct object_type *event_get_type( struct object *obj )
@@ -164,10 +336,58 @@ static struct object_type *event_get_type( struct object *obj )
     return get_object_type( &str );
 }
 
+static int event_add_queue( struct object *obj, struct wait_queue_entry *entry )
+{
+    struct event *event = (struct event *)obj;
+    assert( obj->ops == &event_ops );
+
+    /* clients can signal the eventfd directly, so watch it while we have waiters */
+    if (event->esync_fd && list_empty( &obj->wait_queue )) set_fd_events( event->esync_fd, POLLIN );
+    add_queue( obj, entry );
+    return 1;
+}
+
+static void event_remove_queue( struct object *obj, struct wait_queue_entry *entry )
+{
+    struct event *event = (struct event *)obj;
+    assert( obj->ops == &event_ops );
+
+    remove_queue( obj, entry );
+    if (event->esync_fd && list_empty( &obj->wait_queue ))
+    {
+        set_fd_events( event->esync_fd, 0 );
+        if (event->esync_timeout) remove_timeout_user( event->esync_timeout );
+        event->esync_timeout = NULL;
+    }
+}
+
+/* give back an eventfd count taken by event_signaled() that no wait consumed */
+static void esync_release_timeout( void *private )
+{
+    struct event *event = private;
+
+    event->esync_release = NULL;
+    if (!event->signaled) return;
+    event->signaled = 0;
+    esync_set( event );
+}
+
 static int event_signaled( struct object *obj, struct wait_queue_entry *entry )
 {
     struct event *event = (struct event *)obj;
     assert( obj->ops == &event_ops );
+    if (!event->esync_fd) return event->signaled;
+    if (event->manual_reset || !entry) return event->signaled || esync_is_signaled( event );
+
+    /* take the count of an auto-reset event when checking it, so that a client
+     * can't consume it before event_satisfied(); a wait for all objects may
+     * still not be satisfied, in which case the count is given back later */
+    if (!event->signaled && esync_reset( event ))
+    {
+        event->signaled = 1;
+        if (!event->esync_release)
+            event->esync_release = add_timeout_user( 0, esync_release_timeout, event );
+    }
     return event->signaled;
 }
 
@@ -175,8 +395,49 @@ static void event_satisfied( struct object *obj, struct wait_queue_entry *entry
 {
     struct event *event = (struct event *)obj;
     assert( obj->ops == &event_ops );
-    /* Reset if it's an auto-reset event */
-    if (!event->manual_reset) event->signaled = 0;
+    /* Reset if it's an auto-reset event, with esync the count was taken by event_signaled() */
+    if (event->manual_reset) return;
+    event->signaled = 0;
+}
+
+static void esync_poll_timeout( void *private )
+{
+    struct event *event = private;
+
+    event->esync_timeout = NULL;
+    set_fd_events( event->esync_fd, POLLIN );
+}
+
+static void event_poll_event( struct fd *fd, int event_mask )
+{
+    struct event *event = get_fd_user( fd );
+    assert( event->obj.ops == &event_ops );
+
+    wake_up( &event->obj, 0 );
+
+    /* remaining waiters are waiting for other objects too, don't spin on the eventfd
+     * while it stays signaled but check it again from time to time */
+    if (!list_empty( &event->obj.wait_queue ) && !event->esync_timeout
+        && (event->signaled || esync_is_signaled( event )))
+    {
+        set_fd_events( fd, 0 );
+        event->esync_timeout = add_timeout_user( -TICKS_PER_SEC / 100, esync_poll_timeout, event );
+    }
+}
+
+static void event_destroy( struct object *obj )
+{
+    struct event *event = (struct event *)obj;
+    assert( obj->ops == &event_ops );
+
+    if (event->esync_timeout) remove_timeout_user( event->esync_timeout );
+    if (event->esync_release) remove_timeout_user( event->esync_release );
+    if (event->pulse_timeout) remove_timeout_user( event->pulse_timeout );
+    if (event->esync_fd)
+    {
+        release_object( event->esync_fd );
+        esync_free[esync_free_count++] = event->esync_slot;
+    }
 }
 
 static unsigned int event_map_access( struct object *obj, unsigned int access )
@@ -337,11 +598,47 @@ DECL_HANDLER(query_event)
     if (!(event = get_event_obj( current->process, req->handle, EVENT_QUERY_STATE ))) return;
 
     reply->manual_reset = event->manual_reset;
-    reply->state = event->signaled;
+    reply->state = event_signaled( &event->obj, NULL );
+
+    release_object( event );
+}
+
+/* retrieve the eventfd backing an event */
+DECL_HANDLER(get_esync_fd)
+{
+    struct event *event;
+
+    if (!do_esync())
+    {
+        set_error( STATUS_NOT_IMPLEMENTED );
+        return;
+    }
+    if (!(event = (struct event *)get_handle_obj( current->process, req->handle, 0, NULL ))) return;
+
+    if (event->obj.ops == &event_ops && event->esync_fd)
+    {
+        reply->type   = event->manual_reset ? ESYNC_MANUAL_EVENT : ESYNC_AUTO_EVENT;
+        reply->access = get_handle_access( current->process, req->handle );
+        reply->slot   = event->esync_slot;
+        send_client_fd( current->process, get_unix_fd( event->esync_fd ), req->handle );
+    }
+    else reply->type = ESYNC_NONE;
 
     release_object( event );
 }
 
+/* get the mapping of the esync_shm_t array */
+DECL_HANDLER(get_esync_mapping)
+{
+    if (!esync_mapping)
+    {
+        set_error( STATUS_NOT_IMPLEMENTED );
+        return;
+    }
+    reply->handle = alloc_handle( current->process, esync_mapping,
+                                  SECTION_MAP_READ | SECTION_MAP_WRITE | SECTION_QUERY, 0 );
+}
+
 /* create a keyed event */
 DECL_HANDLER(create_keyed_event)
 {
@@ -291,10 +291,66 @@ static int file_get_poll_events( struct fd *fd )
     return events;
 }
 
+struct flush_job
+{
+    int           unix_fd;   /* dup of the file unix fd */
+    int           error;     /* errno of a failed fsync */
+    struct async *async;     /* async waiting for the flush */
+};
+
+/* called on a worker thread */
+static unsigned int flush_job_func( void *arg )
+{
+    struct flush_job *job = arg;
+
+    if (fsync( job->unix_fd ) != -1) return STATUS_SUCCESS;
+    job->error = errno;
+    return STATUS_UNSUCCESSFUL;
+}
+
+static void flush_job_callback( void *arg, unsigned int status )
+{
+    struct flush_job *job = arg;
+
+    if (status)
+    {
+        errno = job->error;
+        file_set_error();
+        status = get_error();
+        clear_error();
+    }
+    close( job->unix_fd );
+    async_terminate( job->async, status );
+    release_object( job->async );
+    free( job );
+}
+
 static int file_flush( struct fd *fd, struct async *async )
 {
     int unix_fd = get_unix_fd( fd );
-    if (unix_fd != -1 && fsync( unix_fd ) == -1)
+    struct flush_job *job;
+
+    if (unix_fd == -1) return 1;
+
+    /* fsync can take a long time, don't block the whole server if we can avoid it */
+    if ((job = mem_alloc( sizeof(*job) )))
+    {
+        if ((job->unix_fd = dup( unix_fd )) != -1)
+        {
+            job->async = (struct async *)grab_object( async );
+            if (queue_worker_job( flush_job_func, flush_job_callback, job ))
+            {
+                set_error( STATUS_PENDING );
+                return 1;
+            }
+            release_object( async );
+            close( job->unix_fd );
+        }
+        free( job );
+    }
+    clear_error();
+
+    if (fsync( unix_fd ) == -1)
     {
         file_set_error();
         return 0;
@@ -150,6 +150,7 @@ extern mode_t sd_to_mode( const struct security_descriptor *sd, const SID *owner
 
 /* file mapping functions */
 
+extern struct mapping *create_shared_mapping( mem_size_t size, void **ptr );
 extern struct mapping *get_mapping_obj( struct process *process, obj_handle_t handle,
                                         unsigned int access );
 extern struct file *get_mapping_file( struct process *process, client_ptr_t base,
@@ -191,6 +192,8 @@ extern void queue_async( struct async_queue *queue, struct async *async );
 extern void async_set_timeout( struct async *async, timeout_t timeout, unsigned int status );
 extern void async_set_result( struct object *obj, unsigned int status, apc_param_t total );
 extern int async_waiting( struct async_queue *queue );
+extern int async_add_to_batch( struct async_queue *queue, struct process *process, client_ptr_t first,
+                               client_ptr_t user, unsigned int status, apc_param_t total );
 extern void async_terminate( struct async *async, unsigned int status );
 extern void async_wake_up( struct async_queue *queue, unsigned int status );
 extern struct completion *fd_get_completion( struct fd *fd, apc_param_t *p_key );
@@ -34,6 +34,7 @@
 #include "winternl.h"
 
 #include "handle.h"
+#include "file.h"
 #include "process.h"
 #include "thread.h"
 #include "security.h"
@@ -383,7 +384,8 @@ struct handle_table *copy_handle_table( struct process *process, struct process
 }
 
 /* close a handle and decrement the refcount of the associated object */
-unsigned int close_handle( struct process *process, obj_handle_t handle )
+/* the client handle caches are not notified, the client has to take care of it */
+unsigned int close_handle_no_notify( struct process *process, obj_handle_t handle )
 {
     struct handle_table *table;
     struct handle_entry *entry;
@@ -401,6 +403,21 @@ unsigned int close_handle( struct process *process, obj_handle_t handle )
     return STATUS_SUCCESS;
 }
 
+/* close a handle behind the back of the client, and tell its handle caches */
+unsigned int close_handle( struct process *process, obj_handle_t handle )
+{
+    handle_cache_shm_t *shared = process->handle_cache;
+    unsigned int ret = close_handle_no_notify( process, handle );
+
+    if (!ret && shared && !handle_is_global( handle ))
+    {
+        shared->closed[shared->closed_count % HANDLE_CACHE_RING_SIZE] = handle;
+        __sync_synchronize();
+        shared->closed_count++;
+    }
+    return ret;
+}
+
 /* retrieve the object corresponding to one of the magic pseudo-handles */
 static inline struct object *get_magic_handle( obj_handle_t handle )
 {
@@ -621,10 +638,25 @@ unsigned int get_handle_table_count( struct process *process )
 /* close a handle */
 DECL_HANDLER(close_handle)
 {
-    unsigned int err = close_handle( current->process, req->handle );
+    unsigned int err = close_handle_no_notify( current->process, req->handle );
     set_error( err );
 }
 
+/* get the mapping of the handles closed behind the back of the current process */
+DECL_HANDLER(get_handle_cache_mapping)
+{
+    struct process *process = current->process;
+    void *ptr;
+
+    if (!process->handle_cache_mapping)
+    {
+        if (!(process->handle_cache_mapping = create_shared_mapping( sizeof(handle_cache_shm_t), &ptr )))
+            return;
+        process->handle_cache = ptr;
+    }
+    reply->handle = alloc_handle( process, process->handle_cache_mapping, SECTION_MAP_READ | SECTION_QUERY, 0 );
+}
+
 /* set a handle information */
 DECL_HANDLER(set_handle_info)
 {
@@ -651,9 +683,11 @@ DECL_HANDLER(dup_handle)
             release_object( dst );
         }
         /* close the handle no matter what happened */
-        if ((req->options & DUP_HANDLE_CLOSE_SOURCE) && (src != dst || req->src_handle != reply->handle))
-            reply->closed = !close_handle( src, req->src_handle );
         reply->self = (src == current->process);
+        /* the client takes care of its own caches when closing its own handle */
+        if ((req->options & DUP_HANDLE_CLOSE_SOURCE) && (src != dst || req->src_handle != reply->handle))
+            reply->closed = !(reply->self ? close_handle_no_notify( src, req->src_handle )
+                                          : close_handle( src, req->src_handle ));
         release_object( src );
     }
 }
@@ -143,6 +143,7 @@ int main( int argc, char *argv[] )
 
     if (debug_level) fprintf( stderr, "wineserver: starting (pid=%ld)\n", (long) getpid() );
     init_signals();
+    init_workers();
     init_directories();
     init_registry();
     main_loop();
@@ -139,6 +139,7 @@ struct mapping
     pe_image_info_t image;           /* image info (for PE image mapping) */
     struct ranges  *committed;       /* list of committed ranges in this mapping */
     struct shared_map *shared;       /* temp file for shared PE mapping */
+    void           *server_ptr;      /* address in the server for server state mappings */
 };
 
 static void mapping_dump( struct object *obj, int verbose );
@@ -772,6 +773,7 @@ static struct object *create_mapping( struct object *root, const struct unicode_
     mapping->fd          = NULL;
     mapping->shared      = NULL;
     mapping->committed   = NULL;
+    mapping->server_ptr  = NULL;
 
     if (!(mapping->flags = get_mapping_flags( handle, flags ))) goto error;
 
@@ -848,6 +850,25 @@ static struct object *create_mapping( struct object *root, const struct unicode_
     return NULL;
 }
 
+/* create an anonymous mapping holding server state, that is also mapped in the server */
+struct mapping *create_shared_mapping( mem_size_t size, void **ptr )
+{
+    struct mapping *mapping;
+    void *addr;
+
+    if (!(mapping = (struct mapping *)create_mapping( NULL, NULL, 0, size, SEC_COMMIT, 0, 0, NULL )))
+        return NULL;
+    addr = mmap( NULL, mapping->size, PROT_READ | PROT_WRITE, MAP_SHARED, get_unix_fd( mapping->fd ), 0 );
+    if (addr == MAP_FAILED)
+    {
+        file_set_error();
+        release_object( mapping );
+        return NULL;
+    }
+    mapping->server_ptr = *ptr = addr;
+    return mapping;
+}
+
 struct mapping *get_mapping_obj( struct process *process, obj_handle_t handle, unsigned int access )
 {
     return (struct mapping *)get_handle_obj( process, handle, access, &mapping_ops );
@@ -901,6 +922,7 @@ static void mapping_destroy( struct object *obj )
     if (mapping->fd) release_object( mapping->fd );
     if (mapping->committed) release_object( mapping->committed );
     if (mapping->shared) release_object( mapping->shared );
+    if (mapping->server_ptr) munmap( mapping->server_ptr, mapping->size );
 }
 
 static enum server_fd_type mapping_get_fd_type( struct fd *fd )
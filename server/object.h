@@ -218,6 +218,13 @@ extern void stop_watchdog(void);
 extern int watchdog_triggered(void);
 extern void init_signals(void);
 
+/* worker thread functions */
+
+typedef unsigned int (*worker_func)( void *arg );
+typedef void (*worker_callback)( void *arg, unsigned int status );
+extern void init_workers(void);
+extern int queue_worker_job( worker_func func, worker_callback callback, void *arg );
+
 /* atom functions */
 
 extern atom_t add_global_atom( struct winstation *winstation, const struct unicode_str *str );
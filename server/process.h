@@ -95,6 +95,8 @@ struct process
     struct list          rawinput_devices;/* list of registered rawinput devices */
     const struct rawinput_device *rawinput_mouse; /* rawinput mouse device, if any */
     const struct rawinput_device *rawinput_kbd;   /* rawinput keyboard device, if any */
+    struct mapping      *handle_cache_mapping; /* mapping of the client handle cache state */
+    handle_cache_shm_t  *handle_cache;    /* server view of the client handle cache state */
 };
 
 struct process_snapshot
@@ -140,6 +140,8 @@ struct msg_queue
     struct thread_input   *input;           /* thread input descriptor */
     struct hook_table     *hooks;           /* hook table */
     timeout_t              last_get_msg;    /* time of last get message call */
+    struct mapping        *shared_mapping;  /* mapping of the shared queue state */
+    queue_shm_t           *shared;          /* server view of the shared queue state */
 };
 
 struct hotkey
@@ -298,6 +300,8 @@ static struct msg_queue *create_msg_queue( struct thread *thread, struct thread_
         queue->input           = (struct thread_input *)grab_object( input );
         queue->hooks           = NULL;
         queue->last_get_msg    = current_time;
+        queue->shared_mapping  = NULL;
+        queue->shared          = NULL;
         list_init( &queue->send_result );
         list_init( &queue->callback_result );
         list_init( &queue->pending_timers );
@@ -429,6 +433,37 @@ void set_queue_hooks( struct thread *thread, struct hook_table *hooks )
     queue->hooks = hooks;
 }
 
+/* update the desktop state that clients read from shared memory */
+/* readers retry while the sequence number is odd or has changed */
+static void update_desktop_shm( struct desktop *desktop )
+{
+    desktop_shm_t *shared = desktop->shared;
+
+    if (!shared) return;
+    shared->seq++;
+    __sync_synchronize();
+    shared->cursor_x = desktop->cursor.x;
+    shared->cursor_y = desktop->cursor.y;
+    shared->cursor_last_change = desktop->cursor.last_change;
+    memcpy( (void *)shared->keystate, desktop->keystate, sizeof(desktop->keystate) );
+    __sync_synchronize();
+    shared->seq++;
+}
+
+/* update the queue state that clients read from shared memory */
+static void update_queue_shm( struct msg_queue *queue )
+{
+    queue_shm_t *shared = queue->shared;
+
+    if (!shared) return;
+    shared->seq++;
+    __sync_synchronize();
+    shared->wake_bits = queue->wake_bits;
+    shared->changed_bits = queue->changed_bits;
+    __sync_synchronize();
+    shared->seq++;
+}
+
 /* check the queue status */
 static inline int is_signaled( struct msg_queue *queue )
 {
@@ -440,6 +475,7 @@ static inline void set_queue_bits( struct msg_queue *queue, unsigned int bits )
 {
     queue->wake_bits |= bits;
     queue->changed_bits |= bits;
+    update_queue_shm( queue );
     if (is_signaled( queue )) wake_up( &queue->obj, 0 );
 }
 
@@ -448,6 +484,7 @@ static inline void clear_queue_bits( struct msg_queue *queue, unsigned int bits
 {
     queue->wake_bits &= ~bits;
     queue->changed_bits &= ~bits;
+    update_queue_shm( queue );
 }
 
 /* check whether msg is a keyboard message */
@@ -995,6 +1032,7 @@ static void msg_queue_destroy( struct object *obj )
     release_object( queue->input );
     if (queue->hooks) release_object( queue->hooks );
     if (queue->fd) release_object( queue->fd );
+    if (queue->shared_mapping) release_object( queue->shared_mapping );
 }
 
 static void msg_queue_poll_event( struct fd *fd, int event )
@@ -1476,6 +1514,7 @@ static void queue_hardware_message( struct desktop *desktop, struct message *msg
 
     update_input_key_state( desktop, desktop->keystate, msg );
     last_input_time = get_tick_count();
+    update_desktop_shm( desktop );
     if (msg->msg != WM_MOUSEMOVE) always_queue = 1;
 
     if (is_keyboard_msg( msg ))
@@ -1495,6 +1534,7 @@ static void queue_hardware_message( struct desktop *desktop, struct message *msg
             desktop->cursor.x = x;
             desktop->cursor.y = y;
             desktop->cursor.last_change = get_tick_count();
+            update_desktop_shm( desktop );
         }
         if (desktop->keystate[VK_LBUTTON] & 0x80)  msg->wparam |= MK_LBUTTON;
         if (desktop->keystate[VK_MBUTTON] & 0x80)  msg->wparam |= MK_MBUTTON;
@@ -1611,6 +1651,7 @@ static int queue_mouse_message( struct desktop *desktop, user_handle_t win, cons
     };
 
     desktop->cursor.last_change = get_tick_count();
+    update_desktop_shm( desktop );
     flags = input->mouse.flags;
     time  = input->mouse.time;
     if (!time) time = desktop->cursor.last_change;
@@ -2277,11 +2318,51 @@ DECL_HANDLER(get_queue_status)
         reply->wake_bits    = queue->wake_bits;
         reply->changed_bits = queue->changed_bits;
         queue->changed_bits &= ~req->clear_bits;
+        update_queue_shm( queue );
     }
     else reply->wake_bits = reply->changed_bits = 0;
 }
 
 
+/* get the shared memory mappings of the current thread desktop and message queue */
+DECL_HANDLER(get_shared_memory)
+{
+    struct msg_queue *queue = current->queue;
+    struct desktop *desktop;
+    void *ptr;
+
+    if (!(desktop = get_thread_desktop( current, 0 ))) return;
+
+    if (!desktop->shared_mapping)
+    {
+        if (!(desktop->shared_mapping = create_shared_mapping( sizeof(desktop_shm_t), &ptr ))) goto done;
+        desktop->shared = ptr;
+        update_desktop_shm( desktop );
+    }
+    if (!(reply->desktop = alloc_handle( current->process, desktop->shared_mapping,
+                                         SECTION_MAP_READ | SECTION_QUERY, 0 )))
+        goto done;
+
+    /* don't create a queue if the thread doesn't have one yet */
+    if (!queue) goto done;
+    if (!queue->shared_mapping)
+    {
+        if (!(queue->shared_mapping = create_shared_mapping( sizeof(queue_shm_t), &ptr ))) goto failed;
+        queue->shared = ptr;
+        update_queue_shm( queue );
+    }
+    if ((reply->queue = alloc_handle( current->process, queue->shared_mapping,
+                                      SECTION_MAP_READ | SECTION_QUERY, 0 )))
+        goto done;
+
+failed:
+    close_handle( current->process, reply->desktop );
+    reply->desktop = 0;
+done:
+    release_object( desktop );
+}
+
+
 /* send a message to a thread queue */
 DECL_HANDLER(send_message)
 {
@@ -2452,6 +2533,7 @@ DECL_HANDLER(get_message)
     }
     if (filter & QS_INPUT) queue->changed_bits &= ~QS_INPUT;
     if (filter & QS_PAINT) queue->changed_bits &= ~QS_PAINT;
+    update_queue_shm( queue );
 
     /* then check for posted messages */
     if ((filter & QS_POSTMESSAGE) &&
@@ -2882,6 +2964,7 @@ DECL_HANDLER(get_key_state)
         {
             reply->state = desktop->keystate[req->key & 0xff];
             desktop->keystate[req->key & 0xff] &= ~0x40;
+            update_desktop_shm( desktop );
         }
         set_reply_data( desktop->keystate, size );
         release_object( desktop );
@@ -2923,6 +3006,7 @@ DECL_HANDLER(set_key_state)
     {
         if (!(desktop = get_thread_desktop( current, 0 ))) return;
         memcpy( desktop->keystate, get_req_data(), size );
+        update_desktop_shm( desktop );
         release_object( desktop );
     }
     else
@@ -2932,6 +3016,7 @@ DECL_HANDLER(set_key_state)
         if (req->async && (desktop = get_thread_desktop( thread, 0 )))
         {
             memcpy( desktop->keystate, get_req_data(), size );
+            update_desktop_shm( desktop );
             release_object( desktop );
         }
         release_object( thread );
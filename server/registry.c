@@ -35,6 +35,9 @@
 #include <string.h>
 #include <stdlib.h>
 #include <sys/stat.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 #include <unistd.h>
 
 #include "ntstatus.h"
@@ -72,6 +75,9 @@ struct key
     int               last_subkey; /* last in use subkey */
     int               nb_subkeys;  /* count of allocated subkeys */
     struct key      **subkeys;     /* subkeys array */
+    struct list      *subkey_hash; /* hash table of subkeys, for keys with many subkeys */
+    unsigned int      hash_size;   /* size of the subkey hash table */
+    struct list       hash_entry;  /* entry in the parent subkey hash table */
     int               last_value;  /* last in use value */
     int               nb_values;   /* count of allocated values in array */
     struct key_value *values;      /* values array */
@@ -99,6 +105,7 @@ struct key_value
 };
 
 #define MIN_SUBKEYS  8   /* min. number of allocated subkeys per key */
+#define MIN_HASHED_SUBKEYS 64  /* min. number of subkeys to use a hash table */
 #define MIN_VALUES   8   /* min. number of allocated values per key */
 
 #define MAX_NAME_LEN  256    /* max. length of a key name */
@@ -125,6 +132,7 @@ struct save_branch_info
 {
     struct key  *key;
     const char  *path;
+    int          need_cache;  /* binary cache is missing or out of date */
 };
 
 #define MAX_SAVE_BRANCH_INFO 3
@@ -144,6 +152,57 @@ struct file_load_info
     size_t      tmplen;   /* length of temp buffer */
 };
 
+/*
+ * Binary registry cache
+ *
+ * When the server exits, each saved branch is also written in binary form to
+ * <file>.bin next to the text file, unless that is already up to date; the
+ * periodic saves only write the text file. The cache is only used if it
+ * matches the size and modification time of the text file, so the text file
+ * remains the reference and can still be edited by hand. Keys are stored in
+ * depth-first order, with the values of a key followed by its subkeys, in the
+ * same sorted order as in memory.
+ */
+
+#define REG_CACHE_MAGIC   0x42474552  /* "REGB" */
+#define REG_CACHE_VERSION 1
+#define REG_CACHE_ALIGN(len) (((len) + 7) & ~7)
+
+struct reg_cache_header
+{
+    unsigned int   magic;     /* REG_CACHE_MAGIC */
+    unsigned int   version;   /* REG_CACHE_VERSION */
+    unsigned int   prefix;    /* prefix type of the registry */
+    unsigned int   mtime_ns;  /* nanoseconds of the text file modification time */
+    timeout_t      mtime;     /* text file modification time */
+    file_pos_t     size;      /* text file size */
+    file_pos_t     total;     /* total size of the cache file */
+};
+
+struct reg_cache_key
+{
+    timeout_t      modif;     /* last modification time */
+    unsigned short namelen;   /* length of key name, followed by the name */
+    unsigned short classlen;  /* length of class name, following the name */
+    unsigned int   flags;     /* key flags (only KEY_SYMLINK) */
+    unsigned int   values;    /* number of value records following this key */
+    unsigned int   subkeys;   /* number of key records following the values */
+};
+
+struct reg_cache_value
+{
+    unsigned int   type;      /* value type */
+    unsigned int   namelen;   /* length of value name, followed by the name */
+    data_size_t    len;       /* data length, data follows the name */
+};
+
+/* information about a cache being loaded */
+struct cache_load_info
+{
+    const char *ptr;          /* current position */
+    const char *end;          /* end of the cache data */
+};
+
 
 static void key_dump( struct object *obj, int verbose );
 static struct object_type *key_get_type( struct object *obj );
@@ -424,6 +483,7 @@ static void key_destroy( struct object *obj )
         release_object( key->subkeys[i] );
     }
     free( key->subkeys );
+    free( key->subkey_hash );
     /* unconditionally notify everything waiting on this key */
     while ((ptr = list_head( &key->notify_list )))
     {
@@ -487,6 +547,8 @@ static struct key *alloc_key( const struct unicode_str *name, timeout_t modif )
         key->last_subkey = -1;
         key->nb_subkeys  = 0;
         key->subkeys     = NULL;
+        key->subkey_hash = NULL;
+        key->hash_size   = 0;
         key->nb_values   = 0;
         key->last_value  = -1;
         key->values      = NULL;
@@ -576,12 +638,39 @@ static int grow_subkeys( struct key *key )
     return 1;
 }
 
+static unsigned int get_subkey_hash( const WCHAR *name, data_size_t len )
+{
+    unsigned int hash = 0;
+
+    for (len /= sizeof(WCHAR); len; len--) hash = hash * 31 + tolowerW(*name++);
+    return hash;
+}
+
+/* (re)build the subkey hash table, growing it to fit the current number of subkeys */
+static void rehash_subkeys( struct key *key )
+{
+    struct list *hash;
+    unsigned int i, size = MIN_HASHED_SUBKEYS;
+
+    while (size < key->last_subkey + 1) size *= 2;
+    if (!(hash = malloc( size * sizeof(*hash) ))) return;  /* keep using the old one */
+    for (i = 0; i < size; i++) list_init( &hash[i] );
+    for (i = 0; i <= key->last_subkey; i++)
+    {
+        struct key *subkey = key->subkeys[i];
+        list_add_head( &hash[get_subkey_hash( subkey->name, subkey->namelen ) & (size - 1)],
+                       &subkey->hash_entry );
+    }
+    free( key->subkey_hash );
+    key->subkey_hash = hash;
+    key->hash_size   = size;
+}
+
 /* allocate a subkey for a given key, and return its index */
 static struct key *alloc_subkey( struct key *parent, const struct unicode_str *name,
                                  int index, timeout_t modif )
 {
     struct key *key;
-    int i;
 
     if (name->len > MAX_NAME_LEN * sizeof(WCHAR))
     {
@@ -596,9 +685,14 @@ static struct key *alloc_subkey( struct key *parent, const struct unicode_str *n
     if ((key = alloc_key( name, modif )) != NULL)
     {
         key->parent = parent;
-        for (i = ++parent->last_subkey; i > index; i--)
-            parent->subkeys[i] = parent->subkeys[i-1];
+        memmove( parent->subkeys + index + 1, parent->subkeys + index,
+                 (++parent->last_subkey - index) * sizeof(*parent->subkeys) );
         parent->subkeys[index] = key;
+        if (parent->subkey_hash)
+            list_add_head( &parent->subkey_hash[get_subkey_hash( name->str, name->len ) & (parent->hash_size - 1)],
+                           &key->hash_entry );
+        if (parent->last_subkey + 1 >= (parent->subkey_hash ? 2 * parent->hash_size : MIN_HASHED_SUBKEYS))
+            rehash_subkeys( parent );
         if (is_wow6432node( key->name, key->namelen ) && !is_wow6432node( parent->name, parent->namelen ))
             parent->flags |= KEY_WOW64;
     }
@@ -609,14 +703,16 @@ static struct key *alloc_subkey( struct key *parent, const struct unicode_str *n
 static void free_subkey( struct key *parent, int index )
 {
     struct key *key;
-    int i, nb_subkeys;
+    int nb_subkeys;
 
     assert( index >= 0 );
     assert( index <= parent->last_subkey );
 
     key = parent->subkeys[index];
-    for (i = index; i < parent->last_subkey; i++) parent->subkeys[i] = parent->subkeys[i + 1];
+    memmove( parent->subkeys + index, parent->subkeys + index + 1,
+             (parent->last_subkey - index) * sizeof(*parent->subkeys) );
     parent->last_subkey--;
+    if (parent->subkey_hash) list_remove( &key->hash_entry );
     key->flags |= KEY_DELETED;
     key->parent = NULL;
     if (is_wow6432node( key->name, key->namelen )) parent->flags &= ~KEY_WOW64;
@@ -635,8 +731,8 @@ static void free_subkey( struct key *parent, int index )
     }
 }
 
-/* find the named child of a given key and return its index */
-static struct key *find_subkey( const struct key *key, const struct unicode_str *name, int *index )
+/* find the named child of a given key in the sorted array and return its index */
+static struct key *find_sorted_subkey( const struct key *key, const struct unicode_str *name, int *index )
 {
     int i, min, max, res;
     data_size_t len;
@@ -661,6 +757,25 @@ static struct key *find_subkey( const struct key *key, const struct unicode_str
     return NULL;
 }
 
+/* find the named child of a given key */
+/* index is only guaranteed to be set when the key is not found, to the insertion point */
+static struct key *find_subkey( const struct key *key, const struct unicode_str *name, int *index )
+{
+    struct key *subkey;
+
+    if (!key->subkey_hash) return find_sorted_subkey( key, name, index );
+
+    LIST_FOR_EACH_ENTRY( subkey, &key->subkey_hash[get_subkey_hash( name->str, name->len ) & (key->hash_size - 1)],
+                         struct key, hash_entry )
+    {
+        if (subkey->namelen == name->len &&
+            !memicmpW( subkey->name, name->str, name->len / sizeof(WCHAR) ))
+            return subkey;
+    }
+    find_sorted_subkey( key, name, index );
+    return NULL;
+}
+
 /* return the wow64 variant of the key, or the key itself if none */
 static struct key *find_wow64_subkey( struct key *key, const struct unicode_str *name )
 {
@@ -985,6 +1100,7 @@ static void enum_key( const struct key *key, int index, int info_class,
 /* delete a key and its values */
 static int delete_key( struct key *key, int recurse )
 {
+    struct unicode_str name;
     int index;
     struct key *parent = key->parent;
 
@@ -1000,9 +1116,10 @@ static int delete_key( struct key *key, int recurse )
         if (0 > delete_key(key->subkeys[key->last_subkey], 1))
             return -1;
 
-    for (index = 0; index <= parent->last_subkey; index++)
-        if (parent->subkeys[index] == key) break;
-    assert( index <= parent->last_subkey );
+    name.str = key->name;
+    name.len = key->namelen;
+    find_sorted_subkey( parent, &name, &index );
+    assert( parent->subkeys[index] == key );
 
     /* we can only delete a key that has no subkeys */
     if (key->last_subkey >= 0)
@@ -1714,12 +1831,153 @@ static void load_registry( struct key *key, obj_handle_t handle )
     }
 }
 
+/* load a key and its values and subkeys from the binary cache */
+/* if key is NULL, a new subkey of parent is created; if both are NULL, the data is only validated */
+static int load_cache_key( struct key *parent, struct key *key, struct cache_load_info *info )
+{
+    const struct reg_cache_key *rec = (const struct reg_cache_key *)info->ptr;
+    const struct reg_cache_value *val;
+    struct key_value *value;
+    struct unicode_str name;
+    int validate = !parent && !key;
+    unsigned int i;
+    size_t size;
+
+    if (info->end - info->ptr < sizeof(*rec)) return 0;
+    size = REG_CACHE_ALIGN( sizeof(*rec) + rec->namelen + rec->classlen );
+    if (info->end - info->ptr < size) return 0;
+    if (rec->namelen % sizeof(WCHAR) || rec->classlen % sizeof(WCHAR)) return 0;
+    if (rec->namelen > MAX_NAME_LEN * sizeof(WCHAR)) return 0;
+    info->ptr += size;
+
+    if (!validate)
+    {
+        name.str = (const WCHAR *)(rec + 1);
+        name.len = rec->namelen;
+        if (!key)
+        {
+            if (!(key = alloc_subkey( parent, &name, parent->last_subkey + 1, rec->modif ))) return 0;
+        }
+        else key->modif = rec->modif;
+        key->flags |= rec->flags & KEY_SYMLINK;
+        if (rec->classlen)
+        {
+            free( key->class );
+            if (!(key->class = memdup( (const char *)(rec + 1) + rec->namelen, rec->classlen ))) return 0;
+            key->classlen = rec->classlen;
+        }
+    }
+
+    for (i = 0; i < rec->values; i++)
+    {
+        val = (const struct reg_cache_value *)info->ptr;
+        if (info->end - info->ptr < sizeof(*val)) return 0;
+        if (val->namelen % sizeof(WCHAR) || val->namelen > MAX_VALUE_LEN * sizeof(WCHAR)) return 0;
+        if (info->end - info->ptr - sizeof(*val) < (size_t)val->namelen + val->len) return 0;
+        info->ptr += REG_CACHE_ALIGN( sizeof(*val) + val->namelen + val->len );
+        if (info->ptr > info->end) return 0;
+        if (validate) continue;
+
+        if (key->last_value + 1 == key->nb_values && !grow_values( key )) return 0;
+        value = &key->values[key->last_value + 1];
+        value->name    = NULL;
+        value->namelen = val->namelen;
+        value->type    = val->type;
+        value->len     = val->len;
+        value->data    = NULL;
+        if (val->namelen && !(value->name = memdup( val + 1, val->namelen ))) return 0;
+        if (val->len && !(value->data = memdup( (const char *)(val + 1) + val->namelen, val->len )))
+        {
+            free( value->name );
+            return 0;
+        }
+        key->last_value++;
+    }
+
+    for (i = 0; i < rec->subkeys; i++)
+        if (!load_cache_key( validate ? NULL : key, NULL, info )) return 0;
+    return 1;
+}
+
+/* get the size and modification time of a registry text file */
+static int get_registry_file_stamp( const char *filename, struct reg_cache_header *header )
+{
+    struct stat st;
+
+    if (stat( filename, &st ) == -1) return 0;
+    header->size = st.st_size;
+    header->mtime = st.st_mtime;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    header->mtime_ns = st.st_mtim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC)
+    header->mtime_ns = st.st_mtimespec.tv_nsec;
+#else
+    header->mtime_ns = 0;
+#endif
+    return 1;
+}
+
+/* load a registry branch from its binary cache, if it is up to date */
+static int load_registry_cache( const char *filename, struct key *key )
+{
+#ifdef HAVE_SYS_MMAN_H
+    const struct reg_cache_header *header;
+    struct reg_cache_header stamp;
+    struct cache_load_info info;
+    struct stat st;
+    char *cache_name;
+    void *base;
+    int fd, ret = 0;
+
+    if (!get_registry_file_stamp( filename, &stamp )) return 0;
+    if (!(cache_name = malloc( strlen(filename) + sizeof(".bin") ))) return 0;
+    strcpy( cache_name, filename );
+    strcat( cache_name, ".bin" );
+    fd = open( cache_name, O_RDONLY );
+    free( cache_name );
+    if (fd == -1) return 0;
+
+    if (fstat( fd, &st ) == -1 || st.st_size < sizeof(*header) ||
+        (base = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 )) == MAP_FAILED)
+    {
+        close( fd );
+        return 0;
+    }
+    close( fd );
+
+    header = base;
+    if (header->magic != REG_CACHE_MAGIC || header->version != REG_CACHE_VERSION) goto done;
+    if (header->total != st.st_size) goto done;
+    if (header->size != stamp.size || header->mtime != stamp.mtime ||
+        header->mtime_ns != stamp.mtime_ns) goto done;
+    if (prefix_type != PREFIX_UNKNOWN && header->prefix != prefix_type) goto done;
+
+    /* validate everything first, the branch must not be left half loaded */
+    info.ptr = (const char *)(header + 1);
+    info.end = (const char *)base + st.st_size;
+    if (!load_cache_key( NULL, NULL, &info ) || info.ptr != info.end) goto done;
+
+    info.ptr = (const char *)(header + 1);
+    if (!(ret = load_cache_key( NULL, key, &info )))
+        fatal_error( "could not load registry cache for %s\n", filename );
+    if (prefix_type == PREFIX_UNKNOWN) prefix_type = header->prefix;
+    if (debug_level) fprintf( stderr, "wineserver: loaded %s from binary cache\n", filename );
+
+done:
+    munmap( base, st.st_size );
+    return ret;
+#else
+    return 0;
+#endif
+}
+
 /* load one of the initial registry files */
 static int load_init_registry_from_file( const char *filename, struct key *key )
 {
-    FILE *f;
+    FILE *f = NULL;
+    int cached;
 
-    if ((f = fopen( filename, "r" )))
+    if (!(cached = load_registry_cache( filename, key )) && (f = fopen( filename, "r" )))
     {
         load_keys( key, filename, f, 0 );
         fclose( f );
@@ -1733,9 +1991,10 @@ static int load_init_registry_from_file( const char *filename, struct key *key )
     assert( save_branch_count < MAX_SAVE_BRANCH_INFO );
 
     save_branch_info[save_branch_count].path = filename;
+    save_branch_info[save_branch_count].need_cache = (f != NULL);
     save_branch_info[save_branch_count++].key = (struct key *)grab_object( key );
     make_object_static( &key->obj );
-    return (f != NULL);
+    return cached || (f != NULL);
 }
 
 static WCHAR *format_user_registry_path( const SID *sid, struct unicode_str *path )
@@ -1916,9 +2175,95 @@ static void save_registry( struct key *key, obj_handle_t handle )
     }
 }
 
+/* save a key and its values and subkeys to the binary cache */
+static void save_cache_key( const struct key *key, FILE *f )
+{
+    static const char zero[8];
+    struct reg_cache_key rec;
+    struct reg_cache_value val;
+    size_t size;
+    int i;
+
+    rec.modif    = key->modif;
+    rec.namelen  = key->namelen;
+    rec.classlen = key->classlen;
+    rec.flags    = key->flags & KEY_SYMLINK;
+    rec.values   = key->last_value + 1;
+    rec.subkeys  = 0;
+    for (i = 0; i <= key->last_subkey; i++)
+        if (!(key->subkeys[i]->flags & KEY_VOLATILE)) rec.subkeys++;
+
+    size = sizeof(rec) + key->namelen + key->classlen;
+    fwrite( &rec, sizeof(rec), 1, f );
+    fwrite( key->name, key->namelen, 1, f );
+    fwrite( key->class, key->classlen, 1, f );
+    fwrite( zero, REG_CACHE_ALIGN(size) - size, 1, f );
+
+    for (i = 0; i <= key->last_value; i++)
+    {
+        const struct key_value *value = &key->values[i];
+
+        val.type    = value->type;
+        val.namelen = value->namelen;
+        val.len     = value->len;
+        size = sizeof(val) + value->namelen + value->len;
+        fwrite( &val, sizeof(val), 1, f );
+        fwrite( value->name, value->namelen, 1, f );
+        fwrite( value->data, value->len, 1, f );
+        fwrite( zero, REG_CACHE_ALIGN(size) - size, 1, f );
+    }
+
+    for (i = 0; i <= key->last_subkey; i++)
+        if (!(key->subkeys[i]->flags & KEY_VOLATILE)) save_cache_key( key->subkeys[i], f );
+}
+
+/* save the binary cache of a registry branch that has just been saved to path */
+static int save_registry_cache( struct key *key, const char *path )
+{
+    struct reg_cache_header header;
+    char *cache_name, *tmp = NULL;
+    int fd, ret = 0;
+    FILE *f;
+
+    if (!get_registry_file_stamp( path, &header )) return 0;
+    header.magic   = REG_CACHE_MAGIC;
+    header.version = REG_CACHE_VERSION;
+    header.prefix  = prefix_type;
+    header.total   = 0;
+
+    if (!(cache_name = malloc( strlen(path) + sizeof(".bin") ))) return 0;
+    strcpy( cache_name, path );
+    strcat( cache_name, ".bin" );
+    if (!(tmp = malloc( strlen(cache_name) + 20 ))) goto done;
+    sprintf( tmp, "%s.%lx.tmp", cache_name, (long) getpid() );
+
+    if ((fd = open( tmp, O_CREAT | O_TRUNC | O_WRONLY, 0666 )) == -1) goto done;
+    if (!(f = fdopen( fd, "w" )))
+    {
+        close( fd );
+        unlink( tmp );
+        goto done;
+    }
+    fwrite( &header, sizeof(header), 1, f );
+    save_cache_key( key, f );
+    header.total = ftell( f );
+    fseek( f, 0, SEEK_SET );
+    ret = fwrite( &header, sizeof(header), 1, f ) == 1;
+    if (fclose( f )) ret = 0;
+    if (ret) ret = !rename( tmp, cache_name );
+    if (!ret) unlink( tmp );
+
+done:
+    free( tmp );
+    free( cache_name );
+    return ret;
+}
+
 /* save a registry branch to a file */
-static int save_branch( struct key *key, const char *path )
+static int save_branch( struct save_branch_info *info )
 {
+    struct key *key = info->key;
+    const char *path = info->path;
     struct stat st;
     char *p, *tmp = NULL;
     int fd, count = 0, ret = 0;
@@ -1986,7 +2331,11 @@ static int save_branch( struct key *key, const char *path )
 
 done:
     free( tmp );
-    if (ret) make_clean( key );
+    if (ret)
+    {
+        make_clean( key );
+        info->need_cache = 1;
+    }
     return ret;
 }
 
@@ -1998,7 +2347,7 @@ static void periodic_save( void *arg )
     if (fchdir( config_dir_fd ) == -1) return;
     save_timeout_user = NULL;
     for (i = 0; i < save_branch_count; i++)
-        save_branch( save_branch_info[i].key, save_branch_info[i].path );
+        save_branch( &save_branch_info[i] );
     if (fchdir( server_dir_fd ) == -1) fatal_error( "chdir to server dir: %s\n", strerror( errno ));
     set_periodic_save_timer();
 }
@@ -2010,20 +2359,22 @@ static void set_periodic_save_timer(void)
     save_timeout_user = add_timeout_user( save_period, periodic_save, NULL );
 }
 
-/* save the modified registry branches to disk */
+/* save the modified registry branches to disk, and their binary cache if out of date */
 void flush_registry(void)
 {
+    struct save_branch_info *info;
     int i;
 
     if (fchdir( config_dir_fd ) == -1) return;
     for (i = 0; i < save_branch_count; i++)
     {
-        if (!save_branch( save_branch_info[i].key, save_branch_info[i].path ))
+        info = &save_branch_info[i];
+        if (!save_branch( info ))
         {
-            fprintf( stderr, "wineserver: could not save registry branch to %s",
-                     save_branch_info[i].path );
+            fprintf( stderr, "wineserver: could not save registry branch to %s", info->path );
             perror( " " );
         }
+        else if (info->need_cache) info->need_cache = !save_registry_cache( info->key, info->path );
     }
     if (fchdir( server_dir_fd ) == -1) fatal_error( "chdir to server dir: %s\n", strerror( errno ));
 }
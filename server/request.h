@@ -134,6 +134,7 @@ DECL_HANDLER(unload_dll);
 DECL_HANDLER(queue_apc);
 DECL_HANDLER(get_apc_result);
 DECL_HANDLER(close_handle);
+DECL_HANDLER(get_handle_cache_mapping);
 DECL_HANDLER(set_handle_info);
 DECL_HANDLER(dup_handle);
 DECL_HANDLER(open_process);
@@ -142,6 +143,8 @@ DECL_HANDLER(select);
 DECL_HANDLER(create_event);
 DECL_HANDLER(event_op);
 DECL_HANDLER(query_event);
+DECL_HANDLER(get_esync_fd);
+DECL_HANDLER(get_esync_mapping);
 DECL_HANDLER(open_event);
 DECL_HANDLER(create_keyed_event);
 DECL_HANDLER(open_keyed_event);
@@ -171,6 +174,7 @@ DECL_HANDLER(set_socket_event);
 DECL_HANDLER(get_socket_event);
 DECL_HANDLER(get_socket_info);
 DECL_HANDLER(enable_socket_event);
+DECL_HANDLER(complete_socket_asyncs);
 DECL_HANDLER(set_socket_deferred);
 DECL_HANDLER(alloc_console);
 DECL_HANDLER(free_console);
@@ -247,6 +251,7 @@ DECL_HANDLER(get_msg_queue);
 DECL_HANDLER(set_queue_fd);
 DECL_HANDLER(set_queue_mask);
 DECL_HANDLER(get_queue_status);
+DECL_HANDLER(get_shared_memory);
 DECL_HANDLER(get_process_idle_event);
 DECL_HANDLER(send_message);
 DECL_HANDLER(post_quit_message);
@@ -381,6 +386,7 @@ DECL_HANDLER(create_completion);
 DECL_HANDLER(open_completion);
 DECL_HANDLER(add_completion);
 DECL_HANDLER(remove_completion);
+DECL_HANDLER(remove_completions);
 DECL_HANDLER(query_completion);
 DECL_HANDLER(set_completion_info);
 DECL_HANDLER(add_fd_completion);
@@ -429,6 +435,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_queue_apc,
     (req_handler)req_get_apc_result,
     (req_handler)req_close_handle,
+    (req_handler)req_get_handle_cache_mapping,
     (req_handler)req_set_handle_info,
     (req_handler)req_dup_handle,
     (req_handler)req_open_process,
@@ -437,6 +444,8 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_create_event,
     (req_handler)req_event_op,
     (req_handler)req_query_event,
+    (req_handler)req_get_esync_fd,
+    (req_handler)req_get_esync_mapping,
     (req_handler)req_open_event,
     (req_handler)req_create_keyed_event,
     (req_handler)req_open_keyed_event,
@@ -466,6 +475,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_get_socket_event,
     (req_handler)req_get_socket_info,
     (req_handler)req_enable_socket_event,
+    (req_handler)req_complete_socket_asyncs,
     (req_handler)req_set_socket_deferred,
     (req_handler)req_alloc_console,
     (req_handler)req_free_console,
@@ -542,6 +552,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_set_queue_fd,
     (req_handler)req_set_queue_mask,
     (req_handler)req_get_queue_status,
+    (req_handler)req_get_shared_memory,
     (req_handler)req_get_process_idle_event,
     (req_handler)req_send_message,
     (req_handler)req_post_quit_message,
@@ -676,6 +687,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_open_completion,
     (req_handler)req_add_completion,
     (req_handler)req_remove_completion,
+    (req_handler)req_remove_completions,
     (req_handler)req_query_completion,
     (req_handler)req_set_completion_info,
     (req_handler)req_add_fd_completion,
@@ -882,6 +894,9 @@ C_ASSERT( FIELD_OFFSET(struct get_apc_result_reply, result) == 8 );
 C_ASSERT( sizeof(struct get_apc_result_reply) == 48 );
 C_ASSERT( FIELD_OFFSET(struct close_handle_request, handle) == 12 );
 C_ASSERT( sizeof(struct close_handle_request) == 16 );
+C_ASSERT( sizeof(struct get_handle_cache_mapping_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_handle_cache_mapping_reply, handle) == 8 );
+C_ASSERT( sizeof(struct get_handle_cache_mapping_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct set_handle_info_request, handle) == 12 );
 C_ASSERT( FIELD_OFFSET(struct set_handle_info_request, flags) == 16 );
 C_ASSERT( FIELD_OFFSET(struct set_handle_info_request, mask) == 20 );
@@ -934,6 +949,15 @@ C_ASSERT( sizeof(struct query_event_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct query_event_reply, manual_reset) == 8 );
 C_ASSERT( FIELD_OFFSET(struct query_event_reply, state) == 12 );
 C_ASSERT( sizeof(struct query_event_reply) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_esync_fd_request, handle) == 12 );
+C_ASSERT( sizeof(struct get_esync_fd_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_esync_fd_reply, type) == 8 );
+C_ASSERT( FIELD_OFFSET(struct get_esync_fd_reply, access) == 12 );
+C_ASSERT( FIELD_OFFSET(struct get_esync_fd_reply, slot) == 16 );
+C_ASSERT( sizeof(struct get_esync_fd_reply) == 24 );
+C_ASSERT( sizeof(struct get_esync_mapping_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_esync_mapping_reply, handle) == 8 );
+C_ASSERT( sizeof(struct get_esync_mapping_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct open_event_request, access) == 12 );
 C_ASSERT( FIELD_OFFSET(struct open_event_request, attributes) == 16 );
 C_ASSERT( FIELD_OFFSET(struct open_event_request, rootdir) == 20 );
@@ -1098,6 +1122,12 @@ C_ASSERT( FIELD_OFFSET(struct enable_socket_event_request, mask) == 16 );
 C_ASSERT( FIELD_OFFSET(struct enable_socket_event_request, sstate) == 20 );
 C_ASSERT( FIELD_OFFSET(struct enable_socket_event_request, cstate) == 24 );
 C_ASSERT( sizeof(struct enable_socket_event_request) == 32 );
+C_ASSERT( FIELD_OFFSET(struct complete_socket_asyncs_request, handle) == 12 );
+C_ASSERT( FIELD_OFFSET(struct complete_socket_asyncs_request, type) == 16 );
+C_ASSERT( FIELD_OFFSET(struct complete_socket_asyncs_request, user) == 24 );
+C_ASSERT( sizeof(struct complete_socket_asyncs_request) == 32 );
+C_ASSERT( FIELD_OFFSET(struct complete_socket_asyncs_reply, done) == 8 );
+C_ASSERT( sizeof(struct complete_socket_asyncs_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct set_socket_deferred_request, handle) == 12 );
 C_ASSERT( FIELD_OFFSET(struct set_socket_deferred_request, deferred) == 16 );
 C_ASSERT( sizeof(struct set_socket_deferred_request) == 24 );
@@ -1518,6 +1548,10 @@ C_ASSERT( sizeof(struct get_queue_status_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_queue_status_reply, wake_bits) == 8 );
 C_ASSERT( FIELD_OFFSET(struct get_queue_status_reply, changed_bits) == 12 );
 C_ASSERT( sizeof(struct get_queue_status_reply) == 16 );
+C_ASSERT( sizeof(struct get_shared_memory_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_shared_memory_reply, desktop) == 8 );
+C_ASSERT( FIELD_OFFSET(struct get_shared_memory_reply, queue) == 12 );
+C_ASSERT( sizeof(struct get_shared_memory_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_process_idle_event_request, handle) == 12 );
 C_ASSERT( sizeof(struct get_process_idle_event_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_process_idle_event_reply, event) == 8 );
@@ -2316,6 +2350,9 @@ C_ASSERT( FIELD_OFFSET(struct remove_completion_reply, cvalue) == 16 );
 C_ASSERT( FIELD_OFFSET(struct remove_completion_reply, information) == 24 );
 C_ASSERT( FIELD_OFFSET(struct remove_completion_reply, status) == 32 );
 C_ASSERT( sizeof(struct remove_completion_reply) == 40 );
+C_ASSERT( FIELD_OFFSET(struct remove_completions_request, handle) == 12 );
+C_ASSERT( sizeof(struct remove_completions_request) == 16 );
+C_ASSERT( sizeof(struct remove_completions_reply) == 8 );
 C_ASSERT( FIELD_OFFSET(struct query_completion_request, handle) == 12 );
 C_ASSERT( sizeof(struct query_completion_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct query_completion_reply, depth) == 8 );
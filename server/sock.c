@@ -1324,6 +1324,35 @@ DECL_HANDLER(enable_socket_event)
     release_object( &sock->obj );
 }
 
+/* complete pending socket asyncs whose I/O was done by the client together with a woken up async */
+DECL_HANDLER(complete_socket_asyncs)
+{
+    const struct async_result *results = get_req_data();
+    data_size_t i, count = get_req_data_size() / sizeof(*results);
+    struct async_queue *queue;
+    struct sock *sock;
+
+    if (!(sock = (struct sock *)get_handle_obj( current->process, req->handle, 0, &sock_ops )))
+        return;
+
+    queue = req->type == ASYNC_TYPE_WRITE ? &sock->write_q : &sock->read_q;
+    for (i = 0; i < count && i < 32; i++)
+    {
+        if (async_add_to_batch( queue, current->process, req->user, results[i].user,
+                                results[i].status, results[i].total ))
+            reply->done |= 1 << i;
+    }
+
+    if (req->type == ASYNC_TYPE_READ)
+    {
+        /* re-enable FD_READ like the client would do after a recv */
+        sock->pmask &= ~FD_READ;
+        sock->hmask &= ~FD_READ;
+    }
+    sock_reselect( sock );
+    release_object( &sock->obj );
+}
+
 DECL_HANDLER(set_socket_deferred)
 {
     struct sock *sock, *acceptsock;
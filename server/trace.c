@@ -1202,6 +1202,43 @@ static void dump_varargs_rawinput_devices(const char *prefix, data_size_t size )
     fputc( '}', stderr );
 }
 
+static void dump_varargs_completion_packets( const char *prefix, data_size_t size )
+{
+    const struct completion_packet *packet;
+
+    fprintf( stderr, "%s{", prefix );
+    while (size >= sizeof(*packet))
+    {
+        packet = cur_data;
+        dump_uint64( "{ckey=", &packet->ckey );
+        dump_uint64( ",cvalue=", &packet->cvalue );
+        dump_uint64( ",information=", &packet->information );
+        fprintf( stderr, ",status=%s}", get_status_name( packet->status ) );
+        size -= sizeof(*packet);
+        remove_data( sizeof(*packet) );
+        if (size) fputc( ',', stderr );
+    }
+    fputc( '}', stderr );
+}
+
+static void dump_varargs_async_results( const char *prefix, data_size_t size )
+{
+    const struct async_result *result;
+
+    fprintf( stderr, "%s{", prefix );
+    while (size >= sizeof(*result))
+    {
+        result = cur_data;
+        dump_uint64( "{user=", &result->user );
+        dump_uint64( ",total=", &result->total );
+        fprintf( stderr, ",status=%s}", get_status_name( result->status ) );
+        size -= sizeof(*result);
+        remove_data( sizeof(*result) );
+        if (size) fputc( ',', stderr );
+    }
+    fputc( '}', stderr );
+}
+
 static void dump_varargs_handle_infos( const char *prefix, data_size_t size )
 {
     const struct handle_info *handle;
@@ -1501,6 +1538,15 @@ static void dump_close_handle_request( const struct close_handle_request *req )
     fprintf( stderr, " handle=%04x", req->handle );
 }
 
+static void dump_get_handle_cache_mapping_request( const struct get_handle_cache_mapping_request *req )
+{
+}
+
+static void dump_get_handle_cache_mapping_reply( const struct get_handle_cache_mapping_reply *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+}
+
 static void dump_set_handle_info_request( const struct set_handle_info_request *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
@@ -1601,6 +1647,27 @@ static void dump_query_event_reply( const struct query_event_reply *req )
     fprintf( stderr, ", state=%d", req->state );
 }
 
+static void dump_get_esync_fd_request( const struct get_esync_fd_request *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+}
+
+static void dump_get_esync_fd_reply( const struct get_esync_fd_reply *req )
+{
+    fprintf( stderr, " type=%d", req->type );
+    fprintf( stderr, ", access=%08x", req->access );
+    fprintf( stderr, ", slot=%08x", req->slot );
+}
+
+static void dump_get_esync_mapping_request( const struct get_esync_mapping_request *req )
+{
+}
+
+static void dump_get_esync_mapping_reply( const struct get_esync_mapping_reply *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+}
+
 static void dump_open_event_request( const struct open_event_request *req )
 {
     fprintf( stderr, " access=%08x", req->access );
@@ -1942,6 +2009,19 @@ static void dump_enable_socket_event_request( const struct enable_socket_event_r
     fprintf( stderr, ", cstate=%08x", req->cstate );
 }
 
+static void dump_complete_socket_asyncs_request( const struct complete_socket_asyncs_request *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+    fprintf( stderr, ", type=%d", req->type );
+    dump_uint64( ", user=", &req->user );
+    dump_varargs_async_results( ", results=", cur_size );
+}
+
+static void dump_complete_socket_asyncs_reply( const struct complete_socket_asyncs_reply *req )
+{
+    fprintf( stderr, " done=%08x", req->done );
+}
+
 static void dump_set_socket_deferred_request( const struct set_socket_deferred_request *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
@@ -2773,6 +2853,16 @@ static void dump_get_queue_status_reply( const struct get_queue_status_reply *re
     fprintf( stderr, ", changed_bits=%08x", req->changed_bits );
 }
 
+static void dump_get_shared_memory_request( const struct get_shared_memory_request *req )
+{
+}
+
+static void dump_get_shared_memory_reply( const struct get_shared_memory_reply *req )
+{
+    fprintf( stderr, " desktop=%04x", req->desktop );
+    fprintf( stderr, ", queue=%04x", req->queue );
+}
+
 static void dump_get_process_idle_event_request( const struct get_process_idle_event_request *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
@@ -4359,6 +4449,16 @@ static void dump_remove_completion_reply( const struct remove_completion_reply *
     fprintf( stderr, ", status=%08x", req->status );
 }
 
+static void dump_remove_completions_request( const struct remove_completions_request *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+}
+
+static void dump_remove_completions_reply( const struct remove_completions_reply *req )
+{
+    dump_varargs_completion_packets( " packets=", cur_size );
+}
+
 static void dump_query_completion_request( const struct query_completion_request *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
@@ -4552,6 +4652,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_queue_apc_request,
     (dump_func)dump_get_apc_result_request,
     (dump_func)dump_close_handle_request,
+    (dump_func)dump_get_handle_cache_mapping_request,
     (dump_func)dump_set_handle_info_request,
     (dump_func)dump_dup_handle_request,
     (dump_func)dump_open_process_request,
@@ -4560,6 +4661,8 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_create_event_request,
     (dump_func)dump_event_op_request,
     (dump_func)dump_query_event_request,
+    (dump_func)dump_get_esync_fd_request,
+    (dump_func)dump_get_esync_mapping_request,
     (dump_func)dump_open_event_request,
     (dump_func)dump_create_keyed_event_request,
     (dump_func)dump_open_keyed_event_request,
@@ -4589,6 +4692,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_get_socket_event_request,
     (dump_func)dump_get_socket_info_request,
     (dump_func)dump_enable_socket_event_request,
+    (dump_func)dump_complete_socket_asyncs_request,
     (dump_func)dump_set_socket_deferred_request,
     (dump_func)dump_alloc_console_request,
     (dump_func)dump_free_console_request,
@@ -4665,6 +4769,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_set_queue_fd_request,
     (dump_func)dump_set_queue_mask_request,
     (dump_func)dump_get_queue_status_request,
+    (dump_func)dump_get_shared_memory_request,
     (dump_func)dump_get_process_idle_event_request,
     (dump_func)dump_send_message_request,
     (dump_func)dump_post_quit_message_request,
@@ -4799,6 +4904,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_open_completion_request,
     (dump_func)dump_add_completion_request,
     (dump_func)dump_remove_completion_request,
+    (dump_func)dump_remove_completions_request,
     (dump_func)dump_query_completion_request,
     (dump_func)dump_set_completion_info_request,
     (dump_func)dump_add_fd_completion_request,
@@ -4844,6 +4950,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_queue_apc_reply,
     (dump_func)dump_get_apc_result_reply,
     NULL,
+    (dump_func)dump_get_handle_cache_mapping_reply,
     (dump_func)dump_set_handle_info_reply,
     (dump_func)dump_dup_handle_reply,
     (dump_func)dump_open_process_reply,
@@ -4852,6 +4959,8 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_create_event_reply,
     NULL,
     (dump_func)dump_query_event_reply,
+    (dump_func)dump_get_esync_fd_reply,
+    (dump_func)dump_get_esync_mapping_reply,
     (dump_func)dump_open_event_reply,
     (dump_func)dump_create_keyed_event_reply,
     (dump_func)dump_open_keyed_event_reply,
@@ -4881,6 +4990,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_get_socket_event_reply,
     (dump_func)dump_get_socket_info_reply,
     NULL,
+    (dump_func)dump_complete_socket_asyncs_reply,
     NULL,
     (dump_func)dump_alloc_console_reply,
     NULL,
@@ -4957,6 +5067,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     NULL,
     (dump_func)dump_set_queue_mask_reply,
     (dump_func)dump_get_queue_status_reply,
+    (dump_func)dump_get_shared_memory_reply,
     (dump_func)dump_get_process_idle_event_reply,
     NULL,
     NULL,
@@ -5091,6 +5202,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_open_completion_reply,
     NULL,
     (dump_func)dump_remove_completion_reply,
+    (dump_func)dump_remove_completions_reply,
     (dump_func)dump_query_completion_reply,
     NULL,
     NULL,
@@ -5136,6 +5248,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "queue_apc",
     "get_apc_result",
     "close_handle",
+    "get_handle_cache_mapping",
     "set_handle_info",
     "dup_handle",
     "open_process",
@@ -5144,6 +5257,8 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "create_event",
     "event_op",
     "query_event",
+    "get_esync_fd",
+    "get_esync_mapping",
     "open_event",
     "create_keyed_event",
     "open_keyed_event",
@@ -5173,6 +5288,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "get_socket_event",
     "get_socket_info",
     "enable_socket_event",
+    "complete_socket_asyncs",
     "set_socket_deferred",
     "alloc_console",
     "free_console",
@@ -5249,6 +5365,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "set_queue_fd",
     "set_queue_mask",
     "get_queue_status",
+    "get_shared_memory",
     "get_process_idle_event",
     "send_message",
     "post_quit_message",
@@ -5383,6 +5500,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "open_completion",
     "add_completion",
     "remove_completion",
+    "remove_completions",
     "query_completion",
     "set_completion_info",
     "add_fd_completion",
@@ -77,6 +77,8 @@ struct desktop
     unsigned int         users;            /* processes and threads using this desktop */
     struct global_cursor cursor;           /* global cursor information */
     unsigned char        keystate[256];    /* asynchronous key state */
+    struct mapping      *shared_mapping;   /* mapping of the shared desktop state */
+    desktop_shm_t       *shared;           /* server view of the shared desktop state */
 };
 
 /* user handles functions */
@@ -0,0 +1,265 @@
+/*
+ * Server worker threads for blocking operations
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/*
+ * The server state is only ever touched by the main loop thread. Worker
+ * threads only run jobs that block in system calls on private data (for
+ * instance a dup'ed unix fd), the completion callback of the job is then
+ * called from the main loop. Workers are disabled unless WINESERVER_WORKERS
+ * is set to the number of threads to use.
+ */
+
+#include "config.h"
+#include "wine/port.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#ifdef HAVE_POLL_H
+#include <poll.h>
+#endif
+#include <unistd.h>
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#include "windef.h"
+#include "winternl.h"
+
+#include "file.h"
+#include "object.h"
+#include "request.h"
+
+#define MAX_WORKERS 16
+
+struct worker_job
+{
+    struct list      entry;       /* entry in the pending or done list */
+    worker_func      func;        /* function called on the worker thread */
+    worker_callback  callback;    /* function called on the main thread when done */
+    void            *arg;         /* argument for both functions */
+    unsigned int     status;      /* status returned by func */
+};
+
+struct worker_pool
+{
+    struct object    obj;         /* object header */
+    struct fd       *fd;          /* file descriptor for the pipe read side */
+    int              pipe_write;  /* unix fd for the pipe write side */
+    pthread_mutex_t  mutex;       /* mutex protecting the job lists */
+    pthread_cond_t   cond;        /* condition signaled when a job is queued */
+    struct list      pending;     /* jobs waiting for a worker */
+    struct list      done;        /* jobs waiting for their callback */
+    int              notified;    /* did we write to the pipe for the done jobs? */
+};
+
+static void worker_pool_dump( struct object *obj, int verbose );
+
+static const struct object_ops worker_pool_ops =
+{
+    sizeof(struct worker_pool),   /* size */
+    worker_pool_dump,             /* dump */
+    no_get_type,                  /* get_type */
+    no_add_queue,                 /* add_queue */
+    NULL,                         /* remove_queue */
+    NULL,                         /* signaled */
+    NULL,                         /* satisfied */
+    no_signal,                    /* signal */
+    no_get_fd,                    /* get_fd */
+    no_map_access,                /* map_access */
+    default_get_sd,               /* get_sd */
+    default_set_sd,               /* set_sd */
+    no_lookup_name,               /* lookup_name */
+    no_link_name,                 /* link_name */
+    NULL,                         /* unlink_name */
+    no_open_file,                 /* open_file */
+    no_close_handle,              /* close_handle */
+    no_destroy                    /* destroy */
+};
+
+static void worker_pool_poll_event( struct fd *fd, int event );
+
+static const struct fd_ops worker_pool_fd_ops =
+{
+    NULL,                         /* get_poll_events */
+    worker_pool_poll_event,       /* poll_event */
+    NULL,                         /* get_fd_type */
+    no_fd_read,                   /* read */
+    no_fd_write,                  /* write */
+    no_fd_flush,                  /* flush */
+    no_fd_get_file_info,          /* get_file_info */
+    no_fd_get_volume_info,        /* get_volume_info */
+    no_fd_ioctl,                  /* ioctl */
+    no_fd_queue_async,            /* queue_async */
+    NULL                          /* reselect_async */
+};
+
+static struct worker_pool *worker_pool;
+
+static void worker_pool_dump( struct object *obj, int verbose )
+{
+    struct worker_pool *pool = (struct worker_pool *)obj;
+    fprintf( stderr, "Worker pool fd=%p\n", pool->fd );
+}
+
+/* wake up the main loop, called with the mutex held */
+static void worker_pool_notify( struct worker_pool *pool )
+{
+    char dummy = 0;
+
+    if (pool->notified) return;
+    for (;;)
+    {
+        /* a full pipe is readable already */
+        if (write( pool->pipe_write, &dummy, 1 ) == 1 || errno == EAGAIN) break;
+        if (errno == EINTR) continue;
+        fprintf( stderr, "wineserver: failed to wake up the main loop: %s\n", strerror( errno ));
+        return;  /* try again with the next job */
+    }
+    pool->notified = 1;
+}
+
+/* main function of the worker threads */
+static void *worker_thread( void *arg )
+{
+    struct worker_pool *pool = arg;
+    struct worker_job *job;
+    struct list *ptr;
+
+    pthread_mutex_lock( &pool->mutex );
+    for (;;)
+    {
+        while (!(ptr = list_head( &pool->pending ))) pthread_cond_wait( &pool->cond, &pool->mutex );
+        job = LIST_ENTRY( ptr, struct worker_job, entry );
+        list_remove( &job->entry );
+        pthread_mutex_unlock( &pool->mutex );
+
+        job->status = job->func( job->arg );
+
+        pthread_mutex_lock( &pool->mutex );
+        list_add_tail( &pool->done, &job->entry );
+        worker_pool_notify( pool );
+    }
+    return NULL;
+}
+
+/* run the callbacks of the finished jobs */
+static void worker_pool_poll_event( struct fd *fd, int event )
+{
+    struct worker_pool *pool = get_fd_user( fd );
+    struct worker_job *job;
+    struct list done, *ptr;
+    char dummy[16];
+    int ret;
+
+    list_init( &done );
+    pthread_mutex_lock( &pool->mutex );
+    /* the pipe is non-blocking, drain it so that it doesn't stay readable */
+    while ((ret = read( get_unix_fd( pool->fd ), dummy, sizeof(dummy) )) != 0)
+    {
+        if (ret > 0 || errno == EINTR) continue;
+        if (errno != EAGAIN) fprintf( stderr, "wineserver: failed to read the worker pipe: %s\n", strerror( errno ));
+        break;
+    }
+    pool->notified = 0;
+    list_move_tail( &done, &pool->done );
+    pthread_mutex_unlock( &pool->mutex );
+
+    while ((ptr = list_head( &done )))
+    {
+        job = LIST_ENTRY( ptr, struct worker_job, entry );
+        list_remove( &job->entry );
+        job->callback( job->arg, job->status );
+        free( job );
+    }
+}
+
+/* create the worker pool and start the threads */
+void init_workers(void)
+{
+    struct worker_pool *pool;
+    const char *env = getenv( "WINESERVER_WORKERS" );
+    int i, count, fd[2];
+    sigset_t sigset, old_sigset;
+    pthread_t thread;
+
+    if (!env || (count = atoi( env )) <= 0) return;
+    if (count > MAX_WORKERS) count = MAX_WORKERS;
+
+    if (pipe( fd ) == -1) return;
+    fcntl( fd[0], F_SETFL, O_NONBLOCK );
+    fcntl( fd[1], F_SETFL, O_NONBLOCK );
+    if (!(pool = alloc_object( &worker_pool_ops )))
+    {
+        close( fd[0] );
+        close( fd[1] );
+        return;
+    }
+    pool->pipe_write = fd[1];
+    pool->notified   = 0;
+    list_init( &pool->pending );
+    list_init( &pool->done );
+    pthread_mutex_init( &pool->mutex, NULL );
+    pthread_cond_init( &pool->cond, NULL );
+
+    if (!(pool->fd = create_anonymous_fd( &worker_pool_fd_ops, fd[0], &pool->obj, 0 )))
+    {
+        close( fd[1] );
+        release_object( pool );
+        return;
+    }
+    set_fd_events( pool->fd, POLLIN );
+    make_object_static( &pool->obj );
+
+    /* signals are handled by the main loop */
+    sigfillset( &sigset );
+    pthread_sigmask( SIG_BLOCK, &sigset, &old_sigset );
+    for (i = 0; i < count; i++)
+    {
+        if (pthread_create( &thread, NULL, worker_thread, pool )) break;
+        pthread_detach( thread );
+    }
+    pthread_sigmask( SIG_SETMASK, &old_sigset, NULL );
+
+    if (i) worker_pool = pool;
+    if (debug_level) fprintf( stderr, "wineserver: started %d worker threads\n", i );
+}
+
+/* queue a job on a worker thread; returns 0 if workers are disabled and the caller must do the work */
+int queue_worker_job( worker_func func, worker_callback callback, void *arg )
+{
+    struct worker_job *job;
+
+    if (!worker_pool) return 0;
+    if (!(job = mem_alloc( sizeof(*job) ))) return 0;
+
+    job->func     = func;
+    job->callback = callback;
+    job->arg      = arg;
+    job->status   = STATUS_PENDING;
+
+    pthread_mutex_lock( &worker_pool->mutex );
+    list_add_tail( &worker_pool->pending, &job->entry );
+    pthread_cond_signal( &worker_pool->cond );
+    pthread_mutex_unlock( &worker_pool->mutex );
+    return 1;
+}